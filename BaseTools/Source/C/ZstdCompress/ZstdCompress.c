@@ -0,0 +1,220 @@
+/** @file
+Zstandard compress and decompress utility
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#define _CRT_SECURE_NO_WARNINGS
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "Sdk/zstd.h"
+
+#define UTILITY_NAME "ZstdCompress"
+
+#define INTEL_COPYRIGHT \
+  "Copyright (c) 2021, Intel Corporation. All rights reserved."
+
+//
+// The firmware decoder works on one frame with a known content size and
+// does not check the content checksum, so it is not generated.
+//
+#define ZSTD_DEFAULT_LEVEL    19
+
+void PrintHelp (void)
+{
+  printf (   "\n" UTILITY_NAME " - " INTEL_COPYRIGHT "\n"
+             "\nUsage:  ZstdCompress -e|-d  [-l Level]  -o <outputFile>  <inputFile>\n"
+             "  -e: encode file\n"
+             "  -d: decode file\n"
+             "  -l Level: compression level, 1 to %d (default %d)\n"
+             "  -o FileName, --output FileName: specify the output filename\n",
+             ZSTD_maxCLevel (), ZSTD_DEFAULT_LEVEL
+             );
+}
+
+
+int
+main (
+  int    argc,
+  char  *argv[]
+  )
+/*++
+
+Routine Description:
+
+  Compress or Decompress the image using Zstandard algorithm
+
+Arguments:
+
+  Argc            - standard C main() argument count
+
+  Argv            - standard C main() argument list
+
+Returns:
+
+  0             success
+  non-zero      otherwise
+
+--*/
+{
+  FILE               *fp;
+  int                 i;
+  int                 level;
+  int                 decompress;
+  long                inpsz;
+  size_t              bufsz;
+  size_t              res;
+  unsigned long long  sz;
+  char               *bufi;
+  char               *bufo;
+  char               *input;
+  char               *output;
+  ZSTD_CCtx          *cctx;
+
+  bufi   = NULL;
+  bufo   = NULL;
+  output = NULL;
+  input  = NULL;
+  level  = ZSTD_DEFAULT_LEVEL;
+  decompress = -1;
+
+  if (argc < 5) {
+    PrintHelp ();
+    return -1;
+  }
+
+  for (i = 1; i < argc; i++) {
+    if (argv[i][0] == '-') {
+      if (!strcmp(argv[i], "-d")) {
+        decompress = 1;
+      } else if (!strcmp(argv[i], "-e")) {
+        decompress = 0;
+      } else if (!strcmp(argv[i], "-l")) {
+        if (i+1 < argc) {
+          level = atoi (argv[i+1]);
+          i++;
+        }
+      } else if (!strcmp(argv[i], "-o") || !strcmp(argv[i], "--output")) {
+        if (i+1 < argc) {
+          output =  argv[i+1];
+          i++;
+        }
+      } else {
+        printf("Unknown option '%s' !\n", argv[i]);
+        return -1;
+      }
+    } else {
+      if (input == NULL) {
+        input =  argv[i];
+      }
+    }
+  }
+
+  if (input == NULL) {
+    printf("Input file name is required!\n");
+    return -1;
+  }
+
+  if (output == NULL) {
+    printf("Output file name is required!\n");
+    return -2;
+  }
+
+  if (decompress < 0) {
+    printf("Operation is required!\n");
+    return -3;
+  }
+
+  if ((level < 1) || (level > ZSTD_maxCLevel ())) {
+    printf("Invalid compression level %d !\n", level);
+    return -1;
+  }
+
+  fp = fopen (input, "rb");
+  if (!fp) {
+    printf("Cannot open file '%s' !\n", input);
+    return -4;
+  }
+
+  fseek(fp, 0L, SEEK_END);
+  inpsz = ftell(fp);
+  fseek(fp, 0L, SEEK_SET);
+
+  bufi = (char *)malloc(inpsz + 1);
+  if (bufi) {
+    if (fread(bufi, 1, inpsz, fp) != (size_t)inpsz) {
+      free (bufi);
+      bufi = NULL;
+    }
+  }
+  fclose(fp);
+
+  res = 0;
+  if (bufi == NULL) {
+    res = (size_t)-1;
+  } else if (decompress == 1) {
+    sz = ZSTD_getFrameContentSize (bufi, inpsz);
+    if ((sz == ZSTD_CONTENTSIZE_UNKNOWN) || (sz == ZSTD_CONTENTSIZE_ERROR) || (sz > 0x7FFFFFFF)) {
+      res = (size_t)-1;
+    } else {
+      bufo = (char *)malloc((size_t)sz + 1);
+      if (bufo) {
+        res = ZSTD_decompress (bufo, (size_t)sz, bufi, inpsz);
+        if (ZSTD_isError (res) || (res != sz)) {
+          res = (size_t)-1;
+        }
+      } else {
+        res = (size_t)-1;
+      }
+    }
+  } else {
+    bufsz = ZSTD_compressBound(inpsz);
+    bufo  = (char *)malloc(bufsz);
+    cctx  = ZSTD_createCCtx ();
+    if (bufo && cctx) {
+      ZSTD_CCtx_setParameter (cctx, ZSTD_c_compressionLevel, level);
+      ZSTD_CCtx_setParameter (cctx, ZSTD_c_contentSizeFlag, 1);
+      ZSTD_CCtx_setParameter (cctx, ZSTD_c_checksumFlag, 0);
+      ZSTD_CCtx_setParameter (cctx, ZSTD_c_dictIDFlag, 0);
+      res = ZSTD_compress2 (cctx, bufo, bufsz, bufi, inpsz);
+      if (ZSTD_isError (res)) {
+        res = (size_t)-1;
+      }
+    } else {
+      res = (size_t)-1;
+    }
+    ZSTD_freeCCtx (cctx);
+  }
+
+  if (res != (size_t)-1) {
+    fp = fopen (output, "wb");
+    if (!fp) {
+      printf("Cannot create file '%s' !\n", output);
+      res = (size_t)-1;
+    } else {
+      fwrite(bufo, res, 1, fp);
+      fclose(fp);
+    }
+  }
+
+  if (bufi) {
+    free(bufi);
+  }
+
+  if (bufo) {
+    free(bufo);
+  }
+
+  if (res == (size_t)-1) {
+    printf("Failed!\n");
+    return -1;
+  }
+
+  printf("OK!\n");
+  return 0;
+}
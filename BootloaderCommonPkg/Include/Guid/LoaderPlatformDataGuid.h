@@ -17,6 +17,12 @@ extern EFI_GUID gLoaderPlatformDataGuid;
 #define  DEBUG_OUTPUT_DEVICE_LOG_BUFFER     BIT0
 #define  DEBUG_OUTPUT_DEVICE_SERIAL_PORT    BIT1
 #define  DEBUG_OUTPUT_DEVICE_DEBUG_PORT     BIT2
+//
+// Together with LOG_BUFFER and SERIAL_PORT, the debug messages are only
+// recorded into the log buffer and sent to the serial port later on by
+// DebugLogBufferFlush ().
+//
+#define  DEBUG_OUTPUT_DEVICE_SERIAL_DEFERRED BIT3
 #define  DEBUG_OUTPUT_DEVICE_CONSOLE        BIT7
 
 
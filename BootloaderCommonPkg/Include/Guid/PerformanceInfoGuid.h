@@ -10,6 +10,9 @@
 #define __PERFORMANCE_INFO_GUID_H__
 
 extern EFI_GUID gLoaderPerformanceInfoGuid;
+extern EFI_GUID gLoaderPerformanceTimelineGuid;
+
+#define  PERF_SPAN_NO_DEVICE          0xFF
 
 #pragma pack(1)
 
@@ -22,6 +25,30 @@ typedef struct {
   UINT64    TimeStamp[0];
 } PERFORMANCE_INFO;
 
+//
+// A measured span of the boot timeline
+//
+typedef struct {
+  UINT16    Id;           // Measure point Id of the span
+  UINT8     Parent;       // Index of the parent span plus 1, 0 for a top level span
+  UINT8     Device;       // OS_BOOT_MEDIUM_TYPE of the media accessed, or PERF_SPAN_NO_DEVICE
+  UINT32    Tag;          // Signature of the object processed, such as a component name
+  UINT32    Size;         // Bytes processed in the span
+  UINT32    Reserved;
+  UINT64    Start;        // Timestamp at span begin
+  UINT64    End;          // Timestamp at span end, 0 if not ended
+} PERFORMANCE_SPAN;
+
+typedef struct {
+  UINT8             Revision;
+  UINT8             Reserved0[3];
+  UINT16            Count;
+  UINT16            Flags;
+  UINT32            Frequency;
+  UINT64            FpdtBootTable;  // FPDT boot performance table with room for span records, 0 if none
+  PERFORMANCE_SPAN  Span[0];
+} PERFORMANCE_TIMELINE_INFO;
+
 #pragma pack()
 
 #endif
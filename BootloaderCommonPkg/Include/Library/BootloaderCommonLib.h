@@ -14,6 +14,7 @@
 #include <Guid/LoaderPlatformDataGuid.h>
 #include <Guid/DeviceTableHobGuid.h>
 #include <Guid/KeyHashGuid.h>
+#include <Guid/PerformanceInfoGuid.h>
 #include <Library/BaseLib.h>
 #include <Library/CryptoLib.h>
 
@@ -31,10 +32,15 @@
 
 // Data that are handed off between stages
 #define  MAX_TS_NUM                   64
+#define  MAX_PERF_SPAN_NUM            32
 typedef struct {
-  UINT32        PerfIndex;
-  UINT32        FreqKhz;
-  UINT64        TimeStamp[MAX_TS_NUM];
+  UINT32            PerfIndex;
+  UINT32            FreqKhz;
+  UINT64            TimeStamp[MAX_TS_NUM];
+  UINT32            SpanCount;
+  UINT32            SpanOpen;
+  // Table of MAX_PERF_SPAN_NUM spans, NULL until a stage allocates it
+  PERFORMANCE_SPAN *Span;
 } BL_PERF_DATA;
 
 typedef struct {
@@ -607,6 +613,18 @@ GetHashStorePtr (
   VOID
   );
 
+/**
+  This function retrieves the image cache pointer.
+
+  @retval    The image cache pointer, or NULL if there is no image cache.
+
+**/
+VOID *
+EFIAPI
+GetImageCachePtr (
+  VOID
+  );
+
 /**
   Match a given hash with the ones in hash store.
 
@@ -11,6 +11,7 @@
 #define __CONFIGURATION_DATA_LIB_H__
 
 #define CFG_DATA_SIGNATURE  SIGNATURE_32 ('C', 'F', 'G', 'D')
+#define CFG_INDEX_SIGNATURE SIGNATURE_32 ('C', 'F', 'G', 'I')
 
 #define CDATA_BLOB_ATTR_SIGNED  (1 << 0)
 #define CDATA_BLOB_ATTR_MERGED  (1 << 7)
@@ -113,6 +114,30 @@ typedef struct {
 
 } ARRAY_CFG_HDR;
 
+//
+// Runtime tag index for the configuration database.
+// It is placed in the free space right after the used data of the
+// database blob, and is only valid while the blob layout is unchanged.
+//
+typedef struct {
+  UINT16  Tag;                     // Item tag
+  UINT16  Offset;                  // Item header offset in DWORD from the start of data blob
+  UINT16  ReferOffset;             // Resolved reference item offset in DWORD, 0 if not found
+  UINT16  Flags;                   // Item flags
+  UINT32  PidMask;                 // Combined condition mask of the item
+} CDATA_INDEX_ENTRY;
+
+typedef struct {
+  UINT32             Signature;
+  UINT16             EntryCount;
+  //
+  // Snapshot of the data blob layout when the index was built
+  //
+  UINT16             InternalDataOffset;
+  UINT32             UsedLength;
+  CDATA_INDEX_ENTRY  Entry[0];
+} CDATA_INDEX;
+
 
 /**
   Load the configuration data blob from media into destination buffer.
@@ -222,6 +247,24 @@ AddConfigData (
   IN  UINT8                *CfgAddPtr
   );
 
+/**
+  Build the tag index for the configuration database.
+
+  The index is sorted by tag and keeps the database order for the items
+  sharing the same tag. Reference items are resolved while building the
+  index, so a lookup does not need to walk the data blob any more.
+
+  @retval EFI_SUCCESS           The index was built successfully.
+  @retval EFI_NOT_FOUND         The configuration database is not available.
+  @retval EFI_BUFFER_TOO_SMALL  No enough free space in the database to hold the index.
+
+**/
+EFI_STATUS
+EFIAPI
+BuildConfigDataIndex (
+  VOID
+  );
+
 /**
   Build a full set of CFGDATA for current platform.
 
@@ -10,6 +10,7 @@
 
 #include <Library/PcdLib.h>
 #include <Library/CryptoLib.h>
+#include <Library/SecureBootLib.h>
 
 
 #define CONTAINER_LIST_SIGNATURE SIGNATURE_32('C','T','N', 'L')
@@ -89,6 +90,34 @@ typedef struct {
   UINT8            HashData[0];
 } COMPONENT_ENTRY;
 
+typedef struct {
+  UINT32           ContainerSig;
+  UINT32           ComponentName;
+  VOID            *Buffer;
+  UINT32           Length;
+  EFI_STATUS       Status;
+} LOAD_COMPONENT_REQUEST;
+
+//
+// A flash map component that is copied into memory and hashed ahead of its
+// load, a chunk at a time. Buffer may be moved with RelocateStagedComponent
+// once a larger memory region becomes available. The hash context may hold
+// pointers into the code image that started it, so the context can only be
+// copied or used from another stage after Complete is set.
+//
+typedef struct {
+  UINT32           ComponentType;
+  UINT32           ComponentName;
+  UINT8           *Source;
+  UINT8           *Buffer;
+  UINT32           BufferSize;
+  UINT32           Length;
+  UINT32           Offset;
+  BOOLEAN          Complete;
+  HASH_MULTI_CTX   HashCtx;
+  UINT8            Digest[HASH_MULTI_MAX * HASH_DIGEST_MAX];
+} COMPONENT_STAGE_CTX;
+
 
 /**
   Load a component from a container or flahs map to memory and call callback
@@ -117,6 +146,187 @@ LoadComponentWithCallback (
   IN     LOAD_COMPONENT_CALLBACK  LoadComponentCallback
   );
 
+/**
+  Load a list of components from containers or flash map to memory and call
+  callback function at predefined points.
+
+  Independent components are authenticated and decompressed in parallel on
+  the idle APs when the MP service is available. The callback is always
+  called on the BSP, in the order of the request list.
+
+  @param[in,out] Request                Array of component load requests.
+                                        On input, Buffer and Length optionally specify the
+                                        destination buffer. On output, Buffer, Length and
+                                        Status are updated for each request.
+  @param[in]     Count                  Number of requests.
+  @param[in]     LoadComponentCallback  Callback function pointer.
+
+  @retval EFI_INVALID_PARAMETER    Request is NULL.
+  @retval EFI_SUCCESS              All components were loaded successfully.
+  @retval Others                   The status of the first failed request.
+
+**/
+EFI_STATUS
+EFIAPI
+LoadComponentListWithCallback (
+  IN OUT LOAD_COMPONENT_REQUEST   *Request,
+  IN     UINT32                    Count,
+  IN     LOAD_COMPONENT_CALLBACK   LoadComponentCallback
+  );
+
+/**
+  Load a list of components as LoadComponentListWithCallback does, using the
+  digests that have been calculated ahead of time where they apply.
+
+  @param[in,out] Request                Array of component load requests.
+  @param[in]     Count                  Number of requests.
+  @param[in]     DigestList             Digests from PrepareContainerDigests, or NULL.
+  @param[in]     DigestCount            Number of entries in DigestList.
+  @param[in]     LoadComponentCallback  Callback function pointer.
+
+  @retval EFI_INVALID_PARAMETER    Request is NULL.
+  @retval EFI_SUCCESS              All components were loaded successfully.
+  @retval Others                   The status of the first failed request.
+
+**/
+EFI_STATUS
+EFIAPI
+LoadComponentListWithDigest (
+  IN OUT LOAD_COMPONENT_REQUEST   *Request,
+  IN     UINT32                    Count,
+  IN     CONST HASH_REQUEST       *DigestList   OPTIONAL,
+  IN     UINT32                    DigestCount,
+  IN     LOAD_COMPONENT_CALLBACK   LoadComponentCallback
+  );
+
+/**
+  Prepare the hash requests for the components of a container in memory.
+
+  The container does not need to be registered. Only the container data is
+  parsed, so the requests can be prepared right after the container is read
+  and the digests calculated while the next image is read. The digests are
+  then given to LoadComponentListWithDigest once the container is registered
+  and authenticated. A mono signed container is not supported.
+
+  @param[in]     ContainerHdr   Container in memory.
+  @param[in]     Length         Length of the container data in memory.
+  @param[out]    Request        Array to receive the hash requests.
+  @param[in,out] Count          On input, the number of entries in Request.
+                                On output, the number of hash requests prepared.
+
+  @retval EFI_INVALID_PARAMETER  Invalid parameters.
+  @retval EFI_UNSUPPORTED        The container is not supported.
+  @retval EFI_SUCCESS            The hash requests are prepared.
+
+**/
+EFI_STATUS
+EFIAPI
+PrepareContainerDigests (
+  IN     CONTAINER_HDR            *ContainerHdr,
+  IN     UINT32                    Length,
+  OUT    HASH_REQUEST             *Request,
+  IN OUT UINT32                   *Count
+  );
+
+/**
+  Start staging a flash map component into memory ahead of its load.
+
+  Only the signed part of the component is staged. If Buffer is smaller than
+  it, staging stops when Buffer is full and resumes after the context has been
+  relocated into a large enough buffer.
+
+  @param[out]    StageCtx        Stage context to initialize.
+  @param[in]     ComponentType   Component type.
+  @param[in]     ComponentName   Component name.
+  @param[in]     Buffer          Staging buffer.
+  @param[in]     BufferSize      Staging buffer size.
+
+  @retval EFI_INVALID_PARAMETER    Invalid parameters.
+  @retval EFI_UNSUPPORTED          The component cannot be staged.
+  @retval EFI_NOT_FOUND            Cannot locate component.
+  @retval EFI_SUCCESS              The stage context is ready.
+
+**/
+EFI_STATUS
+EFIAPI
+StageComponentInit (
+  OUT    COMPONENT_STAGE_CTX     *StageCtx,
+  IN     UINT32                   ComponentType,
+  IN     UINT32                   ComponentName,
+  IN     VOID                    *Buffer,
+  IN     UINT32                   BufferSize
+  );
+
+/**
+  Copy and hash the next chunk of a staged component.
+
+  It does not print any debug messages or use the loader global data, so it
+  can be called from an FSP event handler. The digests are finalized in the
+  call that stages the last byte.
+
+  @param[in,out] StageCtx        Stage context.
+  @param[in]     MaxLength       Maximum number of bytes to stage in this call.
+
+  @retval TRUE                   The whole component has been staged.
+  @retval FALSE                  There is more to stage.
+
+**/
+BOOLEAN
+EFIAPI
+StageComponentStep (
+  IN OUT COMPONENT_STAGE_CTX     *StageCtx,
+  IN     UINT32                   MaxLength
+  );
+
+/**
+  Move a staged component into a new buffer.
+
+  @param[in,out] StageCtx        Stage context.
+  @param[in]     Buffer          New staging buffer.
+  @param[in]     BufferSize      New staging buffer size.
+
+  @retval EFI_INVALID_PARAMETER  Invalid parameters.
+  @retval EFI_BUFFER_TOO_SMALL   The new buffer cannot hold the staged data.
+  @retval EFI_SUCCESS            The staged data has been moved.
+
+**/
+EFI_STATUS
+EFIAPI
+RelocateStagedComponent (
+  IN OUT COMPONENT_STAGE_CTX     *StageCtx,
+  IN     VOID                    *Buffer,
+  IN     UINT32                   BufferSize
+  );
+
+/**
+  Load a staged component to memory and call callback function at predefined
+  points.
+
+  The rest of the component is staged first. The digests calculated during
+  staging are then used for authentication. If the staged copy cannot be used,
+  the component is loaded from flash as LoadComponentWithCallback does.
+
+  @param[in,out] StageCtx               Stage context.
+  @param[in,out] Buffer                 Pointer to receive component base.
+  @param[in,out] Length                 Pointer to receive component size.
+  @param[in]     LoadComponentCallback  Callback function pointer.
+
+  @retval EFI_UNSUPPORTED          Unsupported AuthType.
+  @retval EFI_NOT_FOUND            Cannot locate component.
+  @retval EFI_BUFFER_TOO_SMALL     Specified buffer size is too small.
+  @retval EFI_SECURITY_VIOLATION   Authentication failed.
+  @retval EFI_SUCCESS              Authentication succeeded.
+
+**/
+EFI_STATUS
+EFIAPI
+LoadStagedComponentWithCallback (
+  IN OUT COMPONENT_STAGE_CTX     *StageCtx,
+  IN OUT VOID                   **Buffer,
+  IN OUT UINT32                  *Length,
+  IN     LOAD_COMPONENT_CALLBACK  LoadComponentCallback
+  );
+
 /**
   Locate a component region information from a container or flash map.
 
@@ -253,4 +463,25 @@ EFI_STATUS
 UnregisterContainer (
   IN  UINT32   Signature
   );
+
+/**
+  Initialize the image cache that keeps the signed component data across warm
+  resets.
+
+  @param[in] CacheBase       Base of the cache region in loader reserved memory.
+  @param[in] CacheSize       Size of the cache region.
+  @param[in] Reset           TRUE to drop the components cached by the last boot.
+
+  @retval EFI_SUCCESS            The components cached by the last boot are kept.
+  @retval EFI_NOT_FOUND          The image cache is initialized empty.
+  @retval EFI_INVALID_PARAMETER  The cache region is too small or not page aligned.
+
+**/
+EFI_STATUS
+EFIAPI
+InitImageCache (
+  IN  VOID       *CacheBase,
+  IN  UINT32      CacheSize,
+  IN  BOOLEAN     Reset
+  );
 #endif
@@ -17,9 +17,14 @@ typedef struct {
   UINT32  Signature;
   UINT8   HeaderLength;
   UINT8   Attribute;
-  UINT8   Reserved[2];
+  // Non-zero while one processor sends the log to the serial port
+  UINT16  FlushLock;
   UINT32  UsedLength;
   UINT32  TotalLength;
+  // Log buffer offset up to which the log has been sent to the serial port
+  UINT32  FlushedLength;
+  // Debug output dropped since the last message, because the flush lock was stuck
+  UINT32  DroppedLength;
   UINT8   Buffer[0];
 } DEBUG_LOG_BUFFER_HEADER;
 
@@ -49,5 +54,64 @@ DebugLogBufferWrite (
   IN UINTN      NumberOfBytes
   );
 
+/**
+  Send the log buffer data not sent yet to the serial port.
+
+  This is only used when the serial output of the debug messages is deferred.
+  It is called at the points where the boot flow waits anyway, and before
+  leaving the bootloader to flush all the pending data.
+
+  @param  MaxBytes         Maximum number of bytes to send. MAX_UINTN sends all.
+
+  @retval The number of bytes sent to the serial port.
+
+**/
+UINTN
+EFIAPI
+DebugLogBufferFlush (
+  IN UINTN      MaxBytes
+  );
+
+/**
+  Send some of the log buffer data not sent yet to the serial port if this
+  can be done without waiting.
+
+  Nothing is sent unless the serial transmitter is empty, and no more than the
+  smallest UART transmit FIFO takes is sent. It is meant for polling and delay
+  loops, and may be called on any processor.
+
+  @retval The number of bytes sent to the serial port.
+
+**/
+UINTN
+EFIAPI
+DebugLogBufferPoll (
+  VOID
+  );
+
+/**
+  Copy the log buffer into a new buffer of the same or a bigger size.
+
+  The log is stored in the new buffer in order from the oldest data, so a
+  full ring buffer is unrolled. The data not sent to the serial port yet is
+  kept pending, so the owner of the new buffer continues sending it out.
+
+  @param  NewLogBufHdr     The new log buffer.
+  @param  NewTotalLength   The size of the new log buffer.
+  @param  LogBufHdr        The log buffer to copy.
+
+  @retval RETURN_SUCCESS            The log buffer was copied.
+  @retval RETURN_INVALID_PARAMETER  The log buffer is not valid.
+  @retval RETURN_BUFFER_TOO_SMALL   The new log buffer is too small.
+
+**/
+RETURN_STATUS
+EFIAPI
+DebugLogBufferCopy (
+  OUT DEBUG_LOG_BUFFER_HEADER  *NewLogBufHdr,
+  IN  UINT32                    NewTotalLength,
+  IN  DEBUG_LOG_BUFFER_HEADER  *LogBufHdr
+  );
+
 #endif
 
@@ -1,7 +1,7 @@
 /** @file
   Basic graphics rendering support
 
-  Copyright (c) 2017 - 2019, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2017 - 2021, Intel Corporation. All rights reserved.<BR>
   SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
@@ -70,6 +70,20 @@ typedef struct {
   UINTN                         CursorY;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL ForegroundColor;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL BackgroundColor;
+  //
+  // Optional cached shadow copy of the console area (Width x Height pixels).
+  // When present, glyphs are rendered and scrolled in the shadow buffer and
+  // only the dirty rectangle is flushed to the frame buffer.
+  //
+  UINT32                        *ShadowBuf;
+  UINT32                        *GlyphAtlas;
+  UINTN                         GlyphCount;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL AtlasForegroundColor;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL AtlasBackgroundColor;
+  UINTN                         DirtyLeft;
+  UINTN                         DirtyTop;
+  UINTN                         DirtyRight;
+  UINTN                         DirtyBottom;
 } FRAME_BUFFER_CONSOLE;
 
 
@@ -207,6 +221,20 @@ FrameBufferConsoleScroll (
   IN UINTN                ScrollAmount
   );
 
+/**
+  Release the console shadow buffer and glyph atlas.
+
+  Pending changes are flushed to the frame buffer first. The console keeps
+  working afterwards by drawing directly into the frame buffer until the
+  next clear screen.
+
+**/
+VOID
+EFIAPI
+FrameBufferConsoleReleaseShadow (
+  VOID
+  );
+
 /**
   Write data from buffer to graphics framebuffer.
 
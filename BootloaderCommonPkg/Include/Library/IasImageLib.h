@@ -8,6 +8,7 @@
 #ifndef __IAS_IMAGE_LIB_H__
 #define __IAS_IMAGE_LIB_H__
 #include <Library/CryptoLib.h>
+#include <Library/SecureBootLib.h>
 
 #define IAS_MAGIC_PATTERN   0x2E6B7069 // ".kpi"
 #define MAX_IAS_SUB_IMAGE   32
@@ -109,6 +110,49 @@ IsIasImageValid (
   OUT IAS_IMAGE_INFO     *IasImageInfo
   );
 
+/**
+Check the Addr parameter for a valid IAS image as IsIasImageValid () does.
+When the digest of the signed region has been calculated ahead of time, the
+signature is verified against it instead of hashing the image again.
+
+@param  Addr              Address of the IAS image to be verified for validity.
+@param  Size              Size of the IAS image to be verified for validity.
+@param  Digest            SHA-256 digest of the request from IasPrepareDigest (), or NULL.
+@param  IasImageInfo      IasImage buffer and hash info data structure
+
+@retval NULL  The IAS image is compromised.
+@retval Hdr   The IAS image is valid.
+
+**/
+IAS_HEADER *
+IsIasImageValidWithDigest (
+  IN  VOID               *Addr,
+  IN  UINT32              Size,
+  IN  CONST UINT8        *Digest       OPTIONAL,
+  OUT IAS_IMAGE_INFO     *IasImageInfo
+  );
+
+/**
+Prepare the hash request for the signed region of an IAS image.
+
+Only the layout of the IAS image is checked, so the digest can be calculated
+ahead of IsIasImageValidWithDigest (), e.g. on an AP.
+
+@param  ImageAddr         Address of the IAS image.
+@param  Size              Size of the IAS image.
+@param  Request           Hash request to prepare.
+
+@retval EFI_SUCCESS       The hash request is prepared.
+@retval EFI_UNSUPPORTED   No digest is needed or the image is not a signed IAS image.
+
+**/
+EFI_STATUS
+IasPrepareDigest (
+  IN  VOID               *ImageAddr,
+  IN  UINT32              Size,
+  OUT HASH_REQUEST       *Request
+  );
+
 /**
 Check the Addr parameter for a valid IAS image; ensure the format is correct,
 confirm the IAS header CRC is correct, and (optional) confirm the hash of the
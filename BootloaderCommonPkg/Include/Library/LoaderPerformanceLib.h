@@ -8,6 +8,28 @@
 #ifndef _LOADER_PERF_LIB_H_
 #define _LOADER_PERF_LIB_H_
 
+#include <IndustryStandard/Acpi.h>
+
+//
+// FPDT boot performance record carrying one PERFORMANCE_SPAN.
+// Type is within the range 0x1000 - 0x1FFF reserved for platform vendors.
+//
+#define FPDT_LOADER_SPAN_RECORD_TYPE        0x1F00
+#define FPDT_LOADER_SPAN_RECORD_REVISION    1
+
+#pragma pack(1)
+typedef struct {
+  EFI_ACPI_5_0_FPDT_PERFORMANCE_RECORD_HEADER  Header;
+  UINT16                                       Id;
+  UINT8                                        Parent;
+  UINT8                                        Device;
+  UINT32                                       Tag;
+  UINT32                                       Size;
+  UINT64                                       StartNs;
+  UINT64                                       EndNs;
+} FPDT_LOADER_SPAN_RECORD;
+#pragma pack()
+
 typedef CHAR8 * (EFIAPI *PERF_ID_TO_STR) (UINT32 Id);
 
 /**
@@ -34,6 +56,81 @@ AddMeasurePoint (
   IN  UINT16         Id
   );
 
+/**
+  Begin a performance measure span.
+
+  The span becomes the parent of the spans begun before it ends.
+
+  @param[in]  Id          Measure point Id
+  @param[in]  Tag         Signature of the object processed in the span, 0 if none
+  @param[in]  Device      Boot medium type accessed in the span, or PERF_SPAN_NO_DEVICE
+
+  @retval     Span handle to pass to EndMeasureSpan(), 0 if the span table is full.
+
+**/
+UINT32
+BeginMeasureSpan (
+  IN  UINT16         Id,
+  IN  UINT32         Tag,
+  IN  UINT8          Device
+  );
+
+/**
+  End a performance measure span.
+
+  @param[in]  Span        Span handle returned by BeginMeasureSpan()
+  @param[in]  Size        Bytes processed in the span
+
+**/
+VOID
+EndMeasureSpan (
+  IN  UINT32         Span,
+  IN  UINT32         Size
+  );
+
+/**
+  Add a performance measure span that has been timed by the caller.
+
+  It is used for work that runs where the performance data cannot be
+  accessed, such as in an FSP event handler. The span is a child of the span
+  that is currently open.
+
+  @param[in]  Id          Measure point Id
+  @param[in]  Tag         Signature of the object processed in the span, 0 if none
+  @param[in]  Device      Boot medium type accessed in the span, or PERF_SPAN_NO_DEVICE
+  @param[in]  Start       Timestamp at the start of the span
+  @param[in]  End         Timestamp at the end of the span
+  @param[in]  Size        Bytes processed in the span
+
+**/
+VOID
+AddMeasureSpan (
+  IN  UINT16         Id,
+  IN  UINT32         Tag,
+  IN  UINT8          Device,
+  IN  UINT64         Start,
+  IN  UINT64         End,
+  IN  UINT32         Size
+  );
+
+/**
+  Write the measure spans as FPDT boot performance records.
+
+  The records are placed right after the basic boot record, replacing any span
+  records written before. The table must have room for MAX_PERF_SPAN_NUM
+  FPDT_LOADER_SPAN_RECORD entries.
+
+  @param[in]  BootPerfTable   FPDT boot performance table
+  @param[in]  PerfData        Performance data holding the spans
+
+**/
+VOID
+EFIAPI
+UpdateFpdtSpanRecords (
+  IN  EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER  *BootPerfTable,
+  IN  BL_PERF_DATA                                *PerfData
+  );
+
 /**
   Print Bootloader Measure Point information.
 
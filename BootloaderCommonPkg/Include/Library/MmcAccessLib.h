@@ -163,6 +163,21 @@ EmmcModeSelection (
   IN EMMC_MODE                          EmmcMode
   );
 
+/**
+  To get the eMMC card operating mode HS200/HS400
+
+  @param[out] EmmcMode                   The current HS200 or HS400 mode
+
+  @retval EFI_SUCCESS                    Emmc Mode was returned.
+  @retval EFI_UNSUPPORTED                The card operates in another mode.
+  @retval Others                         The mode could not be read.
+**/
+EFI_STATUS
+EFIAPI
+EmmcGetModeSelection (
+  OUT EMMC_MODE                         *EmmcMode
+  );
+
 /**
   This function gets serial number of eMMC card.
 
@@ -14,6 +14,39 @@
 #define  SIG_TYPE_RSA2048_SHA256       0
 #define  SIG_TYPE_RSA3072_SHA384       1
 
+#define  HASH_MULTI_MAX                 4
+
+typedef struct {
+  HASH_ALG_TYPE    HashAlg;
+  HASH_CTX         Ctx;
+} HASH_STREAM_CTX;
+
+//
+// Several hash algorithms over the same data. Each chunk is fed to every
+// stream in turn while it is still cache resident. A stream whose algorithm
+// is not supported or failed is set to HASH_TYPE_NONE.
+//
+typedef struct {
+  UINT32           Count;
+  HASH_STREAM_CTX  Stream[HASH_MULTI_MAX];
+} HASH_MULTI_CTX;
+
+//
+// ExtraHashAlg is an optional second algorithm over the same data.
+// Set it to HASH_TYPE_NONE when it is not needed.
+//
+typedef struct {
+  CONST UINT8     *Data;
+  UINT32           Length;
+  HASH_ALG_TYPE    HashAlg;
+  HASH_ALG_TYPE    ExtraHashAlg;
+  UINT8            Reserved[2];
+  RETURN_STATUS    Status;
+  RETURN_STATUS    ExtraStatus;
+  UINT8            Digest[HASH_DIGEST_MAX];
+  UINT8            ExtraDigest[HASH_DIGEST_MAX];
+} HASH_REQUEST;
+
 /**
   Get hash to extend a firmware stage component
   Hash calculation to extend would be in either of ways
@@ -62,6 +95,193 @@ CalculateHash  (
   IN OUT   UINT8          *OutHash
   );
 
+/**
+  Calculate the hash for a list of independent data buffers.
+
+  When the MP service is available, the buffers are hashed in parallel on
+  the idle APs. Otherwise they are hashed one after another on the BSP.
+
+  @param[in,out]  Request    Array of hash requests. Status and digests are updated.
+  @param[in]      Count      Number of entries in Request.
+
+  @retval RETURN_SUCCESS             All hash calculations succeeded.
+  @retval RETRUN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval Others                     At least one hash calculation failed.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateHashList (
+  IN OUT   HASH_REQUEST    *Request,
+  IN       UINT32           Count
+  );
+
+/**
+  Start an incremental hash calculation.
+
+  @param[in,out]  HashCtx    Hash stream context to initialize.
+  @param[in]      HashAlg    Specify hash algrothsm.
+
+  @retval RETURN_SUCCESS             Hash context is initialized.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_UNSUPPORTED         Hash Alg type is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateHashInit (
+  IN OUT   HASH_STREAM_CTX  *HashCtx,
+  IN       UINT8             HashAlg
+  );
+
+/**
+  Feed more data into an incremental hash calculation.
+
+  @param[in,out]  HashCtx    Hash stream context.
+  @param[in]      Data       Data buffer pointer.
+  @param[in]      Length     Data buffer size.
+
+  @retval RETURN_SUCCESS             Data is consumed.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_UNSUPPORTED         Hash Alg type is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateHashUpdate (
+  IN OUT   HASH_STREAM_CTX  *HashCtx,
+  IN CONST UINT8            *Data,
+  IN       UINT32            Length
+  );
+
+/**
+  Finish an incremental hash calculation.
+
+  @param[in,out]  HashCtx    Hash stream context.
+  @param[out]     OutHash    Hash of all data fed into the context.
+
+  @retval RETURN_SUCCESS             Hash Calculation succeeded.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_UNSUPPORTED         Hash Alg type is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateHashFinal (
+  IN OUT   HASH_STREAM_CTX  *HashCtx,
+  OUT      UINT8            *OutHash
+  );
+
+/**
+  Start a hash calculation for several algorithms over the same data.
+
+  @param[in,out]  MultiCtx   Multi hash context to initialize.
+  @param[in]      HashAlg    Array of hash algorithms.
+  @param[in]      Count      Number of entries in HashAlg, at most HASH_MULTI_MAX.
+
+  @retval RETURN_SUCCESS             At least one algorithm is initialized.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_UNSUPPORTED         None of the algorithms is supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateMultiHashInit (
+  IN OUT   HASH_MULTI_CTX   *MultiCtx,
+  IN CONST HASH_ALG_TYPE    *HashAlg,
+  IN       UINT32            Count
+  );
+
+/**
+  Feed more data into a multi hash calculation.
+
+  @param[in,out]  MultiCtx   Multi hash context.
+  @param[in]      Data       Data buffer pointer.
+  @param[in]      Length     Data buffer size.
+
+  @retval RETURN_SUCCESS             Data is consumed by all active algorithms.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval Others                     At least one algorithm failed.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateMultiHashUpdate (
+  IN OUT   HASH_MULTI_CTX   *MultiCtx,
+  IN CONST UINT8            *Data,
+  IN       UINT32            Length
+  );
+
+/**
+  Finish a multi hash calculation.
+
+  Digest Index is stored at OutHash + Index * HASH_DIGEST_MAX. The digest
+  buffer of an algorithm that is not supported or failed is left untouched,
+  and its MultiCtx->Stream[Index].HashAlg is HASH_TYPE_NONE on return.
+
+  @param[in,out]  MultiCtx   Multi hash context.
+  @param[out]     OutHash    Buffer of MultiCtx->Count * HASH_DIGEST_MAX bytes.
+
+  @retval RETURN_SUCCESS             All digests are calculated.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval Others                     At least one digest is not available.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateMultiHashFinal (
+  IN OUT   HASH_MULTI_CTX   *MultiCtx,
+  OUT      UINT8            *OutHash
+  );
+
+/**
+  Calculate the digests of one data buffer for several algorithms in one pass.
+
+  @param[in]  Data           Data buffer pointer.
+  @param[in]  Length         Data buffer size.
+  @param[in]  HashAlg        Array of hash algorithms.
+  @param[in]  Count          Number of entries in HashAlg, at most HASH_MULTI_MAX.
+  @param[out] OutHash        Buffer of Count * HASH_DIGEST_MAX bytes.
+
+  @retval RETURN_SUCCESS             All digests are calculated.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval Others                     At least one digest is not available.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateMultiHash (
+  IN CONST UINT8            *Data,
+  IN       UINT32            Length,
+  IN CONST HASH_ALG_TYPE    *HashAlg,
+  IN       UINT32            Count,
+  OUT      UINT8            *OutHash
+  );
+
+/**
+  Verify a pre-calculated data digest with the built-in one.
+
+  @param[in]      Digest     Calculated digest of the data block.
+  @param[in]      Usage      Hash component usage.
+  @param[in]      HashAlg    Specify hash algorithm.
+  @param[in,out]  Hash       On input,  expected hash value when hash component usage is 0.
+                             On output, calculated hash value when verification succeeds.
+
+  @retval RETURN_SUCCESS             Hash verification succeeded.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_NOT_FOUND           Hash data for hash component usage is not found.
+  @retval RETURN_SECURITY_VIOLATION  Hash verification failed.
+
+**/
+RETURN_STATUS
+EFIAPI
+DoDigestVerify (
+  IN CONST UINT8           *Digest,
+  IN       HASH_COMP_USAGE  Usage,
+  IN       UINT8            HashAlg,
+  IN OUT   UINT8           *Hash
+  );
+
 /**
   Verify data block hash with the built-in one.
 
@@ -122,6 +342,36 @@ DoRsaVerify (
   OUT      UINT8           *OutHash         OPTIONAL
   );
 
+/**
+  Verifies the RSA PKCS1-v1_5 signature against a pre-calculated data digest.
+
+  RSA PSS signatures require the whole message and are not supported here,
+  DoRsaVerify () should be used instead.
+
+  @param[in]  Digest          Calculated digest of the signed data.
+  @param[in]  Usage           Hash usage.
+  @param[in]  Signature       Signature header for singanture data.
+  @param[in]  PubKeyHdr       Public key header for key data
+  @param[in]  PubKeyHashAlg   Hash Alg for PubKeyHash.
+  @param[in]  PubKeyHash      Public key hash value when hash component usage is 0.
+
+  @retval RETURN_SUCCESS             RSA verification succeeded.
+  @retval RETURN_NOT_FOUND           Hash data for hash component usage is not found.
+  @retval RETURN_UNSUPPORTED         Signing scheme is not supported.
+  @retval RETURN_SECURITY_VIOLATION  PubKey or Signature verification failed.
+
+**/
+RETURN_STATUS
+EFIAPI
+DoRsaVerifyDigest (
+  IN CONST UINT8           *Digest,
+  IN       HASH_COMP_USAGE  Usage,
+  IN CONST SIGNATURE_HDR   *SignatureHdr,
+  IN       PUB_KEY_HDR     *PubKeyHdr,
+  IN       UINT8            PubKeyHashAlg,
+  IN       UINT8           *PubKeyHash      OPTIONAL
+  );
+
 /**
   Generate RandomNumbers.
 
@@ -0,0 +1,78 @@
+/** @file
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __MP_SERVICE_H__
+#define __MP_SERVICE_H__
+
+#include <Guid/BootLoaderServiceGuid.h>
+#include <Guid/MpCpuTaskInfoHob.h>
+
+#define MP_SERVICE_SIGNATURE  SIGNATURE_32 ('S', 'M', 'P', 'J')
+#define MP_SERVICE_VERSION    1
+
+//
+// Stack available to a job function, including everything it calls. Larger
+// buffers and contexts have to be passed in through the job argument.
+//
+#define MP_JOB_STACK_SIZE     SIZE_4KB
+
+/**
+  Submit a job to the AP worker pool.
+
+  The job is picked up by the first idle AP, or by the BSP while it waits in
+  WaitAllJobs. A job function runs on an AP with a small stack, and must not
+  use more than MP_JOB_STACK_SIZE of it. It must not allocate memory, print
+  debug messages or access any hardware that is not owned by the job itself.
+
+  @param[in]  TaskFunc    Job function pointer.
+  @param[in]  Argument    Argument for the job function.
+
+  @retval EFI_INVALID_PARAMETER   TaskFunc is NULL.
+  @retval EFI_SUCCESS             The job has been queued.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *MP_SUBMIT_JOB) (
+  IN  CPU_TASK_FUNC  TaskFunc,
+  IN  UINT64         Argument
+  );
+
+/**
+  Wait for all submitted jobs to complete.
+
+  The BSP also runs queued jobs while waiting.
+
+  @retval EFI_SUCCESS             All submitted jobs have completed.
+
+**/
+typedef
+EFI_STATUS
+(EFIAPI *MP_WAIT_ALL_JOBS) (
+  VOID
+  );
+
+/**
+  Get the number of CPUs that can run jobs, including the BSP.
+
+  @retval    CPU count. 1 means jobs will run on the BSP only.
+
+**/
+typedef
+UINT32
+(EFIAPI *MP_GET_WORKER_COUNT) (
+  VOID
+  );
+
+typedef struct {
+  SERVICE_COMMON_HEADER              Header;
+  MP_SUBMIT_JOB                      SubmitJob;
+  MP_WAIT_ALL_JOBS                   WaitAllJobs;
+  MP_GET_WORKER_COUNT                GetWorkerCount;
+} MP_SERVICE;
+
+#endif
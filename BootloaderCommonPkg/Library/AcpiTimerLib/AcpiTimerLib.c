@@ -11,10 +11,17 @@
 #include <Library/BaseLib.h>
 #include <Library/IoLib.h>
 #include <Library/DebugLib.h>
+#include <Library/DebugLogBufferLib.h>
 #include <IndustryStandard/Acpi.h>
 
 #define ACPI_TIMER_COUNT_SIZE  BIT24
 
+//
+// Deferred debug output is only sent while at least 100us of the delay are
+// left, so that sending a burst does not stretch the delay.
+//
+#define ACPI_TIMER_LOG_POLL_TICKS  (ACPI_TIMER_FREQUENCY / 10000)
+
 /**
   Internal function to read the current tick counter of ACPI.
 
@@ -62,7 +69,10 @@ InternalAcpiDelay (
     // Timer wrap-arounds are handled correctly by this function
     //
     while (((Ticks - InternalAcpiGetTimerTick ()) & BIT23) == 0) {
-      CpuPause ();
+      if ((((Ticks - InternalAcpiGetTimerTick ()) & (ACPI_TIMER_COUNT_SIZE - 1)) < ACPI_TIMER_LOG_POLL_TICKS) ||
+          (DebugLogBufferPoll () == 0)) {
+        CpuPause ();
+      }
     }
   } while (Times-- > 0);
 }
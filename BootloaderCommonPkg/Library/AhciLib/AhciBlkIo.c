@@ -67,6 +67,21 @@ CreateNewDeviceInfo (
         4 * sizeof (UINT16)
         );
       DeviceInfo->DeviceFeature |= DEVICE_LBA_48_SUPPORT;
+
+      //
+      // Use native command queuing for reads when both the HBA and the
+      // directly attached device support it.
+      //
+      if ((AhciCtrlData->AhciRegisters.AhciNcqCommandTable != NULL) &&
+          (PortMultiplier == 0xFFFF) &&
+          (AtaData->Serial_ata_capabilities != 0xFFFF) &&
+          ((AtaData->Serial_ata_capabilities & ATA_ID_SATA_CAP_NCQ) != 0)) {
+        DeviceInfo->NcqDepth = (UINT8) MIN ((AtaData->Queue_depth & 0x1F) + 1,
+                                            AhciCtrlData->AhciRegisters.MaxCommandSlotNumber);
+        if (DeviceInfo->NcqDepth < 2) {
+          DeviceInfo->NcqDepth = 0;
+        }
+      }
     } else {
       CopyMem (
         &DeviceInfo->TotalBlockNumber,
@@ -298,6 +313,14 @@ AhciDeinitialize (
 
   AhciRegisters = &AhciController->AhciRegisters;
 
+  if (AhciRegisters->AhciNcqCommandTable != NULL) {
+    IoMmuFreeBuffer (
+       EFI_SIZE_TO_PAGES (AhciRegisters->MaxNcqCommandTableSize),
+       AhciRegisters->AhciNcqCommandTable,
+       AhciRegisters->AhciNcqCommandTableMap
+       );
+  }
+
   if (AhciRegisters->AhciCommandTable != NULL) {
     IoMmuFreeBuffer (
        EFI_SIZE_TO_PAGES (AhciRegisters->MaxCommandTableSize),
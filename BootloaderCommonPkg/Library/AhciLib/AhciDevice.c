@@ -117,6 +117,101 @@ AhciAtaDeviceReadWrite (
            );
 }
 
+/**
+  Block read from ATA device using native command queuing.
+
+  The read is split into READ FPDMA QUEUED commands of the largest size
+  supported per command, and up to NcqDepth commands are queued at once.
+
+  @param[in]  AtaDevice     ATA device instance.
+  @param[in]  StartLba      The starting logical block address (LBA) to read from
+                            on the device.
+  @param[in]  SectorCount   The sector count to read.
+  @param[out] Buffer        A pointer to the destination buffer for the data.
+
+  @retval EFI_DEVICE_ERROR    The DMA data transfer abort with error occurs.
+  @retval EFI_TIMEOUT         The operation is time out.
+  @retval EFI_SUCCESS         The DMA data transfer executes successfully.
+
+**/
+STATIC
+EFI_STATUS
+AhciAtaDeviceQueuedRead (
+  IN     EFI_ATA_DEVICE_INFO *AtaDevice,
+  IN     EFI_LBA              StartLba,
+  IN     UINT32               SectorCount,
+  OUT    VOID                *Buffer
+  )
+{
+  EFI_AHCI_CONTROLLER   *AhciController;
+  EFI_ATA_COMMAND_BLOCK  AtaCmdBlk[EFI_AHCI_MAX_COMMAND_SLOTS];
+  UINT32                 DataCount[EFI_AHCI_MAX_COMMAND_SLOTS];
+  UINT32                 SlotSector;
+  UINT32                 Sectors;
+  UINT32                 BatchSize;
+  UINT8                  Count;
+  EFI_STATUS             Status;
+
+  AhciController = AtaDevice->Controller;
+
+  //
+  // Each slot transfers as much as a single DMA command is allowed to. When
+  // DMA protection limits the mapped size, the whole batch has to fit.
+  //
+  SlotSector = GetMaxTransferSector (AtaDevice);
+  SlotSector = MIN (SlotSector, (EFI_AHCI_NCQ_MAX_PRDT * EFI_AHCI_MAX_DATA_PER_PRDT) / AtaDevice->BlockSize);
+  if (FeaturePcdGet (PcdDmaProtectionEnabled)) {
+    SlotSector = MAX (SlotSector / AtaDevice->NcqDepth, 1);
+  }
+
+  Status = EFI_SUCCESS;
+  while (SectorCount != 0) {
+    ZeroMem (AtaCmdBlk, sizeof (AtaCmdBlk));
+    BatchSize = 0;
+    for (Count = 0; (Count < AtaDevice->NcqDepth) && (SectorCount != 0); Count++) {
+      Sectors = MIN (SectorCount, SlotSector);
+
+      //
+      // READ FPDMA QUEUED carries the sector count in the feature registers,
+      // a count of 0 stands for 65536 sectors.
+      //
+      AtaCmdBlk[Count].AtaCommand         = ATA_CMD_READ_FPDMA_QUEUED;
+      AtaCmdBlk[Count].AtaFeatures        = (UINT8) Sectors;
+      AtaCmdBlk[Count].AtaFeaturesExp     = (UINT8) (Sectors >> 8);
+      AtaCmdBlk[Count].AtaSectorNumber    = (UINT8) StartLba;
+      AtaCmdBlk[Count].AtaCylinderLow     = (UINT8) RShiftU64 (StartLba, 8);
+      AtaCmdBlk[Count].AtaCylinderHigh    = (UINT8) RShiftU64 (StartLba, 16);
+      AtaCmdBlk[Count].AtaSectorNumberExp = (UINT8) RShiftU64 (StartLba, 24);
+      AtaCmdBlk[Count].AtaCylinderLowExp  = (UINT8) RShiftU64 (StartLba, 32);
+      AtaCmdBlk[Count].AtaCylinderHighExp = (UINT8) RShiftU64 (StartLba, 40);
+      DataCount[Count] = Sectors * AtaDevice->BlockSize;
+
+      BatchSize   += DataCount[Count];
+      StartLba    += Sectors;
+      SectorCount -= Sectors;
+    }
+
+    Status = AhciQueuedDmaRead (
+               AhciController,
+               &AhciController->AhciRegisters,
+               (UINT8)AtaDevice->Port,
+               (UINT8)AtaDevice->PortMultiplier,
+               AtaCmdBlk,
+               DataCount,
+               Count,
+               Buffer,
+               MultU64x32 (DMA_WAIT_TIMEOUT_MS * 1000 * 10, Count)
+               );
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+
+    Buffer = (UINT8 *)Buffer + BatchSize;
+  }
+
+  return Status;
+}
+
 /**
   Block read/write to ATA device.
 
@@ -200,6 +295,21 @@ AhciReadWriteBlock (
     return EFI_INVALID_PARAMETER;
   }
 
+  if (Read && (AtaDevice->NcqDepth > 1)) {
+    Status = AhciAtaDeviceQueuedRead (AtaDevice, Lba, (UINT32)NumberOfBlocks, Buffer);
+    if (!EFI_ERROR (Status)) {
+      return EFI_SUCCESS;
+    }
+
+    //
+    // The device needs a reset to leave the NCQ error state. Fall back to
+    // non-queued DMA commands from now on.
+    //
+    DEBUG ((DEBUG_WARN, "AhciDeviceQueuedRead Status = %r, disable NCQ\n", Status));
+    AtaDevice->NcqDepth = 0;
+    AhciPortReset (AtaDevice->Controller, (UINT8)AtaDevice->Port, EFI_AHCI_BUS_RESET_TIMEOUT);
+  }
+
   MaxTransferSector = GetMaxTransferSector (AtaDevice);
   RemainSectorCount = (UINT32)NumberOfBlocks;
   while (RemainSectorCount != 0) {
@@ -37,6 +37,9 @@
 #define  DEVICE_LBA_48_SUPPORT          BIT1
 #define  DMA_WAIT_TIMEOUT_MS            500
 
+#define  ATA_CMD_READ_FPDMA_QUEUED      0x60
+#define  ATA_ID_SATA_CAP_NCQ            BIT8
+
 //
 // ATA device info
 //
@@ -49,6 +52,7 @@ typedef struct {
   UINT32                            BlockSize;
   UINT32                            DeviceFeature;
   EFI_LBA                           TotalBlockNumber;
+  UINT8                             NcqDepth;
   EFI_IDENTIFY_DATA                 IdentifyData;
   EFI_AHCI_CONTROLLER              *Controller;
 } EFI_ATA_DEVICE_INFO;
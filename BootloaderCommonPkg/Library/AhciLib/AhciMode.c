@@ -1144,11 +1144,12 @@ AhciStopCommand (
 }
 
 /**
-  Start command for give slot on specific port.
+  Start commands for the given slots on specific port.
 
-  @param  AhciController              The AHCI controller protocol instance.
+  @param  AhciController     The AHCI controller protocol instance.
   @param  Port               The number of port.
-  @param  CommandSlot        The number of Command Slot.
+  @param  SlotMask           The bit mask of the command slots to start.
+  @param  Queued             TRUE if the slots hold native queued commands.
   @param  Timeout            The timeout value of start, uses 100ns as a unit.
 
   @retval EFI_DEVICE_ERROR   The command start unsuccessfully.
@@ -1156,16 +1157,16 @@ AhciStopCommand (
   @retval EFI_SUCCESS        The command start successfully.
 
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-AhciStartCommand (
+AhciStartCommandSlots (
   IN  EFI_AHCI_CONTROLLER       *AhciController,
   IN  UINT8                     Port,
-  IN  UINT8                     CommandSlot,
+  IN  UINT32                    SlotMask,
+  IN  BOOLEAN                   Queued,
   IN  UINT64                    Timeout
   )
 {
-  UINT32     CmdSlotBit;
   EFI_STATUS Status;
   UINT32     PortStatus;
   UINT32     StartCmd;
@@ -1178,8 +1179,6 @@ AhciStartCommand (
   //
   Capability = AhciReadReg (AhciController, EFI_AHCI_CAPABILITY_OFFSET);
 
-  CmdSlotBit = (UINT32) (1 << CommandSlot);
-
   AhciClearPortStatus (
     AhciController,
     Port
@@ -1226,16 +1225,266 @@ AhciStartCommand (
   Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
   AhciOrReg (AhciController, Offset, EFI_AHCI_PORT_CMD_ST | StartCmd);
 
+  //
+  // Queued commands must be marked active in PxSACT before they are issued.
+  //
+  if (Queued) {
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    AhciWriteReg (AhciController, Offset, SlotMask);
+  }
+
   //
   // Setting the command
   //
   Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
   AhciAndReg (AhciController, Offset, 0);
-  AhciOrReg (AhciController, Offset, CmdSlotBit);
+  AhciOrReg (AhciController, Offset, SlotMask);
 
   return EFI_SUCCESS;
 }
 
+/**
+  Start command for give slot on specific port.
+
+  @param  AhciController              The AHCI controller protocol instance.
+  @param  Port               The number of port.
+  @param  CommandSlot        The number of Command Slot.
+  @param  Timeout            The timeout value of start, uses 100ns as a unit.
+
+  @retval EFI_DEVICE_ERROR   The command start unsuccessfully.
+  @retval EFI_TIMEOUT        The operation is time out.
+  @retval EFI_SUCCESS        The command start successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciStartCommand (
+  IN  EFI_AHCI_CONTROLLER       *AhciController,
+  IN  UINT8                     Port,
+  IN  UINT8                     CommandSlot,
+  IN  UINT64                    Timeout
+  )
+{
+  return AhciStartCommandSlots (AhciController, Port, (UINT32) (1 << CommandSlot), FALSE, Timeout);
+}
+
+/**
+  Fill the command list entry and the NCQ command table of a queued command slot.
+
+  @param[in]  AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]  PortMultiplier      The port multiplier port number.
+  @param[in]  CommandFis          The command FIS of the queued command.
+  @param[in]  CommandSlot         The command slot used for the queued command.
+  @param[in]  DataPhysicalAddr    The bus master address of the data buffer.
+  @param[in]  DataLength          The data count to be transferred.
+
+**/
+STATIC
+VOID
+AhciBuildQueuedCommand (
+  IN  EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN  UINT8                      PortMultiplier,
+  IN  EFI_AHCI_COMMAND_FIS       *CommandFis,
+  IN  UINT8                      CommandSlot,
+  IN  UINT64                     DataPhysicalAddr,
+  IN  UINT32                     DataLength
+  )
+{
+  EFI_AHCI_NCQ_COMMAND_TABLE *CommandTable;
+  EFI_AHCI_COMMAND_LIST      *CommandList;
+  UINT32                     PrdtNumber;
+  UINT32                     PrdtIndex;
+  UINT32                     RemainedData;
+  DATA_64                    Data64;
+
+  PrdtNumber = (UINT32)DivU64x32 (((UINT64)DataLength + EFI_AHCI_MAX_DATA_PER_PRDT - 1), EFI_AHCI_MAX_DATA_PER_PRDT);
+  ASSERT (PrdtNumber <= EFI_AHCI_NCQ_MAX_PRDT);
+
+  CommandTable = &AhciRegisters->AhciNcqCommandTable[CommandSlot];
+  ZeroMem (CommandTable, sizeof (EFI_AHCI_NCQ_COMMAND_TABLE));
+  CommandFis->AhciCFisPmNum = PortMultiplier;
+  CopyMem (&CommandTable->CommandFis, CommandFis, sizeof (EFI_AHCI_COMMAND_FIS));
+
+  RemainedData = DataLength;
+  for (PrdtIndex = 0; PrdtIndex < PrdtNumber; PrdtIndex++) {
+    if (RemainedData < EFI_AHCI_MAX_DATA_PER_PRDT) {
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc = RemainedData - 1;
+    } else {
+      CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbc = EFI_AHCI_MAX_DATA_PER_PRDT - 1;
+    }
+
+    Data64.Uint64 = DataPhysicalAddr;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDba  = Data64.Uint32.Lower32;
+    CommandTable->PrdtTable[PrdtIndex].AhciPrdtDbau = Data64.Uint32.Upper32;
+    RemainedData     -= EFI_AHCI_MAX_DATA_PER_PRDT;
+    DataPhysicalAddr += EFI_AHCI_MAX_DATA_PER_PRDT;
+  }
+
+  CommandList = &AhciRegisters->AhciCmdList[CommandSlot];
+  ZeroMem (CommandList, sizeof (EFI_AHCI_COMMAND_LIST));
+  CommandList->AhciCmdCfl   = EFI_AHCI_FIS_REGISTER_H2D_LENGTH / 4;
+  CommandList->AhciCmdPrdtl = PrdtNumber;
+  CommandList->AhciCmdPmp   = PortMultiplier;
+
+  Data64.Uint64 = (UINT64) (UINTN) &AhciRegisters->AhciNcqCommandTablePciAddr[CommandSlot];
+  CommandList->AhciCmdCtba  = Data64.Uint32.Lower32;
+  CommandList->AhciCmdCtbau = Data64.Uint32.Upper32;
+}
+
+/**
+  Start a batch of READ FPDMA QUEUED commands on specific port and wait for
+  all of them to complete.
+
+  Command N of the batch is issued through command slot N with tag N. The data
+  of all commands is placed back to back in MemoryAddr. Completion is detected
+  by polling PxSACT and PxCI for the whole batch.
+
+  @param[in]       AhciController      The AHCI controller instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The port multiplier port number.
+  @param[in]       AtaCommandBlocks    The EFI_ATA_COMMAND_BLOCK data of each command.
+                                       Sector count and LBA must be filled in the
+                                       FPDMA QUEUED format.
+  @param[in]       DataCounts          The data count to be transferred by each command.
+  @param[in]       CommandCount        The number of commands in the batch.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       Timeout             The timeout value of the batch, uses 100ns as a unit.
+
+  @retval EFI_INVALID_PARAMETER  The batch does not fit into the NCQ command slots.
+  @retval EFI_OUT_OF_RESOURCES   The data buffer could not be mapped.
+  @retval EFI_DEVICE_ERROR       The DMA data transfer abort with error occurs.
+  @retval EFI_TIMEOUT            The operation is time out.
+  @retval EFI_SUCCESS            All queued commands executed successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciQueuedDmaRead (
+  IN     EFI_AHCI_CONTROLLER        *AhciController,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      PortMultiplier,
+  IN     EFI_ATA_COMMAND_BLOCK      *AtaCommandBlocks,
+  IN     UINT32                     *DataCounts,
+  IN     UINT8                      CommandCount,
+  IN OUT VOID                       *MemoryAddr,
+  IN     UINT64                     Timeout
+  )
+{
+  EFI_STATUS                    Status;
+  EFI_PHYSICAL_ADDRESS          PhyAddr;
+  EFI_AHCI_COMMAND_FIS          CFis;
+  UINTN                         MapLength;
+  UINTN                         DataLength;
+  VOID                          *MapData;
+  UINT32                        SlotMask;
+  UINT32                        PortIs;
+  UINT32                        Pending;
+  UINT32                        Offset;
+  UINT64                        Delay;
+  UINT8                         Slot;
+
+  if ((AhciController == NULL) || (AhciRegisters->AhciNcqCommandTable == NULL) ||
+      (CommandCount == 0) || (CommandCount > AhciRegisters->MaxCommandSlotNumber)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  DataLength = 0;
+  for (Slot = 0; Slot < CommandCount; Slot++) {
+    DataLength += DataCounts[Slot];
+  }
+
+  //
+  // Map the whole batch at once, each slot points into its own part of it.
+  //
+  MapData   = NULL;
+  MapLength = DataLength;
+  Status    = IoMmuMap (
+                EdkiiIoMmuOperationBusMasterWrite,
+                MemoryAddr,
+                &MapLength,
+                &PhyAddr,
+                &MapData
+                );
+  if (EFI_ERROR (Status) || (MapLength != DataLength)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ZeroMem ((UINT8 *)AhciRegisters->AhciRFis + sizeof (EFI_AHCI_RECEIVED_FIS) * Port, sizeof (EFI_AHCI_RECEIVED_FIS));
+  Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CMD;
+  AhciAndReg (AhciController, Offset, (UINT32)~ (EFI_AHCI_PORT_CMD_DLAE | EFI_AHCI_PORT_CMD_ATAPI));
+
+  SlotMask = 0;
+  for (Slot = 0; Slot < CommandCount; Slot++) {
+    AhciBuildCommandFis (&CFis, &AtaCommandBlocks[Slot]);
+    //
+    // The NCQ tag goes into Count[7:3], Device[7] is the FUA bit.
+    //
+    CFis.AhciCFisSecCount = (UINT8) (Slot << 3);
+    CFis.AhciCFisDevHead  = BIT6;
+    AhciBuildQueuedCommand (AhciRegisters, PortMultiplier, &CFis, Slot, PhyAddr, DataCounts[Slot]);
+    PhyAddr  += DataCounts[Slot];
+    SlotMask |= BIT0 << Slot;
+  }
+
+  Status = AhciStartCommandSlots (AhciController, Port, SlotMask, TRUE, Timeout);
+  if (EFI_ERROR (Status)) {
+    goto Exit;
+  }
+
+  //
+  // Poll until the device has cleared all tags in PxSACT through Set Device
+  // Bits FIS and the HBA has fetched all commands from PxCI.
+  //
+  Status = EFI_TIMEOUT;
+  Delay  = DivU64x32 (Timeout, 1000) + 1;
+  do {
+    Offset = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_IS;
+    PortIs = AhciReadReg (AhciController, Offset);
+    if ((PortIs & (EFI_AHCI_PORT_IS_TFES | EFI_AHCI_PORT_IS_HBFS | EFI_AHCI_PORT_IS_HBDS | EFI_AHCI_PORT_IS_IFS)) != 0) {
+      Status = EFI_DEVICE_ERROR;
+      break;
+    }
+
+    Offset  = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_SACT;
+    Pending = AhciReadReg (AhciController, Offset);
+    Offset  = EFI_AHCI_PORT_START + Port * EFI_AHCI_PORT_REG_WIDTH + EFI_AHCI_PORT_CI;
+    Pending |= AhciReadReg (AhciController, Offset);
+    if ((Pending & SlotMask) == 0) {
+      Status = EFI_SUCCESS;
+      break;
+    }
+
+    //
+    // Stall for 100 microseconds.
+    //
+    MicroSecondDelay (100);
+
+    Delay--;
+  } while ((Timeout == 0) || (Delay > 0));
+
+Exit:
+  AhciStopCommand (
+    AhciController,
+    Port,
+    Timeout
+    );
+
+  AhciDisableFisReceive (
+    AhciController,
+    Port,
+    Timeout
+    );
+
+  if (MapData != NULL) {
+    IoMmuUnmap (MapData);
+  }
+
+  AhciDumpPortStatus (AhciController, AhciRegisters, Port, NULL);
+  return Status;
+}
+
 /**
   Do AHCI port reset.
 
@@ -1874,6 +2123,34 @@ AhciCreateTransferDescriptor (
     goto Error1;
   }
   AhciRegisters->AhciCommandTablePciAddr = (EFI_AHCI_COMMAND_TABLE *) (UINTN)AhciCommandTablePciAddr;
+  AhciRegisters->MaxCommandSlotNumber    = MaxCommandSlotNumber;
+
+  //
+  // Allocate one small command table per command slot for native command
+  // queuing. NCQ is simply not used if the HBA does not support it or the
+  // allocation fails.
+  //
+  if ((Capability & EFI_AHCI_CAP_SNCQ) != 0) {
+    Buffer = NULL;
+    MaxCommandTableSize = MaxCommandSlotNumber * sizeof (EFI_AHCI_NCQ_COMMAND_TABLE);
+    Status = IoMmuAllocateBuffer (
+               EFI_SIZE_TO_PAGES (MaxCommandTableSize),
+               &Buffer,
+               &DeviceAddress,
+               &Mapping
+               );
+    if (!EFI_ERROR (Status) && (Buffer != NULL)) {
+      if ((!Support64Bit) && ((EFI_PHYSICAL_ADDRESS) (UINTN)Buffer > 0x100000000ULL)) {
+        IoMmuFreeBuffer (EFI_SIZE_TO_PAGES (MaxCommandTableSize), Buffer, Mapping);
+      } else {
+        ZeroMem (Buffer, (UINTN)MaxCommandTableSize);
+        AhciRegisters->AhciNcqCommandTable        = Buffer;
+        AhciRegisters->AhciNcqCommandTableMap     = Mapping;
+        AhciRegisters->AhciNcqCommandTablePciAddr = (EFI_AHCI_NCQ_COMMAND_TABLE *) (UINTN)Buffer;
+        AhciRegisters->MaxNcqCommandTableSize     = MaxCommandTableSize;
+      }
+    }
+  }
 
   return EFI_SUCCESS;
 
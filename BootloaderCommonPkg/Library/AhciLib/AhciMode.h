@@ -13,6 +13,7 @@
 #define EFI_AHCI_CAPABILITY_OFFSET             0x0000
 #define   EFI_AHCI_CAP_SAM                     BIT18
 #define   EFI_AHCI_CAP_SSS                     BIT27
+#define   EFI_AHCI_CAP_SNCQ                    BIT30
 #define   EFI_AHCI_CAP_S64A                    BIT31
 #define EFI_AHCI_GHC_OFFSET                    0x0004
 #define   EFI_AHCI_GHC_RESET                   BIT0
@@ -22,6 +23,7 @@
 #define EFI_AHCI_PI_OFFSET                     0x000C
 
 #define EFI_AHCI_MAX_PORTS                     32
+#define EFI_AHCI_MAX_COMMAND_SLOTS             32
 
 typedef struct {
   UINT32  Lower32;
@@ -273,7 +275,10 @@ typedef struct {
   UINT16  Rec_multi_word_dma_cycle_time;
   UINT16  Min_pio_cycle_time_without_flow_control;
   UINT16  Min_pio_cycle_time_with_flow_control;
-  UINT16  Reserved_69_79[11];
+  UINT16  Reserved_69_74[6];
+  UINT16  Queue_depth; // word 75
+  UINT16  Serial_ata_capabilities; // word 76
+  UINT16  Reserved_77_79[3];
   UINT16  Major_version_no;
   UINT16  Minor_version_no;
   UINT16  Command_set_supported_82; // word 82
@@ -480,6 +485,19 @@ typedef struct {
   EFI_AHCI_COMMAND_PRDT     PrdtTable[65535];     // The scatter/gather list for data transfer
 } EFI_AHCI_COMMAND_TABLE;
 
+//
+// Command table used by each slot of a queued (NCQ) transfer. Its PRD table
+// only covers the largest transfer issued through a single queued command.
+//
+#define EFI_AHCI_NCQ_MAX_PRDT                  8
+
+typedef struct {
+  EFI_AHCI_COMMAND_FIS      CommandFis;
+  EFI_AHCI_ATAPI_COMMAND    AtapiCmd;
+  UINT8                     Reserved[0x30];
+  EFI_AHCI_COMMAND_PRDT     PrdtTable[EFI_AHCI_NCQ_MAX_PRDT];
+} EFI_AHCI_NCQ_COMMAND_TABLE;
+
 //
 // Received FIS structure
 //
@@ -520,6 +538,11 @@ typedef struct {
   UINT32                    MaxCommandListSize;
   UINT32                    MaxCommandTableSize;
   UINT32                    MaxReceiveFisSize;
+  EFI_AHCI_NCQ_COMMAND_TABLE *AhciNcqCommandTable;
+  VOID                      *AhciNcqCommandTableMap;
+  EFI_AHCI_NCQ_COMMAND_TABLE *AhciNcqCommandTablePciAddr;
+  UINT32                    MaxNcqCommandTableSize;
+  UINT8                     MaxCommandSlotNumber;
 } EFI_AHCI_REGISTERS;
 
 typedef struct {
@@ -654,6 +677,67 @@ AhciDmaTransfer (
   IN     UINT64                     Timeout
   );
 
+/**
+  Start a batch of READ FPDMA QUEUED commands on specific port and wait for
+  all of them to complete.
+
+  Command N of the batch is issued through command slot N with tag N. The data
+  of all commands is placed back to back in MemoryAddr. Completion is detected
+  by polling PxSACT and PxCI for the whole batch.
+
+  @param[in]       AhciController      The AHCI controller instance.
+  @param[in]       AhciRegisters       The pointer to the EFI_AHCI_REGISTERS.
+  @param[in]       Port                The number of port.
+  @param[in]       PortMultiplier      The port multiplier port number.
+  @param[in]       AtaCommandBlocks    The EFI_ATA_COMMAND_BLOCK data of each command.
+                                       Sector count and LBA must be filled in the
+                                       FPDMA QUEUED format.
+  @param[in]       DataCounts          The data count to be transferred by each command.
+  @param[in]       CommandCount        The number of commands in the batch.
+  @param[in, out]  MemoryAddr          The pointer to the data buffer.
+  @param[in]       Timeout             The timeout value of the batch, uses 100ns as a unit.
+
+  @retval EFI_INVALID_PARAMETER  The batch does not fit into the NCQ command slots.
+  @retval EFI_OUT_OF_RESOURCES   The data buffer could not be mapped.
+  @retval EFI_DEVICE_ERROR       The DMA data transfer abort with error occurs.
+  @retval EFI_TIMEOUT            The operation is time out.
+  @retval EFI_SUCCESS            All queued commands executed successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciQueuedDmaRead (
+  IN     EFI_AHCI_CONTROLLER        *AhciController,
+  IN     EFI_AHCI_REGISTERS         *AhciRegisters,
+  IN     UINT8                      Port,
+  IN     UINT8                      PortMultiplier,
+  IN     EFI_ATA_COMMAND_BLOCK      *AtaCommandBlocks,
+  IN     UINT32                     *DataCounts,
+  IN     UINT8                      CommandCount,
+  IN OUT VOID                       *MemoryAddr,
+  IN     UINT64                     Timeout
+  );
+
+/**
+  Do AHCI port reset.
+
+  @param  AhciController     The AHCI controller protocol instance.
+  @param  Port               The number of port.
+  @param  Timeout            The timeout value of reset, uses 100ns as a unit.
+
+  @retval EFI_DEVICE_ERROR   The port reset unsuccessfully
+  @retval EFI_TIMEOUT        The reset operation is time out.
+  @retval EFI_SUCCESS        The port reset successfully.
+
+**/
+EFI_STATUS
+EFIAPI
+AhciPortReset (
+  IN  EFI_AHCI_CONTROLLER       *AhciController,
+  IN  UINT8                     Port,
+  IN  UINT64                    Timeout
+  );
+
 /**
   Do AHCI HBA reset.
 
@@ -45,7 +45,13 @@ CpuHalt (
     SerialPortWrite ((UINT8 *)LogBufHdr->Buffer, LogBufHdr->UsedLength - LogBufHdr->HeaderLength);
   }
 
-  CpuDeadLoop ();
+  // Keep sending out the deferred serial output while halted, without
+  // waiting for other processors that may be sending it too
+  while (TRUE) {
+    if (DebugLogBufferPoll () == 0) {
+      CpuPause ();
+    }
+  }
 }
 
 /**
@@ -81,6 +81,12 @@ DebugPrint (
   }
 
   OutputToSerial = (PcdGet32 (PcdDebugOutputDeviceMask) & DEBUG_OUTPUT_DEVICE_SERIAL_PORT) ? TRUE : FALSE;
+
+  // Serial output is deferred, DebugLogBufferFlush() sends it out later.
+  if ((PcdGet32 (PcdDebugOutputDeviceMask) & (DEBUG_OUTPUT_DEVICE_SERIAL_DEFERRED | DEBUG_OUTPUT_DEVICE_LOG_BUFFER)) ==
+      (DEBUG_OUTPUT_DEVICE_SERIAL_DEFERRED | DEBUG_OUTPUT_DEVICE_LOG_BUFFER)) {
+    OutputToSerial = FALSE;
+  }
   if (PcdGet32 (PcdDebugOutputDeviceMask) & DEBUG_OUTPUT_DEVICE_CONSOLE) {
     ConsoleWrite ((UINT8 *)Buffer, Length);
 
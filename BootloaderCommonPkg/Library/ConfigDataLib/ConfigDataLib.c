@@ -10,6 +10,90 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #include <Library/ConfigDataLib.h>
 #include <Library/BaseMemoryLib.h>
 
+/**
+  Get the tag index for the configuration database.
+
+  @param[in] CdataBlob   Configuration data blob pointer.
+
+  @retval             Configuration data index pointer.
+                      NULL if the index does not exist or is out of date.
+
+**/
+STATIC
+CDATA_INDEX *
+GetConfigDataIndex (
+  IN  CDATA_BLOB      *CdataBlob
+  )
+{
+  CDATA_INDEX         *CdataIdx;
+
+  if ((CdataBlob->TotalLength < CdataBlob->UsedLength + sizeof (CDATA_INDEX)) || ((CdataBlob->UsedLength & 3) != 0)) {
+    return NULL;
+  }
+
+  CdataIdx = (CDATA_INDEX *) ((UINT8 *)CdataBlob + CdataBlob->UsedLength);
+  if ((CdataIdx->Signature != CFG_INDEX_SIGNATURE) ||
+      (CdataIdx->UsedLength != CdataBlob->UsedLength) ||
+      (CdataIdx->InternalDataOffset != CdataBlob->ExtraInfo.InternalDataOffset) ||
+      (CdataBlob->TotalLength - CdataBlob->UsedLength < sizeof (CDATA_INDEX) + CdataIdx->EntryCount * sizeof (CDATA_INDEX_ENTRY))) {
+    return NULL;
+  }
+
+  return CdataIdx;
+}
+
+/**
+  Find configuration data index entry by its tag and platform ID mask.
+
+  @param[in] CdataIdx    Configuration data index pointer.
+  @param[in] PidMask     Platform ID mask.
+  @param[in] Tag         Configuration TAG ID to find.
+  @param[in] MinOffset   Minimum item offset in DWORD to search from.
+
+  @retval             Configuration data index entry pointer.
+                      NULL if the tag cannot be found.
+
+**/
+STATIC
+CDATA_INDEX_ENTRY *
+FindConfigIndexEntry (
+  IN  CDATA_INDEX     *CdataIdx,
+  IN  UINT32           PidMask,
+  IN  UINT32           Tag,
+  IN  UINT32           MinOffset
+  )
+{
+  CDATA_INDEX_ENTRY   *Entry;
+  UINT32               Low;
+  UINT32               High;
+  UINT32               Mid;
+
+  // Locate the first entry with the given tag
+  Low  = 0;
+  High = CdataIdx->EntryCount;
+  while (Low < High) {
+    Mid = (Low + High) >> 1;
+    if (CdataIdx->Entry[Mid].Tag < Tag) {
+      Low  = Mid + 1;
+    } else {
+      High = Mid;
+    }
+  }
+
+  // Entries with the same tag are kept in the data blob order
+  for (; Low < CdataIdx->EntryCount; Low++) {
+    Entry = &CdataIdx->Entry[Low];
+    if (Entry->Tag != Tag) {
+      break;
+    }
+    if ((Entry->Offset >= MinOffset) && ((Entry->PidMask & PidMask) != 0)) {
+      return Entry;
+    }
+  }
+
+  return NULL;
+}
+
 /**
   Find configuration data header by its tag and platform ID.
 
@@ -32,6 +116,8 @@ FindConfigHdrByPidMaskTag (
 {
   CDATA_BLOB          *CdataBlob;
   CDATA_HEADER        *CdataHdr;
+  CDATA_INDEX         *CdataIdx;
+  CDATA_INDEX_ENTRY   *Entry;
   UINT8                Idx;
   REFERENCE_CFG_DATA  *Refer;
   UINT32               Offset;
@@ -39,6 +125,21 @@ FindConfigHdrByPidMaskTag (
   CdataBlob = (CDATA_BLOB *) GetConfigDataPtr ();
   Offset    = IsInternal > 0 ? (CdataBlob->ExtraInfo.InternalDataOffset * 4) : CdataBlob->HeaderLength;
 
+  CdataIdx  = GetConfigDataIndex (CdataBlob);
+  if (CdataIdx != NULL) {
+    Entry = FindConfigIndexEntry (CdataIdx, PidMask, Tag, Offset >> 2);
+    if (Entry == NULL) {
+      return NULL;
+    }
+    if ((Entry->Flags & CDATA_FLAG_TYPE_MASK) == CDATA_FLAG_TYPE_REFER) {
+      if ((Level > 0) || (Entry->ReferOffset == 0)) {
+        return NULL;
+      }
+      return (CDATA_HEADER *) ((UINT8 *)CdataBlob + (Entry->ReferOffset << 2));
+    }
+    return (CDATA_HEADER *) ((UINT8 *)CdataBlob + (Entry->Offset << 2));
+  }
+
   while (Offset < CdataBlob->UsedLength) {
     CdataHdr = (CDATA_HEADER *) ((UINT8 *)CdataBlob + Offset);
     if (CdataHdr->Tag == Tag) {
@@ -66,6 +167,103 @@ FindConfigHdrByPidMaskTag (
   return NULL;
 }
 
+/**
+  Build the tag index for the configuration database.
+
+  The index is sorted by tag and keeps the database order for the items
+  sharing the same tag. Reference items are resolved while building the
+  index, so a lookup does not need to walk the data blob any more.
+
+  @retval EFI_SUCCESS           The index was built successfully.
+  @retval EFI_NOT_FOUND         The configuration database is not available.
+  @retval EFI_BUFFER_TOO_SMALL  No enough free space in the database to hold the index.
+
+**/
+EFI_STATUS
+EFIAPI
+BuildConfigDataIndex (
+  VOID
+  )
+{
+  CDATA_BLOB          *CdataBlob;
+  CDATA_HEADER        *CdataHdr;
+  CDATA_INDEX         *CdataIdx;
+  CDATA_INDEX_ENTRY   *Entry;
+  CDATA_INDEX_ENTRY   *Target;
+  CDATA_INDEX_ENTRY    Temp;
+  REFERENCE_CFG_DATA  *Refer;
+  UINT32               Offset;
+  UINT32               Count;
+  UINT32               Index;
+  UINT32               Index2;
+  UINT32               MinOffset;
+
+  CdataBlob = (CDATA_BLOB *) GetConfigDataPtr ();
+  if ((CdataBlob == NULL) || (CdataBlob->Signature != CFG_DATA_SIGNATURE) || ((CdataBlob->UsedLength & 3) != 0)) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (CdataBlob->TotalLength < CdataBlob->UsedLength + sizeof (CDATA_INDEX)) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  CdataIdx = (CDATA_INDEX *) ((UINT8 *)CdataBlob + CdataBlob->UsedLength);
+  CdataIdx->Signature = 0;
+
+  // Collect all items, sorted by tag using insertion sort to keep the blob order
+  Count  = 0;
+  Offset = CdataBlob->HeaderLength;
+  while (Offset < CdataBlob->UsedLength) {
+    CdataHdr = (CDATA_HEADER *) ((UINT8 *)CdataBlob + Offset);
+    if ((CdataHdr->Length == 0) || ((Offset >> 2) > MAX_UINT16)) {
+      return EFI_NOT_FOUND;
+    }
+    if (CdataBlob->TotalLength - CdataBlob->UsedLength < sizeof (CDATA_INDEX) + (Count + 1) * sizeof (CDATA_INDEX_ENTRY)) {
+      return EFI_BUFFER_TOO_SMALL;
+    }
+
+    Temp.Tag         = (UINT16)CdataHdr->Tag;
+    Temp.Offset      = (UINT16)(Offset >> 2);
+    Temp.ReferOffset = 0;
+    Temp.Flags       = (UINT16)CdataHdr->Flags;
+    Temp.PidMask     = 0;
+    for (Index = 0; Index < CdataHdr->ConditionNum; Index++) {
+      Temp.PidMask  |= CdataHdr->Condition[Index].Value;
+    }
+
+    for (Index = Count; (Index > 0) && (CdataIdx->Entry[Index - 1].Tag > Temp.Tag); Index--) {
+      CopyMem (&CdataIdx->Entry[Index], &CdataIdx->Entry[Index - 1], sizeof (CDATA_INDEX_ENTRY));
+    }
+    CopyMem (&CdataIdx->Entry[Index], &Temp, sizeof (CDATA_INDEX_ENTRY));
+    Count++;
+
+    Offset += (CdataHdr->Length << 2);
+  }
+  CdataIdx->EntryCount = (UINT16)Count;
+
+  // Resolve reference items, only one level of reference is allowed
+  for (Index = 0; Index < Count; Index++) {
+    Entry = &CdataIdx->Entry[Index];
+    if ((Entry->Flags & CDATA_FLAG_TYPE_MASK) != CDATA_FLAG_TYPE_REFER) {
+      continue;
+    }
+    CdataHdr  = (CDATA_HEADER *) ((UINT8 *)CdataBlob + (Entry->Offset << 2));
+    Refer     = (REFERENCE_CFG_DATA *) ((UINT8 *)CdataHdr + sizeof (CDATA_HEADER) + sizeof (CDATA_COND) * CdataHdr->ConditionNum);
+    MinOffset = (Refer->IsInternal != 0) ? CdataBlob->ExtraInfo.InternalDataOffset : (CdataBlob->HeaderLength >> 2);
+    Target    = FindConfigIndexEntry (CdataIdx, PID_TO_MASK (Refer->PlatformId), Refer->Tag, MinOffset);
+    if ((Target != NULL) && ((Target->Flags & CDATA_FLAG_TYPE_MASK) != CDATA_FLAG_TYPE_REFER)) {
+      Entry->ReferOffset = Target->Offset;
+    }
+  }
+
+  // Stamp the index with the current blob layout
+  CdataIdx->InternalDataOffset = CdataBlob->ExtraInfo.InternalDataOffset;
+  CdataIdx->UsedLength         = CdataBlob->UsedLength;
+  CdataIdx->Signature          = CFG_INDEX_SIGNATURE;
+
+  return EFI_SUCCESS;
+}
+
 /**
   Find configuration data header by its tag.
 
@@ -169,6 +367,7 @@ AddConfigData (
   CDATA_BLOB               *LdrCfgBlob;
   CDATA_BLOB               *CfgAddBlob;
   INT32                    CfgAddSize;
+  BOOLEAN                  HasIndex;
 
   LdrCfgBlob = (CDATA_BLOB *) GetConfigDataPtr ();
   CfgAddBlob = (CDATA_BLOB *) CfgAddPtr;
@@ -183,6 +382,8 @@ AddConfigData (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  HasIndex = (GetConfigDataIndex (LdrCfgBlob) != NULL);
+
   if (LdrCfgBlob->ExtraInfo.InternalDataOffset == 0) {
     // Append new config data before internal config data is available.
     CopyMem ((UINT8 *)LdrCfgBlob + LdrCfgBlob->UsedLength,
@@ -205,6 +406,11 @@ AddConfigData (
   }
   LdrCfgBlob->UsedLength += CfgAddSize;
 
+  // The new data overwrote the old index, rebuild it if it existed
+  if (HasIndex) {
+    BuildConfigDataIndex ();
+  }
+
   return EFI_SUCCESS;
 }
 
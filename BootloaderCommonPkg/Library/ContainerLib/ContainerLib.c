@@ -17,12 +17,44 @@
 #include <Library/CryptoLib.h>
 #include <Library/SecureBootLib.h>
 #include <Library/DecompressLib.h>
+#include <Library/LoaderPerformanceLib.h>
+#include <Service/MpService.h>
+#include <IndustryStandard/Tpm20.h>
+#include "ImageCache.h"
 
 #define  TEMP_BUF_ALIGN    0x10
 #define  AUTH_DATA_ALIGN   0x04
+#define  STREAM_CHUNK_SIZE 0x8000
 
 #define  IS_FLASH_ADDRESS(x)   (((UINT32)(UINTN)(x)) >= 0xF0000000)
 
+#define  COMPONENT_LOAD_BATCH_MAX    8
+
+typedef struct {
+  UINT32                    ComponentId;
+  UINT32                    Usage;
+  UINT8                     AuthType;
+  HASH_ALG_TYPE             HashAlg;
+  BOOLEAN                   DigestValid;
+  HASH_ALG_TYPE             MbHashAlg;
+  BOOLEAN                   MbDigestValid;
+  UINT8                    *HashData;
+  UINT8                    *AuthData;
+  UINT8                    *CompBuf;
+  UINT32                    SignedDataLen;
+  VOID                     *AllocBuf;
+  VOID                     *ScrBuf;
+  VOID                     *CompBase;
+  VOID                     *ReqCompBase;
+  UINT32                    DecompressedLen;
+  EFI_STATUS                Status;
+  UINT8                     Digest[HASH_DIGEST_MAX];
+  UINT8                     MbDigest[HASH_DIGEST_MAX];
+  BOOLEAN                   Cached;
+  HASH_ALG_TYPE             CacheHashAlg;
+  UINT8                    *CacheDigest;
+} COMPONENT_LOAD_CTX;
+
 /**
   Get the container pointer by the container signature
 
@@ -274,6 +306,7 @@ GetHashAlg(
   @param[in] AuthData     Authentication data buffer.
   @param[in] HashData     Hash data buffer.
   @param[in] Usage        Hash usage.
+  @param[in] Digest       Pre-calculated digest of Data, or NULL to hash Data here.
 
   @retval EFI_UNSUPPORTED          Unsupported AuthType.
   @retval EFI_SECURITY_VIOLATION   Authentication failed.
@@ -288,7 +321,8 @@ AuthenticateComponent (
   IN  UINT8     AuthType,
   IN  UINT8    *AuthData,
   IN  UINT8    *HashData,
-  IN  UINT32    Usage
+  IN  UINT32    Usage,
+  IN  UINT8    *Digest    OPTIONAL
   )
 {
   EFI_STATUS  Status;
@@ -299,7 +333,11 @@ AuthenticateComponent (
   if (!FeaturePcdGet (PcdVerifiedBootEnabled)) {
     Status = EFI_SUCCESS;
   } else {
-    if (AuthType == AUTH_TYPE_SHA2_256) {
+    if ((Digest != NULL) && (AuthType == AUTH_TYPE_SHA2_256)) {
+      Status = DoDigestVerify (Digest, Usage, HASH_TYPE_SHA256, HashData);
+    } else if ((Digest != NULL) && (AuthType == AUTH_TYPE_SHA2_384)) {
+      Status = DoDigestVerify (Digest, Usage, HASH_TYPE_SHA384, HashData);
+    } else if (AuthType == AUTH_TYPE_SHA2_256) {
       Status = DoHashVerify (Data, Length, Usage, HASH_TYPE_SHA256, HashData);
     } else if (AuthType == AUTH_TYPE_SHA2_384) {
       Status = DoHashVerify (Data, Length, Usage, HASH_TYPE_SHA384, HashData);
@@ -308,8 +346,13 @@ AuthenticateComponent (
       SigPtr   = (UINT8 *) AuthData;
       SignHdr  = (SIGNATURE_HDR *) SigPtr;
       KeyPtr   = (UINT8 *)SignHdr + sizeof(SIGNATURE_HDR) + SignHdr->SigSize ;
-      Status   = DoRsaVerify (Data, Length, Usage, SignHdr,
-                             (PUB_KEY_HDR *) KeyPtr, GetHashAlg(AuthType), HashData, NULL);
+      if ((Digest != NULL) && (SignHdr->SigType == SIGNING_TYPE_RSA_PKCS_1_5)) {
+        Status = DoRsaVerifyDigest (Digest, Usage, SignHdr,
+                                    (PUB_KEY_HDR *) KeyPtr, GetHashAlg(AuthType), HashData);
+      } else {
+        Status = DoRsaVerify (Data, Length, Usage, SignHdr,
+                              (PUB_KEY_HDR *) KeyPtr, GetHashAlg(AuthType), HashData, NULL);
+      }
     } else if (AuthType == AUTH_TYPE_NONE) {
       Status = EFI_SUCCESS;
     } else {
@@ -320,6 +363,395 @@ AuthenticateComponent (
   return Status;
 }
 
+/**
+  Get the hash algorithm that can be calculated while a component is copied.
+
+  Only the hash based and RSA PKCS1-v1_5 authentication types can be verified
+  against a pre-calculated digest. RSA PSS needs the whole message again, so
+  no digest is calculated for it during the copy.
+
+  @param[in] AuthType     Authentication type.
+  @param[in] AuthData     Authentication data buffer.
+
+  @retval    Hash algorithm to use, or HASH_TYPE_NONE if not applicable.
+
+**/
+STATIC
+HASH_ALG_TYPE
+GetStreamHashAlg (
+  IN  UINT8    AuthType,
+  IN  UINT8   *AuthData
+  )
+{
+  SIGNATURE_HDR            *SignHdr;
+
+  if (!FeaturePcdGet (PcdVerifiedBootEnabled)) {
+    return HASH_TYPE_NONE;
+  }
+
+  if ((AuthType == AUTH_TYPE_SHA2_256) || (AuthType == AUTH_TYPE_SHA2_384)) {
+    return GetHashAlg (AuthType);
+  }
+
+  if ((AuthType == AUTH_TYPE_SIG_RSA2048_PKCSI1_SHA256) || (AuthType == AUTH_TYPE_SIG_RSA3072_PKCSI1_SHA384)) {
+    SignHdr = (SIGNATURE_HDR *) AuthData;
+    if ((SignHdr->Identifier == SIGNATURE_IDENTIFIER) && (SignHdr->SigType == SIGNING_TYPE_RSA_PKCS_1_5)) {
+      return SignHdr->HashAlg;
+    }
+  }
+
+  return HASH_TYPE_NONE;
+}
+
+/**
+  Get the hash algorithm used by measured boot for a component.
+
+  Only the components extended into the TPM by the stage callbacks need a
+  measured boot digest, and only when measured boot is enabled at runtime.
+
+  @param[in] ContainerSig    Container signature or component type.
+
+  @retval    Hash algorithm to measure the component, or HASH_TYPE_NONE if not applicable.
+
+**/
+STATIC
+HASH_ALG_TYPE
+GetMeasureHashAlg (
+  IN  UINT32   ContainerSig
+  )
+{
+  UINT32     HashMask;
+
+  if (!FeaturePcdGet (PcdMeasuredBootEnabled) || ((GetFeatureCfg () & FEATURE_MEASURED_BOOT) == 0)) {
+    return HASH_TYPE_NONE;
+  }
+
+  if ((ContainerSig != COMP_TYPE_STAGE_2) && (ContainerSig != COMP_TYPE_PAYLOAD) &&
+      (ContainerSig != COMP_TYPE_PAYLOAD_FWU) && (ContainerSig != FLASH_MAP_SIG_EPAYLOAD) &&
+      (ContainerSig != CONTAINER_BOOT_SIGNATURE)) {
+    return HASH_TYPE_NONE;
+  }
+
+  HashMask = PcdGet32 (PcdMeasuredBootHashMask);
+  if (HashMask == HASH_ALG_SHA256) {
+    return HASH_TYPE_SHA256;
+  } else if (HashMask == HASH_ALG_SHA384) {
+    return HASH_TYPE_SHA384;
+  } else if (HashMask == HASH_ALG_SM3_256) {
+    return HASH_TYPE_SM3;
+  }
+
+  return HASH_TYPE_NONE;
+}
+
+/**
+  Get the extra hash algorithm to calculate for measured boot.
+
+  The measured boot digest is only needed when it cannot be taken from the
+  component entry or from the authentication digest.
+
+  @param[in] Ctx          Component load context.
+
+  @retval    Extra hash algorithm, or HASH_TYPE_NONE if not required.
+
+**/
+STATIC
+HASH_ALG_TYPE
+GetExtraHashAlg (
+  IN  COMPONENT_LOAD_CTX   *Ctx
+  )
+{
+  if (Ctx->MbHashAlg == Ctx->HashAlg) {
+    return HASH_TYPE_NONE;
+  }
+  return Ctx->MbHashAlg;
+}
+
+/**
+  Get the measured boot digest calculated while loading a component.
+
+  @param[in] Ctx          Component load context.
+
+  @retval    Digest for Ctx->MbHashAlg, or NULL if it is not available.
+
+**/
+STATIC
+UINT8 *
+GetMeasureDigest (
+  IN  COMPONENT_LOAD_CTX   *Ctx
+  )
+{
+  if (Ctx->MbHashAlg == HASH_TYPE_NONE) {
+    return NULL;
+  }
+
+  if ((Ctx->MbHashAlg == Ctx->HashAlg) && Ctx->DigestValid) {
+    return Ctx->Digest;
+  }
+
+  return Ctx->MbDigestValid ? Ctx->MbDigest : NULL;
+}
+
+/**
+  Copy a component into memory and hash it on the fly.
+
+  The data is copied in small chunks and each chunk is hashed right after
+  it lands in memory, while it is still cache resident. The digests always
+  cover the memory copy rather than the source. The authentication digest
+  and the measured boot digest are calculated in the same pass.
+
+  @param[in,out] Ctx      Component load context. CompBuf, SignedDataLen,
+                          HashAlg and MbHashAlg must be set.
+  @param[in]     Src      Source buffer.
+
+**/
+STATIC
+VOID
+CopyAndHashComponent (
+  IN OUT COMPONENT_LOAD_CTX   *Ctx,
+  IN     UINT8                *Src
+  )
+{
+  RETURN_STATUS       Status;
+  HASH_MULTI_CTX      MultiCtx;
+  HASH_ALG_TYPE       HashAlg[2];
+  UINT8               Digest[2 * HASH_DIGEST_MAX];
+  UINT8              *Dst;
+  UINT32              Length;
+  UINT32              Offset;
+  UINT32              ChunkLen;
+
+  Dst    = Ctx->CompBuf;
+  Length = Ctx->SignedDataLen;
+
+  HashAlg[0] = Ctx->HashAlg;
+  HashAlg[1] = GetExtraHashAlg (Ctx);
+  Status = CalculateMultiHashInit (&MultiCtx, HashAlg, 2);
+  if (RETURN_ERROR (Status)) {
+    CopyMem (Dst, Src, Length);
+    return;
+  }
+
+  for (Offset = 0; Offset < Length; Offset += ChunkLen) {
+    ChunkLen = MIN (Length - Offset, STREAM_CHUNK_SIZE);
+    CopyMem (Dst + Offset, Src + Offset, ChunkLen);
+    CalculateMultiHashUpdate (&MultiCtx, Dst + Offset, ChunkLen);
+  }
+
+  CalculateMultiHashFinal (&MultiCtx, Digest);
+  if (MultiCtx.Stream[0].HashAlg != HASH_TYPE_NONE) {
+    CopyMem (Ctx->Digest, Digest, HASH_DIGEST_MAX);
+    Ctx->DigestValid = TRUE;
+  }
+  if (MultiCtx.Stream[1].HashAlg != HASH_TYPE_NONE) {
+    CopyMem (Ctx->MbDigest, Digest + HASH_DIGEST_MAX, HASH_DIGEST_MAX);
+    Ctx->MbDigestValid = TRUE;
+  }
+}
+
+/**
+  Start staging a flash map component into memory ahead of its load.
+
+  Only the signed part of the component is staged. If Buffer is smaller than
+  it, staging stops when Buffer is full and resumes after the context has been
+  relocated into a large enough buffer.
+
+  @param[out]    StageCtx        Stage context to initialize.
+  @param[in]     ComponentType   Component type.
+  @param[in]     ComponentName   Component name.
+  @param[in]     Buffer          Staging buffer.
+  @param[in]     BufferSize      Staging buffer size.
+
+  @retval EFI_INVALID_PARAMETER    Invalid parameters.
+  @retval EFI_UNSUPPORTED          The component cannot be staged.
+  @retval EFI_NOT_FOUND            Cannot locate component.
+  @retval EFI_SUCCESS              The stage context is ready.
+
+**/
+EFI_STATUS
+EFIAPI
+StageComponentInit (
+  OUT    COMPONENT_STAGE_CTX     *StageCtx,
+  IN     UINT32                   ComponentType,
+  IN     UINT32                   ComponentName,
+  IN     VOID                    *Buffer,
+  IN     UINT32                   BufferSize
+  )
+{
+  EFI_STATUS                Status;
+  LOADER_COMPRESSED_HEADER *CompressHdr;
+  UINT32                    CompLoc;
+  UINT32                    CompLen;
+  HASH_ALG_TYPE             HashAlg[2];
+
+  if ((StageCtx == NULL) || (Buffer == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  ZeroMem (StageCtx, sizeof (COMPONENT_STAGE_CTX));
+  if (ComponentType >= COMP_TYPE_INVALID) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = GetComponentInfo (ComponentName, &CompLoc, &CompLen);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  CompressHdr = (LOADER_COMPRESSED_HEADER *)(UINTN)CompLoc;
+  if (!IS_FLASH_ADDRESS (CompressHdr) || !IS_COMPRESSED (CompressHdr)) {
+    return EFI_UNSUPPORTED;
+  }
+  if (sizeof (LOADER_COMPRESSED_HEADER) + CompressHdr->CompressedSize > CompLen) {
+    return EFI_UNSUPPORTED;
+  }
+
+  // Use the same digests as a regular load of a flash map component
+  HashAlg[0] = HASH_TYPE_NONE;
+  if (FeaturePcdGet (PcdVerifiedBootEnabled)) {
+    HashAlg[0] = FixedPcdGet8 (PcdCompSignHashAlg);
+  }
+  HashAlg[1] = GetMeasureHashAlg (ComponentType);
+  if (HashAlg[1] == HashAlg[0]) {
+    HashAlg[1] = HASH_TYPE_NONE;
+  }
+  Status = CalculateMultiHashInit (&StageCtx->HashCtx, HashAlg, 2);
+  if (RETURN_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  StageCtx->ComponentType = ComponentType;
+  StageCtx->ComponentName = ComponentName;
+  StageCtx->Source        = (UINT8 *)CompressHdr;
+  StageCtx->Buffer        = (UINT8 *)Buffer;
+  StageCtx->BufferSize    = BufferSize;
+  StageCtx->Length        = sizeof (LOADER_COMPRESSED_HEADER) + CompressHdr->CompressedSize;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Copy and hash the next chunk of a staged component.
+
+  It does not print any debug messages or use the loader global data, so it
+  can be called from an FSP event handler. The digests are finalized in the
+  call that stages the last byte.
+
+  @param[in,out] StageCtx        Stage context.
+  @param[in]     MaxLength       Maximum number of bytes to stage in this call.
+
+  @retval TRUE                   The whole component has been staged.
+  @retval FALSE                  There is more to stage.
+
+**/
+BOOLEAN
+EFIAPI
+StageComponentStep (
+  IN OUT COMPONENT_STAGE_CTX     *StageCtx,
+  IN     UINT32                   MaxLength
+  )
+{
+  UINT32              Limit;
+  UINT32              ChunkLen;
+
+  if ((StageCtx == NULL) || (StageCtx->Source == NULL)) {
+    return FALSE;
+  }
+
+  Limit = MIN (StageCtx->Length, StageCtx->BufferSize);
+  while ((MaxLength > 0) && (StageCtx->Offset < Limit)) {
+    ChunkLen = MIN (MIN (Limit - StageCtx->Offset, MaxLength), STREAM_CHUNK_SIZE);
+    CopyMem (StageCtx->Buffer + StageCtx->Offset, StageCtx->Source + StageCtx->Offset, ChunkLen);
+    CalculateMultiHashUpdate (&StageCtx->HashCtx, StageCtx->Buffer + StageCtx->Offset, ChunkLen);
+    StageCtx->Offset += ChunkLen;
+    MaxLength        -= ChunkLen;
+  }
+
+  if ((StageCtx->Offset == StageCtx->Length) && !StageCtx->Complete) {
+    CalculateMultiHashFinal (&StageCtx->HashCtx, StageCtx->Digest);
+    StageCtx->Complete = TRUE;
+  }
+
+  return StageCtx->Complete;
+}
+
+/**
+  Move a staged component into a new buffer.
+
+  @param[in,out] StageCtx        Stage context.
+  @param[in]     Buffer          New staging buffer.
+  @param[in]     BufferSize      New staging buffer size.
+
+  @retval EFI_INVALID_PARAMETER  Invalid parameters.
+  @retval EFI_BUFFER_TOO_SMALL   The new buffer cannot hold the staged data.
+  @retval EFI_SUCCESS            The staged data has been moved.
+
+**/
+EFI_STATUS
+EFIAPI
+RelocateStagedComponent (
+  IN OUT COMPONENT_STAGE_CTX     *StageCtx,
+  IN     VOID                    *Buffer,
+  IN     UINT32                   BufferSize
+  )
+{
+  if ((StageCtx == NULL) || (StageCtx->Source == NULL) || (Buffer == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (BufferSize < StageCtx->Offset) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  CopyMem (Buffer, StageCtx->Buffer, StageCtx->Offset);
+  StageCtx->Buffer     = (UINT8 *)Buffer;
+  StageCtx->BufferSize = BufferSize;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Stage the rest of a component and take the staging digests over.
+
+  The stage context is consumed, so it cannot be used for another load.
+
+  @param[in,out] Ctx        Component load context. HashAlg and MbHashAlg must be set.
+  @param[in,out] StageCtx   Stage context covering the whole signed data.
+
+**/
+STATIC
+VOID
+FinishStagedComponent (
+  IN OUT COMPONENT_LOAD_CTX    *Ctx,
+  IN OUT COMPONENT_STAGE_CTX   *StageCtx
+  )
+{
+  UINT8              *Digest;
+  HASH_ALG_TYPE       HashAlg;
+  UINT32              Index;
+
+  if (!StageComponentStep (StageCtx, StageCtx->Length)) {
+    return;
+  }
+  StageCtx->Source = NULL;
+
+  for (Index = 0; Index < StageCtx->HashCtx.Count; Index++) {
+    HashAlg = StageCtx->HashCtx.Stream[Index].HashAlg;
+    if (HashAlg == HASH_TYPE_NONE) {
+      continue;
+    }
+    Digest = StageCtx->Digest + Index * HASH_DIGEST_MAX;
+    if (HashAlg == Ctx->HashAlg) {
+      CopyMem (Ctx->Digest, Digest, HASH_DIGEST_MAX);
+      Ctx->DigestValid = TRUE;
+    }
+    if (HashAlg == GetExtraHashAlg (Ctx)) {
+      CopyMem (Ctx->MbDigest, Digest, HASH_DIGEST_MAX);
+      Ctx->MbDigestValid = TRUE;
+    }
+  }
+}
+
 /**
   Return Containser Key Type based on its signature
 
@@ -394,7 +826,7 @@ AutheticateContainerInternal (
       } else {
         Status = AuthenticateComponent ((UINT8 *)ContainerHdr, ContainerHdrSize,
                                         AuthType, AuthData, NULL,
-                                        GetContainerKeyUsageBySig (ContainerHeader->Signature));
+                                        GetContainerKeyUsageBySig (ContainerHeader->Signature), NULL);
         if ((!EFI_ERROR(Status)) && (ContainerCallback != NULL)) {
           // Update component Call back info after container header authenticaton is done
           // This info will used by firmware stage to extend to TPM
@@ -428,7 +860,7 @@ AutheticateContainerInternal (
         DataBuf  = (UINT8 *)(UINTN)(ContainerEntry->Base + ContainerHdr->DataOffset);
         DataLen  = CompEntry->Offset;
         Status   = AuthenticateComponent (DataBuf, DataLen, CompEntry->AuthType,
-                                          AuthData, CompEntry->HashData, 0);
+                                          AuthData, CompEntry->HashData, 0, NULL);
 
         if ((!EFI_ERROR(Status)) && (ContainerCallback != NULL)) {
           // Update component Call back info after authenticaton is done
@@ -686,30 +1118,142 @@ LocateComponent (
 }
 
 /**
-  Load a component from a container or flahs map to memory and call callback
-  function at predefined point.
+  Get the trusted digest of the signed data of a component.
 
-  @param[in]     ContainerSig    Container signature or component type.
-  @param[in]     ComponentName   Component name.
-  @param[in,out] Buffer          Pointer to receive component base.
-  @param[in,out] Length          Pointer to receive component size.
-  @param[in,out] LoadComponentCallback  Callback function pointer.
+  It is the key of the component in the image cache. Only the digests known
+  without reading the component data are used: the hash store digest of a
+  flash map component, or the component hash from an authenticated container
+  header.
+
+  @param[in]  ContainerSig    Container signature or component type.
+  @param[in]  ComponentName   Component name.
+  @param[out] HashAlg         Hash algorithm of the digest.
+
+  @retval     The trusted digest, or NULL if it is not available.
+
+**/
+STATIC
+UINT8 *
+GetTrustedDigest (
+  IN  UINT32            ContainerSig,
+  IN  UINT32            ComponentName,
+  OUT HASH_ALG_TYPE    *HashAlg
+  )
+{
+  EFI_STATUS                Status;
+  CONTAINER_ENTRY          *ContainerEntry;
+  COMPONENT_ENTRY          *CompEntry;
+  CONST UINT8              *HashData;
+  UINT8                     HashType;
+
+  if (!FeaturePcdGet (PcdVerifiedBootEnabled)) {
+    return NULL;
+  }
+
+  if (ContainerSig < COMP_TYPE_INVALID) {
+    Status = GetComponentHash ((UINT8)ContainerSig, &HashData, &HashType);
+    if (EFI_ERROR (Status)) {
+      return NULL;
+    }
+    *HashAlg = HashType;
+    return (UINT8 *)HashData;
+  }
+
+  Status = LocateComponentEntry (ContainerSig, ComponentName, &ContainerEntry, &CompEntry);
+  if (EFI_ERROR (Status) || (CompEntry == NULL)) {
+    return NULL;
+  }
+  if ((CompEntry->AuthType != AUTH_TYPE_SHA2_256) && (CompEntry->AuthType != AUTH_TYPE_SHA2_384)) {
+    return NULL;
+  }
+  *HashAlg = GetHashAlg (CompEntry->AuthType);
+  return CompEntry->HashData;
+}
+
+/**
+  Copy the signed data of a component from the image cache.
+
+  The cache lives in memory the OS can write, so the copy is hashed on the way
+  like a copy from flash, and it is only used when its digest matches the
+  trusted digest. The authentication and measured boot digests then cover the
+  bytes that are decompressed and executed.
+
+  @param[in,out] Ctx          Component load context. CompBuf, SignedDataLen,
+                              HashAlg and MbHashAlg must be set.
+  @param[in]     Request      Component load request.
+
+  @retval TRUE                The component was copied from the image cache.
+  @retval FALSE               The component needs to be copied from flash. The
+                              image cache key is set in Ctx if it can be cached.
+
+**/
+STATIC
+BOOLEAN
+CopyCachedComponent (
+  IN OUT COMPONENT_LOAD_CTX       *Ctx,
+  IN     LOAD_COMPONENT_REQUEST   *Request
+  )
+{
+  IMAGE_CACHE_ENTRY        *Entry;
+
+  if (GetImageCachePtr () == NULL) {
+    return FALSE;
+  }
+
+  Ctx->CacheDigest = GetTrustedDigest (Request->ContainerSig, Request->ComponentName, &Ctx->CacheHashAlg);
+  if ((Ctx->CacheDigest == NULL) || (Ctx->CacheHashAlg != Ctx->HashAlg)) {
+    Ctx->CacheDigest = NULL;
+    return FALSE;
+  }
+
+  Entry = ImageCacheLookup (Request->ContainerSig, Request->ComponentName,
+                            Ctx->CacheHashAlg, Ctx->CacheDigest, Ctx->SignedDataLen);
+  if (Entry == NULL) {
+    return FALSE;
+  }
+
+  CopyAndHashComponent (Ctx, ImageCacheGetData (Entry));
+  if (Ctx->DigestValid &&
+      (CompareMem (Ctx->Digest, Ctx->CacheDigest, ImageCacheDigestSize (Ctx->CacheHashAlg)) == 0)) {
+    Ctx->Cached = TRUE;
+    DEBUG ((DEBUG_INFO, "Copied component from image cache\n"));
+    return TRUE;
+  }
+
+  DEBUG ((DEBUG_WARN, "Image cache entry does not match the trusted digest\n"));
+  ImageCacheDrop (Request->ContainerSig, Request->ComponentName);
+  Ctx->DigestValid   = FALSE;
+  Ctx->MbDigestValid = FALSE;
+  return FALSE;
+}
+
+/**
+  Locate a component and prepare it for authentication.
+
+  It collects the component information, allocates the temporary buffers and
+  copies the component into memory if it is still on flash, or from the image
+  cache when it holds a good copy. A digest of the copy is calculated on the
+  way when possible.
+
+  @param[in,out] Ctx                    Component load context. It must be zeroed.
+  @param[in]     Request                Component load request.
+  @param[in]     LoadComponentCallback  Callback function pointer.
+  @param[in,out] StageCtx               Stage context of the component, or NULL.
 
   @retval EFI_UNSUPPORTED          Unsupported AuthType.
   @retval EFI_NOT_FOUND            Cannot locate component.
   @retval EFI_BUFFER_TOO_SMALL     Specified buffer size is too small.
-  @retval EFI_SECURITY_VIOLATION   Authentication failed.
-  @retval EFI_SUCCESS              Authentication succeeded.
+  @retval EFI_OUT_OF_RESOURCES     Temporary buffer allocation failed.
+  @retval EFI_SUCCESS              Component is ready for authentication.
 
 **/
+STATIC
 EFI_STATUS
-EFIAPI
-LoadComponentWithCallback (
-  IN     UINT32                   ContainerSig,
-  IN     UINT32                   ComponentName,
-  IN OUT VOID                   **Buffer,
-  IN OUT UINT32                  *Length,
-  IN     LOAD_COMPONENT_CALLBACK  LoadComponentCallback
+PrepareComponentLoad (
+  IN OUT COMPONENT_LOAD_CTX       *Ctx,
+  IN     LOAD_COMPONENT_REQUEST   *Request,
+  IN     LOAD_COMPONENT_CALLBACK   LoadComponentCallback,
+  IN OUT COMPONENT_STAGE_CTX      *StageCtx  OPTIONAL
   )
 {
   EFI_STATUS                Status;
@@ -718,29 +1262,23 @@ LoadComponentWithCallback (
   CONTAINER_ENTRY          *ContainerEntry;
   COMPONENT_ENTRY          *CompEntry;
   UINT8                    *CompData;
-  UINT8                    *CompBuf;
-  UINT8                    *HashData;
-  VOID                     *CompBase;
-  VOID                     *ScrBuf;
-  VOID                     *AllocBuf;
-  VOID                     *ReqCompBase;
-  UINT32                    Usage;
-  UINT8                     AuthType;
-  UINT32                    DecompressedLen;
+  UINT32                    ContainerSig;
+  UINT32                    ComponentName;
   UINT32                    CompLen;
   UINT32                    CompLoc;
   UINT32                    AllocLen;
-  UINT32                    SignedDataLen;
   UINT32                    DstLen;
   UINT32                    ScrLen;
   BOOLEAN                   IsInFlash;
-  COMPONENT_CALLBACK_INFO   CbInfo;
-  UINT32                    ComponentId;
+  BOOLEAN                   IsStaged;
   UINT64                    ContainerIdBuf;
   UINT64                    ComponentIdBuf;
 
-  ComponentId = ContainerSig;
+  ContainerSig  = Request->ContainerSig;
+  ComponentName = Request->ComponentName;
+  Ctx->ComponentId = ContainerSig;
   CompLoc = 0;
+  ScrLen  = 0;
 
   ComponentIdBuf = ComponentName;
   if (ContainerSig < COMP_TYPE_INVALID) {
@@ -752,8 +1290,7 @@ LoadComponentWithCallback (
 
   if (ContainerSig < COMP_TYPE_INVALID) {
     // Check if it is component type
-    Usage        =  1 << ContainerSig;
-    ContainerSig = 0;
+    Ctx->Usage   =  1 << ContainerSig;
     Status = GetComponentInfo (ComponentName, &CompLoc, &CompLen);
     if (EFI_ERROR (Status)) {
       return EFI_NOT_FOUND;
@@ -761,16 +1298,16 @@ LoadComponentWithCallback (
     CompData = (VOID *)(UINTN)CompLoc;
     if (FeaturePcdGet (PcdVerifiedBootEnabled)) {
       if(FixedPcdGet8(PcdCompSignHashAlg) == HASH_TYPE_SHA256) {
-        AuthType = AUTH_TYPE_SHA2_256;
+        Ctx->AuthType = AUTH_TYPE_SHA2_256;
       } else if (FixedPcdGet8(PcdCompSignHashAlg) == HASH_TYPE_SHA384) {
-        AuthType = AUTH_TYPE_SHA2_384;
+        Ctx->AuthType = AUTH_TYPE_SHA2_384;
       } else {
         return EFI_UNSUPPORTED;
       }
     } else {
-      AuthType = AUTH_TYPE_NONE;
+      Ctx->AuthType = AUTH_TYPE_NONE;
     }
-    HashData = NULL;
+    Ctx->HashData = NULL;
   } else {
     // Find the component info
     Status = LocateComponentEntry (ContainerSig, ComponentName, &ContainerEntry, &CompEntry);
@@ -787,10 +1324,10 @@ LoadComponentWithCallback (
     }
 
     // Collect component info
-    ContainerHdr = (CONTAINER_HDR *)(UINTN)ContainerEntry->HeaderCache;
-    AuthType  = CompEntry->AuthType;
-    HashData  = CompEntry->HashData;
-    Usage     = 0;
+    ContainerHdr  = (CONTAINER_HDR *)(UINTN)ContainerEntry->HeaderCache;
+    Ctx->AuthType = CompEntry->AuthType;
+    Ctx->HashData = CompEntry->HashData;
+    Ctx->Usage    = 0;
     CompData  = (UINT8 *)(UINTN)(ContainerEntry->Base + ContainerHdr->DataOffset + CompEntry->Offset);
     CompLen   = CompEntry->Size;
   }
@@ -807,13 +1344,13 @@ LoadComponentWithCallback (
   }
 
   if (IS_COMPRESSED (CompressHdr)) {
-    SignedDataLen = sizeof (LOADER_COMPRESSED_HEADER) + CompressHdr->CompressedSize;
+    Ctx->SignedDataLen = sizeof (LOADER_COMPRESSED_HEADER) + CompressHdr->CompressedSize;
     if (CompressHdr->Size == 0) {
       Status = EFI_SUCCESS;
       DstLen = 0;
       ScrLen = 0;
     } else {
-      if (SignedDataLen <= CompLen) {
+      if (Ctx->SignedDataLen <= CompLen) {
         Status = DecompressGetInfo (CompressHdr->Signature, CompressHdr->Data,
                                     CompressHdr->CompressedSize, &DstLen, &ScrLen);
       }
@@ -824,11 +1361,10 @@ LoadComponentWithCallback (
   }
 
   // If it is required to use an existing buffer, verify the size
-  ReqCompBase = NULL;
-  DecompressedLen = CompressHdr->Size;
-  if ((Buffer != NULL) && (*Buffer != NULL)) {
-    ReqCompBase = *Buffer;
-    if ((Length != NULL) && (*Length != 0) && (*Length < DecompressedLen)) {
+  Ctx->DecompressedLen = CompressHdr->Size;
+  if (Request->Buffer != NULL) {
+    Ctx->ReqCompBase = Request->Buffer;
+    if ((Request->Length != 0) && (Request->Length < Ctx->DecompressedLen)) {
       return EFI_BUFFER_TOO_SMALL;
     }
   }
@@ -836,88 +1372,573 @@ LoadComponentWithCallback (
   // If it is on flash, the data needs to be copied into memory first
   // before authentication for security concern.
   IsInFlash = IS_FLASH_ADDRESS (CompData);
+  // A copy staged ahead of time can be used if it covers the whole signed data
+  IsStaged  = (BOOLEAN)(IsInFlash && (StageCtx != NULL) && (StageCtx->Source == CompData) &&
+                        (StageCtx->Length == Ctx->SignedDataLen) && (StageCtx->BufferSize >= StageCtx->Length));
   AllocLen  = ScrLen + TEMP_BUF_ALIGN * 2;
-  if (IsInFlash) {
-    AllocLen += SignedDataLen;
+  if (IsInFlash && !IsStaged) {
+    AllocLen += Ctx->SignedDataLen;
   }
-  AllocBuf = AllocateTemporaryMemory (AllocLen);
-  if (AllocBuf == NULL) {
+  Ctx->AllocBuf = AllocateTemporaryMemory (AllocLen);
+  if (Ctx->AllocBuf == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
-  if (IsInFlash) {
+
+  Ctx->AuthData = CompData + ALIGN_UP(Ctx->SignedDataLen, AUTH_DATA_ALIGN);
+  Ctx->HashAlg  = GetStreamHashAlg (Ctx->AuthType, Ctx->AuthData);
+
+  // Measured boot can reuse the component entry hash when the algorithm matches.
+  // Otherwise calculate its digest together with the authentication digest.
+  if (LoadComponentCallback != NULL) {
+    Ctx->MbHashAlg = GetMeasureHashAlg (Ctx->ComponentId);
+    if ((Ctx->HashData != NULL) && (Ctx->MbHashAlg == GetHashAlg (Ctx->AuthType))) {
+      Ctx->MbHashAlg = HASH_TYPE_NONE;
+    }
+  }
+  if (IsStaged) {
+    // Most of the copy and hashing has been done already
+    Ctx->CompBuf = StageCtx->Buffer;
+    Ctx->ScrBuf  = Ctx->AllocBuf;
+    FinishStagedComponent (Ctx, StageCtx);
+    if (LoadComponentCallback != NULL) {
+      LoadComponentCallback (PROGESS_ID_COPY, NULL);
+    }
+  } else if (IsInFlash) {
     // Authenticate component and decompress it if required
-    CompBuf = AllocBuf;
-    ScrBuf  = (UINT8 *)AllocBuf + ALIGN_UP (SignedDataLen, TEMP_BUF_ALIGN);
-    CopyMem (CompBuf, CompData, SignedDataLen);
+    // The digest is calculated while copying to avoid another pass over the data
+    Ctx->CompBuf = Ctx->AllocBuf;
+    Ctx->ScrBuf  = (UINT8 *)Ctx->AllocBuf + ALIGN_UP (Ctx->SignedDataLen, TEMP_BUF_ALIGN);
+    if (!CopyCachedComponent (Ctx, Request)) {
+      CopyAndHashComponent (Ctx, CompData);
+    }
     if (LoadComponentCallback != NULL) {
       LoadComponentCallback (PROGESS_ID_COPY, NULL);
     }
   } else {
-    CompBuf = CompData;
-    ScrBuf  = AllocBuf;
+    Ctx->CompBuf = CompData;
+    Ctx->ScrBuf  = Ctx->AllocBuf;
   }
 
-  // Verify the component
-  Status = AuthenticateComponent (CompBuf, SignedDataLen, AuthType,
-             CompData + ALIGN_UP(SignedDataLen, AUTH_DATA_ALIGN),  HashData, Usage);
-  if (LoadComponentCallback != NULL) {
-    if(Status == EFI_SUCCESS){
-      // Update component Call back info after authenticaton is done
-      // This info will used by firmware stage to extend to TPM
-      CbInfo.ComponentType    = ComponentId;
-      CbInfo.CompBuf          = CompBuf;
-      CbInfo.CompLen          = SignedDataLen;
-      CbInfo.HashAlg          = GetHashAlg(AuthType);
-      CbInfo.HashData         = HashData;
-      LoadComponentCallback (PROGESS_ID_AUTHENTICATE, &CbInfo);
-    } else {
-      LoadComponentCallback (PROGESS_ID_AUTHENTICATE, NULL);
+  return EFI_SUCCESS;
+}
+
+/**
+  The job function to decompress one authenticated component.
+
+  It can run on an AP, so it must not print any debug messages.
+
+  @param[in] Arg  Pointer to the COMPONENT_LOAD_CTX.
+
+  @retval  0      Always.
+**/
+STATIC
+UINT64
+EFIAPI
+DecompressComponentTask (
+  IN  UINT64   Arg
+  )
+{
+  COMPONENT_LOAD_CTX       *Ctx;
+  LOADER_COMPRESSED_HEADER *CompressHdr;
+
+  Ctx = (COMPONENT_LOAD_CTX *)(UINTN)Arg;
+  CompressHdr = (LOADER_COMPRESSED_HEADER *)Ctx->CompBuf;
+  Ctx->Status = Decompress (CompressHdr->Signature, CompressHdr->Data, CompressHdr->CompressedSize,
+                            Ctx->CompBase, Ctx->ScrBuf);
+  return 0;
+}
+
+/**
+  Take the digest of a component from a list of digests calculated ahead of
+  time.
+
+  An entry is only used when it covers exactly the signed data of the
+  component in its current buffer, with the hash algorithm needed to
+  authenticate it.
+
+  @param[in,out] Ctx          Component load context.
+  @param[in]     DigestList   Digests calculated ahead of time, or NULL.
+  @param[in]     DigestCount  Number of entries in DigestList.
+
+**/
+STATIC
+VOID
+UsePrecalculatedDigest (
+  IN OUT COMPONENT_LOAD_CTX   *Ctx,
+  IN     CONST HASH_REQUEST   *DigestList   OPTIONAL,
+  IN     UINT32                DigestCount
+  )
+{
+  UINT32                    Index;
+
+  if ((DigestList == NULL) || (Ctx->HashAlg == HASH_TYPE_NONE)) {
+    return;
+  }
+
+  for (Index = 0; Index < DigestCount; Index++) {
+    if ((DigestList[Index].Data == Ctx->CompBuf) && (DigestList[Index].Length == Ctx->SignedDataLen) &&
+        (DigestList[Index].HashAlg == Ctx->HashAlg) && !RETURN_ERROR (DigestList[Index].Status)) {
+      CopyMem (Ctx->Digest, DigestList[Index].Digest, HASH_DIGEST_MAX);
+      Ctx->DigestValid = TRUE;
+      break;
     }
   }
-  if (!EFI_ERROR (Status)) {
-    CompressHdr = (LOADER_COMPRESSED_HEADER *)CompBuf;
-    if (ReqCompBase == NULL) {
-      CompBase = AllocatePages (EFI_SIZE_TO_PAGES ((UINTN) DecompressedLen));
-    } else {
-      CompBase = ReqCompBase;
+}
+
+/**
+  Load a batch of components from containers or flash map to memory.
+
+  All components are located and copied first. Their digests are then
+  calculated in parallel, authenticated on the BSP in order, and finally
+  decompressed in parallel. The idle APs are used through the MP service
+  when it is available. Components found in the image cache are copied from
+  there instead of flash, and the others are added to it once they are
+  authenticated.
+
+  @param[in,out] Request                Array of component load requests.
+  @param[in]     Count                  Number of requests, at most COMPONENT_LOAD_BATCH_MAX.
+  @param[in]     LoadComponentCallback  Callback function pointer.
+  @param[in,out] StageCtx               Stage context of the first request, or NULL.
+  @param[in]     DigestList             Digests calculated ahead of time, or NULL.
+  @param[in]     DigestCount            Number of entries in DigestList.
+
+**/
+STATIC
+VOID
+LoadComponentBatch (
+  IN OUT LOAD_COMPONENT_REQUEST   *Request,
+  IN     UINT32                    Count,
+  IN     LOAD_COMPONENT_CALLBACK   LoadComponentCallback,
+  IN OUT COMPONENT_STAGE_CTX      *StageCtx     OPTIONAL,
+  IN     CONST HASH_REQUEST       *DigestList   OPTIONAL,
+  IN     UINT32                    DigestCount
+  )
+{
+  COMPONENT_LOAD_CTX        Ctx[COMPONENT_LOAD_BATCH_MAX];
+  HASH_REQUEST              HashReq[COMPONENT_LOAD_BATCH_MAX];
+  UINT32                    HashIdx[COMPONENT_LOAD_BATCH_MAX];
+  COMPONENT_CALLBACK_INFO   CbInfo;
+  MP_SERVICE               *MpService;
+  UINT32                    HashCount;
+  UINT32                    JobCount;
+  UINT32                    Index;
+  UINT32                    Span;
+  UINT32                    CompSpan;
+  UINT32                    LoadedLen;
+  EFI_STATUS                Status;
+
+  Span = BeginMeasureSpan (0x5000, Request[0].ContainerSig, PERF_SPAN_NO_DEVICE);
+
+  // Locate and copy all components
+  ZeroMem (Ctx, sizeof (Ctx));
+  HashCount = 0;
+  for (Index = 0; Index < Count; Index++) {
+    CompSpan = BeginMeasureSpan (0x5010, Request[Index].ComponentName, PERF_SPAN_NO_DEVICE);
+    Ctx[Index].Status = PrepareComponentLoad (&Ctx[Index], &Request[Index], LoadComponentCallback,
+                                              (Index == 0) ? StageCtx : NULL);
+    EndMeasureSpan (CompSpan, EFI_ERROR (Ctx[Index].Status) ? 0 : Ctx[Index].SignedDataLen);
+    if (!EFI_ERROR (Ctx[Index].Status) && !Ctx[Index].DigestValid) {
+      UsePrecalculatedDigest (&Ctx[Index], DigestList, DigestCount);
     }
+    if (EFI_ERROR (Ctx[Index].Status) || Ctx[Index].DigestValid || Ctx[Index].MbDigestValid) {
+      continue;
+    }
+    if ((Ctx[Index].HashAlg == HASH_TYPE_NONE) && (Ctx[Index].MbHashAlg == HASH_TYPE_NONE)) {
+      continue;
+    }
+    HashReq[HashCount].Data    = Ctx[Index].CompBuf;
+    HashReq[HashCount].Length  = Ctx[Index].SignedDataLen;
+    HashReq[HashCount].HashAlg = Ctx[Index].HashAlg;
+    HashReq[HashCount].ExtraHashAlg = GetExtraHashAlg (&Ctx[Index]);
+    HashIdx[HashCount] = Index;
+    HashCount++;
+  }
 
-    if (CompBase != NULL) {
-      Status = Decompress (CompressHdr->Signature, CompressHdr->Data, CompressHdr->CompressedSize,
-                           CompBase, ScrBuf);
-      if (LoadComponentCallback != NULL) {
-        LoadComponentCallback (PROGESS_ID_DECOMPRESS, NULL);
+  // Calculate the digests that were not done during the copy
+  if (HashCount > 0) {
+    CalculateHashList (HashReq, HashCount);
+    for (Index = 0; Index < HashCount; Index++) {
+      if (!RETURN_ERROR (HashReq[Index].Status)) {
+        CopyMem (Ctx[HashIdx[Index]].Digest, HashReq[Index].Digest, HASH_DIGEST_MAX);
+        Ctx[HashIdx[Index]].DigestValid = TRUE;
+      }
+      if (!RETURN_ERROR (HashReq[Index].ExtraStatus)) {
+        CopyMem (Ctx[HashIdx[Index]].MbDigest, HashReq[Index].ExtraDigest, HASH_DIGEST_MAX);
+        Ctx[HashIdx[Index]].MbDigestValid = TRUE;
       }
-      if (EFI_ERROR (Status)) {
-        if (ReqCompBase == NULL) {
-          FreePages (CompBase, EFI_SIZE_TO_PAGES ((UINTN) DecompressedLen));
+    }
+  }
+
+  // Verify the components in order
+  JobCount = 0;
+  for (Index = 0; Index < Count; Index++) {
+    if (EFI_ERROR (Ctx[Index].Status)) {
+      continue;
+    }
+
+    Status = AuthenticateComponent (Ctx[Index].CompBuf, Ctx[Index].SignedDataLen, Ctx[Index].AuthType,
+               Ctx[Index].AuthData, Ctx[Index].HashData, Ctx[Index].Usage,
+               Ctx[Index].DigestValid ? Ctx[Index].Digest : NULL);
+    if (LoadComponentCallback != NULL) {
+      if(Status == EFI_SUCCESS){
+        // Update component Call back info after authenticaton is done
+        // This info will used by firmware stage to extend to TPM
+        CbInfo.ComponentType    = Ctx[Index].ComponentId;
+        CbInfo.CompBuf          = Ctx[Index].CompBuf;
+        CbInfo.CompLen          = Ctx[Index].SignedDataLen;
+        CbInfo.HashAlg          = GetHashAlg(Ctx[Index].AuthType);
+        CbInfo.HashData         = Ctx[Index].HashData;
+        // Hand the measured boot digest over so that it is not calculated again
+        if (GetMeasureDigest (&Ctx[Index]) != NULL) {
+          CbInfo.HashAlg        = Ctx[Index].MbHashAlg;
+          CbInfo.HashData       = GetMeasureDigest (&Ctx[Index]);
         }
+        LoadComponentCallback (PROGESS_ID_AUTHENTICATE, &CbInfo);
+      } else {
+        LoadComponentCallback (PROGESS_ID_AUTHENTICATE, NULL);
       }
+    }
+    if (EFI_ERROR (Status)) {
+      Ctx[Index].Status = EFI_SECURITY_VIOLATION;
+      continue;
+    }
+
+    if (Ctx[Index].ReqCompBase == NULL) {
+      Ctx[Index].CompBase = AllocatePages (EFI_SIZE_TO_PAGES ((UINTN) Ctx[Index].DecompressedLen));
     } else {
-      if (CompressHdr->Size == 0) {
-        Status = EFI_BAD_BUFFER_SIZE;
+      Ctx[Index].CompBase = Ctx[Index].ReqCompBase;
+    }
+
+    if (Ctx[Index].CompBase == NULL) {
+      if (Ctx[Index].DecompressedLen == 0) {
+        Ctx[Index].Status = EFI_BAD_BUFFER_SIZE;
       } else {
-        Status = EFI_OUT_OF_RESOURCES;
+        Ctx[Index].Status = EFI_OUT_OF_RESOURCES;
       }
+      continue;
     }
+    JobCount++;
+  }
 
-  } else {
-    Status = EFI_SECURITY_VIOLATION;
+  // Decompress all authenticated components
+  MpService = NULL;
+  if (JobCount > 1) {
+    MpService = (MP_SERVICE *) GetServiceBySignature (MP_SERVICE_SIGNATURE);
+  }
+  for (Index = 0; Index < Count; Index++) {
+    if (!EFI_ERROR (Ctx[Index].Status)) {
+      if (MpService != NULL) {
+        MpService->SubmitJob (DecompressComponentTask, (UINT64)(UINTN)&Ctx[Index]);
+      } else {
+        DecompressComponentTask ((UINT64)(UINTN)&Ctx[Index]);
+      }
+    }
+  }
+  if (MpService != NULL) {
+    MpService->WaitAllJobs ();
   }
-  FreeTemporaryMemory (AllocBuf);
 
-  if (!EFI_ERROR (Status)) {
+  // Report the results in order and release the temporary memory
+  LoadedLen = 0;
+  for (Index = 0; Index < Count; Index++) {
+    if (Ctx[Index].CompBase != NULL) {
+      if (LoadComponentCallback != NULL) {
+        LoadComponentCallback (PROGESS_ID_DECOMPRESS, NULL);
+      }
+      if (EFI_ERROR (Ctx[Index].Status) && (Ctx[Index].ReqCompBase == NULL)) {
+        FreePages (Ctx[Index].CompBase, EFI_SIZE_TO_PAGES ((UINTN) Ctx[Index].DecompressedLen));
+      }
+    }
+
+    Request[Index].Status = Ctx[Index].Status;
+    if (!EFI_ERROR (Ctx[Index].Status)) {
+      Request[Index].Buffer = Ctx[Index].CompBase;
+      Request[Index].Length = Ctx[Index].DecompressedLen;
+      LoadedLen += Ctx[Index].DecompressedLen;
+      // Keep the authenticated signed data for the next warm reset
+      if (!Ctx[Index].Cached && (Ctx[Index].CacheDigest != NULL)) {
+        ImageCacheStore (Request[Index].ContainerSig, Request[Index].ComponentName,
+                         Ctx[Index].CacheHashAlg, Ctx[Index].CacheDigest,
+                         Ctx[Index].CompBuf, Ctx[Index].SignedDataLen);
+      }
+    }
+  }
+
+  Index = Count;
+  while (Index > 0) {
+    Index--;
+    if (Ctx[Index].AllocBuf != NULL) {
+      FreeTemporaryMemory (Ctx[Index].AllocBuf);
+    }
+  }
+
+  EndMeasureSpan (Span, LoadedLen);
+}
+
+/**
+  Load a list of components from containers or flash map to memory and call
+  callback function at predefined points.
+
+  Independent components are authenticated and decompressed in parallel on
+  the idle APs when the MP service is available. The callback is always
+  called on the BSP, in the order of the request list.
+
+  @param[in,out] Request                Array of component load requests.
+                                        On input, Buffer and Length optionally specify the
+                                        destination buffer. On output, Buffer, Length and
+                                        Status are updated for each request.
+  @param[in]     Count                  Number of requests.
+  @param[in]     LoadComponentCallback  Callback function pointer.
+
+  @retval EFI_INVALID_PARAMETER    Request is NULL.
+  @retval EFI_SUCCESS              All components were loaded successfully.
+  @retval Others                   The status of the first failed request.
+
+**/
+EFI_STATUS
+EFIAPI
+LoadComponentListWithCallback (
+  IN OUT LOAD_COMPONENT_REQUEST   *Request,
+  IN     UINT32                    Count,
+  IN     LOAD_COMPONENT_CALLBACK   LoadComponentCallback
+  )
+{
+  return LoadComponentListWithDigest (Request, Count, NULL, 0, LoadComponentCallback);
+}
+
+/**
+  Load a list of components as LoadComponentListWithCallback does, using the
+  digests that have been calculated ahead of time where they apply.
+
+  @param[in,out] Request                Array of component load requests.
+  @param[in]     Count                  Number of requests.
+  @param[in]     DigestList             Digests from PrepareContainerDigests, or NULL.
+  @param[in]     DigestCount            Number of entries in DigestList.
+  @param[in]     LoadComponentCallback  Callback function pointer.
+
+  @retval EFI_INVALID_PARAMETER    Request is NULL.
+  @retval EFI_SUCCESS              All components were loaded successfully.
+  @retval Others                   The status of the first failed request.
+
+**/
+EFI_STATUS
+EFIAPI
+LoadComponentListWithDigest (
+  IN OUT LOAD_COMPONENT_REQUEST   *Request,
+  IN     UINT32                    Count,
+  IN     CONST HASH_REQUEST       *DigestList   OPTIONAL,
+  IN     UINT32                    DigestCount,
+  IN     LOAD_COMPONENT_CALLBACK   LoadComponentCallback
+  )
+{
+  UINT32                    Index;
+  UINT32                    BatchLen;
+
+  if ((Request == NULL) && (Count > 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < Count; Index += BatchLen) {
+    BatchLen = MIN (Count - Index, COMPONENT_LOAD_BATCH_MAX);
+    LoadComponentBatch (&Request[Index], BatchLen, LoadComponentCallback, NULL, DigestList, DigestCount);
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    if (EFI_ERROR (Request[Index].Status)) {
+      return Request[Index].Status;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Prepare the hash requests for the components of a container in memory.
+
+  The container does not need to be registered. Only the container data is
+  parsed, so the requests can be prepared right after the container is read
+  and the digests calculated while the next image is read. The digests are
+  then given to LoadComponentListWithDigest once the container is registered
+  and authenticated. A mono signed container is not supported.
+
+  @param[in]     ContainerHdr   Container in memory.
+  @param[in]     Length         Length of the container data in memory.
+  @param[out]    Request        Array to receive the hash requests.
+  @param[in,out] Count          On input, the number of entries in Request.
+                                On output, the number of hash requests prepared.
+
+  @retval EFI_INVALID_PARAMETER  Invalid parameters.
+  @retval EFI_UNSUPPORTED        The container is not supported.
+  @retval EFI_SUCCESS            The hash requests are prepared.
+
+**/
+EFI_STATUS
+EFIAPI
+PrepareContainerDigests (
+  IN     CONTAINER_HDR            *ContainerHdr,
+  IN     UINT32                    Length,
+  OUT    HASH_REQUEST             *Request,
+  IN OUT UINT32                   *Count
+  )
+{
+  COMPONENT_ENTRY          *CompEntry;
+  LOADER_COMPRESSED_HEADER *CompressHdr;
+  UINT8                    *AuthData;
+  UINT32                    CompOffset;
+  UINT32                    SignedDataLen;
+  UINT32                    HdrSize;
+  UINT32                    Index;
+  UINT32                    ReqCount;
+
+  if ((ContainerHdr == NULL) || (Request == NULL) || (Count == NULL)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if ((Length < sizeof (CONTAINER_HDR)) || (ContainerHdr->DataOffset > Length) ||
+      ((ContainerHdr->Flags & CONTAINER_HDR_FLAG_MONO_SIGNING) != 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  HdrSize = GetContainerHeaderSize (ContainerHdr);
+  if (HdrSize == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  ReqCount  = 0;
+  CompEntry = (COMPONENT_ENTRY *)&ContainerHdr[1];
+  for (Index = 0; (Index < ContainerHdr->Count) && (ReqCount < *Count); Index++) {
+    CompOffset = ContainerHdr->DataOffset + CompEntry->Offset;
+    if (((CompEntry->Attribute & COMPONENT_ENTRY_ATTR_RESERVED) == 0) &&
+        (CompEntry->Offset < Length) && (CompOffset >= ContainerHdr->DataOffset) &&
+        (CompEntry->Size <= Length - CompOffset) && (CompEntry->Size >= sizeof (LOADER_COMPRESSED_HEADER))) {
+      CompressHdr   = (LOADER_COMPRESSED_HEADER *)((UINT8 *)ContainerHdr + CompOffset);
+      SignedDataLen = sizeof (LOADER_COMPRESSED_HEADER) + CompressHdr->CompressedSize;
+      if (IS_COMPRESSED (CompressHdr) && (CompressHdr->CompressedSize < CompEntry->Size) &&
+          (SignedDataLen <= CompEntry->Size) &&
+          (ALIGN_UP (SignedDataLen, AUTH_DATA_ALIGN) + sizeof (SIGNATURE_HDR) <= Length - CompOffset)) {
+        AuthData = (UINT8 *)CompressHdr + ALIGN_UP (SignedDataLen, AUTH_DATA_ALIGN);
+        ZeroMem (&Request[ReqCount], sizeof (HASH_REQUEST));
+        Request[ReqCount].HashAlg = GetStreamHashAlg (CompEntry->AuthType, AuthData);
+        if (Request[ReqCount].HashAlg != HASH_TYPE_NONE) {
+          Request[ReqCount].Data         = (UINT8 *)CompressHdr;
+          Request[ReqCount].Length       = SignedDataLen;
+          Request[ReqCount].ExtraHashAlg = HASH_TYPE_NONE;
+          Request[ReqCount].Status       = RETURN_NOT_READY;
+          Request[ReqCount].ExtraStatus  = RETURN_NOT_READY;
+          ReqCount++;
+        }
+      }
+    }
+    CompEntry = (COMPONENT_ENTRY *)((UINT8 *)(CompEntry + 1) + CompEntry->HashSize);
+  }
+
+  *Count = ReqCount;
+  return EFI_SUCCESS;
+}
+
+/**
+  Load a component from a container or flahs map to memory and call callback
+  function at predefined point.
+
+  @param[in]     ContainerSig    Container signature or component type.
+  @param[in]     ComponentName   Component name.
+  @param[in,out] Buffer          Pointer to receive component base.
+  @param[in,out] Length          Pointer to receive component size.
+  @param[in,out] LoadComponentCallback  Callback function pointer.
+
+  @retval EFI_UNSUPPORTED          Unsupported AuthType.
+  @retval EFI_NOT_FOUND            Cannot locate component.
+  @retval EFI_BUFFER_TOO_SMALL     Specified buffer size is too small.
+  @retval EFI_SECURITY_VIOLATION   Authentication failed.
+  @retval EFI_SUCCESS              Authentication succeeded.
+
+**/
+EFI_STATUS
+EFIAPI
+LoadComponentWithCallback (
+  IN     UINT32                   ContainerSig,
+  IN     UINT32                   ComponentName,
+  IN OUT VOID                   **Buffer,
+  IN OUT UINT32                  *Length,
+  IN     LOAD_COMPONENT_CALLBACK  LoadComponentCallback
+  )
+{
+  LOAD_COMPONENT_REQUEST    Request;
+
+  Request.ContainerSig  = ContainerSig;
+  Request.ComponentName = ComponentName;
+  Request.Buffer        = (Buffer != NULL) ? *Buffer : NULL;
+  Request.Length        = (Length != NULL) ? *Length : 0;
+  Request.Status        = EFI_NOT_STARTED;
+
+  LoadComponentBatch (&Request, 1, LoadComponentCallback, NULL, NULL, 0);
+
+  if (!EFI_ERROR (Request.Status)) {
     if (Buffer != NULL) {
-      *Buffer = CompBase;
+      *Buffer = Request.Buffer;
     }
     if (Length != NULL) {
-      *Length = DecompressedLen;
+      *Length = Request.Length;
     }
   }
 
-  return Status;
+  return Request.Status;
 }
 
+/**
+  Load a staged component to memory and call callback function at predefined
+  points.
+
+  The rest of the component is staged first. The digests calculated during
+  staging are then used for authentication. If the staged copy cannot be used,
+  the component is loaded from flash as LoadComponentWithCallback does.
+
+  @param[in,out] StageCtx               Stage context.
+  @param[in,out] Buffer                 Pointer to receive component base.
+  @param[in,out] Length                 Pointer to receive component size.
+  @param[in]     LoadComponentCallback  Callback function pointer.
+
+  @retval EFI_UNSUPPORTED          Unsupported AuthType.
+  @retval EFI_NOT_FOUND            Cannot locate component.
+  @retval EFI_BUFFER_TOO_SMALL     Specified buffer size is too small.
+  @retval EFI_SECURITY_VIOLATION   Authentication failed.
+  @retval EFI_SUCCESS              Authentication succeeded.
+
+**/
+EFI_STATUS
+EFIAPI
+LoadStagedComponentWithCallback (
+  IN OUT COMPONENT_STAGE_CTX     *StageCtx,
+  IN OUT VOID                   **Buffer,
+  IN OUT UINT32                  *Length,
+  IN     LOAD_COMPONENT_CALLBACK  LoadComponentCallback
+  )
+{
+  LOAD_COMPONENT_REQUEST    Request;
+
+  if (StageCtx == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Request.ContainerSig  = StageCtx->ComponentType;
+  Request.ComponentName = StageCtx->ComponentName;
+  Request.Buffer        = (Buffer != NULL) ? *Buffer : NULL;
+  Request.Length        = (Length != NULL) ? *Length : 0;
+  Request.Status        = EFI_NOT_STARTED;
+
+  LoadComponentBatch (&Request, 1, LoadComponentCallback, StageCtx, NULL, 0);
+
+  if (!EFI_ERROR (Request.Status)) {
+    if (Buffer != NULL) {
+      *Buffer = Request.Buffer;
+    }
+    if (Length != NULL) {
+      *Length = Request.Length;
+    }
+  }
+
+  return Request.Status;
+}
 
 /**
   Load a component from a container or flash map to memory.
@@ -0,0 +1,401 @@
+/** @file
+  Keep the signed data of verified components in loader reserved memory so
+  that a warm reset does not need to read them from flash again.
+
+  The trust policy of the cache:
+  - Only components with a trusted digest of their signed data are cached:
+    the hash store digest for flash map components, or the component hash in
+    an authenticated container header. The entries are keyed by this digest,
+    so a component updated in flash never matches an old entry.
+  - The cache region is part of the loader reserved memory, which the OS can
+    write. The cached data is therefore never trusted: the loader hashes it
+    while copying it out, and only uses the copy when the digest matches the
+    trusted digest. The copy is then authenticated, measured and decompressed
+    exactly like a copy from flash.
+  - It is dropped on power-on, global and watchdog resets, and on firmware
+    update boots.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/BootloaderCommonLib.h>
+#include <Library/ContainerLib.h>
+#include "ImageCache.h"
+
+#define IMAGE_CACHE_DATA_START    ALIGN_UP (sizeof (IMAGE_CACHE_HDR), EFI_PAGE_SIZE)
+
+/**
+  Get the digest size of a hash algorithm.
+
+  @param[in] HashAlg         Hash algorithm.
+
+  @retval    Digest size in bytes, or 0 if the algorithm is not supported.
+
+**/
+UINT32
+ImageCacheDigestSize (
+  IN  HASH_ALG_TYPE    HashAlg
+  )
+{
+  switch (HashAlg) {
+  case HASH_TYPE_SHA256:
+    return SHA256_DIGEST_SIZE;
+  case HASH_TYPE_SHA384:
+    return SHA384_DIGEST_SIZE;
+  case HASH_TYPE_SHA512:
+    return SHA512_DIGEST_SIZE;
+  case HASH_TYPE_SM3:
+    return SM3_DIGEST_SIZE;
+  default:
+    return 0;
+  }
+}
+
+/**
+  Update the CRC of the image cache header after it was changed.
+
+  @param[in,out] Hdr         Image cache header.
+
+**/
+STATIC
+VOID
+ImageCacheUpdateHeader (
+  IN OUT IMAGE_CACHE_HDR   *Hdr
+  )
+{
+  Hdr->HeaderCrc = CalculateCrc32 (Hdr, OFFSET_OF (IMAGE_CACHE_HDR, HeaderCrc));
+}
+
+/**
+  Drop all components from the image cache.
+
+  @param[in,out] Hdr         Image cache header.
+  @param[in]     Size        Size of the image cache region.
+
+**/
+STATIC
+VOID
+ImageCacheReset (
+  IN OUT IMAGE_CACHE_HDR   *Hdr,
+  IN     UINT32             Size
+  )
+{
+  ZeroMem (Hdr, sizeof (IMAGE_CACHE_HDR));
+  Hdr->Signature  = IMAGE_CACHE_SIGNATURE;
+  Hdr->Version    = IMAGE_CACHE_VERSION;
+  Hdr->Size       = Size;
+  Hdr->UsedLength = IMAGE_CACHE_DATA_START;
+  ImageCacheUpdateHeader (Hdr);
+}
+
+/**
+  Get the image cache header if the cache is available and consistent.
+
+  @retval    The image cache header, or NULL if the cache cannot be used.
+
+**/
+STATIC
+IMAGE_CACHE_HDR *
+ImageCacheGetHeader (
+  VOID
+  )
+{
+  IMAGE_CACHE_HDR   *Hdr;
+
+  Hdr = (IMAGE_CACHE_HDR *)GetImageCachePtr ();
+  if ((Hdr == NULL) || (Hdr->Signature != IMAGE_CACHE_SIGNATURE)) {
+    return NULL;
+  }
+
+  if (Hdr->HeaderCrc != CalculateCrc32 (Hdr, OFFSET_OF (IMAGE_CACHE_HDR, HeaderCrc))) {
+    return NULL;
+  }
+
+  return Hdr;
+}
+
+/**
+  Remove an entry from the image cache.
+
+  The data of the following entries is moved down so that the free space is
+  always at the end of the cache.
+
+  @param[in,out] Hdr         Image cache header.
+  @param[in]     Index       Index of the entry to remove.
+
+**/
+STATIC
+VOID
+ImageCacheRemove (
+  IN OUT IMAGE_CACHE_HDR   *Hdr,
+  IN     UINT32             Index
+  )
+{
+  IMAGE_CACHE_ENTRY  *Entry;
+  UINT32              Start;
+  UINT32              Gap;
+  UINT32              Idx;
+
+  Entry = &Hdr->Entry[Index];
+  Start = Entry->Offset;
+  Gap   = ALIGN_UP (Entry->Length, EFI_PAGE_SIZE);
+  CopyMem ((UINT8 *)Hdr + Start, (UINT8 *)Hdr + Start + Gap, Hdr->UsedLength - Start - Gap);
+
+  for (Idx = Index + 1; Idx < Hdr->EntryCount; Idx++) {
+    CopyMem (&Hdr->Entry[Idx - 1], &Hdr->Entry[Idx], sizeof (IMAGE_CACHE_ENTRY));
+    Hdr->Entry[Idx - 1].Offset -= Gap;
+  }
+  Hdr->EntryCount--;
+  ZeroMem (&Hdr->Entry[Hdr->EntryCount], sizeof (IMAGE_CACHE_ENTRY));
+  Hdr->UsedLength -= Gap;
+  ImageCacheUpdateHeader (Hdr);
+}
+
+/**
+  Find the entry index of a component in the image cache.
+
+  @param[in] Hdr             Image cache header.
+  @param[in] ContainerSig    Container signature or component type.
+  @param[in] ComponentName   Component name.
+
+  @retval    The entry index, or IMAGE_CACHE_ENTRY_MAX if it is not found.
+
+**/
+STATIC
+UINT32
+ImageCacheFind (
+  IN  IMAGE_CACHE_HDR  *Hdr,
+  IN  UINT32            ContainerSig,
+  IN  UINT32            ComponentName
+  )
+{
+  UINT32    Index;
+
+  for (Index = 0; Index < Hdr->EntryCount; Index++) {
+    if ((Hdr->Entry[Index].ContainerSig == ContainerSig) &&
+        (Hdr->Entry[Index].ComponentName == ComponentName)) {
+      return Index;
+    }
+  }
+
+  return IMAGE_CACHE_ENTRY_MAX;
+}
+
+/**
+  Initialize the image cache that keeps the signed component data across warm
+  resets.
+
+  @param[in] CacheBase       Base of the cache region in loader reserved memory.
+  @param[in] CacheSize       Size of the cache region.
+  @param[in] Reset           TRUE to drop the components cached by the last boot.
+
+  @retval EFI_SUCCESS            The components cached by the last boot are kept.
+  @retval EFI_NOT_FOUND          The image cache is initialized empty.
+  @retval EFI_INVALID_PARAMETER  The cache region is too small or not page aligned.
+
+**/
+EFI_STATUS
+EFIAPI
+InitImageCache (
+  IN  VOID       *CacheBase,
+  IN  UINT32      CacheSize,
+  IN  BOOLEAN     Reset
+  )
+{
+  IMAGE_CACHE_HDR   *Hdr;
+  UINT32             Index;
+
+  Hdr = (IMAGE_CACHE_HDR *)CacheBase;
+  if ((Hdr == NULL) || (CacheSize <= IMAGE_CACHE_DATA_START) ||
+      (((UINTN)CacheBase & EFI_PAGE_MASK) != 0)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (!Reset && (Hdr->Signature == IMAGE_CACHE_SIGNATURE) && (Hdr->Version == IMAGE_CACHE_VERSION) &&
+      (Hdr->Size == CacheSize) && (Hdr->EntryCount <= IMAGE_CACHE_ENTRY_MAX) &&
+      (Hdr->UsedLength >= IMAGE_CACHE_DATA_START) && (Hdr->UsedLength <= CacheSize) &&
+      (Hdr->HeaderCrc == CalculateCrc32 (Hdr, OFFSET_OF (IMAGE_CACHE_HDR, HeaderCrc)))) {
+    for (Index = 0; Index < Hdr->EntryCount; Index++) {
+      if ((Hdr->Entry[Index].Offset < IMAGE_CACHE_DATA_START) ||
+          (Hdr->Entry[Index].Offset + ALIGN_UP (Hdr->Entry[Index].Length, EFI_PAGE_SIZE) > Hdr->UsedLength)) {
+        break;
+      }
+    }
+    if (Index == Hdr->EntryCount) {
+      DEBUG ((DEBUG_INFO, "Image cache has %d components\n", Hdr->EntryCount));
+      return EFI_SUCCESS;
+    }
+  }
+
+  ImageCacheReset (Hdr, CacheSize);
+  return EFI_NOT_FOUND;
+}
+
+/**
+  Find a component in the image cache.
+
+  The entry is only returned when its key digest matches the trusted digest
+  and it holds Length bytes. A stale entry for the component is dropped. The
+  caller must still check the digest of the data it copies out of the entry.
+
+  @param[in] ContainerSig    Container signature or component type.
+  @param[in] ComponentName   Component name.
+  @param[in] HashAlg         Hash algorithm of Digest.
+  @param[in] Digest          Trusted digest of the signed component data.
+  @param[in] Length          Length of the signed component data.
+
+  @retval    The cache entry, or NULL if the component is not cached.
+
+**/
+IMAGE_CACHE_ENTRY *
+ImageCacheLookup (
+  IN  UINT32           ContainerSig,
+  IN  UINT32           ComponentName,
+  IN  HASH_ALG_TYPE    HashAlg,
+  IN  CONST UINT8     *Digest,
+  IN  UINT32           Length
+  )
+{
+  IMAGE_CACHE_HDR    *Hdr;
+  IMAGE_CACHE_ENTRY  *Entry;
+  UINT32              Index;
+  UINT32              DigestSize;
+
+  Hdr = ImageCacheGetHeader ();
+  if (Hdr == NULL) {
+    return NULL;
+  }
+
+  Index = ImageCacheFind (Hdr, ContainerSig, ComponentName);
+  if (Index == IMAGE_CACHE_ENTRY_MAX) {
+    return NULL;
+  }
+
+  Entry      = &Hdr->Entry[Index];
+  DigestSize = ImageCacheDigestSize (HashAlg);
+  if ((DigestSize == 0) || (Entry->HashAlg != HashAlg) || (Entry->Length != Length) ||
+      (CompareMem (Entry->Digest, Digest, DigestSize) != 0)) {
+    // The component was changed since it was cached
+    ImageCacheRemove (Hdr, Index);
+    return NULL;
+  }
+
+  return Entry;
+}
+
+/**
+  Drop a component from the image cache.
+
+  @param[in] ContainerSig    Container signature or component type.
+  @param[in] ComponentName   Component name.
+
+**/
+VOID
+ImageCacheDrop (
+  IN  UINT32           ContainerSig,
+  IN  UINT32           ComponentName
+  )
+{
+  IMAGE_CACHE_HDR    *Hdr;
+  UINT32              Index;
+
+  Hdr = ImageCacheGetHeader ();
+  if (Hdr == NULL) {
+    return;
+  }
+
+  Index = ImageCacheFind (Hdr, ContainerSig, ComponentName);
+  if (Index < IMAGE_CACHE_ENTRY_MAX) {
+    ImageCacheRemove (Hdr, Index);
+  }
+}
+
+/**
+  Get the data of an image cache entry.
+
+  @param[in] Entry           Image cache entry.
+
+  @retval    The cached component data.
+
+**/
+VOID *
+ImageCacheGetData (
+  IN  IMAGE_CACHE_ENTRY   *Entry
+  )
+{
+  return (UINT8 *)GetImageCachePtr () + Entry->Offset;
+}
+
+/**
+  Add the signed data of an authenticated component into the image cache.
+
+  An existing entry for the same component is replaced. When there is not
+  enough room, the whole cache is dropped first.
+
+  @param[in] ContainerSig    Container signature or component type.
+  @param[in] ComponentName   Component name.
+  @param[in] HashAlg         Hash algorithm of Digest.
+  @param[in] Digest          Trusted digest of the signed component data.
+  @param[in] Data            Signed component data.
+  @param[in] Length          Length of the signed component data.
+
+  @retval EFI_SUCCESS           The component is cached.
+  @retval EFI_NOT_READY         The image cache is not available.
+  @retval EFI_BUFFER_TOO_SMALL  The component does not fit into the cache.
+
+**/
+EFI_STATUS
+ImageCacheStore (
+  IN  UINT32           ContainerSig,
+  IN  UINT32           ComponentName,
+  IN  HASH_ALG_TYPE    HashAlg,
+  IN  CONST UINT8     *Digest,
+  IN  CONST VOID      *Data,
+  IN  UINT32           Length
+  )
+{
+  IMAGE_CACHE_HDR    *Hdr;
+  IMAGE_CACHE_ENTRY  *Entry;
+  UINT32              Index;
+  UINT32              DataLen;
+
+  Hdr = ImageCacheGetHeader ();
+  if ((Hdr == NULL) || (ImageCacheDigestSize (HashAlg) == 0)) {
+    return EFI_NOT_READY;
+  }
+
+  DataLen = ALIGN_UP (Length, EFI_PAGE_SIZE);
+  if ((Length == 0) || (DataLen > Hdr->Size - IMAGE_CACHE_DATA_START)) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Index = ImageCacheFind (Hdr, ContainerSig, ComponentName);
+  if (Index < IMAGE_CACHE_ENTRY_MAX) {
+    ImageCacheRemove (Hdr, Index);
+  }
+  if ((Hdr->EntryCount == IMAGE_CACHE_ENTRY_MAX) || (DataLen > Hdr->Size - Hdr->UsedLength)) {
+    ImageCacheReset (Hdr, Hdr->Size);
+  }
+
+  Entry = &Hdr->Entry[Hdr->EntryCount];
+  ZeroMem (Entry, sizeof (IMAGE_CACHE_ENTRY));
+  Entry->ContainerSig  = ContainerSig;
+  Entry->ComponentName = ComponentName;
+  Entry->Offset        = Hdr->UsedLength;
+  Entry->Length        = Length;
+  Entry->HashAlg       = HashAlg;
+  CopyMem (Entry->Digest, Digest, ImageCacheDigestSize (HashAlg));
+  CopyMem ((UINT8 *)Hdr + Entry->Offset, Data, Length);
+
+  Hdr->EntryCount++;
+  Hdr->UsedLength += DataLen;
+  ImageCacheUpdateHeader (Hdr);
+
+  return EFI_SUCCESS;
+}
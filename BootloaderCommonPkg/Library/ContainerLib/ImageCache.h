@@ -0,0 +1,139 @@
+/** @file
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __IMAGE_CACHE_H__
+#define __IMAGE_CACHE_H__
+
+#include <Library/CryptoLib.h>
+
+#define IMAGE_CACHE_SIGNATURE       SIGNATURE_32 ('I', 'M', 'G', 'C')
+#define IMAGE_CACHE_VERSION         2
+#define IMAGE_CACHE_ENTRY_MAX       4
+
+//
+// The signed data of one component kept in the cache. Digest is the trusted
+// digest of the signed component data and is the key of the entry. The data
+// is not trusted on its own and is checked against Digest on every use.
+//
+typedef struct {
+  UINT32                    ContainerSig;
+  UINT32                    ComponentName;
+  UINT32                    Offset;
+  UINT32                    Length;
+  UINT8                     HashAlg;
+  UINT8                     Reserved[3];
+  UINT8                     Digest[HASH_DIGEST_MAX];
+} IMAGE_CACHE_ENTRY;
+
+//
+// The header is at the start of the cache region. The data of each entry is
+// page aligned and follows the header in the order of the entries.
+//
+typedef struct {
+  UINT32                    Signature;
+  UINT8                     Version;
+  UINT8                     EntryCount;
+  UINT16                    Reserved;
+  UINT32                    Size;
+  UINT32                    UsedLength;
+  IMAGE_CACHE_ENTRY         Entry[IMAGE_CACHE_ENTRY_MAX];
+  UINT32                    HeaderCrc;
+} IMAGE_CACHE_HDR;
+
+/**
+  Get the digest size of a hash algorithm.
+
+  @param[in] HashAlg         Hash algorithm.
+
+  @retval    Digest size in bytes, or 0 if the algorithm is not supported.
+
+**/
+UINT32
+ImageCacheDigestSize (
+  IN  HASH_ALG_TYPE    HashAlg
+  );
+
+/**
+  Find a component in the image cache.
+
+  The entry is only returned when its key digest matches the trusted digest
+  and it holds Length bytes. A stale entry for the component is dropped. The
+  caller must still check the digest of the data it copies out of the entry.
+
+  @param[in] ContainerSig    Container signature or component type.
+  @param[in] ComponentName   Component name.
+  @param[in] HashAlg         Hash algorithm of Digest.
+  @param[in] Digest          Trusted digest of the signed component data.
+  @param[in] Length          Length of the signed component data.
+
+  @retval    The cache entry, or NULL if the component is not cached.
+
+**/
+IMAGE_CACHE_ENTRY *
+ImageCacheLookup (
+  IN  UINT32           ContainerSig,
+  IN  UINT32           ComponentName,
+  IN  HASH_ALG_TYPE    HashAlg,
+  IN  CONST UINT8     *Digest,
+  IN  UINT32           Length
+  );
+
+/**
+  Drop a component from the image cache.
+
+  @param[in] ContainerSig    Container signature or component type.
+  @param[in] ComponentName   Component name.
+
+**/
+VOID
+ImageCacheDrop (
+  IN  UINT32           ContainerSig,
+  IN  UINT32           ComponentName
+  );
+
+/**
+  Get the data of an image cache entry.
+
+  @param[in] Entry           Image cache entry.
+
+  @retval    The cached component data.
+
+**/
+VOID *
+ImageCacheGetData (
+  IN  IMAGE_CACHE_ENTRY   *Entry
+  );
+
+/**
+  Add the signed data of an authenticated component into the image cache.
+
+  An existing entry for the same component is replaced. When there is not
+  enough room, the whole cache is dropped first.
+
+  @param[in] ContainerSig    Container signature or component type.
+  @param[in] ComponentName   Component name.
+  @param[in] HashAlg         Hash algorithm of Digest.
+  @param[in] Digest          Trusted digest of the signed component data.
+  @param[in] Data            Signed component data.
+  @param[in] Length          Length of the signed component data.
+
+  @retval EFI_SUCCESS           The component is cached.
+  @retval EFI_NOT_READY         The image cache is not available.
+  @retval EFI_BUFFER_TOO_SMALL  The component does not fit into the cache.
+
+**/
+EFI_STATUS
+ImageCacheStore (
+  IN  UINT32           ContainerSig,
+  IN  UINT32           ComponentName,
+  IN  HASH_ALG_TYPE    HashAlg,
+  IN  CONST UINT8     *Digest,
+  IN  CONST VOID      *Data,
+  IN  UINT32           Length
+  );
+
+#endif
@@ -8,10 +8,323 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 
 #include <PiPei.h>
 #include <Library/BaseMemoryLib.h>
+#include <Library/PcdLib.h>
+#include <Library/SerialPortLib.h>
+#include <Library/SynchronizationLib.h>
 #include <Library/BootloaderCommonLib.h>
 #include <Library/DebugLogBufferLib.h>
 #include <Guid/LoaderPlatformDataGuid.h>
 
+#define  DEBUG_OUTPUT_DEVICE_DEFERRED_MASK  (DEBUG_OUTPUT_DEVICE_LOG_BUFFER | \
+                                             DEBUG_OUTPUT_DEVICE_SERIAL_PORT | \
+                                             DEBUG_OUTPUT_DEVICE_SERIAL_DEFERRED)
+
+//
+// Bytes sent at a time by DebugLogBufferPoll (), the transmit FIFO depth of
+// a 16550 UART.
+//
+#define  DEBUG_LOG_BUFFER_POLL_SIZE         16
+
+//
+// Attempts to take the flush lock before DebugLogBufferWrite () gives up.
+//
+#define  DEBUG_LOG_BUFFER_LOCK_RETRY        0x100000
+
+//
+// Logged in place of the debug output dropped when the flush lock is stuck.
+//
+#define  DEBUG_LOG_BUFFER_MARKER_PREFIX     "[log dropped "
+#define  DEBUG_LOG_BUFFER_MARKER_SUFFIX     " bytes]\n"
+#define  DEBUG_LOG_BUFFER_MARKER_SIZE       32
+
+/**
+  Get the log buffer header if the serial output can be tracked in it.
+
+  A log buffer created with an older header has no FlushedLength field.
+
+  @retval The log buffer header, or NULL if the log buffer is not valid.
+
+**/
+STATIC
+DEBUG_LOG_BUFFER_HEADER *
+GetFlushableLogBuffer (
+  VOID
+  )
+{
+  DEBUG_LOG_BUFFER_HEADER  *LogBufHdr;
+
+  LogBufHdr = (DEBUG_LOG_BUFFER_HEADER *) GetDebugLogBufferPtr ();
+  if ((LogBufHdr == NULL) || (LogBufHdr->Signature != DEBUG_LOG_BUFFER_SIGNATURE) ||
+      (LogBufHdr->HeaderLength < sizeof (DEBUG_LOG_BUFFER_HEADER))) {
+    return NULL;
+  }
+
+  if ((LogBufHdr->FlushedLength < LogBufHdr->HeaderLength) ||
+      (LogBufHdr->FlushedLength > LogBufHdr->TotalLength)) {
+    LogBufHdr->FlushedLength = LogBufHdr->UsedLength;
+  }
+
+  return LogBufHdr;
+}
+
+/**
+  Get the length of the log buffer data not sent to the serial port yet.
+
+  @param  LogBufHdr        Log buffer header.
+
+  @retval The pending data length.
+
+**/
+STATIC
+UINT32
+GetPendingLength (
+  IN DEBUG_LOG_BUFFER_HEADER  *LogBufHdr
+  )
+{
+  if (LogBufHdr->UsedLength >= LogBufHdr->FlushedLength) {
+    return LogBufHdr->UsedLength - LogBufHdr->FlushedLength;
+  }
+
+  return (LogBufHdr->TotalLength - LogBufHdr->FlushedLength) +
+         (LogBufHdr->UsedLength  - LogBufHdr->HeaderLength);
+}
+
+/**
+  Take the flush lock without waiting forever.
+
+  The debug output comes from the BSP only, and a processor polling the
+  serial output holds the lock for one transmit FIFO of data at most. The
+  lock is not released in time only when its holder was interrupted on this
+  processor, e.g. by an exception while sending.
+
+  @param  LogBufHdr        Log buffer header.
+
+  @retval TRUE             The flush lock is taken.
+  @retval FALSE            The flush lock is held by someone else.
+
+**/
+STATIC
+BOOLEAN
+AcquireFlushLock (
+  IN DEBUG_LOG_BUFFER_HEADER  *LogBufHdr
+  )
+{
+  UINT32                    Retry;
+
+  for (Retry = 0; Retry < DEBUG_LOG_BUFFER_LOCK_RETRY; Retry++) {
+    if (InterlockedCompareExchange16 (&LogBufHdr->FlushLock, 0, 1) == 0) {
+      return TRUE;
+    }
+    CpuPause ();
+  }
+
+  return FALSE;
+}
+
+/**
+  Build the message logged in place of the debug output that was dropped.
+
+  @param  Marker           Buffer of DEBUG_LOG_BUFFER_MARKER_SIZE bytes for the message.
+  @param  DroppedLength    Number of bytes dropped.
+
+  @retval The length of the message.
+
+**/
+STATIC
+UINT32
+GetDropMarker (
+  OUT CHAR8   *Marker,
+  IN  UINT32   DroppedLength
+  )
+{
+  CHAR8                     Digits[10];
+  UINT32                    Count;
+  UINT32                    Length;
+
+  Count = 0;
+  do {
+    Digits[Count++] = (CHAR8)('0' + (DroppedLength % 10));
+    DroppedLength  /= 10;
+  } while (DroppedLength != 0);
+
+  Length = sizeof (DEBUG_LOG_BUFFER_MARKER_PREFIX) - 1;
+  CopyMem (Marker, DEBUG_LOG_BUFFER_MARKER_PREFIX, Length);
+  while (Count > 0) {
+    Marker[Length++] = Digits[--Count];
+  }
+  CopyMem (&Marker[Length], DEBUG_LOG_BUFFER_MARKER_SUFFIX, sizeof (DEBUG_LOG_BUFFER_MARKER_SUFFIX) - 1);
+  Length += sizeof (DEBUG_LOG_BUFFER_MARKER_SUFFIX) - 1;
+
+  return Length;
+}
+
+/**
+  Append data to the log buffer, wrapping around at its end.
+
+  @param  LogBufHdr        Log buffer header.
+  @param  Buffer           Pointer to the data.
+  @param  NumberOfBytes    Number of bytes of data.
+
+**/
+STATIC
+VOID
+CopyToLogBuffer (
+  IN DEBUG_LOG_BUFFER_HEADER  *LogBufHdr,
+  IN CONST UINT8              *Buffer,
+  IN UINTN                     NumberOfBytes
+  )
+{
+  UINTN                     RemainingBytes;
+
+  RemainingBytes = 0;
+  if (LogBufHdr->UsedLength + NumberOfBytes > LogBufHdr->TotalLength) {
+    RemainingBytes = LogBufHdr->UsedLength + NumberOfBytes - LogBufHdr->TotalLength;
+    NumberOfBytes  = LogBufHdr->TotalLength - LogBufHdr->UsedLength;
+  }
+
+  if (NumberOfBytes > 0) {
+    CopyMem (&LogBufHdr->Buffer[LogBufHdr->UsedLength - LogBufHdr->HeaderLength], Buffer, NumberOfBytes);
+    LogBufHdr->UsedLength += (UINT32)NumberOfBytes;
+  }
+
+  //
+  // Handle Ring Buffer
+  //
+  if (RemainingBytes > 0) {
+    CopyMem (&LogBufHdr->Buffer[0], Buffer + NumberOfBytes, RemainingBytes);
+    LogBufHdr->UsedLength = LogBufHdr->HeaderLength + (UINT32)RemainingBytes;
+    LogBufHdr->Attribute |= DEBUG_LOG_BUFFER_ATTRIBUTE_FULL;
+  }
+}
+
+/**
+  Send the log buffer data not sent yet to the serial port.
+
+  The caller must hold the flush lock. The lock is released with an
+  interlocked operation so the FlushedLength update is visible to other
+  processors before they can take it.
+
+  @param  LogBufHdr        Log buffer header.
+  @param  MaxBytes         Maximum number of bytes to send.
+
+  @retval The number of bytes sent to the serial port.
+
+**/
+STATIC
+UINTN
+SendPendingLog (
+  IN DEBUG_LOG_BUFFER_HEADER  *LogBufHdr,
+  IN UINTN                     MaxBytes
+  )
+{
+  UINTN                     Length;
+  UINTN                     Flushed;
+
+  Flushed = 0;
+  while ((MaxBytes > 0) && (GetPendingLength (LogBufHdr) > 0)) {
+    if (LogBufHdr->FlushedLength == LogBufHdr->TotalLength) {
+      LogBufHdr->FlushedLength = LogBufHdr->HeaderLength;
+    }
+
+    if (LogBufHdr->UsedLength >= LogBufHdr->FlushedLength) {
+      Length = LogBufHdr->UsedLength - LogBufHdr->FlushedLength;
+    } else {
+      Length = LogBufHdr->TotalLength - LogBufHdr->FlushedLength;
+    }
+    Length = MIN (Length, MaxBytes);
+
+    SerialPortWrite (&LogBufHdr->Buffer[LogBufHdr->FlushedLength - LogBufHdr->HeaderLength], Length);
+    LogBufHdr->FlushedLength += (UINT32)Length;
+    MaxBytes -= Length;
+    Flushed  += Length;
+  }
+
+  return Flushed;
+}
+
+/**
+  Send the log buffer data not sent yet to the serial port.
+
+  This is only used when the serial output of the debug messages is deferred.
+  It is called at the points where the boot flow waits anyway, and before
+  leaving the bootloader to flush all the pending data.
+
+  @param  MaxBytes         Maximum number of bytes to send. MAX_UINTN sends all.
+
+  @retval The number of bytes sent to the serial port.
+
+**/
+UINTN
+EFIAPI
+DebugLogBufferFlush (
+  IN UINTN      MaxBytes
+  )
+{
+  DEBUG_LOG_BUFFER_HEADER  *LogBufHdr;
+  UINTN                     Flushed;
+
+  // Please DON'T use DEBUG/ASSERT macro inside this function.
+  if ((PcdGet32 (PcdDebugOutputDeviceMask) & DEBUG_OUTPUT_DEVICE_DEFERRED_MASK) != DEBUG_OUTPUT_DEVICE_DEFERRED_MASK) {
+    return 0;
+  }
+
+  LogBufHdr = GetFlushableLogBuffer ();
+  if (LogBufHdr == NULL) {
+    return 0;
+  }
+
+  while (InterlockedCompareExchange16 (&LogBufHdr->FlushLock, 0, 1) != 0) {
+    CpuPause ();
+  }
+  Flushed = SendPendingLog (LogBufHdr, MaxBytes);
+  InterlockedCompareExchange16 (&LogBufHdr->FlushLock, 1, 0);
+
+  return Flushed;
+}
+
+/**
+  Send some of the log buffer data not sent yet to the serial port if this
+  can be done without waiting.
+
+  Nothing is sent unless the serial transmitter is empty, and no more than the
+  smallest UART transmit FIFO takes is sent. It is meant for polling and delay
+  loops, and may be called on any processor.
+
+  @retval The number of bytes sent to the serial port.
+
+**/
+UINTN
+EFIAPI
+DebugLogBufferPoll (
+  VOID
+  )
+{
+  DEBUG_LOG_BUFFER_HEADER  *LogBufHdr;
+  UINT32                    Control;
+  UINTN                     Flushed;
+
+  if ((PcdGet32 (PcdDebugOutputDeviceMask) & DEBUG_OUTPUT_DEVICE_DEFERRED_MASK) != DEBUG_OUTPUT_DEVICE_DEFERRED_MASK) {
+    return 0;
+  }
+
+  LogBufHdr = GetFlushableLogBuffer ();
+  if ((LogBufHdr == NULL) || (GetPendingLength (LogBufHdr) == 0)) {
+    return 0;
+  }
+
+  if (RETURN_ERROR (SerialPortGetControl (&Control)) || ((Control & EFI_SERIAL_OUTPUT_BUFFER_EMPTY) == 0)) {
+    return 0;
+  }
+
+  if (InterlockedCompareExchange16 (&LogBufHdr->FlushLock, 0, 1) != 0) {
+    return 0;
+  }
+  Flushed = SendPendingLog (LogBufHdr, DEBUG_LOG_BUFFER_POLL_SIZE);
+  InterlockedCompareExchange16 (&LogBufHdr->FlushLock, 1, 0);
+
+  return Flushed;
+}
+
 /**
   Write data from buffer to console buffer.
 
@@ -39,7 +352,13 @@ DebugLogBufferWrite (
   )
 {
   DEBUG_LOG_BUFFER_HEADER  *LogBufHdr;
-  UINTN                     RemainingBytes;
+  DEBUG_LOG_BUFFER_HEADER  *FlushLogBufHdr;
+  CHAR8                     Marker[DEBUG_LOG_BUFFER_MARKER_SIZE];
+  UINT32                    MarkerLength;
+  UINT32                    Pending;
+  UINT32                    Capacity;
+  UINTN                     Length;
+  UINTN                     Written;
 
   // This function will be called by DEBUG or ASSERT macro.
   // So please DON'T use DEBUG/ASSERT macro inside this function,
@@ -61,25 +380,134 @@ DebugLogBufferWrite (
     LogBufHdr->UsedLength = LogBufHdr->HeaderLength;
   }
 
-  RemainingBytes = 0;
-  if (LogBufHdr->UsedLength + NumberOfBytes > LogBufHdr->TotalLength) {
-    RemainingBytes = LogBufHdr->UsedLength + NumberOfBytes - LogBufHdr->TotalLength;
-    NumberOfBytes  = LogBufHdr->TotalLength - LogBufHdr->UsedLength;
-  }
+  FlushLogBufHdr = GetFlushableLogBuffer ();
+  if ((FlushLogBufHdr == NULL) ||
+      ((PcdGet32 (PcdDebugOutputDeviceMask) & DEBUG_OUTPUT_DEVICE_DEFERRED_MASK) != DEBUG_OUTPUT_DEVICE_DEFERRED_MASK)) {
+    CopyToLogBuffer (LogBufHdr, Buffer, NumberOfBytes);
 
-  if (NumberOfBytes > 0) {
-    CopyMem (&LogBufHdr->Buffer[LogBufHdr->UsedLength - LogBufHdr->HeaderLength], Buffer, NumberOfBytes);
-    LogBufHdr->UsedLength += (UINT32)NumberOfBytes;
+    //
+    // Without deferred serial output, nothing is left to send later.
+    //
+    if (FlushLogBufHdr != NULL) {
+      FlushLogBufHdr->FlushedLength = FlushLogBufHdr->UsedLength;
+    }
+    return NumberOfBytes;
   }
 
   //
-  // Handle Ring Buffer
+  // With deferred serial output, the log buffer is only written with the
+  // flush lock held, so a processor polling the serial output never sends
+  // data while it is overwritten. If the lock is stuck, the message is
+  // dropped and a marker telling so is logged in its place with the next one.
   //
-  if (RemainingBytes > 0) {
-    CopyMem (&LogBufHdr->Buffer[0], Buffer + NumberOfBytes, RemainingBytes);
-    LogBufHdr->UsedLength = LogBufHdr->HeaderLength + (UINT32)RemainingBytes;
-    LogBufHdr->Attribute |= DEBUG_LOG_BUFFER_ATTRIBUTE_FULL;
+  if (!AcquireFlushLock (FlushLogBufHdr)) {
+    FlushLogBufHdr->DroppedLength += (UINT32)NumberOfBytes;
+    return 0;
+  }
+
+  MarkerLength = 0;
+  if (FlushLogBufHdr->DroppedLength != 0) {
+    MarkerLength = GetDropMarker (Marker, FlushLogBufHdr->DroppedLength);
+    FlushLogBufHdr->DroppedLength = 0;
+  }
+
+  Written  = NumberOfBytes;
+  Length   = MarkerLength + NumberOfBytes;
+  Capacity = FlushLogBufHdr->TotalLength - FlushLogBufHdr->HeaderLength;
+  Pending  = GetPendingLength (FlushLogBufHdr);
+  if (Length < Capacity) {
+    //
+    // Send the pending data out first when this write would overwrite it.
+    //
+    if (Pending + Length >= Capacity) {
+      SendPendingLog (FlushLogBufHdr, Pending + Length + 1 - Capacity);
+    }
+    CopyToLogBuffer (LogBufHdr, (UINT8 *)Marker, MarkerLength);
+    CopyToLogBuffer (LogBufHdr, Buffer, NumberOfBytes);
+  } else {
+    //
+    // Data not fitting in the log buffer is sent right away, and only its
+    // end is kept in the log buffer.
+    //
+    SendPendingLog (FlushLogBufHdr, MAX_UINTN);
+    SerialPortWrite ((UINT8 *)Marker, MarkerLength);
+    SerialPortWrite (Buffer, NumberOfBytes);
+    if (NumberOfBytes >= Capacity) {
+      Buffer        += NumberOfBytes - (Capacity - 1);
+      NumberOfBytes  = Capacity - 1;
+      MarkerLength   = 0;
+    }
+    CopyToLogBuffer (LogBufHdr, (UINT8 *)Marker, MarkerLength);
+    CopyToLogBuffer (LogBufHdr, Buffer, NumberOfBytes);
+    FlushLogBufHdr->FlushedLength = FlushLogBufHdr->UsedLength;
+  }
+
+  InterlockedCompareExchange16 (&FlushLogBufHdr->FlushLock, 1, 0);
+
+  return Written;
+}
+
+/**
+  Copy the log buffer into a new buffer of the same or a bigger size.
+
+  The log is stored in the new buffer in order from the oldest data, so a
+  full ring buffer is unrolled. The data not sent to the serial port yet is
+  kept pending, so the owner of the new buffer continues sending it out.
+
+  @param  NewLogBufHdr     The new log buffer.
+  @param  NewTotalLength   The size of the new log buffer.
+  @param  LogBufHdr        The log buffer to copy.
+
+  @retval RETURN_SUCCESS            The log buffer was copied.
+  @retval RETURN_INVALID_PARAMETER  The log buffer is not valid.
+  @retval RETURN_BUFFER_TOO_SMALL   The new log buffer is too small.
+
+**/
+RETURN_STATUS
+EFIAPI
+DebugLogBufferCopy (
+  OUT DEBUG_LOG_BUFFER_HEADER  *NewLogBufHdr,
+  IN  UINT32                    NewTotalLength,
+  IN  DEBUG_LOG_BUFFER_HEADER  *LogBufHdr
+  )
+{
+  UINT32                    OlderLength;
+  UINT32                    NewerLength;
+
+  if ((NewLogBufHdr == NULL) || (LogBufHdr == NULL) ||
+      (LogBufHdr->Signature != DEBUG_LOG_BUFFER_SIGNATURE) ||
+      (LogBufHdr->UsedLength > LogBufHdr->TotalLength)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (NewTotalLength < LogBufHdr->TotalLength) {
+    return RETURN_BUFFER_TOO_SMALL;
+  }
+
+  if ((LogBufHdr->Attribute & DEBUG_LOG_BUFFER_ATTRIBUTE_FULL) == 0) {
+    CopyMem (NewLogBufHdr, LogBufHdr, LogBufHdr->UsedLength);
+  } else {
+    OlderLength = LogBufHdr->TotalLength - LogBufHdr->UsedLength;
+    NewerLength = LogBufHdr->UsedLength  - LogBufHdr->HeaderLength;
+    CopyMem (NewLogBufHdr, LogBufHdr, LogBufHdr->HeaderLength);
+    CopyMem (&NewLogBufHdr->Buffer[0], &LogBufHdr->Buffer[NewerLength], OlderLength);
+    CopyMem (&NewLogBufHdr->Buffer[OlderLength], &LogBufHdr->Buffer[0], NewerLength);
+    NewLogBufHdr->UsedLength = LogBufHdr->TotalLength;
+    NewLogBufHdr->Attribute &= (UINT8)~(DEBUG_LOG_BUFFER_ATTRIBUTE_FULL);
+
+    if (LogBufHdr->HeaderLength >= sizeof (DEBUG_LOG_BUFFER_HEADER)) {
+      if (LogBufHdr->FlushedLength >= LogBufHdr->UsedLength) {
+        NewLogBufHdr->FlushedLength = LogBufHdr->HeaderLength + (LogBufHdr->FlushedLength - LogBufHdr->UsedLength);
+      } else {
+        NewLogBufHdr->FlushedLength = LogBufHdr->HeaderLength + OlderLength + (LogBufHdr->FlushedLength - LogBufHdr->HeaderLength);
+      }
+    }
+  }
+
+  NewLogBufHdr->TotalLength = NewTotalLength;
+  if (LogBufHdr->HeaderLength >= sizeof (DEBUG_LOG_BUFFER_HEADER)) {
+    NewLogBufHdr->FlushLock = 0;
   }
 
-  return (NumberOfBytes + RemainingBytes);
+  return RETURN_SUCCESS;
 }
@@ -8,6 +8,7 @@
 
 #include <Library/LzmaDecompressLib.h>
 #include <Library/Lz4DecompressLib.h>
+#include <Library/ZstdDecompressLib.h>
 #include <Library/DecompressLib.h>
 
 /**
@@ -65,6 +66,8 @@ DecompressGetInfo (
   } else if (!FeaturePcdGet (PcdMinDecompression)) {
     if (Signature == LZMA_SIGNATURE) {
       Status = LzmaUefiDecompressGetInfo (Source, SourceSize, DestinationSize, ScratchSize);
+    } else if (Signature == ZSTD_SIGNATURE) {
+      Status = ZstdDecompressGetInfo (Source, SourceSize, DestinationSize, ScratchSize);
     }
   }
 
@@ -115,6 +118,8 @@ Decompress (
   } else if (!FeaturePcdGet (PcdMinDecompression)) {
     if (Signature == LZMA_SIGNATURE) {
       Status = LzmaUefiDecompress (Source, SourceSize, Destination, Scratch);
+    } else if (Signature == ZSTD_SIGNATURE) {
+      Status = ZstdDecompress (Source, SourceSize, Destination, Scratch);
     }
   }
 
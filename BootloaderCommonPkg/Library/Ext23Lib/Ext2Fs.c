@@ -103,6 +103,8 @@
   @param[in]  File            pointer to an Open file.
   @param[in]  FileBlock       Block to find the file.
   @param[out] DiskBlockPtr    Pointer to the disk which contains block.
+  @param[out] RunPtr          Number of contiguous disk blocks known to be
+                              mapped from FileBlock on. Optional.
 
   @retval 0 if success
   @retval other if error.
@@ -112,7 +114,8 @@ RETURN_STATUS
 BlockMap (
   IN  OPEN_FILE     *File,
   IN  INDPTR         FileBlock,
-  OUT INDPTR        *DiskBlockPtr
+  OUT INDPTR        *DiskBlockPtr,
+  OUT UINT32        *RunPtr       OPTIONAL
   );
 
 /**
@@ -256,6 +259,8 @@ ReadInode (
   @param[in]  File            pointer to an Open file.
   @param[in]  FileBlock       Block to find the file.
   @param[out] DiskBlockPtr    Pointer to the disk which contains block.
+  @param[out] RunPtr          Number of contiguous disk blocks known to be
+                              mapped from FileBlock on. Optional.
 
   @retval 0 if success
   @retval other if error.
@@ -265,7 +270,8 @@ RETURN_STATUS
 BlockMap (
   IN  OPEN_FILE     *File,
   IN  INDPTR         FileBlock,
-  OUT INDPTR        *DiskBlockPtr
+  OUT INDPTR        *DiskBlockPtr,
+  OUT UINT32        *RunPtr       OPTIONAL
   )
 {
   FILE     *Fp;
@@ -286,6 +292,10 @@ BlockMap (
   FileSystem = Fp->SuperBlockPtr;
   Buf = (VOID *)Fp->Buffer;
 
+  if (RunPtr != NULL) {
+    *RunPtr = 1;
+  }
+
   if ((Fp->DiskInode.Ext2DInodeStatusFlags & EXT4_EXTENTS) != 0) {
     Etable = (EXT4_EXTENT_TABLE*) &(Fp->DiskInode.Ext2DInodeBlocks);
     if (Etable->Eheader.EhMagic != EXT4_EXTENT_HEADER_MAGIC) {
@@ -352,6 +362,9 @@ BlockMap (
       //
       ASSERT (Extent->EstartHi == 0);
       *DiskBlockPtr = Extent->EstartLo + (FileBlock - Extent->Eblk); // (LShiftU64((UINT64)Extent->EiLeafHi, 32) | Extent->EstartLo) + (FileBlock - Extent->Eblk);
+      if (RunPtr != NULL) {
+        *RunPtr = Extent->Elen - (FileBlock - Extent->Eblk);
+      }
     } else {
       *DiskBlockPtr = 0;
     }
@@ -469,7 +482,7 @@ BufReadFile (
   BlockSize = FileSystem->Ext2FsBlockSize;    // no fragment
 
   if (FileBlock != Fp->BufferBlockNum) {
-    Rc = BlockMap (File, FileBlock, &DiskBlock);
+    Rc = BlockMap (File, FileBlock, &DiskBlock, NULL);
     if (Rc != 0) {
       return Rc;
     }
@@ -953,7 +966,7 @@ Ext2fsOpen (
         INDPTR    DiskBlock;
 
         Buf = Fp->Buffer;
-        Status = BlockMap (File, (INDPTR)0, &DiskBlock);
+        Status = BlockMap (File, (INDPTR)0, &DiskBlock, NULL);
         if (RETURN_ERROR (Status)) {
           goto out;
         }
@@ -1067,6 +1080,99 @@ Ext2fsFileSize (
   return (UINT32)Fp->DiskInode.Ext2DInodeSize;
 }
 
+/**
+  Read whole file blocks from the current seek position straight into a memory.
+
+  Physically contiguous file blocks are merged, so that each contiguous run
+  on the disk is read with a single device request without going through
+  the file block buffer.
+
+  @param[in/out]    File      File handle to be read
+  @param[in]        Start     Start address of read buffer
+  @param[in]        Blocks    Number of file blocks to be read
+
+  @retval RETURN_SUCCESS if file read is success
+  @retval other if error.
+**/
+STATIC
+RETURN_STATUS
+BulkReadFile (
+  IN OUT  OPEN_FILE     *File,
+  IN      VOID          *Start,
+  IN      UINT32         Blocks
+  )
+{
+  FILE          *Fp;
+  M_EXT2FS      *FileSystem;
+  CHAR8         *Address;
+  INDPTR        FileBlock;
+  INDPTR        DiskBlock;
+  INDPTR        NextDiskBlock;
+  UINT32        BlockSize;
+  UINT32        Count;
+  UINT32        Run;
+  UINT32        RSize;
+  RETURN_STATUS Status;
+
+  Fp = (FILE *)File->FileSystemSpecificData;
+  FileSystem = Fp->SuperBlockPtr;
+  BlockSize  = FileSystem->Ext2FsBlockSize;
+  FileBlock  = LBLKNO (FileSystem, Fp->SeekPtr);
+  Address    = Start;
+
+  //
+  // Mapping may read extent or indirect blocks into the file block buffer
+  //
+  Fp->BufferBlockNum = -1;
+
+  while (Blocks != 0) {
+    Status = BlockMap (File, FileBlock, &DiskBlock, &Run);
+    if (RETURN_ERROR (Status)) {
+      return Status;
+    }
+
+    if (DiskBlock == 0) {
+      //
+      // A hole in the file reads as zero
+      //
+      Count = 1;
+      ZeroMem (Address, BlockSize);
+    } else {
+      //
+      // Extend the run while the next file blocks follow on the disk
+      //
+      Count = MIN (Run, Blocks);
+      while (Count < Blocks) {
+        Status = BlockMap (File, FileBlock + Count, &NextDiskBlock, &Run);
+        if (RETURN_ERROR (Status)) {
+          return Status;
+        }
+        if ((NextDiskBlock == 0) || (NextDiskBlock != DiskBlock + (INDPTR)Count)) {
+          break;
+        }
+        Count += MIN (Run, Blocks - Count);
+      }
+
+      Status = DEV_STRATEGY (File->DevPtr) (File->FileDevData, F_READ,
+                                            FSBTODB (FileSystem, DiskBlock),
+                                            Count * BlockSize, Address, &RSize);
+      if (RETURN_ERROR (Status)) {
+        return Status;
+      }
+      if (RSize != Count * BlockSize) {
+        return EFI_DEVICE_ERROR;
+      }
+    }
+
+    Fp->SeekPtr += Count * BlockSize;
+    Address     += Count * BlockSize;
+    FileBlock   += Count;
+    Blocks      -= Count;
+  }
+
+  return RETURN_SUCCESS;
+}
+
 /**
   Copy a portion of a FILE into a memory.
   Cross block boundaries when necessary
@@ -1093,11 +1199,13 @@ Ext2fsRead (
   CHAR8 *Buf;
   UINT32 BufSize;
   CHAR8 *Address;
+  UINT32 BlockSize;
   RETURN_STATUS Status;
 
   Fp = (FILE *)File->FileSystemSpecificData;
   Status = RETURN_SUCCESS;
   Address = Start;
+  BlockSize = Fp->SuperBlockPtr->Ext2FsBlockSize;
 
   while (Size != 0) {
     //
@@ -1107,6 +1215,27 @@ Ext2fsRead (
       break;
     }
 
+    //
+    // Read whole blocks directly into the caller buffer when the seek pointer
+    // is block aligned, and partial blocks through the file block buffer.
+    //
+    if (BLOCKOFFSET (Fp->SuperBlockPtr, Fp->SeekPtr) == 0) {
+      Csize = (UINT32)Fp->DiskInode.Ext2DInodeSize - (UINT32)Fp->SeekPtr;
+      if (Csize > Size) {
+        Csize = Size;
+      }
+      Csize -= Csize % BlockSize;
+      if (Csize != 0) {
+        Status = BulkReadFile (File, Address, Csize / BlockSize);
+        if (RETURN_ERROR (Status)) {
+          break;
+        }
+        Address += Csize;
+        Size -= Csize;
+        continue;
+      }
+    }
+
     Status = BufReadFile (File, &Buf, &BufSize);
     if (RETURN_ERROR (Status)) {
       break;
@@ -269,6 +269,110 @@ FatGetNextCluster (
 }
 
 
+/**
+  Get the volume cluster holding a file cluster and the number of contiguous
+  clusters from there.
+
+  Contiguous cluster runs found while walking the cluster chain are recorded in
+  the file, so that moving forward in the file does not walk the FAT again.
+
+  @param  PrivateData            the global memory map
+  @param  File                   the file
+  @param  FileCluster            the cluster index within the file
+  @param  Cluster                the volume cluster holding FileCluster, or the
+                                 chain terminator if the chain is too short
+  @param  Count                  the number of contiguous clusters starting
+                                 from Cluster
+
+  @retval EFI_SUCCESS            Success.
+  @retval EFI_NOT_FOUND          FileCluster is beyond the cluster chain.
+  @retval EFI_DEVICE_ERROR       Something error while accessing media.
+
+**/
+STATIC
+EFI_STATUS
+FatGetClusterRun (
+  IN  PEI_FAT_PRIVATE_DATA  *PrivateData,
+  IN  PEI_FAT_FILE          *File,
+  IN  UINT32                FileCluster,
+  OUT UINT32                *Cluster,
+  OUT UINT32                *Count
+  )
+{
+  EFI_STATUS           Status;
+  PEI_FAT_CLUSTER_RUN  *Run;
+  PEI_FAT_CLUSTER_RUN  NewRun;
+  UINT32               Index;
+  UINT32               NextCluster;
+
+  //
+  // Find the last known run starting at or before FileCluster
+  //
+  Run = NULL;
+  for (Index = 0; Index < File->RunCount; Index++) {
+    if (File->Run[Index].FileCluster > FileCluster) {
+      break;
+    }
+    Run = &File->Run[Index];
+  }
+
+  if (Run != NULL) {
+    if (FileCluster < Run->FileCluster + Run->Count) {
+      *Cluster = Run->Cluster + (FileCluster - Run->FileCluster);
+      *Count   = Run->Count - (FileCluster - Run->FileCluster);
+      return EFI_SUCCESS;
+    }
+    NewRun.FileCluster = Run->FileCluster + Run->Count;
+    Status = FatGetNextCluster (PrivateData, File->Volume, Run->Cluster + Run->Count - 1, &NextCluster);
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
+  } else {
+    NewRun.FileCluster = 0;
+    NextCluster        = File->StartingCluster;
+  }
+
+  //
+  // Walk the chain forward one run at a time
+  //
+  while (TRUE) {
+    if (FAT_CLUSTER_FUNCTIONAL (NextCluster)) {
+      *Cluster = NextCluster;
+      *Count   = 0;
+      return EFI_NOT_FOUND;
+    }
+
+    NewRun.Cluster = NextCluster;
+    NewRun.Count   = 0;
+    do {
+      NewRun.Count++;
+      Status = FatGetNextCluster (PrivateData, File->Volume, NewRun.Cluster + NewRun.Count - 1, &NextCluster);
+      if (EFI_ERROR (Status)) {
+        return EFI_DEVICE_ERROR;
+      }
+    } while (NextCluster == NewRun.Cluster + NewRun.Count);
+
+    //
+    // Only runs following the last known one keep the table ordered
+    //
+    if ((Run == NULL) ? (File->RunCount == 0) : (Run == &File->Run[File->RunCount - 1])) {
+      if (File->RunCount == PEI_FAT_MAX_CLUSTER_RUN) {
+        File->RunCount--;
+      }
+      Run = &File->Run[File->RunCount++];
+      CopyMem (Run, &NewRun, sizeof (PEI_FAT_CLUSTER_RUN));
+    }
+
+    if (FileCluster < NewRun.FileCluster + NewRun.Count) {
+      *Cluster = NewRun.Cluster + (FileCluster - NewRun.FileCluster);
+      *Count   = NewRun.Count - (FileCluster - NewRun.FileCluster);
+      return EFI_SUCCESS;
+    }
+    NewRun.FileCluster += NewRun.Count;
+  }
+}
+
+
 /**
   Set a file's CurrentPos and CurrentCluster, then compute StraightReadAmount.
 
@@ -290,10 +394,11 @@ FatSetFilePos (
   )
 {
   EFI_STATUS  Status;
-  UINT32      AlignedPos;
+  UINT32      NewPos;
+  UINT32      FileCluster;
   UINT32      Offset;
   UINT32      Cluster;
-  UINT32      PrevCluster;
+  UINT32      Count;
 
   if (File->IsFixedRootDir) {
 
@@ -306,52 +411,24 @@ FatSetFilePos (
 
   } else {
 
-    DivU64x32Remainder (File->CurrentPos, File->Volume->ClusterSize, &Offset);
-    AlignedPos = (UINT32) File->CurrentPos - (UINT32) Offset;
+    NewPos      = (UINT32) File->CurrentPos + Pos;
+    FileCluster = (UINT32) DivU64x32Remainder (NewPos, File->Volume->ClusterSize, &Offset);
 
-    while
-    (
-      !FAT_CLUSTER_FUNCTIONAL (File->CurrentCluster) &&
-      AlignedPos + File->Volume->ClusterSize <= File->CurrentPos + Pos
-      ) {
-      AlignedPos += File->Volume->ClusterSize;
-      Status = FatGetNextCluster (
-                 PrivateData,
-                 File->Volume,
-                 File->CurrentCluster,
-                 &File->CurrentCluster
-                 );
-      if (EFI_ERROR (Status)) {
-        return EFI_DEVICE_ERROR;
-      }
-    }
-
-    if (FAT_CLUSTER_FUNCTIONAL (File->CurrentCluster)) {
+    Status = FatGetClusterRun (PrivateData, File, FileCluster, &Cluster, &Count);
+    if (Status == EFI_NOT_FOUND) {
+      File->CurrentCluster = Cluster;
       return EFI_INVALID_PARAMETER;
+    } else if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
     }
 
-    File->CurrentPos += Pos;
+    File->CurrentCluster = Cluster;
+    File->CurrentPos     = NewPos;
     //
-    // Calculate the amount of consecutive cluster occupied by the file.
+    // The amount of consecutive cluster occupied by the file.
     // FatReadFile() will use it to read these blocks once.
     //
-    File->StraightReadAmount  = 0;
-    Cluster                   = File->CurrentCluster;
-    while (!FAT_CLUSTER_FUNCTIONAL (Cluster)) {
-      File->StraightReadAmount += File->Volume->ClusterSize;
-      PrevCluster = Cluster;
-      Status      = FatGetNextCluster (PrivateData, File->Volume, Cluster, &Cluster);
-      if (EFI_ERROR (Status)) {
-        return EFI_DEVICE_ERROR;
-      }
-
-      if (Cluster != PrevCluster + 1) {
-        break;
-      }
-    }
-
-    DivU64x32Remainder (File->CurrentPos, File->Volume->ClusterSize, &Offset);
-    File->StraightReadAmount -= (UINT32) Offset;
+    File->StraightReadAmount = Count * File->Volume->ClusterSize - Offset;
 
   }
 
@@ -138,7 +138,10 @@ FatReadBlock (
 
 /**
   Find a cache block designated to specific Block device and Lba.
-  If not found, invalidate an oldest one and use it. (LRU cache)
+  If not found, invalidate the least recently used one and use it. (LRU cache)
+
+  A cache buffer holds several consecutive blocks, so a miss reads ahead
+  the blocks following Lba as well.
 
   @param  PrivateData       the global memory map.
   @param  BlockDeviceNo     the Block device.
@@ -160,53 +163,72 @@ FatGetCacheBlock (
 {
   EFI_STATUS            Status;
   PEI_FAT_CACHE_BUFFER  *CacheBuffer;
+  PEI_FAT_BLOCK_DEVICE  *BlockDev;
   INTN                  Index;
-  STATIC UINT8          Seed;
-
-  Status      = EFI_SUCCESS;
-  CacheBuffer = NULL;
+  INTN                  Victim;
+  UINT32                BlockSize;
+  UINT32                LineBlocks;
+  UINT32                Remainder;
+  UINT64                LineLba;
 
   //
-  // go through existing cache buffers
+  // Current device ID should be less than maximum device ID.
   //
-  for (Index = 0; Index < PEI_FAT_CACHE_SIZE; Index++) {
-    CacheBuffer = & (PrivateData->CacheBuffer[Index]);
-    if (CacheBuffer->Valid && CacheBuffer->BlockDeviceNo == BlockDeviceNo && CacheBuffer->Lba == Lba) {
-      break;
-    }
+  if (BlockDeviceNo >= PEI_FAT_MAX_BLOCK_DEVICE) {
+    return EFI_DEVICE_ERROR;
   }
 
-  if (Index < PEI_FAT_CACHE_SIZE) {
-    *CachePtr = (CHAR8 *) CacheBuffer->Buffer;
-    return EFI_SUCCESS;
+  BlockDev   = &PrivateData->BlockDevice[BlockDeviceNo];
+  BlockSize  = BlockDev->BlockSize;
+  LineBlocks = PEI_FAT_MAX_BLOCK_SIZE / BlockSize;
+  if (LineBlocks == 0) {
+    return EFI_DEVICE_ERROR;
   }
+  DivU64x32Remainder (Lba, LineBlocks, &Remainder);
+  LineLba = Lba - Remainder;
+
   //
-  // We have to find an invalid cache buffer
+  // go through existing cache buffers, and pick the victim on the way
   //
+  Victim = 0;
   for (Index = 0; Index < PEI_FAT_CACHE_SIZE; Index++) {
-    if (!PrivateData->CacheBuffer[Index].Valid) {
-      break;
+    CacheBuffer = & (PrivateData->CacheBuffer[Index]);
+    if (!CacheBuffer->Valid) {
+      if (PrivateData->CacheBuffer[Victim].Valid) {
+        Victim = Index;
+      }
+      continue;
+    }
+
+    if ((CacheBuffer->BlockDeviceNo == BlockDeviceNo) && (CacheBuffer->Lba == LineLba) &&
+        (MultU64x32 (Lba - LineLba + 1, BlockSize) <= CacheBuffer->Size)) {
+      CacheBuffer->Lru = ++PrivateData->CacheLru;
+      *CachePtr = (CHAR8 *) CacheBuffer->Buffer + (UINTN) MultU64x32 (Lba - LineLba, BlockSize);
+      return EFI_SUCCESS;
+    }
+
+    if (PrivateData->CacheBuffer[Victim].Valid && (CacheBuffer->Lru < PrivateData->CacheBuffer[Victim].Lru)) {
+      Victim = Index;
     }
   }
+
   //
-  // Use the cache buffer
+  // Read ahead up to a full cache buffer, but not beyond the device end
   //
-  if (Index == PEI_FAT_CACHE_SIZE) {
-    Index = (Seed++) % PEI_FAT_CACHE_SIZE;
+  if (LineLba + LineBlocks - 1 > BlockDev->LastBlock) {
+    LineBlocks = (UINT32) (BlockDev->LastBlock - LineLba + 1);
   }
 
   //
-  // Current device ID should be less than maximum device ID.
+  // Claim the cache buffer before reading, the read for a logical device
+  // goes through the cache of its parent device.
   //
-  if (BlockDeviceNo >= PEI_FAT_MAX_BLOCK_DEVICE) {
-    return EFI_DEVICE_ERROR;
-  }
-
-  CacheBuffer                 = & (PrivateData->CacheBuffer[Index]);
-
+  CacheBuffer                 = & (PrivateData->CacheBuffer[Victim]);
+  CacheBuffer->Valid          = TRUE;
   CacheBuffer->BlockDeviceNo  = BlockDeviceNo;
-  CacheBuffer->Lba            = Lba;
-  CacheBuffer->Size           = PrivateData->BlockDevice[BlockDeviceNo].BlockSize;
+  CacheBuffer->Lba            = MAX_UINT64;
+  CacheBuffer->Lru            = ++PrivateData->CacheLru;
+  CacheBuffer->Size           = LineBlocks * BlockSize;
 
   //
   // Read in the data
@@ -214,16 +236,17 @@ FatGetCacheBlock (
   Status = FatReadBlock (
              PrivateData,
              BlockDeviceNo,
-             Lba,
+             LineLba,
              CacheBuffer->Size,
              CacheBuffer->Buffer
              );
   if (EFI_ERROR (Status)) {
+    CacheBuffer->Valid = FALSE;
     return EFI_DEVICE_ERROR;
   }
 
-  CacheBuffer->Valid  = TRUE;
-  *CachePtr           = (CHAR8 *) CacheBuffer->Buffer;
+  CacheBuffer->Lba    = LineLba;
+  *CachePtr           = (CHAR8 *) CacheBuffer->Buffer + (UINTN) MultU64x32 (Lba - LineLba, BlockSize);
 
   return Status;
 }
@@ -266,24 +289,27 @@ FatReadDisk (
 
   //
   // Read underrun
+  // A block aligned read of full blocks goes to the device directly.
   //
   Lba     = DivU64x32Remainder (StartingAddress, BlockSize, &Offset);
-  Status  = FatGetCacheBlock (PrivateData, BlockDeviceNo, Lba, &CachePtr);
-  if (EFI_ERROR (Status)) {
-    return EFI_DEVICE_ERROR;
-  }
+  if ((Offset != 0) || (Size < BlockSize)) {
+    Status  = FatGetCacheBlock (PrivateData, BlockDeviceNo, Lba, &CachePtr);
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
 
-  Amount = Size < (BlockSize - Offset) ? Size : (BlockSize - Offset);
-  CopyMem (BufferPtr, CachePtr + Offset, Amount);
+    Amount = Size < (BlockSize - Offset) ? Size : (BlockSize - Offset);
+    CopyMem (BufferPtr, CachePtr + Offset, Amount);
 
-  if (Size == Amount) {
-    return EFI_SUCCESS;
-  }
+    if (Size == Amount) {
+      return EFI_SUCCESS;
+    }
 
-  Size -= Amount;
-  BufferPtr += Amount;
-  StartingAddress += Amount;
-  Lba += 1;
+    Size -= Amount;
+    BufferPtr += Amount;
+    StartingAddress += Amount;
+    Lba += 1;
+  }
 
   //
   // Read aligned parts
@@ -291,9 +317,11 @@ FatReadDisk (
   OverRunLba = Lba + DivU64x32Remainder (Size, BlockSize, &Offset);
 
   Size -= Offset;
-  Status = FatReadBlock (PrivateData, BlockDeviceNo, Lba, Size, BufferPtr);
-  if (EFI_ERROR (Status)) {
-    return EFI_DEVICE_ERROR;
+  if (Size > 0) {
+    Status = FatReadBlock (PrivateData, BlockDeviceNo, Lba, Size, BufferPtr);
+    if (EFI_ERROR (Status)) {
+      return EFI_DEVICE_ERROR;
+    }
   }
 
   BufferPtr += Size;
@@ -26,8 +26,9 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 //
 // Definitions
 //
-#define PEI_FAT_CACHE_SIZE                            4
+#define PEI_FAT_CACHE_SIZE                            16
 #define PEI_FAT_MAX_BLOCK_SIZE                        8192
+#define PEI_FAT_MAX_CLUSTER_RUN                       16
 #define FAT_MAX_FILE_NAME_LENGTH                      128
 #define PEI_FAT_MAX_BLOCK_DEVICE                      64
 #define PEI_FAT_MAX_BLOCK_IO_PPI                      32
@@ -78,6 +79,15 @@ typedef struct {
   UINT32        RootDirCluster;
 } PEI_FAT_VOLUME;
 
+//
+// A run of contiguous clusters occupied by a file
+//
+typedef struct {
+  UINT32          FileCluster;    // Cluster index within the file
+  UINT32          Cluster;        // First cluster number of the run on the volume
+  UINT32          Count;          // Number of contiguous clusters
+} PEI_FAT_CLUSTER_RUN;
+
 //
 // File instance
 //
@@ -92,10 +102,14 @@ typedef struct {
   UINT32          CurrentCluster;
   UINT8           Attributes;
   UINT32          FileSize;
+  UINT32          RunCount;
+  PEI_FAT_CLUSTER_RUN  Run[PEI_FAT_MAX_CLUSTER_RUN];
 } PEI_FAT_FILE;
 
 //
 // Cache Buffer
+// Each cache buffer holds up to PEI_FAT_MAX_BLOCK_SIZE bytes of consecutive
+// blocks starting from Lba, so that a miss also reads ahead the next blocks.
 //
 typedef struct {
   BOOLEAN Valid;
@@ -177,6 +191,7 @@ typedef struct {
   PEI_FAT_VOLUME                      Volume[PEI_FAT_MAX_VOLUME];
   PEI_FAT_FILE                        File;
   PEI_FAT_CACHE_BUFFER                CacheBuffer[PEI_FAT_CACHE_SIZE];
+  UINT32                              CacheLru;
 } PEI_FAT_PRIVATE_DATA;
 
 
@@ -1,7 +1,7 @@
 /** @file
   Basic graphics rendering support
 
-  Copyright (c) 2017 - 2019, Intel Corporation. All rights reserved.<BR>
+  Copyright (c) 2017 - 2021, Intel Corporation. All rights reserved.<BR>
   SPDX-License-Identifier: BSD-2-Clause-Patent
 
 **/
@@ -12,6 +12,12 @@
 
 #define  ANSI_ESCAPE_SEQ_CLEAR_SCREEN    (UINT8 *)"\x1b[2J"
 
+//
+// Largest console area (in bytes) cached in the shadow buffer; it is carved
+// from the payload heap, so bigger consoles draw into the frame buffer directly.
+//
+#define  CONSOLE_SHADOW_MAX_SIZE         SIZE_8MB
+
 CONST EFI_GRAPHICS_OUTPUT_BLT_PIXEL mColors[16] = {
   //
   // B     G     R
@@ -87,6 +93,37 @@ BltToFrameBuffer (
   return EFI_SUCCESS;
 }
 
+/**
+  Get the index of a glyph in the narrow font table (ASCII only).
+
+  @param[in] Glyph               ASCII character
+
+  @retval                        Index into gUsStdNarrowGlyphData
+
+**/
+STATIC
+UINTN
+GetGlyphIndex (
+  IN CHAR8                         Glyph
+  )
+{
+  UINTN                            Code;
+  UINTN                            Base;
+
+  // Glyph table maps to ASCII characters, index the table with the character
+  Code = (UINTN)(Glyph & 0xFF);
+  Base = 0xAF;
+  if ((Code >= Base) && (Code <= 0xF2)) {
+    Code = (0x80 - 0x20) + (Code - Base);
+  } else if ((Code >= 0x20) && (Code <= 0x7F)) {
+    Code = Code - 0x20;
+  } else {
+    Code = 0;
+  }
+
+  return Code;
+}
+
 /**
   Draw a glyph into the frame buffer (ASCII only).
 
@@ -116,8 +153,6 @@ BltGlyphToFrameBuffer (
   UINTN                            Width, Height;
   UINTN                            Row;
   UINTN                            Col;
-  UINTN                            Code;
-  UINTN                            Base;
   EFI_GRAPHICS_OUTPUT_BLT_PIXEL    GopBlt[GLYPH_WIDTH * GLYPH_HEIGHT];
 
   if (GfxInfoHob == NULL) {
@@ -128,18 +163,7 @@ BltGlyphToFrameBuffer (
   Height = GLYPH_HEIGHT;
 
   // Glyph table maps to ASCII characters, index the table with the character
-  Code = (UINTN)(Glyph & 0xFF);
-  Base = 0xAF;
-  if ((Code >= Base) && (Code <= 0xF2)) {
-    Code = (0x80 - 0x20) + (Code - Base);
-  } else if ((Code >= 0x20) && (Code <= 0x7F)) {
-    Code = Code - 0x20;
-  } else {
-    Code = 0;
-  }
-
-  // Glyph table maps to ASCII characters, index the table with the character
-  GlyphBitmap = gUsStdNarrowGlyphData[Code].GlyphCol1;
+  GlyphBitmap = gUsStdNarrowGlyphData[GetGlyphIndex (Glyph)].GlyphCol1;
 
   for (Row = 0; Row < Height; Row++) {
     for (Col = 0; Col < Width; Col++) {
@@ -150,6 +174,298 @@ BltGlyphToFrameBuffer (
   return BltToFrameBuffer (GfxInfoHob, GopBlt, Width, Height, OffX, OffY);
 }
 
+/**
+  Expand every glyph of the narrow font into the glyph atlas using the
+  given colors.
+
+  @param[in] Console             Pointer to the frame buffer console
+  @param[in] ForegroundColor     Foreground color to use
+  @param[in] BackgroundColor     Background color to use
+
+**/
+STATIC
+VOID
+BuildGlyphAtlas (
+  IN FRAME_BUFFER_CONSOLE          *Console,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL ForegroundColor,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL BackgroundColor
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION  Fg;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION  Bg;
+  UINT8                               *GlyphBitmap;
+  UINT32                              *Pixel;
+  UINTN                                Index;
+  UINTN                                Row;
+  UINTN                                Col;
+
+  Fg.Pixel = ForegroundColor;
+  Bg.Pixel = BackgroundColor;
+  Pixel    = Console->GlyphAtlas;
+  for (Index = 0; Index < Console->GlyphCount; Index++) {
+    GlyphBitmap = gUsStdNarrowGlyphData[Index].GlyphCol1;
+    for (Row = 0; Row < GLYPH_HEIGHT; Row++) {
+      for (Col = 0; Col < GLYPH_WIDTH; Col++) {
+        *Pixel++ = ((GlyphBitmap[Row] & (1 << (GLYPH_WIDTH - Col - 1))) != 0) ? Fg.Raw : Bg.Raw;
+      }
+    }
+  }
+
+  Console->AtlasForegroundColor = ForegroundColor;
+  Console->AtlasBackgroundColor = BackgroundColor;
+}
+
+/**
+  Add a rectangle of the console area to the region to be flushed.
+
+  @param[in] Console             Pointer to the frame buffer console
+  @param[in] PosX                X offset of the rectangle within the console
+  @param[in] PosY                Y offset of the rectangle within the console
+  @param[in] Width               Width of the rectangle
+  @param[in] Height              Height of the rectangle
+
+**/
+STATIC
+VOID
+MarkShadowDirty (
+  IN FRAME_BUFFER_CONSOLE    *Console,
+  IN UINTN                    PosX,
+  IN UINTN                    PosY,
+  IN UINTN                    Width,
+  IN UINTN                    Height
+  )
+{
+  if (Console->DirtyRight <= Console->DirtyLeft) {
+    Console->DirtyLeft   = PosX;
+    Console->DirtyTop    = PosY;
+    Console->DirtyRight  = PosX + Width;
+    Console->DirtyBottom = PosY + Height;
+    return;
+  }
+
+  Console->DirtyLeft   = MIN (Console->DirtyLeft,   PosX);
+  Console->DirtyTop    = MIN (Console->DirtyTop,    PosY);
+  Console->DirtyRight  = MAX (Console->DirtyRight,  PosX + Width);
+  Console->DirtyBottom = MAX (Console->DirtyBottom, PosY + Height);
+}
+
+/**
+  Copy the dirty rectangle of the shadow buffer into the frame buffer.
+
+  Each row is copied with CopyMem, which uses non-temporal 16-byte stores
+  for the aligned part of the row when built with BaseMemoryLibSse2.
+
+  @param[in] Console             Pointer to the frame buffer console
+
+**/
+STATIC
+VOID
+FlushShadowBuffer (
+  IN FRAME_BUFFER_CONSOLE    *Console
+  )
+{
+  UINT32                     *FrameBufferPtr;
+  UINT32                     *ShadowPtr;
+  UINTN                       Stride;
+  UINTN                       Length;
+  UINTN                       Row;
+
+  if ((Console->ShadowBuf == NULL) || (Console->DirtyRight <= Console->DirtyLeft)) {
+    return;
+  }
+
+  Stride         = Console->GfxInfoHob->GraphicsMode.HorizontalResolution;
+  FrameBufferPtr = (UINT32 *) (UINTN) (Console->GfxInfoHob->FrameBufferBase);
+  FrameBufferPtr = &FrameBufferPtr[(Console->OffY + Console->DirtyTop) * Stride + Console->OffX + Console->DirtyLeft];
+  ShadowPtr      = &Console->ShadowBuf[Console->DirtyTop * Console->Width + Console->DirtyLeft];
+  Length         = (Console->DirtyRight - Console->DirtyLeft) * sizeof (UINT32);
+  for (Row = Console->DirtyTop; Row < Console->DirtyBottom; Row++) {
+    CopyMem (FrameBufferPtr, ShadowPtr, Length);
+    FrameBufferPtr += Stride;
+    ShadowPtr      += Console->Width;
+  }
+
+  Console->DirtyLeft   = 0;
+  Console->DirtyTop    = 0;
+  Console->DirtyRight  = 0;
+  Console->DirtyBottom = 0;
+}
+
+/**
+  Draw a glyph into the console shadow buffer (ASCII only).
+
+  Glyphs using the atlas colors are copied from the pre-expanded glyph atlas,
+  all others are expanded from the font bitmap.
+
+  @param[in] Console             Pointer to the frame buffer console
+  @param[in] Glyph               ASCII character to write
+  @param[in] ForegroundColor     Foreground color to use
+  @param[in] BackgroundColor     Background color to use
+  @param[in] PosX                X offset within the console
+  @param[in] PosY                Y offset within the console
+
+  @retval EFI_SUCCESS            Success
+  @retval EFI_INVALID_PARAMETER  Could not draw entire glyph in the console
+
+**/
+STATIC
+EFI_STATUS
+BltGlyphToShadowBuffer (
+  IN FRAME_BUFFER_CONSOLE          *Console,
+  IN CHAR8                         Glyph,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL ForegroundColor,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL BackgroundColor,
+  IN UINTN                         PosX,
+  IN UINTN                         PosY
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION  Fg;
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION  Bg;
+  UINT8                               *GlyphBitmap;
+  UINT32                              *GlyphPixel;
+  UINT32                              *ShadowPtr;
+  UINTN                                Code;
+  UINTN                                Row;
+  UINTN                                Col;
+
+  if (((PosX + GLYPH_WIDTH) > Console->Width) || ((PosY + GLYPH_HEIGHT) > Console->Height)) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  Code      = GetGlyphIndex (Glyph);
+  ShadowPtr = &Console->ShadowBuf[PosY * Console->Width + PosX];
+  if ((CompareMem (&ForegroundColor, &Console->AtlasForegroundColor, sizeof (ForegroundColor)) == 0) &&
+      (CompareMem (&BackgroundColor, &Console->AtlasBackgroundColor, sizeof (BackgroundColor)) == 0)) {
+    GlyphPixel = &Console->GlyphAtlas[Code * GLYPH_WIDTH * GLYPH_HEIGHT];
+    for (Row = 0; Row < GLYPH_HEIGHT; Row++) {
+      CopyMem (ShadowPtr, GlyphPixel, GLYPH_WIDTH * sizeof (UINT32));
+      GlyphPixel += GLYPH_WIDTH;
+      ShadowPtr  += Console->Width;
+    }
+  } else {
+    Fg.Pixel    = ForegroundColor;
+    Bg.Pixel    = BackgroundColor;
+    GlyphBitmap = gUsStdNarrowGlyphData[Code].GlyphCol1;
+    for (Row = 0; Row < GLYPH_HEIGHT; Row++) {
+      for (Col = 0; Col < GLYPH_WIDTH; Col++) {
+        ShadowPtr[Col] = ((GlyphBitmap[Row] & (1 << (GLYPH_WIDTH - Col - 1))) != 0) ? Fg.Raw : Bg.Raw;
+      }
+      ShadowPtr += Console->Width;
+    }
+  }
+
+  MarkShadowDirty (Console, PosX, PosY, GLYPH_WIDTH, GLYPH_HEIGHT);
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Draw a glyph of the frame buffer console at the given console offset.
+
+  @param[in] Console             Pointer to the frame buffer console
+  @param[in] Glyph               ASCII character to write
+  @param[in] ForegroundColor     Foreground color to use
+  @param[in] BackgroundColor     Background color to use
+  @param[in] PosX                X offset within the console
+  @param[in] PosY                Y offset within the console
+
+  @retval EFI_SUCCESS            Success
+  @retval EFI_INVALID_PARAMETER  Could not draw entire glyph
+
+**/
+STATIC
+EFI_STATUS
+ConsoleDrawGlyph (
+  IN FRAME_BUFFER_CONSOLE          *Console,
+  IN CHAR8                         Glyph,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL ForegroundColor,
+  IN EFI_GRAPHICS_OUTPUT_BLT_PIXEL BackgroundColor,
+  IN UINTN                         PosX,
+  IN UINTN                         PosY
+  )
+{
+  if (Console->ShadowBuf != NULL) {
+    return BltGlyphToShadowBuffer (Console, Glyph, ForegroundColor, BackgroundColor, PosX, PosY);
+  }
+
+  return BltGlyphToFrameBuffer (Console->GfxInfoHob, Glyph, ForegroundColor, BackgroundColor,
+                                Console->OffX + PosX, Console->OffY + PosY);
+}
+
+/**
+  Allocate the console shadow buffer and glyph atlas.
+
+  The shadow buffer starts out cleared, so it must only be created when the
+  console area is known to be blank (i.e. on a clear screen). Consoles larger
+  than CONSOLE_SHADOW_MAX_SIZE, or consoles for which the buffers cannot be
+  allocated, draw directly into the frame buffer.
+
+  @param[in] Console             Pointer to the frame buffer console
+
+**/
+STATIC
+VOID
+InitConsoleShadowBuffer (
+  IN FRAME_BUFFER_CONSOLE    *Console
+  )
+{
+  UINTN                       ShadowSize;
+
+  if (Console->ShadowBuf != NULL) {
+    return;
+  }
+
+  ShadowSize = Console->Width * Console->Height * sizeof (UINT32);
+  if (ShadowSize > CONSOLE_SHADOW_MAX_SIZE) {
+    return;
+  }
+
+  Console->GlyphCount = mNarrowFontSize / sizeof (EFI_NARROW_GLYPH);
+  Console->GlyphAtlas = AllocatePool (Console->GlyphCount * GLYPH_WIDTH * GLYPH_HEIGHT * sizeof (UINT32));
+  if (Console->GlyphAtlas == NULL) {
+    return;
+  }
+
+  Console->ShadowBuf = AllocatePages (EFI_SIZE_TO_PAGES (ShadowSize));
+  if (Console->ShadowBuf == NULL) {
+    FreePool (Console->GlyphAtlas);
+    Console->GlyphAtlas = NULL;
+    return;
+  }
+
+  BuildGlyphAtlas (Console, Console->ForegroundColor, Console->BackgroundColor);
+  ZeroMem (Console->ShadowBuf, ShadowSize);
+  Console->DirtyRight = Console->DirtyLeft;
+}
+
+/**
+  Release the console shadow buffer and glyph atlas.
+
+  Pending changes are flushed to the frame buffer first. The console keeps
+  working afterwards by drawing directly into the frame buffer until the
+  next clear screen.
+
+**/
+VOID
+EFIAPI
+FrameBufferConsoleReleaseShadow (
+  VOID
+  )
+{
+  FRAME_BUFFER_CONSOLE  *Console;
+
+  Console = &mFbConsole;
+  if (Console->ShadowBuf == NULL) {
+    return;
+  }
+
+  FlushShadowBuffer (Console);
+  FreePages (Console->ShadowBuf, EFI_SIZE_TO_PAGES (Console->Width * Console->Height * sizeof (UINT32)));
+  FreePool (Console->GlyphAtlas);
+  Console->ShadowBuf  = NULL;
+  Console->GlyphAtlas = NULL;
+}
+
 /**
   Initialize the frame buffer console.
 
@@ -223,35 +539,87 @@ InitFrameBufferConsole (
 }
 
 /**
-  Scroll the console area of the screen up.
+  Scroll the text rows of the console shadow buffer up.
 
-  @param[in] ScrollAmount Amount (in rows) to scroll
+  The pixels are moved inside the cached shadow buffer instead of re-rendering
+  the glyphs, and the whole text area is marked dirty for the next flush.
 
-  @retval EFI_SUCCESS
+  @param[in] Console      Pointer to the frame buffer console
+  @param[in] ScrollAmount Amount (in rows) to scroll, less than Console->Rows
 
 **/
-EFI_STATUS
-EFIAPI
-FrameBufferConsoleScroll (
-  IN UINTN               ScrollAmount
+STATIC
+VOID
+ScrollShadowBuffer (
+  IN FRAME_BUFFER_CONSOLE  *Console,
+  IN UINTN                  ScrollAmount
+  )
+{
+  EFI_GRAPHICS_OUTPUT_BLT_PIXEL_UNION  Bg;
+  UINT32                              *ShadowPtr;
+  UINTN                                TextWidth;
+  UINTN                                TextHeight;
+  UINTN                                Shift;
+  UINTN                                Row;
+
+  Bg.Pixel   = Console->BackgroundColor;
+  TextWidth  = Console->Cols * GLYPH_WIDTH;
+  TextHeight = Console->Rows * GLYPH_HEIGHT;
+  Shift      = ScrollAmount * GLYPH_HEIGHT;
+
+  ShadowPtr  = Console->ShadowBuf;
+  if (TextWidth == Console->Width) {
+    CopyMem (ShadowPtr, &ShadowPtr[Shift * Console->Width], (TextHeight - Shift) * Console->Width * sizeof (UINT32));
+    SetMem32 (&ShadowPtr[(TextHeight - Shift) * Console->Width], Shift * Console->Width * sizeof (UINT32), Bg.Raw);
+  } else {
+    for (Row = 0; Row < TextHeight; Row++) {
+      if (Row < TextHeight - Shift) {
+        CopyMem (ShadowPtr, &ShadowPtr[Shift * Console->Width], TextWidth * sizeof (UINT32));
+      } else {
+        SetMem32 (ShadowPtr, TextWidth * sizeof (UINT32), Bg.Raw);
+      }
+      ShadowPtr += Console->Width;
+    }
+  }
+
+  MarkShadowDirty (Console, 0, 0, TextWidth, TextHeight);
+}
+
+/**
+  Scroll the console area of the screen up without flushing the shadow buffer.
+
+  @param[in] Console      Pointer to the frame buffer console
+  @param[in] ScrollAmount Amount (in rows) to scroll
+
+**/
+STATIC
+VOID
+ConsoleScroll (
+  IN FRAME_BUFFER_CONSOLE  *Console,
+  IN UINTN                  ScrollAmount
   )
 {
-  FRAME_BUFFER_CONSOLE   *Console;
   UINTN                  BufX;
   UINTN                  BufY;
   UINTN                  BufPos;
   UINTN                  ScreenX;
   UINTN                  ScreenY;
 
-  Console = &mFbConsole;
-  if (Console->Height == 0) {
-    return EFI_UNSUPPORTED;
-  }
-
   if (ScrollAmount > Console->Rows) {
     ScrollAmount = Console->Rows;
   }
 
+  if ((Console->ShadowBuf != NULL) && (ScrollAmount > 0) && (ScrollAmount < Console->Rows)) {
+    // Move the text and the rendered pixels together
+    CopyMem (&Console->TextDisplayBuf[0],
+             &Console->TextDisplayBuf[Console->Cols * ScrollAmount],
+             Console->Cols * (Console->Rows - ScrollAmount));
+    ZeroMem (&Console->TextDisplayBuf[Console->Cols * (Console->Rows - ScrollAmount)],
+             Console->Cols * ScrollAmount);
+    ScrollShadowBuffer (Console, ScrollAmount);
+    return;
+  }
+
   if (ScrollAmount < Console->Rows) {
     // Move all lines in text buffer up
     CopyMem (&Console->TextSwapBuf[0],
@@ -270,21 +638,46 @@ FrameBufferConsoleScroll (
   // every character of the buffer and update the framebuffer with any
   // differences.
   BufPos = 0;
-  ScreenY = Console->OffY;
+  ScreenY = 0;
   for (BufY = 0; BufY < Console->Rows; BufY++) {
-    ScreenX = Console->OffX;
+    ScreenX = 0;
     for (BufX = 0; BufX < Console->Cols; BufX++) {
       if (Console->TextSwapBuf[BufPos] != Console->TextDisplayBuf[BufPos]) {
         Console->TextDisplayBuf[BufPos] = Console->TextSwapBuf[BufPos];
-        BltGlyphToFrameBuffer (Console->GfxInfoHob, Console->TextSwapBuf[BufPos],
-                               Console->ForegroundColor, Console->BackgroundColor,
-                               ScreenX, ScreenY);
+        ConsoleDrawGlyph (Console, Console->TextSwapBuf[BufPos],
+                          Console->ForegroundColor, Console->BackgroundColor,
+                          ScreenX, ScreenY);
       }
       BufPos++;
       ScreenX += GLYPH_WIDTH;
     }
     ScreenY += GLYPH_HEIGHT;
   }
+}
+
+/**
+  Scroll the console area of the screen up.
+
+  @param[in] ScrollAmount Amount (in rows) to scroll
+
+  @retval EFI_SUCCESS
+
+**/
+EFI_STATUS
+EFIAPI
+FrameBufferConsoleScroll (
+  IN UINTN               ScrollAmount
+  )
+{
+  FRAME_BUFFER_CONSOLE   *Console;
+
+  Console = &mFbConsole;
+  if (Console->Height == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  ConsoleScroll (Console, ScrollAmount);
+  FlushShadowBuffer (Console);
 
   return EFI_SUCCESS;
 }
@@ -338,6 +731,13 @@ FrameBufferWrite (
     GfxInfoHob = Console->GfxInfoHob;
     Length = (GfxInfoHob->GraphicsMode.HorizontalResolution * GfxInfoHob->GraphicsMode.PixelsPerScanLine) * 4;
     SetMem64 ((UINT32 *) (UINTN)(GfxInfoHob->FrameBufferBase), Length, 0);
+    // The console area is blank now, so the shadow can start from a known state
+    if (Console->ShadowBuf == NULL) {
+      InitConsoleShadowBuffer (Console);
+    } else {
+      ZeroMem (Console->ShadowBuf, Console->Width * Console->Height * sizeof (UINT32));
+      Console->DirtyRight = Console->DirtyLeft;
+    }
     Console->CursorX = 0;
     Console->CursorY = 0;
     return NumberOfBytes;
@@ -352,7 +752,7 @@ FrameBufferWrite (
 
     // Create new line when cursor overflows rows
     if (Console->CursorY >= Console->Rows) {
-      FrameBufferConsoleScroll (1);
+      ConsoleScroll (Console, 1);
       Console->CursorY = Console->Rows - 1;
       Console->CursorX = 0;
     }
@@ -379,10 +779,10 @@ FrameBufferWrite (
       Console->CursorX = 0;
     } else {
       Console->TextDisplayBuf[Console->CursorY * Console->Cols + Console->CursorX] = Buffer[Pos];
-      Status = BltGlyphToFrameBuffer (Console->GfxInfoHob, Buffer[Pos],
-                                      Console->ForegroundColor, Console->BackgroundColor,
-                                      Console->OffX + Console->CursorX * GLYPH_WIDTH,
-                                      Console->OffY + Console->CursorY * GLYPH_HEIGHT);
+      Status = ConsoleDrawGlyph (Console, Buffer[Pos],
+                                 Console->ForegroundColor, Console->BackgroundColor,
+                                 Console->CursorX * GLYPH_WIDTH,
+                                 Console->CursorY * GLYPH_HEIGHT);
       if (Status != EFI_SUCCESS) {
         break;
       }
@@ -390,6 +790,8 @@ FrameBufferWrite (
     }
   }
 
+  FlushShadowBuffer (Console);
+
   return Pos;
 }
 
@@ -453,17 +855,19 @@ DrawFrameBuffer (
       Ptr   = (UINT16 *)(Console->TextDrawBuf + Pos);
       if (*Ptr != Value) {
         *Ptr = Value;
-        BltGlyphToFrameBuffer (
-          Console->GfxInfoHob, Buffer[Pos],
+        ConsoleDrawGlyph (
+          Console, Buffer[Pos],
           mColors[(Value >>  8) & 0x0F],
           mColors[(Value >> 12) & 0x0F],
-          Console->OffX + (PosX + OffX) * GLYPH_WIDTH,
-          Console->OffY + (PosY + OffY) * GLYPH_HEIGHT);
+          (PosX + OffX) * GLYPH_WIDTH,
+          (PosY + OffY) * GLYPH_HEIGHT);
       }
       Pos += 2;
     }
   }
 
+  FlushShadowBuffer (Console);
+
   return EFI_SUCCESS;
 }
 
@@ -14,6 +14,54 @@
 #include <Library/Crc32Lib.h>
 #include <Library/SecureBootLib.h>
 
+/**
+Prepare the hash request for the signed region of an IAS image.
+
+Only the layout of the IAS image is checked, so the digest can be calculated
+ahead of IsIasImageValidWithDigest (), e.g. on an AP.
+
+@param  ImageAddr         Address of the IAS image.
+@param  Size              Size of the IAS image.
+@param  Request           Hash request to prepare.
+
+@retval EFI_SUCCESS       The hash request is prepared.
+@retval EFI_UNSUPPORTED   No digest is needed or the image is not a signed IAS image.
+
+**/
+EFI_STATUS
+IasPrepareDigest (
+  IN  VOID               *ImageAddr,
+  IN  UINT32              Size,
+  OUT HASH_REQUEST       *Request
+  )
+{
+  IAS_HEADER                 *Hdr;
+
+  Hdr = (IAS_HEADER *) ImageAddr;
+  if (!FeaturePcdGet (PcdVerifiedBootEnabled) || (Size < sizeof (IAS_HEADER))) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if ((Hdr->MagicPattern != IAS_MAGIC_PATTERN) || (Hdr->DataOffset > Size) ||
+      !IAS_IMAGE_IS_SIGNED (Hdr->ImageType)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (((UINT8 *)IAS_IMAGE_END(Hdr) < (UINT8 *)Hdr) ||  ((UINT8 *)IAS_IMAGE_END(Hdr) > ((UINT8 *)Hdr + Size))) {
+    return EFI_UNSUPPORTED;
+  }
+
+  ZeroMem (Request, sizeof (HASH_REQUEST));
+  Request->Data         = (UINT8 *)Hdr;
+  Request->Length       = ((UINT32)IAS_PAYLOAD_END (Hdr)) - ((UINT32)(UINTN)Hdr);
+  Request->HashAlg      = HASH_TYPE_SHA256;
+  Request->ExtraHashAlg = HASH_TYPE_NONE;
+  Request->Status       = RETURN_NOT_READY;
+  Request->ExtraStatus  = RETURN_NOT_READY;
+
+  return EFI_SUCCESS;
+}
+
 /**
 Check the Addr parameter for a valid IAS image; ensure the format is correct,
 confirm the IAS header CRC is correct, and (optional) confirm the hash of the
@@ -34,6 +82,31 @@ IsIasImageValid (
   IN  UINT32              Size,
   OUT IAS_IMAGE_INFO     *IasImageInfo
   )
+{
+  return IsIasImageValidWithDigest (ImageAddr, Size, NULL, IasImageInfo);
+}
+
+/**
+Check the Addr parameter for a valid IAS image as IsIasImageValid () does.
+When the digest of the signed region has been calculated ahead of time, the
+signature is verified against it instead of hashing the image again.
+
+@param  Addr              Address of the IAS image to be verified for validity.
+@param  Size              Size of the IAS image to be verified for validity.
+@param  Digest            SHA-256 digest of the request from IasPrepareDigest (), or NULL.
+@param  IasImageInfo      IasImage buffer and hash info data structure
+
+@retval NULL  The IAS image is compromised.
+@retval Hdr   The IAS image is valid.
+
+**/
+IAS_HEADER *
+IsIasImageValidWithDigest (
+  IN  VOID               *ImageAddr,
+  IN  UINT32              Size,
+  IN  CONST UINT8        *Digest       OPTIONAL,
+  OUT IAS_IMAGE_INFO     *IasImageInfo
+  )
 {
   EFI_STATUS                 Status;
   IAS_HEADER                 *Hdr;
@@ -103,8 +176,13 @@ IsIasImageValid (
     Key->PubExp[Index]  = ((UINT8 *) IAS_PUBLIC_KEY (Hdr))[KeyIdx];
   }
 
-  Status = DoRsaVerify ((CONST UINT8 *)Hdr, ((UINT32)IAS_PAYLOAD_END (Hdr)) - ((UINT32)(UINTN)Hdr),
-                         HASH_USAGE_PUBKEY_OS, SignHdr, PubKeyHdr, PcdGet8(PcdCompSignHashAlg), NULL, IasImageInfo->HashData);
+  if (Digest != NULL) {
+    Status = DoRsaVerifyDigest (Digest, HASH_USAGE_PUBKEY_OS, SignHdr, PubKeyHdr, PcdGet8(PcdCompSignHashAlg), NULL);
+    CopyMem (IasImageInfo->HashData, Digest, SHA256_DIGEST_SIZE);
+  } else {
+    Status = DoRsaVerify ((CONST UINT8 *)Hdr, ((UINT32)IAS_PAYLOAD_END (Hdr)) - ((UINT32)(UINTN)Hdr),
+                           HASH_USAGE_PUBKEY_OS, SignHdr, PubKeyHdr, PcdGet8(PcdCompSignHashAlg), NULL, IasImageInfo->HashData);
+  }
   if (EFI_ERROR (Status) != EFI_SUCCESS) {
     DEBUG ((DEBUG_ERROR, "IAS image verification failed!\n"));
     return NULL;
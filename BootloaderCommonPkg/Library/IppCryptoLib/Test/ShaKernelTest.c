@@ -0,0 +1,470 @@
+/** @file
+Host known-answer and throughput test for the IppCryptoLib SHA kernels
+
+Runs every X64 SHA-256 and SHA-384 compression kernel the host CPU supports
+on messages of 1, 2, 4 and 8 blocks, and compares the digests with reference
+values. The messages are hashed both with separate calls for the message and
+the padding block, and with one call for all blocks, so the kernels that
+process several blocks at once see both even and odd block counts.
+
+Build and run with "make run" in this directory. It needs gcc and nasm.
+
+Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <cpuid.h>
+
+#define UTILITY_NAME "ShaKernelTest"
+
+//
+// The kernels use the firmware (Microsoft x64) calling convention
+//
+#define KERNEL_API  __attribute__((ms_abi))
+
+typedef void (KERNEL_API *SHA_KERNEL) (void *Hash, const unsigned char *Msg, int MsgLen, const void *Param);
+
+void KERNEL_API UpdateSHA256V8  (void *Hash, const unsigned char *Msg, int MsgLen, const void *Param);
+void KERNEL_API UpdateSHA256Ni  (void *Hash, const unsigned char *Msg, int MsgLen, const void *Param);
+void KERNEL_API UpdateSHA512W7  (void *Hash, const unsigned char *Msg, int MsgLen, const void *Param);
+void KERNEL_API UpdateSHA512G9  (void *Hash, const unsigned char *Msg, int MsgLen, const void *Param);
+void KERNEL_API UpdateSHA512L9  (void *Hash, const unsigned char *Msg, int MsgLen, const void *Param);
+
+#define CPU_SSSE3   0x01
+#define CPU_SSE41   0x02
+#define CPU_AVX     0x04
+#define CPU_AVX2    0x08
+#define CPU_BMI2    0x10
+#define CPU_SHA     0x20
+
+#define SHA256_BLOCK_SIZE   64
+#define SHA512_BLOCK_SIZE   128
+#define MAX_BLOCKS          8
+#define PERF_DATA_SIZE      (16 * 1024 * 1024)
+
+typedef struct {
+  const char    *Name;
+  SHA_KERNEL     Kernel;
+  unsigned int   CpuFeature;
+} KERNEL_ENTRY;
+
+typedef struct {
+  int            Blocks;
+  const char    *Digest;
+} KAT_ENTRY;
+
+static const unsigned int __attribute__((aligned(16))) mK256[64] = {
+  0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+  0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+  0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+  0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+  0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+  0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+  0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+  0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+static const unsigned long long __attribute__((aligned(16))) mK512[80] = {
+  0x428a2f98d728ae22ULL, 0x7137449123ef65cdULL, 0xb5c0fbcfec4d3b2fULL, 0xe9b5dba58189dbbcULL,
+  0x3956c25bf348b538ULL, 0x59f111f1b605d019ULL, 0x923f82a4af194f9bULL, 0xab1c5ed5da6d8118ULL,
+  0xd807aa98a3030242ULL, 0x12835b0145706fbeULL, 0x243185be4ee4b28cULL, 0x550c7dc3d5ffb4e2ULL,
+  0x72be5d74f27b896fULL, 0x80deb1fe3b1696b1ULL, 0x9bdc06a725c71235ULL, 0xc19bf174cf692694ULL,
+  0xe49b69c19ef14ad2ULL, 0xefbe4786384f25e3ULL, 0x0fc19dc68b8cd5b5ULL, 0x240ca1cc77ac9c65ULL,
+  0x2de92c6f592b0275ULL, 0x4a7484aa6ea6e483ULL, 0x5cb0a9dcbd41fbd4ULL, 0x76f988da831153b5ULL,
+  0x983e5152ee66dfabULL, 0xa831c66d2db43210ULL, 0xb00327c898fb213fULL, 0xbf597fc7beef0ee4ULL,
+  0xc6e00bf33da88fc2ULL, 0xd5a79147930aa725ULL, 0x06ca6351e003826fULL, 0x142929670a0e6e70ULL,
+  0x27b70a8546d22ffcULL, 0x2e1b21385c26c926ULL, 0x4d2c6dfc5ac42aedULL, 0x53380d139d95b3dfULL,
+  0x650a73548baf63deULL, 0x766a0abb3c77b2a8ULL, 0x81c2c92e47edaee6ULL, 0x92722c851482353bULL,
+  0xa2bfe8a14cf10364ULL, 0xa81a664bbc423001ULL, 0xc24b8b70d0f89791ULL, 0xc76c51a30654be30ULL,
+  0xd192e819d6ef5218ULL, 0xd69906245565a910ULL, 0xf40e35855771202aULL, 0x106aa07032bbd1b8ULL,
+  0x19a4c116b8d2d0c8ULL, 0x1e376c085141ab53ULL, 0x2748774cdf8eeb99ULL, 0x34b0bcb5e19b48a8ULL,
+  0x391c0cb3c5c95a63ULL, 0x4ed8aa4ae3418acbULL, 0x5b9cca4f7763e373ULL, 0x682e6ff3d6b2b8a3ULL,
+  0x748f82ee5defb2fcULL, 0x78a5636f43172f60ULL, 0x84c87814a1f0ab72ULL, 0x8cc702081a6439ecULL,
+  0x90befffa23631e28ULL, 0xa4506cebde82bde9ULL, 0xbef9a3f7b2c67915ULL, 0xc67178f2e372532bULL,
+  0xca273eceea26619cULL, 0xd186b8c721c0c207ULL, 0xeada7dd6cde0eb1eULL, 0xf57d4f7fee6ed178ULL,
+  0x06f067aa72176fbaULL, 0x0a637dc5a2c898a6ULL, 0x113f9804bef90daeULL, 0x1b710b35131c471bULL,
+  0x28db77f523047d84ULL, 0x32caab7b40c72493ULL, 0x3c9ebe0a15c9bebcULL, 0x431d67c49c100d4cULL,
+  0x4cc5d4becb3e42b6ULL, 0x597f299cfc657e2aULL, 0x5fcb6fab3ad6faecULL, 0x6c44198c4a475817ULL
+};
+
+static const unsigned int mSha256Iv[8] = {
+  0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+static const unsigned long long mSha384Iv[8] = {
+  0xcbbb9d5dc1059ed8ULL, 0x629a292a367cd507ULL, 0x9159015a3070dd17ULL, 0x152fecd8f70e5939ULL,
+  0x67332667ffc00b31ULL, 0x8eb44a8768581511ULL, 0xdb0c2e0d64f98fa7ULL, 0x47b5481dbefa4fa4ULL
+};
+
+static const KERNEL_ENTRY mSha256Kernels[] = {
+  { "SHA-256 V8 (SSSE3)",       UpdateSHA256V8, CPU_SSSE3 },
+  { "SHA-256 Ni (SHA-NI)",      UpdateSHA256Ni, CPU_SHA | CPU_SSE41 },
+};
+
+static const KERNEL_ENTRY mSha384Kernels[] = {
+  { "SHA-384 W7 (SSE2)",        UpdateSHA512W7, 0 },
+  { "SHA-384 G9 (AVX)",         UpdateSHA512G9, CPU_AVX },
+  { "SHA-384 L9 (AVX2, BMI2)",  UpdateSHA512L9, CPU_AVX2 | CPU_BMI2 },
+};
+
+//
+// Digests of the messages with byte i = i * 31 + 7, of 1, 2, 4 and 8 blocks
+//
+static const KAT_ENTRY mSha256Kat[] = {
+  { 1, "c6ab9724ade5b6a7a1edfffb12f3aa9181351355af8fd08c919952ad211339dd" },
+  { 2, "cc548ca2dec1f6fe4f58b2e27aa9c7521607df1130d140b55a4dad0665302356" },
+  { 4, "c8c6e02d597fa6c407a5fec30c981c7bbad08972240eea89841b8f37e2fbf32c" },
+  { 8, "ac2d778f0a74ac00d4781913df18cfdd01a8a266e5db8c34322229f1968533f0" },
+};
+
+static const KAT_ENTRY mSha384Kat[] = {
+  { 1, "95ab88109cbf117548a8ad35909ffefa175d06a9c42614b9d359548cff5d550b30affb36ff638cd32aa5f5409066c68a" },
+  { 2, "1309811305efc73654ede73c40aaff0f19353c321689dcbb04138ab3fff3a6eabbc5a65af08da09fe44766d9e223826e" },
+  { 4, "49712d2066c7a9f5c5886e8d5e967f43e170100fd976a6dd294f6568b84f28ba97afaa1820bae16c28ff3bd31e8b320b" },
+  { 8, "842464fc1cdb79019d67aaf4a9dad824f2f44b3ea496a89155867a1f4eb5f4c8861cfa4266b72696a5f9e63bf74b9feb" },
+};
+
+//
+// FIPS 180-2 "abc" digests
+//
+static const char mSha256Abc[] = "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad";
+static const char mSha384Abc[] = "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7";
+
+static unsigned int
+GetCpuFeature (
+  void
+  )
+/*++
+
+Routine Description:
+
+  Get the CPU features the kernels depend on
+
+Returns:
+
+  CPU_XXX feature mask
+
+--*/
+{
+  unsigned int  Eax;
+  unsigned int  Ebx;
+  unsigned int  Ecx;
+  unsigned int  Edx;
+  unsigned int  XcrLo;
+  unsigned int  XcrHi;
+  unsigned int  Feature;
+
+  Feature = 0;
+  if (!__get_cpuid (1, &Eax, &Ebx, &Ecx, &Edx)) {
+    return 0;
+  }
+
+  if (Ecx & (1 << 9)) {
+    Feature |= CPU_SSSE3;
+  }
+  if (Ecx & (1 << 19)) {
+    Feature |= CPU_SSE41;
+  }
+  if ((Ecx & (1 << 27)) && (Ecx & (1 << 28))) {
+    // AVX needs the OS to save the ymm state
+    __asm__ ("xgetbv" : "=a" (XcrLo), "=d" (XcrHi) : "c" (0));
+    if ((XcrLo & 0x6) == 0x6) {
+      Feature |= CPU_AVX;
+    }
+  }
+
+  if (__get_cpuid_count (7, 0, &Eax, &Ebx, &Ecx, &Edx)) {
+    if ((Ebx & (1 << 5)) && (Feature & CPU_AVX)) {
+      Feature |= CPU_AVX2;
+    }
+    if (Ebx & (1 << 8)) {
+      Feature |= CPU_BMI2;
+    }
+    if (Ebx & (1 << 29)) {
+      Feature |= CPU_SHA;
+    }
+  }
+
+  return Feature;
+}
+
+static int
+PadMessage (
+  unsigned char  *Buffer,
+  int             MsgLen,
+  int             BlockSize
+  )
+/*++
+
+Routine Description:
+
+  Append the SHA padding to the message in Buffer
+
+Arguments:
+
+  Buffer          - message, with room for two more blocks
+
+  MsgLen          - message length in bytes
+
+  BlockSize       - 64 for SHA-256, 128 for SHA-384
+
+Returns:
+
+  Length of the padded message
+
+--*/
+{
+  int                 LenSize;
+  int                 PadLen;
+  int                 Index;
+  unsigned long long  BitLen;
+
+  // SHA-256 ends with a 64-bit length, SHA-384 with a 128-bit length
+  LenSize = (BlockSize == SHA256_BLOCK_SIZE) ? 8 : 16;
+  PadLen  = MsgLen + 1 + LenSize;
+  PadLen  = (PadLen + BlockSize - 1) / BlockSize * BlockSize;
+
+  memset (Buffer + MsgLen, 0, PadLen - MsgLen);
+  Buffer[MsgLen] = 0x80;
+  BitLen = (unsigned long long)MsgLen * 8;
+  for (Index = 0; Index < 8; Index++) {
+    Buffer[PadLen - 1 - Index] = (unsigned char)(BitLen >> (Index * 8));
+  }
+
+  return PadLen;
+}
+
+static void
+FormatDigest (
+  char          *Text,
+  const void    *State,
+  int            BlockSize
+  )
+/*++
+
+Routine Description:
+
+  Format the big-endian digest from the hash state words as hex string
+
+Arguments:
+
+  Text            - output, room for 97 characters
+
+  State           - hash state
+
+  BlockSize       - 64 for SHA-256, 128 for SHA-384
+
+--*/
+{
+  const unsigned int        *State32;
+  const unsigned long long  *State64;
+  int                        Index;
+
+  if (BlockSize == SHA256_BLOCK_SIZE) {
+    State32 = (const unsigned int *)State;
+    for (Index = 0; Index < 8; Index++) {
+      sprintf (Text + Index * 8, "%08x", State32[Index]);
+    }
+  } else {
+    State64 = (const unsigned long long *)State;
+    for (Index = 0; Index < 6; Index++) {
+      sprintf (Text + Index * 16, "%016llx", State64[Index]);
+    }
+  }
+}
+
+static int
+HashMessage (
+  const KERNEL_ENTRY  *Entry,
+  int                  BlockSize,
+  const unsigned char *Msg,
+  int                  MsgLen,
+  int                  SplitPadding,
+  char                *Text
+  )
+/*++
+
+Routine Description:
+
+  Hash a message with one kernel and format the digest
+
+Arguments:
+
+  Entry           - kernel to use
+
+  BlockSize       - 64 for SHA-256, 128 for SHA-384
+
+  Msg             - message
+
+  MsgLen          - message length, at most MAX_BLOCKS blocks
+
+  SplitPadding    - hash the full message blocks and the padding with separate calls
+
+  Text            - output digest as hex string
+
+Returns:
+
+  0             success
+  non-zero      otherwise
+
+--*/
+{
+  unsigned char       Buffer[(MAX_BLOCKS + 2) * SHA512_BLOCK_SIZE];
+  unsigned long long  State[8];
+  int                 FullLen;
+  int                 PadLen;
+
+  if (BlockSize == SHA256_BLOCK_SIZE) {
+    memcpy (State, mSha256Iv, sizeof (mSha256Iv));
+  } else {
+    memcpy (State, mSha384Iv, sizeof (mSha384Iv));
+  }
+
+  memcpy (Buffer, Msg, MsgLen);
+  PadLen = PadMessage (Buffer, MsgLen, BlockSize);
+
+  if (SplitPadding) {
+    FullLen = MsgLen / BlockSize * BlockSize;
+    if (FullLen > 0) {
+      Entry->Kernel (State, Buffer, FullLen, (BlockSize == SHA256_BLOCK_SIZE) ? (const void *)mK256 : (const void *)mK512);
+    }
+    Entry->Kernel (State, Buffer + FullLen, PadLen - FullLen, (BlockSize == SHA256_BLOCK_SIZE) ? (const void *)mK256 : (const void *)mK512);
+  } else {
+    Entry->Kernel (State, Buffer, PadLen, (BlockSize == SHA256_BLOCK_SIZE) ? (const void *)mK256 : (const void *)mK512);
+  }
+
+  FormatDigest (Text, State, BlockSize);
+  return 0;
+}
+
+static int
+TestKernel (
+  const KERNEL_ENTRY  *Entry,
+  int                  BlockSize,
+  const KAT_ENTRY     *Kat,
+  int                  KatCount,
+  const char          *AbcDigest,
+  const unsigned char *Msg
+  )
+/*++
+
+Routine Description:
+
+  Run the known-answer tests and the throughput test of one kernel
+
+Returns:
+
+  Number of failed tests
+
+--*/
+{
+  char              Text[128];
+  int               Failed;
+  int               Index;
+  int               Split;
+  unsigned char    *PerfData;
+  unsigned long long State[8];
+  struct timespec   Start;
+  struct timespec   End;
+  double            Seconds;
+
+  Failed = 0;
+  HashMessage (Entry, BlockSize, (const unsigned char *)"abc", 3, 1, Text);
+  if (strcmp (Text, AbcDigest) != 0) {
+    printf ("  FAIL \"abc\": %s\n", Text);
+    Failed++;
+  }
+
+  for (Index = 0; Index < KatCount; Index++) {
+    for (Split = 0; Split < 2; Split++) {
+      HashMessage (Entry, BlockSize, Msg, Kat[Index].Blocks * BlockSize, Split, Text);
+      if (strcmp (Text, Kat[Index].Digest) != 0) {
+        printf ("  FAIL %d block(s)%s: %s\n", Kat[Index].Blocks, Split ? " + padding" : " with padding", Text);
+        Failed++;
+      }
+    }
+  }
+
+  PerfData = (unsigned char *)calloc (1, PERF_DATA_SIZE);
+  if (PerfData != NULL) {
+    memset (State, 0, sizeof (State));
+    clock_gettime (CLOCK_MONOTONIC, &Start);
+    Entry->Kernel (State, PerfData, PERF_DATA_SIZE, (BlockSize == SHA256_BLOCK_SIZE) ? (const void *)mK256 : (const void *)mK512);
+    clock_gettime (CLOCK_MONOTONIC, &End);
+    Seconds = (End.tv_sec - Start.tv_sec) + (End.tv_nsec - Start.tv_nsec) / 1e9;
+    printf ("  %s, %.1f MB/s\n", Failed ? "FAILED" : "PASS", PERF_DATA_SIZE / Seconds / 1e6);
+    free (PerfData);
+  }
+
+  return Failed;
+}
+
+int
+main (
+  int    argc,
+  char  *argv[]
+  )
+/*++
+
+Routine Description:
+
+  Test all the SHA kernels the CPU supports
+
+Arguments:
+
+  Argc            - standard C main() argument count
+
+  Argv            - standard C main() argument list
+
+Returns:
+
+  0             success
+  non-zero      otherwise
+
+--*/
+{
+  unsigned char  Msg[MAX_BLOCKS * SHA512_BLOCK_SIZE];
+  unsigned int   Feature;
+  unsigned int   Index;
+  int            Failed;
+
+  for (Index = 0; Index < sizeof (Msg); Index++) {
+    Msg[Index] = (unsigned char)(Index * 31 + 7);
+  }
+
+  Feature = GetCpuFeature ();
+  Failed  = 0;
+
+  for (Index = 0; Index < sizeof (mSha256Kernels) / sizeof (mSha256Kernels[0]); Index++) {
+    printf ("%s\n", mSha256Kernels[Index].Name);
+    if ((Feature & mSha256Kernels[Index].CpuFeature) != mSha256Kernels[Index].CpuFeature) {
+      printf ("  SKIP, not supported by the CPU\n");
+      continue;
+    }
+    Failed += TestKernel (&mSha256Kernels[Index], SHA256_BLOCK_SIZE, mSha256Kat,
+                          sizeof (mSha256Kat) / sizeof (mSha256Kat[0]), mSha256Abc, Msg);
+  }
+
+  for (Index = 0; Index < sizeof (mSha384Kernels) / sizeof (mSha384Kernels[0]); Index++) {
+    printf ("%s\n", mSha384Kernels[Index].Name);
+    if ((Feature & mSha384Kernels[Index].CpuFeature) != mSha384Kernels[Index].CpuFeature) {
+      printf ("  SKIP, not supported by the CPU\n");
+      continue;
+    }
+    Failed += TestKernel (&mSha384Kernels[Index], SHA512_BLOCK_SIZE, mSha384Kat,
+                          sizeof (mSha384Kat) / sizeof (mSha384Kat[0]), mSha384Abc, Msg);
+  }
+
+  if (Failed != 0) {
+    printf ("%s: %d test(s) failed!\n", UTILITY_NAME, Failed);
+    return 1;
+  }
+
+  printf ("%s: all tests passed\n", UTILITY_NAME);
+  return 0;
+}
@@ -0,0 +1,76 @@
+/*******************************************************************************
+* Copyright 2002-2020 Intel Corporation
+*
+* Licensed under the Apache License, Version 2.0 (the "License");
+* you may not use this file except in compliance with the License.
+* You may obtain a copy of the License at
+*
+*     http://www.apache.org/licenses/LICENSE-2.0
+*
+* Unless required by applicable law or agreed to in writing, software
+* distributed under the License is distributed on an "AS IS" BASIS,
+* WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+* See the License for the specific language governing permissions and
+* limitations under the License.
+*******************************************************************************/
+
+/*
+//
+//  Purpose:
+//     Cryptography Primitive.
+//     CPU feature detection
+//
+//  Contents:
+//     cpGetFeature()
+//
+//
+*/
+
+#include "owndefs.h"
+#include "owncp.h"
+
+/*F*
+//    Name: cpGetFeature
+//
+// Purpose: Test if CPU supports all requested features.
+//
+// Returns:
+//    1  all features in the mask are supported
+//    0  otherwise
+//
+// Parameters:
+//    Feature  ippCPUID_XXX feature mask
+//
+// Note:
+//    No global state is kept, so that it can be used in XIP stages.
+//    AVX is reported only when enabled by AsmEnableAvx() (CR4.OSXSAVE set),
+//    which is done for the BSP in Stage1A and for the APs in MpInitLib.
+*F*/
+int cpGetFeature( Ipp64u Feature )
+{
+   Ipp32u maxLeaf;
+   Ipp32u regEbx;
+   Ipp32u regEcx;
+   Ipp64u cpuFeature = 0;
+
+   AsmCpuid(0, &maxLeaf, NULL, NULL, NULL);
+   AsmCpuid(1, NULL, NULL, &regEcx, NULL);
+
+   if(regEcx & BIT9)
+      cpuFeature |= ippCPUID_SSSE3;
+   if(regEcx & BIT19)
+      cpuFeature |= ippCPUID_SSE41;
+   if((regEcx & (BIT27|BIT28)) == (BIT27|BIT28))
+      cpuFeature |= ippCPUID_AVX | ippAVX_ENABLEDBYOS;
+
+   if(maxLeaf >= 7) {
+      AsmCpuidEx(7, 0, NULL, &regEbx, NULL, NULL);
+      /* the AVX2 kernels also use BMI2 instructions */
+      if(((regEbx & (BIT5|BIT8)) == (BIT5|BIT8)) && (cpuFeature & ippAVX_ENABLEDBYOS))
+         cpuFeature |= ippCPUID_AVX2;
+      if(regEbx & BIT29)
+         cpuFeature |= ippCPUID_SHA;
+   }
+
+   return (cpuFeature & Feature) == Feature;
+}
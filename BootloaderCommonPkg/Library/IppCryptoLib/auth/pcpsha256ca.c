@@ -177,13 +177,20 @@ void UpdateSHA256Compact(void* uniHash, const Ipp8u* mblk, int mlen, const void*
 void UpdateSHA256(void* pHash, const Ipp8u* pMsg, int msgLen, const void* pParam)
 {
 #if defined(_SLIMBOOT_OPT)
+   /* use the fastest kernel built in that the CPU supports */
    #if (FixedPcdGet32 (PcdCryptoShaOptMask) & IPP_CRYPTO_SHA256_NI)
+   if(IsFeatureEnabled(ippCPUID_SHA | ippCPUID_SSE41)) {
       UpdateSHA256Ni(pHash, pMsg, msgLen, pParam);
-   #elif (FixedPcdGet32 (PcdCryptoShaOptMask) & IPP_CRYPTO_SHA256_V8)
+      return;
+   }
+   #endif
+   #if (FixedPcdGet32 (PcdCryptoShaOptMask) & IPP_CRYPTO_SHA256_V8)
+   if(IsFeatureEnabled(ippCPUID_SSSE3)) {
       UpdateSHA256V8(pHash, pMsg, msgLen, pParam);
-   #else
-      UpdateSHA256Compact(pHash, pMsg, msgLen, pParam);
+      return;
+   }
    #endif
+   UpdateSHA256Compact(pHash, pMsg, msgLen, pParam);
 #else
   #if defined(_ALG_SHA256_COMPACT_)
     UpdateSHA256Compact(pHash, pMsg, msgLen, pParam);
@@ -565,9 +565,20 @@ void UpdateSHA512Normal(void* uniHash, const Ipp8u* mblk, int mlen, const void*
 void UpdateSHA512(void* uniHash, const Ipp8u* mblk, int mlen, const void* uniPraram)
 {
 #if defined(_SLIMBOOT_OPT)
+   /* use the fastest kernel built in that the CPU supports */
+   #if defined(MDE_CPU_X64) && (FixedPcdGet32 (PcdCryptoShaOptMask) & IPP_CRYPTO_SHA384_L9)
+   if(IsFeatureEnabled(ippCPUID_AVX2 | ippAVX_ENABLEDBYOS)) {
+      UpdateSHA512L9 (uniHash, mblk, mlen, uniPraram);
+      return;
+   }
+   #endif
    #if (FixedPcdGet32 (PcdCryptoShaOptMask) & IPP_CRYPTO_SHA384_G9)
+   if(IsFeatureEnabled(ippCPUID_AVX | ippAVX_ENABLEDBYOS)) {
       UpdateSHA512G9 (uniHash, mblk, mlen, uniPraram);
-   #elif (FixedPcdGet32 (PcdCryptoShaOptMask) & IPP_CRYPTO_SHA384_W7)
+      return;
+   }
+   #endif
+   #if (FixedPcdGet32 (PcdCryptoShaOptMask) & IPP_CRYPTO_SHA384_W7)
       UpdateSHA512W7 (uniHash, mblk, mlen, uniPraram);
    #else
       UpdateSHA512Compact (uniHash, mblk, mlen, uniPraram);
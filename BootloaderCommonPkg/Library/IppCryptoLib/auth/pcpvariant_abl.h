@@ -37,5 +37,6 @@
 #define IPP_CRYPTO_SHA256_NI    0x0002
 #define IPP_CRYPTO_SHA384_W7    0x0004
 #define IPP_CRYPTO_SHA384_G9    0x0008
+#define IPP_CRYPTO_SHA384_L9    0x0010
 
 #endif /* _CP_VARIANT_ABL_H */
@@ -217,6 +217,261 @@ GetActiveVaraibelStoreBase (
   return VarStoreHdrPtr;
 }
 
+/**
+  Calculate the index hash of a variable name.
+
+  @param[in]  VariableName    Variable name to hash.
+
+  @retval     16-bit hash of the variable name.
+
+**/
+STATIC
+UINT16
+VariableNameHash (
+  IN CONST CHAR8   *VariableName
+  )
+{
+  UINT32    Hash;
+
+  Hash = 2166136261u;
+  while (*VariableName != 0) {
+    Hash = (Hash ^ (UINT8)*VariableName++) * 16777619u;
+  }
+
+  return (UINT16)(Hash ^ (Hash >> 16));
+}
+
+/**
+  Check if a variable store area is in erased state.
+
+  @param[in]  Buffer          Area base.
+  @param[in]  Length          Area size.
+
+  @retval     TRUE            All bytes in the area are 0xFF.
+  @retval     FALSE           The area has been written.
+
+**/
+STATIC
+BOOLEAN
+IsVariableAreaErased (
+  IN CONST UINT8   *Buffer,
+  IN UINT32         Length
+  )
+{
+  UINT32    Idx;
+
+  for (Idx = 0; Idx < Length; Idx++) {
+    if (Buffer[Idx] != 0xFF) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Erase blocks of the variable store area left to erase after a reclaim.
+
+  Blocks that are still erased are skipped without being counted, so the
+  whole area can be given again to finish an erase that was interrupted.
+
+  @param[in]  VarInstance     Variable instance holding the area left to erase.
+  @param[in]  MaxBlocks       Maximum number of blocks to erase.
+
+  @retval     EFI_SUCCESS     The blocks were erased.
+  @retval     Others          Erasing a block failed.
+
+**/
+STATIC
+EFI_STATUS
+ErasePendingVariableStore (
+  IN VARIABLE_INSTANCE      *VarInstance,
+  IN UINT32                  MaxBlocks
+  )
+{
+  EFI_STATUS    Status;
+  UINT8        *Block;
+
+  while ((VarInstance->EraseLength >= VARIABLE_ERASE_BLOCK_SIZE) && (MaxBlocks > 0)) {
+    Block = (UINT8 *)(UINTN)VarInstance->EraseBase;
+    if (!IsVariableAreaErased (Block, VARIABLE_ERASE_BLOCK_SIZE)) {
+      Status = EraseVariableStore (Block, VARIABLE_ERASE_BLOCK_SIZE);
+      if (EFI_ERROR (Status)) {
+        return Status;
+      }
+      MaxBlocks--;
+    }
+    VarInstance->EraseBase   += VARIABLE_ERASE_BLOCK_SIZE;
+    VarInstance->EraseLength -= VARIABLE_ERASE_BLOCK_SIZE;
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Build the variable name index for the active variable store.
+
+  The index follows the same rules as the variable store scan: the first
+  copy that is not in migration wins, otherwise the last copy found. Any
+  state that SetVariable needs to repair is recorded so that the next write
+  takes the full scan path.
+
+  @param[in]  VarInstance       Variable instance holding the index.
+  @param[in]  VarStoreHdrPtr    Active variable store header pointer.
+
+**/
+STATIC
+VOID
+BuildVariableIndex (
+  IN VARIABLE_INSTANCE      *VarInstance,
+  IN VARIABLE_STORE_HEADER  *VarStoreHdrPtr
+  )
+{
+  VARIABLE_HEADER        *VarHdrPtr;
+  VARIABLE_HEADER        *IdxHdrPtr;
+  VARIABLE_INDEX_ENTRY   *Entry;
+  UINT32                  Offset;
+  UINT32                  Idx;
+  UINT16                  Hash;
+  UINT8                   State;
+
+  VarInstance->IndexStore      = (UINT32)(UINTN)VarStoreHdrPtr;
+  VarInstance->IndexState      = VariableIndexValid;
+  VarInstance->IndexNeedRepair = FALSE;
+  VarInstance->IndexCount      = 0;
+  VarInstance->LiveSize        = 0;
+
+  Offset = sizeof (VARIABLE_STORE_HEADER);
+  while (Offset + sizeof (VARIABLE_HEADER) <= VarStoreHdrPtr->Size) {
+    VarHdrPtr = (VARIABLE_HEADER *)((UINT8 *)VarStoreHdrPtr + Offset);
+    State     = VarHdrPtr->State;
+    if (!IS_HEADER_VALID (State)) {
+      if (!IsVariableAreaErased ((UINT8 *)VarHdrPtr, sizeof (VARIABLE_HEADER))) {
+        VarInstance->IndexNeedRepair = TRUE;
+      }
+      break;
+    }
+
+    if (VarHdrPtr->StartId != VARIABLE_DATA) {
+      VarInstance->IndexState = VariableIndexUnavailable;
+      return;
+    }
+
+    if (!IS_DATA_VALID (State) && !IS_DELETED (State)) {
+      VarInstance->IndexNeedRepair = TRUE;
+    }
+
+    if (IS_DATA_VALID (State) && !IS_DELETED (State)) {
+      Hash  = VariableNameHash ((CHAR8 *)&VarHdrPtr[1]);
+      Entry = NULL;
+      for (Idx = 0; Idx < VarInstance->IndexCount; Idx++) {
+        IdxHdrPtr = (VARIABLE_HEADER *)((UINT8 *)VarStoreHdrPtr + VarInstance->Index[Idx].Offset);
+        if ((VarInstance->Index[Idx].Hash == Hash) &&
+            (AsciiStrCmp ((CHAR8 *)&IdxHdrPtr[1], (CHAR8 *)&VarHdrPtr[1]) == 0)) {
+          Entry = &VarInstance->Index[Idx];
+          break;
+        }
+      }
+
+      if (Entry == NULL) {
+        if (VarInstance->IndexCount >= VARIABLE_INDEX_MAX_ENTRIES) {
+          VarInstance->IndexState = VariableIndexUnavailable;
+          return;
+        }
+        Entry = &VarInstance->Index[VarInstance->IndexCount++];
+        Entry->Hash   = Hash;
+        Entry->Offset = Offset;
+        VarInstance->LiveSize += sizeof (VARIABLE_HEADER) + VarHdrPtr->DataSize;
+      } else {
+        //
+        // Duplicated variable, SetVariable will delete the older copy
+        //
+        VarInstance->IndexNeedRepair = TRUE;
+        if (IS_IN_MIGRATION (IdxHdrPtr->State)) {
+          VarInstance->LiveSize -= sizeof (VARIABLE_HEADER) + IdxHdrPtr->DataSize;
+          VarInstance->LiveSize += sizeof (VARIABLE_HEADER) + VarHdrPtr->DataSize;
+          Entry->Offset = Offset;
+        }
+      }
+    }
+
+    Offset += sizeof (VARIABLE_HEADER) + VarHdrPtr->DataSize;
+  }
+
+  VarInstance->FreeOffset = Offset;
+}
+
+/**
+  Get the variable instance with a valid name index for the active store.
+
+  The index is rebuilt when it does not belong to the given store.
+
+  @param[in]  VarStoreHdrPtr    Active variable store header pointer.
+
+  @retval     Variable instance pointer if the index can be used, otherwise NULL.
+
+**/
+STATIC
+VARIABLE_INSTANCE *
+GetVariableIndex (
+  IN VARIABLE_STORE_HEADER  *VarStoreHdrPtr
+  )
+{
+  VARIABLE_INSTANCE  *VarInstance;
+
+  VarInstance = GetVariableInstance ();
+  if (VarInstance == NULL) {
+    return NULL;
+  }
+
+  if ((VarInstance->IndexState == VariableIndexInvalid) ||
+      (VarInstance->IndexStore != (UINT32)(UINTN)VarStoreHdrPtr)) {
+    BuildVariableIndex (VarInstance, VarStoreHdrPtr);
+  }
+
+  if (VarInstance->IndexState != VariableIndexValid) {
+    return NULL;
+  }
+
+  return VarInstance;
+}
+
+/**
+  Find a variable name in the variable index.
+
+  @param[in]  VarInstance       Variable instance holding a valid index.
+  @param[in]  VarStoreHdrPtr    Active variable store header pointer.
+  @param[in]  VariableName      Variable name to find.
+  @param[in]  Hash              Hash of the variable name.
+
+  @retval     Index entry pointer if found, otherwise NULL.
+
+**/
+STATIC
+VARIABLE_INDEX_ENTRY *
+FindVariableIndexEntry (
+  IN VARIABLE_INSTANCE      *VarInstance,
+  IN VARIABLE_STORE_HEADER  *VarStoreHdrPtr,
+  IN CONST CHAR8            *VariableName,
+  IN UINT16                  Hash
+  )
+{
+  VARIABLE_HEADER  *VarHdrPtr;
+  UINT32            Idx;
+
+  for (Idx = 0; Idx < VarInstance->IndexCount; Idx++) {
+    if (VarInstance->Index[Idx].Hash != Hash) {
+      continue;
+    }
+    VarHdrPtr = (VARIABLE_HEADER *)((UINT8 *)VarStoreHdrPtr + VarInstance->Index[Idx].Offset);
+    if (AsciiStrCmp ((CHAR8 *)&VarHdrPtr[1], VariableName) == 0) {
+      return &VarInstance->Index[Idx];
+    }
+  }
+
+  return NULL;
+}
+
 /**
 
   This function initilizes the variable store.
@@ -363,6 +618,8 @@ InternalGetVariable (
   UINT32                  VariableNameLen;
   UINT32                  VariableDataLen;
   UINTN                   DataSizeIn;
+  VARIABLE_INSTANCE      *VarInstance;
+  VARIABLE_INDEX_ENTRY   *Entry;
 
   if ((DataSize == NULL) || (VariableName == NULL)) {
     return EFI_INVALID_PARAMETER;
@@ -378,7 +635,18 @@ InternalGetVariable (
   VarEndPtr = (UINT8 *)VarStoreHdrPtr + VarStoreHdrPtr->Size;
 
   FindVarHdrPtr = NULL;
-  while ((UINT8 *)VarHdrPtr < VarEndPtr) {
+  VarInstance   = GetVariableIndex (VarStoreHdrPtr);
+  if (VarInstance != NULL) {
+    //
+    // Look up the variable through the name index instead of scanning the store
+    //
+    Entry = FindVariableIndexEntry (VarInstance, VarStoreHdrPtr, VariableName, VariableNameHash (VariableName));
+    if (Entry != NULL) {
+      FindVarHdrPtr = (VARIABLE_HEADER *)((UINT8 *)VarStoreHdrPtr + Entry->Offset);
+    }
+  }
+
+  while ((VarInstance == NULL) && ((UINT8 *)VarHdrPtr < VarEndPtr)) {
     State = VarHdrPtr->State;
     if (!IS_HEADER_VALID (State)) {
       break;
@@ -560,6 +828,12 @@ GetNextVariableName (
 
   This function reclaim the variable store from active region to the alternative region.
 
+  The alternative region is expected to be erased already, since the region
+  that becomes inactive is erased a block at a time by the writes following
+  each switch. Only the blocks where that did not complete (e.g. too few
+  writes, power loss, or a store switched by older firmware) are erased here,
+  so that the free space of an active store is always erased.
+
   @param   ActiveVarStoreHdrPtr       The active variable store header pointer
 
   @retval  EFI_DEVICE_ERROR      Failed to erase device
@@ -588,11 +862,13 @@ Reclaim (
   UINTN                   Key;
   UINT8                   ActiveState;
   UINT8                   InactiveState;
+  VARIABLE_INSTANCE      *VarInstance;
 
   DEBUG ((DEBUG_INFO, "Reclaiming variable storage\n"));
 
+  VarInstance     = GetVariableInstance ();
   VarStoreHdrPtr1 = (VARIABLE_STORE_HEADER *)GetVaraibelStoreBase (&FullVarStoreLen);
-  if (VarStoreHdrPtr1 == NULL) {
+  if ((VarInstance == NULL) || (VarStoreHdrPtr1 == NULL)) {
     return EFI_NOT_READY;
   }
 
@@ -607,9 +883,12 @@ Reclaim (
   CurPtr = (UINT8 *) (InactiveVarStoreHdrPtr + 1);
 
   //
-  // Erase InactiveVarStoreHdrPtr
+  // Finish erasing InactiveVarStoreHdrPtr where the writes since the last
+  // switch did not get to
   //
-  Status = EraseVariableStore (InactiveVarStoreHdrPtr, VarStoreLen);
+  VarInstance->EraseBase   = (UINT32)(UINTN)InactiveVarStoreHdrPtr;
+  VarInstance->EraseLength = VarStoreLen;
+  Status = ErasePendingVariableStore (VarInstance, MAX_UINT32);
   if (EFI_ERROR (Status)) {
     return EFI_DEVICE_ERROR;
   }
@@ -679,6 +958,13 @@ Reclaim (
     return Status;
   }
 
+  //
+  // Leave the old store to the following writes to erase, so neither this
+  // reclaim nor the next one has to erase a whole store.
+  //
+  VarInstance->EraseBase   = (UINT32)(UINTN)ActiveVarStoreHdrPtr;
+  VarInstance->EraseLength = VarStoreLen;
+
   return EFI_SUCCESS;
 }
 
@@ -735,6 +1021,10 @@ SetVariable (
   BOOLEAN                 SkipVarWrite;
   BOOLEAN                 CheckVarDataValid;
   BOOLEAN                 NeedReclaim;
+  BOOLEAN                 ScanStore;
+  VARIABLE_INSTANCE      *VarInstance;
+  VARIABLE_INDEX_ENTRY   *Entry;
+  UINT16                  Hash;
 
   if (VariableName == NULL) {
     return EFI_INVALID_PARAMETER;
@@ -749,6 +1039,18 @@ SetVariable (
     return EFI_VOLUME_CORRUPTED;
   }
 
+  //
+  // Erase one block of the store left behind by the last reclaim. A failure
+  // is handled by the next reclaim.
+  //
+  VarInstance = GetVariableInstance ();
+  if (VarInstance != NULL) {
+    Status = ErasePendingVariableStore (VarInstance, 1);
+    if (EFI_ERROR (Status)) {
+      DEBUG ((DEBUG_WARN, "Erase inactive variable store failed - %r\n", Status));
+    }
+  }
+
   VarHdrPtr = (VARIABLE_HEADER *)&VarStoreHdrPtr[1];
   VarEndPtr = (UINT8 *)VarStoreHdrPtr + VarStoreHdrPtr->Size;
 
@@ -771,7 +1073,37 @@ SetVariable (
   FoundSpace    = FALSE;
   FindVarHdrPtr = NULL;
   FindVarState  = 0;
-  while (!FoundSpace) {
+  Entry         = NULL;
+  ScanStore     = TRUE;
+  Hash          = VariableNameHash (VariableName);
+  VarInstance   = GetVariableIndex (VarStoreHdrPtr);
+  if ((VarInstance != NULL) && !VarInstance->IndexNeedRepair) {
+    //
+    // The index knows the current copy and the free space, and there is
+    // nothing to repair. Skip the full store scan.
+    //
+    ScanStore = FALSE;
+    Entry     = FindVariableIndexEntry (VarInstance, VarStoreHdrPtr, VariableName, Hash);
+    if (Entry != NULL) {
+      FindVarHdrPtr = (VARIABLE_HEADER *)((UINT8 *)VarStoreHdrPtr + Entry->Offset);
+      FindVarState  = FindVarHdrPtr->State;
+      if ((DataSize > 0) && (FindVarHdrPtr->DataSize == VariableNameLen + DataSize) &&
+          (CompareMem ((UINT8 *)&FindVarHdrPtr[1] + VariableNameLen, Data, DataSize) == 0)) {
+        SkipVarWrite = TRUE;
+      }
+    }
+    VarHdrPtr   = (VARIABLE_HEADER *)((UINT8 *)VarStoreHdrPtr + VarInstance->FreeOffset);
+    FoundSpace  = (BOOLEAN)((UINT8 *)VarHdrPtr + TotalLen <= VarEndPtr);
+    NeedReclaim = (BOOLEAN)(VarInstance->FreeOffset - sizeof (VARIABLE_STORE_HEADER) > VarInstance->LiveSize);
+  } else if (VarInstance != NULL) {
+    //
+    // The full scan below may repair the store, rebuild the index afterwards
+    //
+    VarInstance->IndexState = VariableIndexInvalid;
+    VarInstance = NULL;
+  }
+
+  while (ScanStore && !FoundSpace) {
     CheckVarDataValid = FALSE;
     State = VarHdrPtr->State;
 
@@ -898,6 +1230,13 @@ SetVariable (
     return EFI_OUT_OF_RESOURCES;
   }
 
+  //
+  // The index is stale until all writes below have completed
+  //
+  if (VarInstance != NULL) {
+    VarInstance->IndexState = VariableIndexInvalid;
+  }
+
   if (DataSize > 0) {
     //
     // Write the variable header
@@ -973,6 +1312,30 @@ SetVariable (
     }
   }
 
+  if (VarInstance != NULL) {
+    //
+    // Update the index with the new copy instead of scanning the store again
+    //
+    if (Entry != NULL) {
+      VarInstance->LiveSize -= sizeof (VARIABLE_HEADER) + FindVarHdrPtr->DataSize;
+    }
+    if (DataSize > 0) {
+      if (Entry == NULL) {
+        if (VarInstance->IndexCount >= VARIABLE_INDEX_MAX_ENTRIES) {
+          return EFI_SUCCESS;
+        }
+        Entry = &VarInstance->Index[VarInstance->IndexCount++];
+        Entry->Hash = Hash;
+      }
+      Entry->Offset            = (UINT32)((UINT8 *)VarHdrPtr - (UINT8 *)VarStoreHdrPtr);
+      VarInstance->LiveSize   += TotalLen;
+      VarInstance->FreeOffset += TotalLen;
+    } else {
+      *Entry = VarInstance->Index[--VarInstance->IndexCount];
+    }
+    VarInstance->IndexState = VariableIndexValid;
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -992,8 +1355,9 @@ VariableConstructor (
   IN  UINT32    Size
   )
 {
-  EFI_STATUS         Status;
-  VARIABLE_INSTANCE *VarInstance;
+  EFI_STATUS             Status;
+  VARIABLE_INSTANCE     *VarInstance;
+  VARIABLE_STORE_HEADER *VarStoreHdrPtr;
 
   VarInstance = GetVariableInstance();
   ASSERT (VarInstance != NULL);
@@ -1018,6 +1382,24 @@ VariableConstructor (
     return Status;
   }
 
+  //
+  // Build the name index once so later accesses skip the store scan
+  //
+  VarStoreHdrPtr = GetActiveVaraibelStoreBase (NULL);
+  GetVariableIndex (VarStoreHdrPtr);
+
+  //
+  // Let the writes finish erasing the inactive store if an earlier boot was
+  // interrupted before completing it
+  //
+  if (VarStoreHdrPtr != NULL) {
+    VarInstance->EraseBase = VarInstance->StoreBase;
+    if (VarInstance->EraseBase == (UINT32)(UINTN)VarStoreHdrPtr) {
+      VarInstance->EraseBase += Size >> 1;
+    }
+    VarInstance->EraseLength = Size >> 1;
+  }
+
   Status = RegisterService ((VOID *)&mVariableService);
   return Status;
 }
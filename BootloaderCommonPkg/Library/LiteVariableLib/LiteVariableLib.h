@@ -26,10 +26,46 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 ///
 #define VARIABLE_INSTANCE_SIGNATURE  SIGNATURE_32 ('V', 'A', 'R', 'I')
 
+#define VARIABLE_INDEX_MAX_ENTRIES   32
+
+#define VARIABLE_ERASE_BLOCK_SIZE    SIZE_4KB
+
+typedef enum {
+  VariableIndexInvalid,
+  VariableIndexValid,
+  VariableIndexUnavailable
+} VARIABLE_INDEX_STATE;
+
+///
+/// Name hash to variable header offset in the active variable store
+///
+typedef struct {
+  UINT16                Hash;
+  UINT16                Reserved;
+  UINT32                Offset;
+} VARIABLE_INDEX_ENTRY;
+
 typedef struct {
   UINT32                Signature;
   UINT32                StoreSize;
   UINT32                StoreBase;
+  //
+  // In-memory index of the active variable store. It is rebuilt whenever
+  // IndexStore does not match the active store base.
+  //
+  UINT32                IndexStore;
+  UINT8                 IndexState;
+  BOOLEAN               IndexNeedRepair;
+  UINT16                IndexCount;
+  UINT32                FreeOffset;
+  UINT32                LiveSize;
+  VARIABLE_INDEX_ENTRY  Index[VARIABLE_INDEX_MAX_ENTRIES];
+  //
+  // Variable store area left to erase after a reclaim. It is erased a block
+  // at a time by the following writes.
+  //
+  UINT32                EraseBase;
+  UINT32                EraseLength;
 } VARIABLE_INSTANCE;
 
 #endif
@@ -8,6 +8,7 @@
 #include <PiPei.h>
 #include <Library/TimeStampLib.h>
 #include <Library/BootloaderCommonLib.h>
+#include <Library/LoaderPerformanceLib.h>
 
 /**
   Add a given performance measure point timestamp.
@@ -45,3 +46,189 @@ AddMeasurePoint (
 {
   AddMeasurePointTimestamp (Id, ReadTimeStamp());
 }
+
+/**
+  Begin a performance measure span.
+
+  The span becomes the parent of the spans begun before it ends.
+
+  @param[in]  Id          Measure point Id
+  @param[in]  Tag         Signature of the object processed in the span, 0 if none
+  @param[in]  Device      Boot medium type accessed in the span, or PERF_SPAN_NO_DEVICE
+
+  @retval     Span handle to pass to EndMeasureSpan(), 0 if the span table is
+              full or not allocated.
+
+**/
+UINT32
+BeginMeasureSpan (
+  IN  UINT16         Id,
+  IN  UINT32         Tag,
+  IN  UINT8          Device
+  )
+{
+  BL_PERF_DATA      *PerfData;
+  PERFORMANCE_SPAN  *Span;
+
+  PerfData = GetPerfDataPtr();
+  if ((PerfData->Span == NULL) || (PerfData->SpanCount >= MAX_PERF_SPAN_NUM)) {
+    return 0;
+  }
+
+  Span = &PerfData->Span[PerfData->SpanCount++];
+  Span->Id       = Id;
+  Span->Parent   = (UINT8)PerfData->SpanOpen;
+  Span->Device   = Device;
+  Span->Tag      = Tag;
+  Span->Size     = 0;
+  Span->Reserved = 0;
+  Span->End      = 0;
+  Span->Start    = ReadTimeStamp();
+  PerfData->SpanOpen = PerfData->SpanCount;
+
+  return PerfData->SpanCount;
+}
+
+/**
+  End a performance measure span.
+
+  @param[in]  Span        Span handle returned by BeginMeasureSpan()
+  @param[in]  Size        Bytes processed in the span
+
+**/
+VOID
+EndMeasureSpan (
+  IN  UINT32         Span,
+  IN  UINT32         Size
+  )
+{
+  BL_PERF_DATA      *PerfData;
+  PERFORMANCE_SPAN  *SpanPtr;
+
+  PerfData = GetPerfDataPtr();
+  if ((PerfData->Span == NULL) || (Span == 0) || (Span > PerfData->SpanCount)) {
+    return;
+  }
+
+  SpanPtr = &PerfData->Span[Span - 1];
+  SpanPtr->End  = ReadTimeStamp();
+  SpanPtr->Size = Size;
+  if (PerfData->SpanOpen == Span) {
+    PerfData->SpanOpen = SpanPtr->Parent;
+  }
+}
+
+/**
+  Add a performance measure span that has been timed by the caller.
+
+  It is used for work that runs where the performance data cannot be
+  accessed, such as in an FSP event handler. The span is a child of the span
+  that is currently open.
+
+  @param[in]  Id          Measure point Id
+  @param[in]  Tag         Signature of the object processed in the span, 0 if none
+  @param[in]  Device      Boot medium type accessed in the span, or PERF_SPAN_NO_DEVICE
+  @param[in]  Start       Timestamp at the start of the span
+  @param[in]  End         Timestamp at the end of the span
+  @param[in]  Size        Bytes processed in the span
+
+**/
+VOID
+AddMeasureSpan (
+  IN  UINT16         Id,
+  IN  UINT32         Tag,
+  IN  UINT8          Device,
+  IN  UINT64         Start,
+  IN  UINT64         End,
+  IN  UINT32         Size
+  )
+{
+  BL_PERF_DATA      *PerfData;
+  PERFORMANCE_SPAN  *Span;
+
+  PerfData = GetPerfDataPtr();
+  if ((PerfData->Span == NULL) || (PerfData->SpanCount >= MAX_PERF_SPAN_NUM)) {
+    return;
+  }
+
+  Span = &PerfData->Span[PerfData->SpanCount++];
+  Span->Id       = Id;
+  Span->Parent   = (UINT8)PerfData->SpanOpen;
+  Span->Device   = Device;
+  Span->Tag      = Tag;
+  Span->Size     = Size;
+  Span->Reserved = 0;
+  Span->Start    = Start;
+  Span->End      = End;
+}
+
+/**
+  Convert a timestamp to nanoseconds.
+
+  @param[in]  Tsc         Timestamp value
+  @param[in]  FreqKhz     Timestamp frequency in KHz
+
+  @retval     Time in nanoseconds
+
+**/
+STATIC
+UINT64
+TimeStampToNs (
+  IN  UINT64         Tsc,
+  IN  UINT32         FreqKhz
+  )
+{
+  if (FreqKhz == 0) {
+    return 0;
+  }
+  return DivU64x32 (MultU64x32 (Tsc & 0x0000FFFFFFFFFFFFULL, 1000000), FreqKhz);
+}
+
+/**
+  Write the measure spans as FPDT boot performance records.
+
+  The records are placed right after the basic boot record, replacing any span
+  records written before. The table must have room for MAX_PERF_SPAN_NUM
+  FPDT_LOADER_SPAN_RECORD entries.
+
+  @param[in]  BootPerfTable   FPDT boot performance table
+  @param[in]  PerfData        Performance data holding the spans
+
+**/
+VOID
+EFIAPI
+UpdateFpdtSpanRecords (
+  IN  EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER  *BootPerfTable,
+  IN  BL_PERF_DATA                                *PerfData
+  )
+{
+  FPDT_LOADER_SPAN_RECORD  *Record;
+  PERFORMANCE_SPAN         *Span;
+  UINT32                    Index;
+  UINT32                    Count;
+
+  if ((BootPerfTable == NULL) || (PerfData == NULL)) {
+    return;
+  }
+
+  Count  = (PerfData->Span == NULL) ? 0 : MIN (PerfData->SpanCount, MAX_PERF_SPAN_NUM);
+  Record = (FPDT_LOADER_SPAN_RECORD *)((UINT8 *)(BootPerfTable + 1) +
+                                       sizeof (EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD));
+  for (Index = 0; Index < Count; Index++, Record++) {
+    Span = &PerfData->Span[Index];
+    Record->Header.Type     = FPDT_LOADER_SPAN_RECORD_TYPE;
+    Record->Header.Length   = sizeof (FPDT_LOADER_SPAN_RECORD);
+    Record->Header.Revision = FPDT_LOADER_SPAN_RECORD_REVISION;
+    Record->Id              = Span->Id;
+    Record->Parent          = Span->Parent;
+    Record->Device          = Span->Device;
+    Record->Tag             = Span->Tag;
+    Record->Size            = Span->Size;
+    Record->StartNs         = TimeStampToNs (Span->Start, PerfData->FreqKhz);
+    Record->EndNs           = (Span->End == 0) ? 0 : TimeStampToNs (Span->End, PerfData->FreqKhz);
+  }
+
+  BootPerfTable->Length = sizeof (EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER) +
+                          sizeof (EFI_ACPI_5_0_FPDT_FIRMWARE_BASIC_BOOT_RECORD) +
+                          Count * sizeof (FPDT_LOADER_SPAN_RECORD);
+}
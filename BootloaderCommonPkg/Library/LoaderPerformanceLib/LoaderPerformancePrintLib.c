@@ -64,6 +64,8 @@ DefPerfIdToStr (
     return "Stage1B entry point";
   case 0x2020:
     return "Board PreMemoryInit hook";
+  case 0x2028:
+    return "Stage Stage2 during FSP MemoryInit";
   case 0x2030:
     return "FSP MemoryInit";
   case 0x2040:
@@ -108,6 +110,8 @@ DefPerfIdToStr (
     return "PCI enumeration";
   case 0x30B0:
     return "Board PostPciEnumeration hook";
+  case 0x30B8:
+    return "Early boot device init";
   case 0x30C0:
     return "FSP PostPciEnumeration notify";
   case 0x30D0:
@@ -138,6 +142,10 @@ DefPerfIdToStr (
     return "FSP EndOfFirmware notify";
   case 0x31F0:
     return "End of stage2";
+  case 0x5000:
+    return "Load components";
+  case 0x5010:
+    return "Read component";
   }
   return NULL;
 }
@@ -372,6 +380,59 @@ PrintBootloaderPerfData (
   DEBUG ((DEBUG_INFO | DEBUG_EVENT, "------+------------+------------+----------------------------------\n"));
 }
 
+/**
+  Print Bootloader Measure Span information.
+
+  @param[in]  PerfData          A pointer indicating BL_PERF_DATA instance to print performance data
+  @param[in]  PerfIdToStrTbl    A pointer to description table corresponding to Id
+
+**/
+VOID
+PrintBootloaderPerfSpan (
+  IN BL_PERF_DATA   *PerfData,
+  IN PERF_ID_TO_STR  PerfIdToStrTbl
+  )
+{
+  UINT32            Idx;
+  UINT32            Depth;
+  UINT32            Parent;
+  UINT32            Start;
+  UINT32            Time;
+  UINT32            Rate;
+  UINT64            Tag;
+  PERFORMANCE_SPAN *Span;
+  CHAR8             Indent[8];
+
+  if ((PerfData->Span == NULL) || (PerfData->SpanCount == 0)) {
+    return;
+  }
+
+  DEBUG ((DEBUG_INFO | DEBUG_EVENT, " Id   | Start (ms) | Time (us)  | Size (KB) | MB/s | Tag  | Description\n"));
+  DEBUG ((DEBUG_INFO | DEBUG_EVENT, "------+------------+------------+-----------+------+------+------------------\n"));
+  for (Idx = 0; Idx < MIN (PerfData->SpanCount, MAX_PERF_SPAN_NUM); Idx++) {
+    Span  = &PerfData->Span[Idx];
+    Start = (UINT32)DivU64x32 (Span->Start, PerfData->FreqKhz);
+    Time  = 0;
+    if (Span->End > Span->Start) {
+      Time = (UINT32)DivU64x32 (MultU64x32 (Span->End - Span->Start, 1000), PerfData->FreqKhz);
+    }
+    Rate  = (Time == 0) ? 0 : Span->Size / Time;
+    Tag   = (Span->Tag == 0) ? SIGNATURE_32 (' ', ' ', ' ', ' ') : Span->Tag;
+
+    Depth  = 0;
+    Parent = Span->Parent;
+    while ((Parent != 0) && (Parent <= Idx) && (Depth < sizeof (Indent) - 1)) {
+      Indent[Depth++] = ' ';
+      Parent = PerfData->Span[Parent - 1].Parent;
+    }
+    Indent[Depth] = 0;
+
+    DEBUG ((DEBUG_INFO | DEBUG_EVENT, " %4X | %7d ms | %7d us | %9d | %4d | %4a | %a%a\n",
+            Span->Id, Start, Time, Span->Size / SIZE_1KB, Rate, (CHAR8 *)&Tag, Indent, PerfIdToStr (Span->Id, PerfIdToStrTbl)));
+  }
+  DEBUG ((DEBUG_INFO | DEBUG_EVENT, "------+------------+------------+-----------+------+------+------------------\n"));
+}
+
 /**
   Print Bootloader Measure Point information.
 
@@ -389,6 +450,7 @@ PrintMeasurePoint (
   // Print bootloader performance
   if ((PcdGet32 (PcdBootPerformanceMask) & BIT0) != 0) {
     PrintBootloaderPerfData (PerfData, PerfIdToStrTbl);
+    PrintBootloaderPerfSpan (PerfData, PerfIdToStrTbl);
   }
 
   // Print FSP boot performance
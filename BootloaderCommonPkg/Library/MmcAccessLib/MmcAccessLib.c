@@ -357,6 +357,8 @@ SdMmcInitialize (
   EFI_STATUS                      Status;
   SD_MMC_HC_PRIVATE_DATA         *Private;
   UINT32                          SdMmcHcBase;
+  UINT16                          ControllerVer;
+  UINT16                          HostCtrl2;
 
   Private = MmcGetHcPrivateData ();
   if (Private == NULL) {
@@ -374,6 +376,7 @@ SdMmcInitialize (
   Private->SdMmcHcBase    = SdMmcHcBase;
   if (Private->Signature == SD_MMC_HC_PRIVATE_SIGNATURE) {
     if (Private->Slot.CardType != CardType) {
+      SdMmcFreeAdmaDescRing (Private);
       ZeroMem (Private, sizeof(SD_MMC_HC_PRIVATE_DATA));
       Private->SdMmcHcBase = SdMmcHcBase;
     }
@@ -396,7 +399,31 @@ SdMmcInitialize (
   DumpCapabilityReg (&Private->Capability);
   DEBUG_CODE_END ();
 
-  if (Private->Capability.Adma2 && Private->Capability.Sdma) {
+  Status = SdMmcHcRwMmio (Private->SdMmcHcBase, SD_MMC_HC_CTRL_VER, TRUE, sizeof (ControllerVer), &ControllerVer);
+  if (EFI_ERROR (Status)) {
+    goto Done;
+  }
+  Private->ControllerVersion = ControllerVer & 0xFF;
+
+  //
+  // Version 4.x hosts report 64-bit addressing separately for version 3 and
+  // version 4 mode. The 96-bit descriptors are the version 3 mode format, so
+  // keep the host in version 3 mode and check the matching capability.
+  //
+  if (Private->ControllerVersion >= SD_MMC_HC_CTRL_VER_400) {
+    HostCtrl2 = (UINT16)~SD_MMC_HC_V4_EN;
+    Status = SdMmcHcAndMmio (Private->SdMmcHcBase, SD_MMC_HC_HOST_CTRL2, sizeof (HostCtrl2), &HostCtrl2);
+    if (EFI_ERROR (Status)) {
+      goto Done;
+    }
+  }
+
+  //
+  // ADMA2 with 64-bit descriptors can reach buffers above 4GB and needs no
+  // boundary handling, so prefer it over SDMA when the host supports it.
+  //
+  Private->Adma64 = (BOOLEAN)(Private->Capability.Adma2 && Private->Capability.SysBus64V3);
+  if (Private->Capability.Adma2 && Private->Capability.Sdma && !Private->Adma64) {
     DEBUG ((DEBUG_INFO, "Use SDMA instead of ADMA2\n"));
     Private->Capability.Adma2 = 0;
   }
@@ -429,6 +456,7 @@ SdMmcInitialize (
 Done:
   if (EFI_ERROR (Status)) {
     if (Private != NULL) {
+      SdMmcFreeAdmaDescRing (Private);
       if (Private->PrivateDataMemType == PayloadMemory) {
         FreePool ((VOID *)Private);
       }
@@ -472,6 +500,7 @@ MmcInitialize (
     if (Private != NULL) {
       // Disable controller
       MmioAnd8 (Private->SdMmcHcPciBase + PCI_COMMAND_OFFSET,  (UINT8)(~(EFI_PCI_COMMAND_MEMORY_SPACE | EFI_PCI_COMMAND_BUS_MASTER)));
+      SdMmcFreeAdmaDescRing (Private);
       ZeroMem (Private, sizeof(SD_MMC_HC_PRIVATE_DATA));
     }
     return EFI_SUCCESS;
@@ -509,6 +538,7 @@ SdInitialize (
     // Handle Deinit if required.
     Private = MmcGetHcPrivateData ();
     if (Private != NULL) {
+      SdMmcFreeAdmaDescRing (Private);
       ZeroMem (Private, sizeof(SD_MMC_HC_PRIVATE_DATA));
     }
     return EFI_SUCCESS;
@@ -2395,6 +2395,47 @@ Done:
   return Status;
 }
 
+/**
+  To get the eMMC card operating mode HS200/HS400
+
+  @param[out] EmmcMode                   The current HS200 or HS400 mode
+
+  @retval EFI_SUCCESS                    Emmc Mode was returned.
+  @retval EFI_UNSUPPORTED                The card operates in another mode.
+  @retval Others                         The mode could not be read.
+**/
+EFI_STATUS
+EFIAPI
+EmmcGetModeSelection (
+  OUT EMMC_MODE                         *EmmcMode
+  )
+{
+  EFI_STATUS                    Status;
+  SD_MMC_HC_PRIVATE_DATA       *Private;
+  UINT8                         HsTiming;
+
+  Private = MmcGetHcPrivateData ();
+  if (Private == NULL) {
+    return EFI_NOT_READY;
+  }
+
+  Status = MmcGetHsTiming (Private, &HsTiming);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_ERROR, "EmmcGetModeSelection: GetHsTiming fails with %r\n", Status));
+    return Status;
+  }
+
+  if (HsTiming == 2) {
+    *EmmcMode = Hs200;
+  } else if (HsTiming == 3) {
+    *EmmcMode = Hs400;
+  } else {
+    Status = EFI_UNSUPPORTED;
+  }
+
+  return Status;
+}
+
 /**
   This function gets serial number of eMMC card.
 
@@ -79,6 +79,13 @@ typedef struct {
   UINT32                              PrivateDataMemType;
   UINT32                              ControllerVersion;
   UINTN                               CurrentPartition;
+
+  BOOLEAN                             Adma64;
+  UINT8                               AdmaRingStage;
+  VOID                                *AdmaRing;
+  EFI_PHYSICAL_ADDRESS                AdmaRingPhy;
+  VOID                                *AdmaRingMap;
+  UINT32                              AdmaRingPages;
 } SD_MMC_HC_PRIVATE_DATA;
 
 #define SD_MMC_HC_TRB_SIG             SIGNATURE_32 ('T', 'R', 'B', 'T')
@@ -103,7 +110,11 @@ typedef struct {
   BOOLEAN                             Started;
   UINT64                              Timeout;
 
-  SD_MMC_HC_ADMA_DESC_LINE            *AdmaDesc;
+  //
+  // AdmaPages is 0 when the descriptor table is borrowed from the
+  // controller's descriptor ring and must not be freed with the TRB.
+  //
+  VOID                                *AdmaDesc;
   EFI_PHYSICAL_ADDRESS                AdmaDescPhy;
   VOID                                *AdmaMap;
   UINT32                              AdmaPages;
@@ -125,6 +136,17 @@ SdMmcCreateTrb (
   IN EFI_SD_MMC_PASS_THRU_COMMAND_PACKET *Packet
   );
 
+/**
+  Free the ADMA descriptor ring of the host controller.
+
+  @param[in] Private        A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+
+**/
+VOID
+SdMmcFreeAdmaDescRing (
+  IN SD_MMC_HC_PRIVATE_DATA              *Private
+  );
+
 /**
   Free the resource used by the TRB.
 
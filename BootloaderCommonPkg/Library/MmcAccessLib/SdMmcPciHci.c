@@ -13,6 +13,7 @@
 #include <Library/IoLib.h>
 #include <Library/TimerLib.h>
 #include <Library/IoMmuLib.h>
+#include <Library/BootloaderCommonLib.h>
 #include "SdMmcPciHcDxe.h"
 
 /**
@@ -42,7 +43,8 @@ DumpCapabilityReg (
   DEBUG ((DEBUG_VERBOSE, "   Voltage 3.3       %a\n", Capability->Voltage33 ? "TRUE" : "FALSE"));
   DEBUG ((DEBUG_VERBOSE, "   Voltage 3.0       %a\n", Capability->Voltage30 ? "TRUE" : "FALSE"));
   DEBUG ((DEBUG_VERBOSE, "   Voltage 1.8       %a\n", Capability->Voltage18 ? "TRUE" : "FALSE"));
-  DEBUG ((DEBUG_VERBOSE, "   64-bit Sys Bus    %a\n", Capability->SysBus64 ? "TRUE" : "FALSE"));
+  DEBUG ((DEBUG_VERBOSE, "   64-bit Sys Bus V4 %a\n", Capability->SysBus64V4 ? "TRUE" : "FALSE"));
+  DEBUG ((DEBUG_VERBOSE, "   64-bit Sys Bus V3 %a\n", Capability->SysBus64V3 ? "TRUE" : "FALSE"));
   DEBUG ((DEBUG_VERBOSE, "   Async Interrupt   %a\n", Capability->AsyncInt ? "TRUE" : "FALSE"));
   DEBUG ((DEBUG_VERBOSE, "   SlotType          "));
   if (Capability->SlotType == 0x00) {
@@ -1003,11 +1005,115 @@ SdMmcHcLedOnOff (
   return Status;
 }
 
+/**
+  Get the reusable ADMA descriptor ring of the host controller.
+
+  The ring is allocated on first use and kept in the private data for the
+  following transfers. A ring left over from an earlier loader stage is not
+  reused since its DMA mapping belongs to that stage.
+
+  @param[in] Private        A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+
+  @retval EFI_SUCCESS       The ADMA descriptor ring is available.
+  @retval Others            The ADMA descriptor ring could not be allocated.
+
+**/
+STATIC
+EFI_STATUS
+SdMmcGetAdmaDescRing (
+  IN SD_MMC_HC_PRIVATE_DATA  *Private
+  )
+{
+  EFI_STATUS                Status;
+  UINT32                    Pages;
+
+  if ((Private->AdmaRing != NULL) && (Private->AdmaRingStage == (UINT8)GetLoaderStage ())) {
+    return EFI_SUCCESS;
+  }
+
+  Pages  = (UINT32)EFI_SIZE_TO_PAGES (SD_MMC_ADMA_DESC_RING_LINES * sizeof (SD_MMC_HC_ADMA_64_DESC_LINE));
+  Status = IoMmuAllocateBuffer (
+                                Pages,
+                                &Private->AdmaRing,
+                                &Private->AdmaRingPhy,
+                                &Private->AdmaRingMap
+                               );
+  if (EFI_ERROR (Status)) {
+    Private->AdmaRing = NULL;
+    return Status;
+  }
+
+  Private->AdmaRingPages = Pages;
+  Private->AdmaRingStage = (UINT8)GetLoaderStage ();
+  return EFI_SUCCESS;
+}
+
+/**
+  Free the ADMA descriptor ring of the host controller.
+
+  @param[in] Private        A pointer to the SD_MMC_HC_PRIVATE_DATA instance.
+
+**/
+VOID
+SdMmcFreeAdmaDescRing (
+  IN SD_MMC_HC_PRIVATE_DATA              *Private
+  )
+{
+  if ((Private->AdmaRing != NULL) && (Private->AdmaRingStage == (UINT8)GetLoaderStage ())) {
+    IoMmuFreeBuffer (Private->AdmaRingPages, Private->AdmaRing, Private->AdmaRingMap);
+  }
+  Private->AdmaRing      = NULL;
+  Private->AdmaRingPages = 0;
+}
+
+/**
+  Fill one ADMA2 transfer descriptor line.
+
+  @param[in] Trb            The pointer to the SD_MMC_HC_TRB instance.
+  @param[in] Adma64         TRUE to use 96-bit descriptors with 64-bit address.
+  @param[in] Index          The index of the descriptor line.
+  @param[in] Address        The data address of the descriptor line.
+  @param[in] Length         The data length of the descriptor line, 0 means 64KB.
+
+**/
+STATIC
+VOID
+SetAdmaDescLine (
+  IN SD_MMC_HC_TRB          *Trb,
+  IN BOOLEAN                Adma64,
+  IN UINT32                 Index,
+  IN UINT64                 Address,
+  IN UINT16                 Length
+  )
+{
+  SD_MMC_HC_ADMA_DESC_LINE     *Desc32;
+  SD_MMC_HC_ADMA_64_DESC_LINE  *Desc64;
+
+  if (Adma64) {
+    Desc64 = (SD_MMC_HC_ADMA_64_DESC_LINE *)Trb->AdmaDesc + Index;
+    Desc64->Valid     = 1;
+    Desc64->Act       = 2;
+    Desc64->Length    = Length;
+    Desc64->AddressLo = (UINT32)Address;
+    Desc64->AddressHi = (UINT32)RShiftU64 (Address, 32);
+  } else {
+    Desc32 = (SD_MMC_HC_ADMA_DESC_LINE *)Trb->AdmaDesc + Index;
+    Desc32->Valid     = 1;
+    Desc32->Act       = 2;
+    Desc32->Length    = Length;
+    Desc32->Address   = (UINT32)Address;
+  }
+}
+
 /**
   Build ADMA descriptor table for transfer.
 
   Refer to SD Host Controller Simplified spec 3.0 Section 1.13 for details.
 
+  The descriptor table is built in the controller's preallocated descriptor
+  ring when the transfer fits. 96-bit descriptors are used when the host
+  controller supports 64-bit system addressing.
+
   @param[in] Trb            The pointer to the SD_MMC_HC_TRB instance.
 
   @retval EFI_SUCCESS       The ADMA descriptor table is created successfully.
@@ -1019,63 +1125,85 @@ BuildAdmaDescTable (
   IN SD_MMC_HC_TRB          *Trb
   )
 {
+  SD_MMC_HC_PRIVATE_DATA    *Private;
   EFI_PHYSICAL_ADDRESS      Data;
   UINT64                    DataLen;
   UINT64                    Entries;
   UINT32                    Index;
   UINT64                    Remaining;
-  UINT32                    Address;
+  UINT64                    Address;
+  UINTN                     LineSize;
   UINTN                     TableSize;
+  BOOLEAN                   Adma64;
   EFI_STATUS                Status;
 
+  Private = Trb->Private;
   Data    = (EFI_PHYSICAL_ADDRESS) (UINTN)Trb->DataPhy;
   DataLen = Trb->DataLen;
+  Adma64  = Private->Adma64;
 
-  DEBUG ((DEBUG_INFO, "BuildAdmaDescTable Data=0x%08X DataLen=0x%08X\n", (UINT32) (UINTN)Data, (UINT32)DataLen));
-  //
-  // Only support 32bit ADMA Descriptor Table
-  //
-  if ((Data >= 0x100000000ul) || ((Data + DataLen) > 0x100000000ul)) {
-    return EFI_INVALID_PARAMETER;
-  }
-  //
-  // Address field shall be set on 32-bit boundary (Lower 2-bit is always set to 0)
-  // for 32-bit address descriptor table.
-  //
-  if ((Data & (BIT0 | BIT1)) != 0) {
-    DEBUG ((DEBUG_INFO, "The buffer [0x%x] to construct ADMA desc is not aligned to 4 bytes boundary!\n", Data));
+  DEBUG ((DEBUG_INFO, "BuildAdmaDescTable Data=0x%lX DataLen=0x%08X\n", Data, (UINT32)DataLen));
+  if (!Adma64) {
+    //
+    // Only 32bit ADMA Descriptor Table is supported by the host controller
+    //
+    if ((Data >= 0x100000000ul) || ((Data + DataLen) > 0x100000000ul)) {
+      return EFI_INVALID_PARAMETER;
+    }
+    //
+    // Address field shall be set on 32-bit boundary (Lower 2-bit is always set to 0)
+    // for 32-bit address descriptor table.
+    //
+    if ((Data & (BIT0 | BIT1)) != 0) {
+      DEBUG ((DEBUG_INFO, "The buffer [0x%lx] to construct ADMA desc is not aligned to 4 bytes boundary!\n", Data));
+    }
+    LineSize = sizeof (SD_MMC_HC_ADMA_DESC_LINE);
+  } else {
+    //
+    // Address field shall be set on 64-bit boundary (Lower 3-bit is always set to 0)
+    // for 64-bit address descriptor table.
+    //
+    if ((Data & (BIT0 | BIT1 | BIT2)) != 0) {
+      DEBUG ((DEBUG_INFO, "The buffer [0x%lx] to construct ADMA desc is not aligned to 8 bytes boundary!\n", Data));
+    }
+    LineSize = sizeof (SD_MMC_HC_ADMA_64_DESC_LINE);
   }
 
   Entries   = DivU64x32 ((DataLen + ADMA_MAX_DATA_PER_LINE - 1), ADMA_MAX_DATA_PER_LINE);
-  TableSize = (UINTN)MultU64x32 (Entries, sizeof (SD_MMC_HC_ADMA_DESC_LINE));
-  Trb->AdmaPages = (UINT32)EFI_SIZE_TO_PAGES (TableSize);
+  TableSize = (UINTN)MultU64x32 (Entries, (UINT32)LineSize);
 
-  Status = IoMmuAllocateBuffer (
-                                EFI_SIZE_TO_PAGES (TableSize),
-                                (VOID **)&Trb->AdmaDesc,
-                                &Trb->AdmaDescPhy,
-                                &Trb->AdmaMap
-                               );
-  if (EFI_ERROR (Status)) {
-    return EFI_OUT_OF_RESOURCES;
+  if ((Entries <= SD_MMC_ADMA_DESC_RING_LINES) && !EFI_ERROR (SdMmcGetAdmaDescRing (Private))) {
+    //
+    // Borrow the descriptor ring, it stays with the host controller.
+    //
+    Trb->AdmaDesc    = Private->AdmaRing;
+    Trb->AdmaDescPhy = Private->AdmaRingPhy;
+    Trb->AdmaPages   = 0;
+  } else {
+    Trb->AdmaPages = (UINT32)EFI_SIZE_TO_PAGES (TableSize);
+    Status = IoMmuAllocateBuffer (
+                                  Trb->AdmaPages,
+                                  &Trb->AdmaDesc,
+                                  &Trb->AdmaDescPhy,
+                                  &Trb->AdmaMap
+                                 );
+    if (EFI_ERROR (Status)) {
+      Trb->AdmaDesc  = NULL;
+      Trb->AdmaPages = 0;
+      return EFI_OUT_OF_RESOURCES;
+    }
   }
 
-  ZeroMem ((VOID *) (UINTN) Trb->AdmaDesc, TableSize);
+  ZeroMem (Trb->AdmaDesc, TableSize);
 
   Remaining = DataLen;
-  Address   = (UINT32)Data;
+  Address   = Data;
   for (Index = 0; Index < Entries; Index++) {
     if (Remaining <= ADMA_MAX_DATA_PER_LINE) {
-      Trb->AdmaDesc[Index].Valid = 1;
-      Trb->AdmaDesc[Index].Act   = 2;
-      Trb->AdmaDesc[Index].Length  = (UINT16)Remaining;
-      Trb->AdmaDesc[Index].Address = Address;
+      SetAdmaDescLine (Trb, Adma64, Index, Address, (UINT16)Remaining);
       break;
     } else {
-      Trb->AdmaDesc[Index].Valid = 1;
-      Trb->AdmaDesc[Index].Act   = 2;
-      Trb->AdmaDesc[Index].Length  = 0;
-      Trb->AdmaDesc[Index].Address = Address;
+      SetAdmaDescLine (Trb, Adma64, Index, Address, 0);
     }
 
     Remaining -= ADMA_MAX_DATA_PER_LINE;
@@ -1085,7 +1213,11 @@ BuildAdmaDescTable (
   //
   // Set the last descriptor line as end of descriptor table
   //
-  Trb->AdmaDesc[Index].End = 1;
+  if (Adma64) {
+    ((SD_MMC_HC_ADMA_64_DESC_LINE *)Trb->AdmaDesc)[Index].End = 1;
+  } else {
+    ((SD_MMC_HC_ADMA_DESC_LINE *)Trb->AdmaDesc)[Index].End = 1;
+  }
   return EFI_SUCCESS;
 }
 
@@ -1221,7 +1353,7 @@ SdMmcFreeTrb (
   )
 {
   if (Trb != NULL) {
-    if (Trb->AdmaDesc != NULL) {
+    if ((Trb->AdmaDesc != NULL) && (Trb->AdmaPages != 0)) {
       IoMmuFreeBuffer (Trb->AdmaPages, Trb->AdmaDesc, Trb->AdmaMap);
     }
     if (Trb->DataMap != NULL) {
@@ -1385,7 +1517,12 @@ SdMmcExecTrb (
   // Set Host Control 1 register DMA Select field
   //
   if (Trb->Mode == SdMmcAdmaMode) {
-    HostCtrl1 = BIT4;
+    HostCtrl1 = (UINT8)~SD_MMC_HC_DMA_SEL_MASK;
+    Status = SdMmcHcAndMmio (Address, SD_MMC_HC_HOST_CTRL1, sizeof (HostCtrl1), (VOID *) (UINTN)&HostCtrl1);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+    HostCtrl1 = Private->Adma64 ? SD_MMC_HC_DMA_SEL_ADMA2_64 : SD_MMC_HC_DMA_SEL_ADMA2_32;
     Status = SdMmcHcOrMmio (Address,  SD_MMC_HC_HOST_CTRL1, sizeof (HostCtrl1), (VOID *) (UINTN)&HostCtrl1);
     if (EFI_ERROR (Status)) {
       return Status;
@@ -83,6 +83,44 @@ typedef struct {
   UINT32 Address;
 } SD_MMC_HC_ADMA_DESC_LINE;
 
+//
+// 96-bit ADMA2 descriptor used with 64-bit system addressing
+// Simplified Spec 3.0 Figure 1-10
+//
+#pragma pack(1)
+typedef struct {
+  UINT32 Valid: 1;
+  UINT32 End: 1;
+  UINT32 Int: 1;
+  UINT32 Reserved: 1;
+  UINT32 Act: 2;
+  UINT32 Reserved1: 10;
+  UINT32 Length: 16;
+  UINT32 AddressLo;
+  UINT32 AddressHi;
+} SD_MMC_HC_ADMA_64_DESC_LINE;
+#pragma pack()
+
+//
+// DMA Select field of Host Control 1 register
+//
+#define SD_MMC_HC_DMA_SEL_MASK        (BIT3 | BIT4)
+#define SD_MMC_HC_DMA_SEL_ADMA2_32    BIT4
+#define SD_MMC_HC_DMA_SEL_ADMA2_64    (BIT3 | BIT4)
+
+//
+// Host Controller Specification Version 4.00 and the Host Version 4 Enable
+// field of Host Control 2 register
+//
+#define SD_MMC_HC_CTRL_VER_400        0x03
+#define SD_MMC_HC_V4_EN               BIT12
+
+//
+// Number of descriptor lines kept in the reusable ADMA descriptor ring.
+// It covers the largest transfer of 0xFFFF blocks of 512 bytes.
+//
+#define SD_MMC_ADMA_DESC_RING_LINES   512
+
 #define SD_MMC_SDMA_BOUNDARY          512 * 1024
 #define SD_MMC_SDMA_ROUND_UP(x, n)    (((x) + n) & ~(n - 1))
 
@@ -108,8 +146,8 @@ typedef struct {
   UINT32   Voltage33: 1;      // bit 24
   UINT32   Voltage30: 1;      // bit 25
   UINT32   Voltage18: 1;      // bit 26
-  UINT32   Reserved3: 1;      // bit 27
-  UINT32   SysBus64: 1;       // bit 28
+  UINT32   SysBus64V4: 1;     // bit 27
+  UINT32   SysBus64V3: 1;     // bit 28
   UINT32   AsyncInt: 1;       // bit 29
   UINT32   SlotType: 2;       // bit 30:31
   UINT32   Sdr50: 1;          // bit 32
@@ -256,6 +256,10 @@ NvmeDeInitialize (
     IoMmuFreeBuffer (6, Private->Buffer, Private->Mapping);
   }
 
+  if (Private->QueuedPrpList != NULL) {
+    IoMmuFreeBuffer (NVME_QUEUED_IO_DEPTH, Private->QueuedPrpList, Private->QueuedPrpMapping);
+  }
+
   if (Private->ControllerData != NULL) {
     FreePool (Private->ControllerData);
   }
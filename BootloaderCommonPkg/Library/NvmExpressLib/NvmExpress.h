@@ -69,6 +69,15 @@ VOID
 
 #define NVME_MAX_QUEUES                           3     // Number of queues supported by the driver
 
+//
+// Queued I/O keeps multiple read commands in flight on I/O queue #2.
+// Each in-flight command owns one PRP list page, so a single command
+// can transfer at most NVME_QUEUED_IO_MAX_PAGES pages.
+//
+#define NVME_QUEUED_IO_QID                        2
+#define NVME_QUEUED_IO_DEPTH                      32
+#define NVME_QUEUED_IO_MAX_PAGES                  (EFI_PAGE_SIZE / sizeof (UINT64))
+
 #define NVME_CONTROLLER_ID                        0
 
 //
@@ -86,6 +95,15 @@ VOID
 //
 #define NVME_CONTROLLER_PRIVATE_DATA_SIGNATURE    SIGNATURE_32 ('N','V','M','E')
 
+//
+// Nvme queued I/O command slot.
+//
+typedef struct {
+  VOID                                *MapData;
+  UINT32                              Bytes;
+  BOOLEAN                             Busy;
+} NVME_QUEUED_IO_SLOT;
+
 //
 // Nvme private data structure.
 //
@@ -143,6 +161,18 @@ struct _NVME_CONTROLLER_PRIVATE_DATA {
   EFI_EVENT                           TimerEvent;
   LIST_ENTRY                          AsyncPassThruQueue;
   LIST_ENTRY                          UnsubmittedSubtasks;
+
+  //
+  // For queued I/O operations.
+  // One PRP list page per slot is carved out of QueuedPrpList.
+  //
+  UINT64                              *QueuedPrpList;
+  EFI_PHYSICAL_ADDRESS                QueuedPrpListPciAddr;
+  VOID                                *QueuedPrpMapping;
+  BOOLEAN                             QueuedIoDisabled;
+  UINT32                              QueuedIoCount;
+  UINT32                              QueuedIoBytes;
+  NVME_QUEUED_IO_SLOT                 QueuedSlot[NVME_QUEUED_IO_DEPTH];
 };
 
 #define NVME_CONTROLLER_PRIVATE_DATA_FROM_PASS_THRU(a) \
@@ -362,6 +392,98 @@ NvmExpressGetNextNamespace (
   IN OUT UINT32                                      *NamespaceId
   );
 
+/**
+  Prepare the controller for queued I/O operations.
+
+  The PRP list pages used by the queued commands are allocated on the first call.
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS            Queued I/O can be used.
+  @retval EFI_UNSUPPORTED        Queued I/O is not available on this controller.
+
+**/
+EFI_STATUS
+NvmeQueuedIoInit (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  );
+
+/**
+  Get the number of commands that can be kept in flight by queued I/O.
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval The queued I/O depth.
+
+**/
+UINT32
+NvmeQueuedIoDepth (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  );
+
+/**
+  Place a read or write command into the queued I/O submission queue.
+
+  The submission queue doorbell is not rung, so that a batch of commands can be
+  submitted with a single doorbell write through NvmeQueuedIoKick().
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  NamespaceId        The namespace identifier.
+  @param[in]  Opcode             NVME_IO_READ_OPC or NVME_IO_WRITE_OPC.
+  @param[in]  Buffer             The data buffer.
+  @param[in]  Lba                The start block number.
+  @param[in]  Blocks             The block number to transfer.
+  @param[in]  BlockSize          The media block size.
+
+  @retval EFI_SUCCESS            The command was placed into the submission queue.
+  @retval EFI_NOT_READY          No free slot is available.
+  @retval EFI_BAD_BUFFER_SIZE    The transfer exceeds NVME_QUEUED_IO_MAX_PAGES pages.
+  @retval EFI_OUT_OF_RESOURCES   The data buffer could not be mapped.
+
+**/
+EFI_STATUS
+NvmeQueuedIoSubmit (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private,
+  IN UINT32                           NamespaceId,
+  IN UINT8                            Opcode,
+  IN VOID                             *Buffer,
+  IN UINT64                           Lba,
+  IN UINT32                           Blocks,
+  IN UINT32                           BlockSize
+  );
+
+/**
+  Ring the queued I/O submission queue doorbell for all submitted commands.
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS            The doorbell was written.
+  @retval Others                 The doorbell write failed.
+
+**/
+EFI_STATUS
+NvmeQueuedIoKick (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  );
+
+/**
+  Reap all available completions from the queued I/O completion queue.
+
+  The completion queue head doorbell is written once for the whole batch.
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[out] Reaped             The number of completions reaped.
+
+  @retval EFI_SUCCESS            All reaped commands completed successfully.
+  @retval EFI_DEVICE_ERROR       At least one reaped command failed.
+
+**/
+EFI_STATUS
+NvmeQueuedIoReap (
+  IN  NVME_CONTROLLER_PRIVATE_DATA    *Private,
+  OUT UINT32                          *Reaped
+  );
+
 /**
   Dump the execution status from a given completion queue entry.
 
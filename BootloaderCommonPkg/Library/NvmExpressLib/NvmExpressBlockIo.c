@@ -174,6 +174,149 @@ WriteSectors (
   return Status;
 }
 
+/**
+  Read some blocks from the device with multiple commands in flight.
+
+  The read is split into MaxTransferBlocks sized commands. As many commands as
+  the queue depth allows are submitted with one doorbell write, and completions
+  are reaped in batches while new commands are submitted.
+
+  @param  Device                 The pointer to the NVME_DEVICE_PRIVATE_DATA data structure.
+  @param  Buffer                 The buffer used to store the data read from the device.
+  @param  Lba                    The start block number.
+  @param  Blocks                 Total block number to be read.
+  @param  MaxTransferBlocks      Max block number of a single command.
+
+  @retval EFI_SUCCESS            Datum are read from the device.
+  @retval EFI_UNSUPPORTED        Queued I/O is not available, use the synchronous path.
+  @retval Others                 Fail to read all the datum.
+
+**/
+STATIC
+EFI_STATUS
+NvmeQueuedRead (
+  IN     NVME_DEVICE_PRIVATE_DATA       *Device,
+  OUT VOID                              *Buffer,
+  IN     UINT64                         Lba,
+  IN     UINTN                          Blocks,
+  IN     UINT32                         MaxTransferBlocks
+  )
+{
+  EFI_STATUS                       Status;
+  EFI_STATUS                       ReapStatus;
+  NVME_CONTROLLER_PRIVATE_DATA     *Private;
+  UINT32                           BlockSize;
+  UINT32                           IoAlign;
+  UINT32                           XferBlocks;
+  UINT32                           MaxBytesInFlight;
+  UINT32                           Submitted;
+  UINT32                           Reaped;
+  UINT64                           TimeCount;
+
+  Private   = Device->Controller;
+  BlockSize = Device->Media.BlockSize;
+
+  IoAlign = Private->PassThruMode.IoAlign;
+  if ((IoAlign > 0) && (((UINTN)Buffer & (IoAlign - 1)) != 0)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  Status = NvmeQueuedIoInit (Private);
+  if (EFI_ERROR (Status)) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // Each command can only describe NVME_QUEUED_IO_MAX_PAGES pages with its PRP list.
+  //
+  XferBlocks = MIN (MaxTransferBlocks, (NVME_QUEUED_IO_MAX_PAGES * EFI_PAGE_SIZE) / BlockSize);
+  if (XferBlocks == 0) {
+    return EFI_UNSUPPORTED;
+  }
+
+  //
+  // With DMA protection every in-flight command is bounced through the DMA buffer.
+  //
+  if (FeaturePcdGet (PcdDmaProtectionEnabled)) {
+    MaxBytesInFlight = PcdGet32 (PcdDmaBufferSize) >> 1;
+  } else {
+    MaxBytesInFlight = MAX_UINT32;
+  }
+
+  Status = EFI_SUCCESS;
+  while ((Blocks > 0) || (Private->QueuedIoCount > 0)) {
+    //
+    // Fill up the submission queue, then ring the doorbell once.
+    //
+    Submitted = 0;
+    while ((Blocks > 0) && !EFI_ERROR (Status)) {
+      if (XferBlocks > Blocks) {
+        XferBlocks = (UINT32)Blocks;
+      }
+      if ((Private->QueuedIoCount > 0) &&
+          (Private->QueuedIoBytes + XferBlocks * BlockSize > MaxBytesInFlight)) {
+        break;
+      }
+      Status = NvmeQueuedIoSubmit (Private, Device->NamespaceId, NVME_IO_READ_OPC, Buffer, Lba, XferBlocks, BlockSize);
+      if (Status == EFI_NOT_READY) {
+        Status = EFI_SUCCESS;
+        break;
+      }
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+      Blocks -= XferBlocks;
+      Buffer  = (VOID *) (UINTN) ((UINT64) (UINTN)Buffer + XferBlocks * BlockSize);
+      Lba    += XferBlocks;
+      Submitted++;
+    }
+
+    if (Submitted > 0) {
+      ReapStatus = NvmeQueuedIoKick (Private);
+      if (EFI_ERROR (ReapStatus)) {
+        Status = ReapStatus;
+      }
+    }
+
+    if (Private->QueuedIoCount == 0) {
+      break;
+    }
+
+    //
+    // Wait for at least one completion, then reap everything available.
+    //
+    TimeCount = RShiftU64 (NVME_GENERIC_TIMEOUT, 7); //times = 128ns unit
+    Reaped    = 0;
+    while (TimeCount-- != 0) {
+      ReapStatus = NvmeQueuedIoReap (Private, &Reaped);
+      if (EFI_ERROR (ReapStatus)) {
+        Status = ReapStatus;
+      }
+      if (Reaped > 0) {
+        break;
+      }
+      NanoSecondDelay (100);
+    }
+
+    if (Reaped == 0) {
+      //
+      // The controller stopped responding, the queue state cannot be trusted anymore.
+      //
+      Private->QueuedIoDisabled = TRUE;
+      return EFI_TIMEOUT;
+    }
+
+    //
+    // On error, stop submitting and only drain the commands in flight.
+    //
+    if (EFI_ERROR (Status)) {
+      Blocks = 0;
+    }
+  }
+
+  return Status;
+}
+
 /**
   Read some blocks from the device.
 
@@ -220,7 +363,22 @@ NvmeRead (
   OrginalBlocks = Blocks;
 
   MaxTransferBlocks = GetMaxTransferBlockNumber (Private, BlockSize);
-  while (Blocks > 0) {
+  if (Blocks > MaxTransferBlocks) {
+    //
+    // Keep multiple commands in flight for large reads
+    //
+    Status = NvmeQueuedRead (Device, Buffer, Lba, Blocks, MaxTransferBlocks);
+    if (Status == EFI_UNSUPPORTED) {
+      //
+      // Fall back to one command at a time
+      //
+      Status = EFI_SUCCESS;
+    } else if (!EFI_ERROR (Status)) {
+      Blocks = 0;
+    }
+  }
+
+  while ((Blocks > 0) && !EFI_ERROR (Status)) {
     if (Blocks > MaxTransferBlocks) {
       Status = ReadSectors (Device, (UINT64) (UINTN)Buffer, Lba, MaxTransferBlocks);
 
@@ -965,7 +965,7 @@ NvmeControllerInit (
 
   //
   // Create two I/O completion queues.
-  // One for blocking I/O, one for non-blocking I/O.
+  // One for blocking I/O, one for queued (non-blocking) I/O.
   //
   Status = NvmeCreateIoCompletionQueue (Private);
   if (EFI_ERROR (Status)) {
@@ -974,7 +974,7 @@ NvmeControllerInit (
 
   //
   // Create two I/O Submission queues.
-  // One for blocking I/O, one for non-blocking I/O.
+  // One for blocking I/O, one for queued (non-blocking) I/O.
   //
   Status = NvmeCreateIoSubmissionQueue (Private);
 
@@ -686,6 +686,301 @@ EXIT:
   return Status;
 }
 
+/**
+  Prepare the controller for queued I/O operations.
+
+  The PRP list pages used by the queued commands are allocated on the first call.
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS            Queued I/O can be used.
+  @retval EFI_UNSUPPORTED        Queued I/O is not available on this controller.
+
+**/
+EFI_STATUS
+NvmeQueuedIoInit (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  )
+{
+  EFI_STATUS                     Status;
+  VOID                           *PrpList;
+
+  if (Private->QueuedIoDisabled) {
+    return EFI_UNSUPPORTED;
+  }
+
+  if (Private->QueuedPrpList != NULL) {
+    return EFI_SUCCESS;
+  }
+
+  //
+  // Nothing to gain if only one command can be in flight.
+  //
+  if (NvmeQueuedIoDepth (Private) < 2) {
+    Private->QueuedIoDisabled = TRUE;
+    return EFI_UNSUPPORTED;
+  }
+
+  PrpList = NULL;
+  Status  = IoMmuAllocateBuffer (
+              NVME_QUEUED_IO_DEPTH,
+              &PrpList,
+              &Private->QueuedPrpListPciAddr,
+              &Private->QueuedPrpMapping
+              );
+  if (EFI_ERROR (Status) || (PrpList == NULL)) {
+    DEBUG ((DEBUG_VERBOSE, "NvmeQueuedIoInit: create PrpList failure!\n"));
+    Private->QueuedIoDisabled = TRUE;
+    return EFI_UNSUPPORTED;
+  }
+
+  Private->QueuedPrpList = (UINT64 *)PrpList;
+  Private->QueuedIoCount = 0;
+  Private->QueuedIoBytes = 0;
+  ZeroMem (Private->QueuedSlot, sizeof (Private->QueuedSlot));
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Get the number of commands that can be kept in flight by queued I/O.
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval The queued I/O depth.
+
+**/
+UINT32
+NvmeQueuedIoDepth (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  )
+{
+  UINT32                         SqSize;
+
+  //
+  // One submission queue entry is always kept empty to tell full from empty.
+  //
+  SqSize = MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes) + 1;
+  return MIN (NVME_QUEUED_IO_DEPTH, SqSize - 1);
+}
+
+/**
+  Place a read or write command into the queued I/O submission queue.
+
+  The submission queue doorbell is not rung, so that a batch of commands can be
+  submitted with a single doorbell write through NvmeQueuedIoKick().
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[in]  NamespaceId        The namespace identifier.
+  @param[in]  Opcode             NVME_IO_READ_OPC or NVME_IO_WRITE_OPC.
+  @param[in]  Buffer             The data buffer.
+  @param[in]  Lba                The start block number.
+  @param[in]  Blocks             The block number to transfer.
+  @param[in]  BlockSize          The media block size.
+
+  @retval EFI_SUCCESS            The command was placed into the submission queue.
+  @retval EFI_NOT_READY          No free slot is available.
+  @retval EFI_BAD_BUFFER_SIZE    The transfer exceeds NVME_QUEUED_IO_MAX_PAGES pages.
+  @retval EFI_OUT_OF_RESOURCES   The data buffer could not be mapped.
+
+**/
+EFI_STATUS
+NvmeQueuedIoSubmit (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private,
+  IN UINT32                           NamespaceId,
+  IN UINT8                            Opcode,
+  IN VOID                             *Buffer,
+  IN UINT64                           Lba,
+  IN UINT32                           Blocks,
+  IN UINT32                           BlockSize
+  )
+{
+  EFI_STATUS                     Status;
+  NVME_SQ                        *Sq;
+  UINT16                         SqSize;
+  UINT16                         Slot;
+  UINT32                         Bytes;
+  UINT32                         Offset;
+  UINTN                          Pages;
+  UINTN                          Index;
+  UINTN                          MapLength;
+  UINT64                         *PrpList;
+  EFI_PHYSICAL_ADDRESS           PhyAddr;
+  EFI_PHYSICAL_ADDRESS           PageAddr;
+  VOID                           *MapData;
+  EDKII_IOMMU_OPERATION          Flag;
+
+  if (Private->QueuedIoCount >= NvmeQueuedIoDepth (Private)) {
+    return EFI_NOT_READY;
+  }
+
+  for (Slot = 0; Slot < NVME_QUEUED_IO_DEPTH; Slot++) {
+    if (!Private->QueuedSlot[Slot].Busy) {
+      break;
+    }
+  }
+  if (Slot >= NVME_QUEUED_IO_DEPTH) {
+    return EFI_NOT_READY;
+  }
+
+  if (Opcode == NVME_IO_READ_OPC) {
+    Flag = EdkiiIoMmuOperationBusMasterWrite;
+  } else {
+    Flag = EdkiiIoMmuOperationBusMasterRead;
+  }
+
+  Bytes     = Blocks * BlockSize;
+  MapLength = Bytes;
+  MapData   = NULL;
+  Status    = IoMmuMap (Flag, Buffer, &MapLength, &PhyAddr, &MapData);
+  if (EFI_ERROR (Status) || (MapLength != Bytes)) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  //
+  // PRP entry 1 covers the first page, the PRP list of this slot covers the rest.
+  //
+  Offset = (UINT32)PhyAddr & (EFI_PAGE_SIZE - 1);
+  Pages  = EFI_SIZE_TO_PAGES (Offset + Bytes);
+  if (Pages > NVME_QUEUED_IO_MAX_PAGES + 1) {
+    IoMmuUnmap (MapData);
+    return EFI_BAD_BUFFER_SIZE;
+  }
+
+  Sq = Private->SqBuffer[NVME_QUEUED_IO_QID] + Private->SqTdbl[NVME_QUEUED_IO_QID].Sqt;
+  ZeroMem (Sq, sizeof (NVME_SQ));
+  Sq->Opc    = Opcode;
+  Sq->Cid    = Slot;
+  Sq->Nsid   = NamespaceId;
+  Sq->Prp[0] = PhyAddr;
+
+  PageAddr = (PhyAddr + EFI_PAGE_SIZE) & ~((EFI_PHYSICAL_ADDRESS)EFI_PAGE_SIZE - 1);
+  if (Pages > 2) {
+    PrpList = Private->QueuedPrpList + Slot * NVME_QUEUED_IO_MAX_PAGES;
+    for (Index = 0; Index < Pages - 1; Index++) {
+      PrpList[Index] = PageAddr;
+      PageAddr += EFI_PAGE_SIZE;
+    }
+    Sq->Prp[1] = Private->QueuedPrpListPciAddr + Slot * EFI_PAGE_SIZE;
+  } else if (Pages == 2) {
+    Sq->Prp[1] = PageAddr;
+  }
+
+  Sq->Payload.Raw.Cdw10 = (UINT32)Lba;
+  Sq->Payload.Raw.Cdw11 = (UINT32)RShiftU64 (Lba, 32);
+  Sq->Payload.Raw.Cdw12 = (Blocks - 1) & 0xFFFF;
+  if (Opcode == NVME_IO_WRITE_OPC) {
+    //
+    // Set Force Unit Access bit (bit 30) to use write-through behaviour
+    //
+    Sq->Payload.Raw.Cdw12 |= BIT30;
+  }
+
+  SqSize = MIN (NVME_ASYNC_CSQ_SIZE, Private->Cap.Mqes) + 1;
+  Private->SqTdbl[NVME_QUEUED_IO_QID].Sqt = (Private->SqTdbl[NVME_QUEUED_IO_QID].Sqt + 1) % SqSize;
+
+  Private->QueuedSlot[Slot].MapData = MapData;
+  Private->QueuedSlot[Slot].Bytes   = Bytes;
+  Private->QueuedSlot[Slot].Busy    = TRUE;
+  Private->QueuedIoCount++;
+  Private->QueuedIoBytes += Bytes;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Ring the queued I/O submission queue doorbell for all submitted commands.
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+
+  @retval EFI_SUCCESS            The doorbell was written.
+  @retval Others                 The doorbell write failed.
+
+**/
+EFI_STATUS
+NvmeQueuedIoKick (
+  IN NVME_CONTROLLER_PRIVATE_DATA     *Private
+  )
+{
+  UINT32                         Data;
+
+  Data = ReadUnaligned32 ((UINT32 *)&Private->SqTdbl[NVME_QUEUED_IO_QID]);
+  return NvmHcRwMmio (Private->NvmeHCBase, NVME_SQTDBL_OFFSET (NVME_QUEUED_IO_QID, Private->Cap.Dstrd), FALSE,
+                      sizeof (Data), &Data);
+}
+
+/**
+  Reap all available completions from the queued I/O completion queue.
+
+  The completion queue head doorbell is written once for the whole batch.
+
+  @param[in]  Private            The pointer to the NVME_CONTROLLER_PRIVATE_DATA data structure.
+  @param[out] Reaped             The number of completions reaped.
+
+  @retval EFI_SUCCESS            All reaped commands completed successfully.
+  @retval EFI_DEVICE_ERROR       At least one reaped command failed.
+
+**/
+EFI_STATUS
+NvmeQueuedIoReap (
+  IN  NVME_CONTROLLER_PRIVATE_DATA    *Private,
+  OUT UINT32                          *Reaped
+  )
+{
+  EFI_STATUS                     Status;
+  NVME_CQ                        *Cq;
+  NVME_QUEUED_IO_SLOT            *Slot;
+  UINT16                         CqSize;
+  UINT32                         Count;
+  UINT32                         Data;
+
+  Status = EFI_SUCCESS;
+  Count  = 0;
+  CqSize = MIN (NVME_ASYNC_CCQ_SIZE, Private->Cap.Mqes) + 1;
+
+  while (TRUE) {
+    Cq = Private->CqBuffer[NVME_QUEUED_IO_QID] + Private->CqHdbl[NVME_QUEUED_IO_QID].Cqh;
+    if (Cq->Pt == Private->Pt[NVME_QUEUED_IO_QID]) {
+      break;
+    }
+
+    if ((Cq->Sct != 0) || (Cq->Sc != 0)) {
+      Status = EFI_DEVICE_ERROR;
+      DEBUG_CODE_BEGIN();
+      NvmeDumpStatus (Cq);
+      DEBUG_CODE_END();
+    }
+
+    Private->AsyncSqHead = Cq->Sqhd;
+    if (Cq->Cid < NVME_QUEUED_IO_DEPTH) {
+      Slot = &Private->QueuedSlot[Cq->Cid];
+      if (Slot->Busy) {
+        if (Slot->MapData != NULL) {
+          IoMmuUnmap (Slot->MapData);
+        }
+        Private->QueuedIoCount--;
+        Private->QueuedIoBytes -= Slot->Bytes;
+        ZeroMem (Slot, sizeof (NVME_QUEUED_IO_SLOT));
+      }
+    }
+
+    if (++Private->CqHdbl[NVME_QUEUED_IO_QID].Cqh == CqSize) {
+      Private->CqHdbl[NVME_QUEUED_IO_QID].Cqh = 0;
+      Private->Pt[NVME_QUEUED_IO_QID] ^= 1;
+    }
+    Count++;
+  }
+
+  if (Count > 0) {
+    Data = ReadUnaligned32 ((UINT32 *)&Private->CqHdbl[NVME_QUEUED_IO_QID]);
+    NvmHcRwMmio (Private->NvmeHCBase, NVME_CQHDBL_OFFSET (NVME_QUEUED_IO_QID, Private->Cap.Dstrd), FALSE,
+                 sizeof (Data), &Data);
+  }
+
+  *Reaped = Count;
+  return Status;
+}
+
 /**
   Used to retrieve the next namespace ID for this NVM Express controller.
 
@@ -12,6 +12,13 @@
 #include <Library/CryptoLib.h>
 #include <Library/SecureBootLib.h>
 #include <Library/BootloaderCommonLib.h>
+#include <Service/MpService.h>
+
+//
+// Each algorithm of a multi hash reads the same chunk in turn, so keep it
+// small enough to stay in the L1 data cache.
+//
+#define  HASH_MULTI_CHUNK_SIZE   0x2000
 
 /**
   Get hash to extend a firmware stage component
@@ -134,27 +141,409 @@ CalculateHash  (
 
 
 /**
-  Verify data block hash with the built-in one.
+  Start an incremental hash calculation.
+
+  @param[in,out]  HashCtx    Hash stream context to initialize.
+  @param[in]      HashAlg    Specify hash algrothsm.
+
+  @retval RETURN_SUCCESS             Hash context is initialized.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_UNSUPPORTED         Hash Alg type is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateHashInit (
+  IN OUT   HASH_STREAM_CTX  *HashCtx,
+  IN       UINT8             HashAlg
+  )
+{
+  if (HashCtx == NULL) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  HashCtx->HashAlg = HashAlg;
+  if (HashAlg == HASH_TYPE_SHA256) {
+    return Sha256Init (&HashCtx->Ctx, sizeof (HashCtx->Ctx));
+  } else if (HashAlg == HASH_TYPE_SHA384) {
+    return Sha384Init (&HashCtx->Ctx, sizeof (HashCtx->Ctx));
+  } else if (HashAlg == HASH_TYPE_SM3) {
+    return Sm3Init (&HashCtx->Ctx, sizeof (HashCtx->Ctx));
+  }
+
+  HashCtx->HashAlg = HASH_TYPE_NONE;
+  return RETURN_UNSUPPORTED;
+}
+
+/**
+  Feed more data into an incremental hash calculation.
+
+  @param[in,out]  HashCtx    Hash stream context.
+  @param[in]      Data       Data buffer pointer.
+  @param[in]      Length     Data buffer size.
+
+  @retval RETURN_SUCCESS             Data is consumed.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_UNSUPPORTED         Hash Alg type is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateHashUpdate (
+  IN OUT   HASH_STREAM_CTX  *HashCtx,
+  IN CONST UINT8            *Data,
+  IN       UINT32            Length
+  )
+{
+  if ((HashCtx == NULL) || (Data == NULL)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (HashCtx->HashAlg == HASH_TYPE_SHA256) {
+    return Sha256Update (&HashCtx->Ctx, Data, Length);
+  } else if (HashCtx->HashAlg == HASH_TYPE_SHA384) {
+    return Sha384Update (&HashCtx->Ctx, Data, Length);
+  } else if (HashCtx->HashAlg == HASH_TYPE_SM3) {
+    return Sm3Update (&HashCtx->Ctx, Data, Length);
+  }
+
+  return RETURN_UNSUPPORTED;
+}
+
+/**
+  Finish an incremental hash calculation.
+
+  @param[in,out]  HashCtx    Hash stream context.
+  @param[out]     OutHash    Hash of all data fed into the context.
+
+  @retval RETURN_SUCCESS             Hash Calculation succeeded.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_UNSUPPORTED         Hash Alg type is not supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateHashFinal (
+  IN OUT   HASH_STREAM_CTX  *HashCtx,
+  OUT      UINT8            *OutHash
+  )
+{
+  if ((HashCtx == NULL) || (OutHash == NULL)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (HashCtx->HashAlg == HASH_TYPE_SHA256) {
+    return Sha256Final (&HashCtx->Ctx, OutHash);
+  } else if (HashCtx->HashAlg == HASH_TYPE_SHA384) {
+    return Sha384Final (&HashCtx->Ctx, OutHash);
+  } else if (HashCtx->HashAlg == HASH_TYPE_SM3) {
+    return Sm3Final (&HashCtx->Ctx, OutHash);
+  }
+
+  return RETURN_UNSUPPORTED;
+}
+
+/**
+  Start a hash calculation for several algorithms over the same data.
+
+  @param[in,out]  MultiCtx   Multi hash context to initialize.
+  @param[in]      HashAlg    Array of hash algorithms.
+  @param[in]      Count      Number of entries in HashAlg, at most HASH_MULTI_MAX.
+
+  @retval RETURN_SUCCESS             At least one algorithm is initialized.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_UNSUPPORTED         None of the algorithms is supported.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateMultiHashInit (
+  IN OUT   HASH_MULTI_CTX   *MultiCtx,
+  IN CONST HASH_ALG_TYPE    *HashAlg,
+  IN       UINT32            Count
+  )
+{
+  RETURN_STATUS     Status;
+  UINT32            Index;
+
+  if ((MultiCtx == NULL) || (HashAlg == NULL) || (Count == 0) || (Count > HASH_MULTI_MAX)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Status = RETURN_UNSUPPORTED;
+  MultiCtx->Count = Count;
+  for (Index = 0; Index < Count; Index++) {
+    if (RETURN_ERROR (CalculateHashInit (&MultiCtx->Stream[Index], HashAlg[Index]))) {
+      MultiCtx->Stream[Index].HashAlg = HASH_TYPE_NONE;
+    } else {
+      Status = RETURN_SUCCESS;
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Feed more data into a multi hash calculation.
+
+  @param[in,out]  MultiCtx   Multi hash context.
+  @param[in]      Data       Data buffer pointer.
+  @param[in]      Length     Data buffer size.
+
+  @retval RETURN_SUCCESS             Data is consumed by all active algorithms.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval Others                     At least one algorithm failed.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateMultiHashUpdate (
+  IN OUT   HASH_MULTI_CTX   *MultiCtx,
+  IN CONST UINT8            *Data,
+  IN       UINT32            Length
+  )
+{
+  HASH_STREAM_CTX  *Stream;
+  RETURN_STATUS     Status;
+  UINT32            Offset;
+  UINT32            ChunkLen;
+  UINT32            Index;
+
+  if ((MultiCtx == NULL) || (Data == NULL) || (MultiCtx->Count > HASH_MULTI_MAX)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Status = RETURN_SUCCESS;
+  for (Offset = 0; Offset < Length; Offset += ChunkLen) {
+    ChunkLen = MIN (Length - Offset, HASH_MULTI_CHUNK_SIZE);
+    for (Index = 0; Index < MultiCtx->Count; Index++) {
+      Stream = &MultiCtx->Stream[Index];
+      if (Stream->HashAlg == HASH_TYPE_NONE) {
+        continue;
+      }
+      if (RETURN_ERROR (CalculateHashUpdate (Stream, Data + Offset, ChunkLen))) {
+        Stream->HashAlg = HASH_TYPE_NONE;
+        Status = RETURN_DEVICE_ERROR;
+      }
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Finish a multi hash calculation.
+
+  Digest Index is stored at OutHash + Index * HASH_DIGEST_MAX. The digest
+  buffer of an algorithm that is not supported or failed is left untouched,
+  and its MultiCtx->Stream[Index].HashAlg is HASH_TYPE_NONE on return.
+
+  @param[in,out]  MultiCtx   Multi hash context.
+  @param[out]     OutHash    Buffer of MultiCtx->Count * HASH_DIGEST_MAX bytes.
+
+  @retval RETURN_SUCCESS             All digests are calculated.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval Others                     At least one digest is not available.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateMultiHashFinal (
+  IN OUT   HASH_MULTI_CTX   *MultiCtx,
+  OUT      UINT8            *OutHash
+  )
+{
+  HASH_STREAM_CTX  *Stream;
+  RETURN_STATUS     Status;
+  UINT32            Index;
+
+  if ((MultiCtx == NULL) || (OutHash == NULL) || (MultiCtx->Count > HASH_MULTI_MAX)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Status = RETURN_SUCCESS;
+  for (Index = 0; Index < MultiCtx->Count; Index++) {
+    Stream = &MultiCtx->Stream[Index];
+    if ((Stream->HashAlg == HASH_TYPE_NONE) ||
+        RETURN_ERROR (CalculateHashFinal (Stream, OutHash + Index * HASH_DIGEST_MAX))) {
+      Stream->HashAlg = HASH_TYPE_NONE;
+      Status = RETURN_UNSUPPORTED;
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Calculate the digests of one data buffer for several algorithms in one pass.
 
   @param[in]  Data           Data buffer pointer.
   @param[in]  Length         Data buffer size.
-  @param[in]  Usage          Hash component usage.
-  @param[in]  HashAlg        Specify hash algorithm.
-  @param[in,out]  Hash       On input,  expected hash value when hash component usage is 0.
+  @param[in]  HashAlg        Array of hash algorithms.
+  @param[in]  Count          Number of entries in HashAlg, at most HASH_MULTI_MAX.
+  @param[out] OutHash        Buffer of Count * HASH_DIGEST_MAX bytes.
+
+  @retval RETURN_SUCCESS             All digests are calculated.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval Others                     At least one digest is not available.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateMultiHash (
+  IN CONST UINT8            *Data,
+  IN       UINT32            Length,
+  IN CONST HASH_ALG_TYPE    *HashAlg,
+  IN       UINT32            Count,
+  OUT      UINT8            *OutHash
+  )
+{
+  HASH_MULTI_CTX    MultiCtx;
+  RETURN_STATUS     Status;
+
+  if (OutHash == NULL) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Status = CalculateMultiHashInit (&MultiCtx, HashAlg, Count);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  CalculateMultiHashUpdate (&MultiCtx, Data, Length);
+  return CalculateMultiHashFinal (&MultiCtx, OutHash);
+}
+
+/**
+  The job function to calculate the hash for one hash request.
+
+  It can run on an AP, so it must not print any debug messages and has to
+  fit in MP_JOB_STACK_SIZE. The hash context takes about 1 KB of it.
+
+  @param[in] Arg  Pointer to the HASH_REQUEST.
+
+  @retval  0      Always.
+**/
+STATIC
+UINT64
+EFIAPI
+CalculateHashTask (
+  IN  UINT64   Arg
+  )
+{
+  HASH_REQUEST     *Request;
+  HASH_MULTI_CTX    MultiCtx;
+  HASH_ALG_TYPE     HashAlg[2];
+
+  Request = (HASH_REQUEST *)(UINTN)Arg;
+  Request->Status      = RETURN_UNSUPPORTED;
+  Request->ExtraStatus = RETURN_UNSUPPORTED;
+
+  // Both digests are calculated in a single pass over the data
+  HashAlg[0] = Request->HashAlg;
+  HashAlg[1] = Request->ExtraHashAlg;
+  if (RETURN_ERROR (CalculateMultiHashInit (&MultiCtx, HashAlg, 2))) {
+    return 0;
+  }
+
+  if (Request->Data == NULL) {
+    return 0;
+  }
+
+  //
+  // Each digest is stored straight into the request, so the AP stack only
+  // holds the hash context
+  //
+  CalculateMultiHashUpdate (&MultiCtx, Request->Data, Request->Length);
+  if (MultiCtx.Stream[0].HashAlg != HASH_TYPE_NONE) {
+    Request->Status = CalculateHashFinal (&MultiCtx.Stream[0], Request->Digest);
+  }
+  if (MultiCtx.Stream[1].HashAlg != HASH_TYPE_NONE) {
+    Request->ExtraStatus = CalculateHashFinal (&MultiCtx.Stream[1], Request->ExtraDigest);
+  }
+
+  return 0;
+}
+
+/**
+  Calculate the hash for a list of independent data buffers.
+
+  When the MP service is available, the buffers are hashed in parallel on
+  the idle APs. Otherwise they are hashed one after another on the BSP.
+
+  @param[in,out]  Request    Array of hash requests. Status and digests are updated.
+  @param[in]      Count      Number of entries in Request.
+
+  @retval RETURN_SUCCESS             All hash calculations succeeded.
+  @retval RETRUN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval Others                     At least one hash calculation failed.
+
+**/
+RETURN_STATUS
+EFIAPI
+CalculateHashList (
+  IN OUT   HASH_REQUEST    *Request,
+  IN       UINT32           Count
+  )
+{
+  MP_SERVICE      *MpService;
+  RETURN_STATUS    Status;
+  UINT32           Index;
+
+  if ((Request == NULL) && (Count > 0)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  MpService = NULL;
+  if (Count > 1) {
+    MpService = (MP_SERVICE *) GetServiceBySignature (MP_SERVICE_SIGNATURE);
+    if ((MpService != NULL) && (MpService->GetWorkerCount () <= 1)) {
+      MpService = NULL;
+    }
+  }
+
+  for (Index = 0; Index < Count; Index++) {
+    if (MpService != NULL) {
+      MpService->SubmitJob (CalculateHashTask, (UINT64)(UINTN)&Request[Index]);
+    } else {
+      CalculateHashTask ((UINT64)(UINTN)&Request[Index]);
+    }
+  }
+
+  if (MpService != NULL) {
+    MpService->WaitAllJobs ();
+  }
+
+  Status = RETURN_SUCCESS;
+  for (Index = 0; Index < Count; Index++) {
+    if (RETURN_ERROR (Request[Index].Status)) {
+      Status = Request[Index].Status;
+      break;
+    }
+  }
+
+  return Status;
+}
+
+/**
+  Verify a pre-calculated data digest with the built-in one.
+
+  @param[in]      Digest     Calculated digest of the data block.
+  @param[in]      Usage      Hash component usage.
+  @param[in]      HashAlg    Specify hash algorithm.
+  @param[in,out]  HashData   On input,  expected hash value when hash component usage is 0.
                              On output, calculated hash value when verification succeeds.
 
   @retval RETURN_SUCCESS             Hash verification succeeded.
   @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
   @retval RETURN_NOT_FOUND           Hash data for hash component usage is not found.
-  @retval RETURN_UNSUPPORTED         HashAlg not supported.
   @retval RETURN_SECURITY_VIOLATION  Hash verification failed.
 
 **/
 RETURN_STATUS
 EFIAPI
-DoHashVerify (
-  IN CONST UINT8           *Data,
-  IN       UINT32           Length,
+DoDigestVerify (
+  IN CONST UINT8           *Digest,
   IN       HASH_COMP_USAGE  Usage,
   IN       UINT8            HashAlg,
   IN OUT   UINT8           *HashData
@@ -162,12 +551,9 @@ DoHashVerify (
 {
   RETURN_STATUS        Status;
   RETURN_STATUS        Status2;
-  UINT8                Digest[HASH_DIGEST_MAX];
   UINT8                DigestSize;
 
-
-  if ((Data == NULL) ||
-      ((HashAlg != HASH_TYPE_SHA256) && (HashAlg != HASH_TYPE_SHA384))) {
+  if (Digest == NULL) {
     return RETURN_INVALID_PARAMETER;
   }
 
@@ -183,11 +569,6 @@ DoHashVerify (
     return RETURN_INVALID_PARAMETER;
   }
 
-  Status = CalculateHash (Data, Length, HashAlg, Digest);
-  if (EFI_ERROR(Status)) {
-    return RETURN_UNSUPPORTED;
-  }
-
   Status = RETURN_SECURITY_VIOLATION;
   if (Usage == 0) {
     // Compare hash with the buffer passed in
@@ -196,7 +577,7 @@ DoHashVerify (
     }
   } else {
     // Compare hash with the the one stored in hash store
-    Status2 = MatchHashInStore (Usage, HashAlg, Digest);
+    Status2 = MatchHashInStore (Usage, HashAlg, (UINT8 *)Digest);
     if (!EFI_ERROR(Status2)) {
       if (HashData != NULL) {
         CopyMem (HashData, Digest, DigestSize);
@@ -209,12 +590,6 @@ DoHashVerify (
   if (EFI_ERROR(Status)) {
     DEBUG_CODE_BEGIN();
 
-    DEBUG ((DEBUG_INFO, "First %d Bytes Input Data\n", DigestSize));
-    DumpHex (2, 0, DigestSize, (VOID *)Data);
-
-    DEBUG ((DEBUG_INFO, "Last %d Bytes Input Data\n", DigestSize));
-    DumpHex (2, 0, DigestSize, (VOID *) (Data + Length - DigestSize));
-
     DEBUG ((DEBUG_INFO, "Image Digest\n"));
     DumpHex (2, 0, DigestSize, (VOID *)Digest);
 
@@ -226,3 +601,71 @@ DoHashVerify (
 
   return Status;
 }
+
+/**
+  Verify data block hash with the built-in one.
+
+  @param[in]  Data           Data buffer pointer.
+  @param[in]  Length         Data buffer size.
+  @param[in]  Usage          Hash component usage.
+  @param[in]  HashAlg        Specify hash algorithm.
+  @param[in,out]  Hash       On input,  expected hash value when hash component usage is 0.
+                             On output, calculated hash value when verification succeeds.
+
+  @retval RETURN_SUCCESS             Hash verification succeeded.
+  @retval RETURN_INVALID_PARAMETER   Hash parameter is not valid.
+  @retval RETURN_NOT_FOUND           Hash data for hash component usage is not found.
+  @retval RETURN_UNSUPPORTED         HashAlg not supported.
+  @retval RETURN_SECURITY_VIOLATION  Hash verification failed.
+
+**/
+RETURN_STATUS
+EFIAPI
+DoHashVerify (
+  IN CONST UINT8           *Data,
+  IN       UINT32           Length,
+  IN       HASH_COMP_USAGE  Usage,
+  IN       UINT8            HashAlg,
+  IN OUT   UINT8           *HashData
+  )
+{
+  RETURN_STATUS        Status;
+  UINT8                Digest[HASH_DIGEST_MAX];
+  UINT8                DigestSize;
+
+
+  if ((Data == NULL) ||
+      ((HashAlg != HASH_TYPE_SHA256) && (HashAlg != HASH_TYPE_SHA384))) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if ((Usage == 0) && (HashData == NULL)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (HashAlg == HASH_TYPE_SHA256) {
+    DigestSize = SHA256_DIGEST_SIZE;
+  } else {
+    DigestSize = SHA384_DIGEST_SIZE;
+  }
+
+  Status = CalculateHash (Data, Length, HashAlg, Digest);
+  if (EFI_ERROR(Status)) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  Status = DoDigestVerify (Digest, Usage, HashAlg, HashData);
+  if (EFI_ERROR(Status)) {
+    DEBUG_CODE_BEGIN();
+
+    DEBUG ((DEBUG_INFO, "First %d Bytes Input Data\n", DigestSize));
+    DumpHex (2, 0, DigestSize, (VOID *)Data);
+
+    DEBUG ((DEBUG_INFO, "Last %d Bytes Input Data\n", DigestSize));
+    DumpHex (2, 0, DigestSize, (VOID *) (Data + Length - DigestSize));
+
+    DEBUG_CODE_END();
+  }
+
+  return Status;
+}
@@ -9,6 +9,7 @@
 #include <Library/BaseLib.h>
 #include <Library/IoLib.h>
 #include <Library/PlatformHookLib.h>
+#include <Library/SerialPortLib.h>
 
 //---------------------------------------------
 // UART Register Offsets
@@ -35,6 +36,14 @@
 #define LSR_RXDA                0x01
 #define DLAB                    0x01
 #define UART_MAGIC              0x55
+#define IIR_FIFO_ENABLED        0xC0
+#define IIR_FIFO64_ENABLED      0x20
+
+//---------------------------------------------
+// UART transmit FIFO depth
+//---------------------------------------------
+#define TX_FIFO_SIZE_16550      16
+#define TX_FIFO_SIZE_16750      64
 
 UINTN   gBps      = 115200;
 UINT8   gData     = 8;
@@ -103,6 +112,32 @@ SerialPortWriteRegister (
   return Value;
 }
 
+/**
+  Get the number of bytes that can be written after the transmitter is empty.
+
+  The FIFO state is read back from the UART every time, since the UART could
+  have been programmed by another stage, and this library has no writable
+  global data when it is executed in place.
+
+  @retval The transmit FIFO depth, or 1 if the FIFO is not enabled.
+
+**/
+STATIC
+UINTN
+GetTxFifoSize (
+  VOID
+  )
+{
+  UINT8    Iir;
+
+  Iir = SerialPortReadRegister (EIR_OFFSET);
+  if ((Iir & IIR_FIFO_ENABLED) != IIR_FIFO_ENABLED) {
+    return 1;
+  }
+
+  return ((Iir & IIR_FIFO64_ENABLED) != 0) ? TX_FIFO_SIZE_16750 : TX_FIFO_SIZE_16550;
+}
+
 /**
   Initialize the serial device hardware.
 
@@ -181,22 +216,31 @@ SerialPortWrite (
   )
 {
   UINTN  Result;
+  UINTN  FifoSize;
+  UINTN  Count;
   UINT8  Data;
 
   if (NULL == Buffer) {
     return 0;
   }
 
-  Result = NumberOfBytes;
+  Result   = NumberOfBytes;
+  FifoSize = GetTxFifoSize ();
 
-  while (NumberOfBytes--) {
+  while (NumberOfBytes > 0) {
     //
-    // Wait for the serail port to be ready.
+    // Wait for the serail port to be ready. With the FIFO enabled, TXRDY
+    // means the whole transmit FIFO is empty, so fill it up in one burst.
     //
     do {
       Data = SerialPortReadRegister (LSR_OFFSET);
     } while ((Data & LSR_TXRDY) == 0);
-    SerialPortWriteRegister (0, *Buffer++);
+
+    Count = MIN (NumberOfBytes, FifoSize);
+    NumberOfBytes -= Count;
+    while (Count-- > 0) {
+      SerialPortWriteRegister (0, *Buffer++);
+    }
   }
 
   return Result;
@@ -268,3 +312,33 @@ SerialPortPoll (
   return FALSE;
 }
 
+/**
+  Retrieve the status of the control bits on a serial device.
+
+  Only the input and output buffer states are reported. The output buffer is
+  empty when a write of up to the transmit FIFO depth does not wait.
+
+  @param Control                A pointer to return the current control signals from the serial device.
+
+  @retval RETURN_SUCCESS        The control bits were read from the serial device.
+
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortGetControl (
+  OUT UINT32 *Control
+  )
+{
+  UINT8    Lsr;
+
+  *Control = 0;
+  Lsr      = SerialPortReadRegister (LSR_OFFSET);
+  if ((Lsr & LSR_TXRDY) != 0) {
+    *Control |= EFI_SERIAL_OUTPUT_BUFFER_EMPTY;
+  }
+  if ((Lsr & LSR_RXDA) == 0) {
+    *Control |= EFI_SERIAL_INPUT_BUFFER_EMPTY;
+  }
+
+  return RETURN_SUCCESS;
+}
@@ -0,0 +1,243 @@
+/** @file
+  Shell command `mmcperf` to measure eMMC read throughput.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/ShellLib.h>
+#include <Library/MmcAccessLib.h>
+#include <Library/TimerLib.h>
+#include <Library/MemoryAllocationLib.h>
+#include <Library/BootloaderCommonLib.h>
+#include <Guid/OsBootOptionGuid.h>
+
+#define MMC_PERF_DEFAULT_SIZE_MB    16
+#define MMC_PERF_MAX_SIZE_MB        512
+#define MMC_PERF_BUFFER_SIZE        SIZE_1MB
+
+//
+// Request sizes used for each pass. Small requests show the per-transfer
+// setup overhead, large requests show the bus throughput.
+//
+STATIC CONST UINT32 mMmcPerfRequestSize[] = { SIZE_4KB, SIZE_64KB, SIZE_1MB };
+
+/**
+  Measure eMMC read throughput.
+
+  @param[in]  Shell        shell instance
+  @param[in]  Argc         number of command line arguments
+  @param[in]  Argv         command line arguments
+
+  @retval EFI_SUCCESS
+
+**/
+EFI_STATUS
+EFIAPI
+ShellCommandMmcPerfFunc (
+  IN SHELL  *Shell,
+  IN UINTN   Argc,
+  IN CHAR16 *Argv[]
+  );
+
+CONST SHELL_COMMAND ShellCommandMmcPerf = {
+  L"mmcperf",
+  L"Measure eMMC read throughput",
+  &ShellCommandMmcPerfFunc
+};
+
+/**
+  Read the given amount of data with fixed size requests and print the rate.
+
+  @param[in]  ModeName      name of the bus mode under test
+  @param[in]  Buffer        buffer of MMC_PERF_BUFFER_SIZE bytes to read into
+  @param[in]  BlockSize     device block size
+  @param[in]  TotalSize     total number of bytes to read
+  @param[in]  RequestSize   number of bytes per read request
+
+  @retval EFI_SUCCESS       The pass completed.
+  @retval Others            A read request failed.
+
+**/
+STATIC
+EFI_STATUS
+MmcPerfRunPass (
+  IN CONST CHAR16  *ModeName,
+  IN VOID          *Buffer,
+  IN UINT32         BlockSize,
+  IN UINT64         TotalSize,
+  IN UINT32         RequestSize
+  )
+{
+  EFI_STATUS        Status;
+  EFI_LBA           Lba;
+  UINT64            Offset;
+  UINT64            StartNs;
+  UINT64            ElapsedUs;
+  UINT64            Rate;
+  UINT32            RateFrac;
+
+  Lba     = 0;
+  Status  = EFI_SUCCESS;
+  StartNs = GetTimeInNanoSecond (GetPerformanceCounter ());
+  for (Offset = 0; Offset < TotalSize; Offset += RequestSize) {
+    Status = MmcReadBlocks (0, Lba, RequestSize, Buffer);
+    if (EFI_ERROR (Status)) {
+      ShellPrint (L"Read LBA 0x%lx failed - %r\n", Lba, Status);
+      return Status;
+    }
+    Lba += RequestSize / BlockSize;
+  }
+  ElapsedUs = DivU64x32 (GetTimeInNanoSecond (GetPerformanceCounter ()) - StartNs, 1000);
+  if (ElapsedUs == 0) {
+    ElapsedUs = 1;
+  }
+
+  //
+  // Rate in units of 0.1 MB/s
+  //
+  Rate = DivU64x64Remainder (MultU64x32 (TotalSize, 10 * 1000 * 1000), MultU64x32 (ElapsedUs, SIZE_1MB), NULL);
+  Rate = DivU64x32Remainder (Rate, 10, &RateFrac);
+  ShellPrint (L"  %-8s | %4d KB | %6d ms | %4d.%d MB/s\n",
+              ModeName, RequestSize / SIZE_1KB, (UINT32)DivU64x32 (ElapsedUs, 1000),
+              (UINT32)Rate, RateFrac);
+
+  return Status;
+}
+
+/**
+  Measure eMMC read throughput.
+
+  @param[in]  Shell        shell instance
+  @param[in]  Argc         number of command line arguments
+  @param[in]  Argv         command line arguments
+
+  @retval EFI_SUCCESS
+
+**/
+EFI_STATUS
+EFIAPI
+ShellCommandMmcPerfFunc (
+  IN SHELL  *Shell,
+  IN UINTN   Argc,
+  IN CHAR16 *Argv[]
+  )
+{
+  EFI_STATUS                Status;
+  UINTN                     EmmcHcPciBase;
+  DEVICE_BLOCK_INFO         BlockInfo;
+  EMMC_MODE                 Modes[2];
+  EMMC_MODE                 OrgMode;
+  CONST CHAR16              *ModeNames[2];
+  UINTN                     ModeCount;
+  UINTN                     ModeIdx;
+  BOOLEAN                   SwitchMode;
+  UINTN                     Index;
+  UINT64                    TotalSize;
+  UINTN                     SizeMb;
+  VOID                      *Buffer;
+
+  if (Argc > 3) {
+    goto usage;
+  }
+
+  ModeCount  = 0;
+  SwitchMode = (BOOLEAN)(Argc >= 2);
+  if ((Argc < 2) || (StrCmp (Argv[1], L"cur") == 0)) {
+    ModeNames[ModeCount++] = L"current";
+    SwitchMode             = FALSE;
+  } else if (StrCmp (Argv[1], L"hs200") == 0) {
+    Modes[ModeCount]       = Hs200;
+    ModeNames[ModeCount++] = L"HS200";
+  } else if (StrCmp (Argv[1], L"hs400") == 0) {
+    Modes[ModeCount]       = Hs400;
+    ModeNames[ModeCount++] = L"HS400";
+  } else if (StrCmp (Argv[1], L"all") == 0) {
+    Modes[ModeCount]       = Hs200;
+    ModeNames[ModeCount++] = L"HS200";
+    Modes[ModeCount]       = Hs400;
+    ModeNames[ModeCount++] = L"HS400";
+  } else {
+    goto usage;
+  }
+
+  SizeMb = MMC_PERF_DEFAULT_SIZE_MB;
+  if (Argc == 3) {
+    SizeMb = StrDecimalToUintn (Argv[2]);
+    if ((SizeMb == 0) || (SizeMb > MMC_PERF_MAX_SIZE_MB)) {
+      goto usage;
+    }
+  }
+
+  EmmcHcPciBase = TO_MM_PCI_ADDRESS (GetDeviceAddr (OsBootDeviceEmmc, 0));
+  if (EmmcHcPciBase == 0) {
+    ShellPrint (L"Invalid base address for Mmc device!\n");
+    return EFI_ABORTED;
+  }
+
+  Status = MmcInitialize (EmmcHcPciBase, DevInitAll);
+  if (!EFI_ERROR (Status)) {
+    Status = MmcGetMediaInfo (0, &BlockInfo);
+  }
+  if (EFI_ERROR (Status) || (BlockInfo.BlockSize == 0)) {
+    ShellPrint (L"MMC device is not ready - %r\n", Status);
+    return EFI_DEVICE_ERROR;
+  }
+
+  TotalSize = MultU64x32 (SizeMb, SIZE_1MB);
+  if (TotalSize > MultU64x32 (BlockInfo.BlockNum, BlockInfo.BlockSize)) {
+    ShellPrint (L"Test size exceeds the device size!\n");
+    return EFI_INVALID_PARAMETER;
+  }
+
+  //
+  // The original mode is restored after the test, so only switch from a
+  // mode that can be selected again.
+  //
+  if (SwitchMode) {
+    Status = EmmcGetModeSelection (&OrgMode);
+    if (EFI_ERROR (Status)) {
+      ShellPrint (L"Current bus mode can not be restored - %r\n", Status);
+      return EFI_UNSUPPORTED;
+    }
+  }
+
+  Buffer = AllocatePages (EFI_SIZE_TO_PAGES (MMC_PERF_BUFFER_SIZE));
+  if (Buffer == NULL) {
+    return EFI_OUT_OF_RESOURCES;
+  }
+
+  ShellPrint (L"Read %d MB from LBA 0\n", (UINT32)SizeMb);
+  ShellPrint (L"  Mode     | Request | Time      | Rate\n");
+  for (ModeIdx = 0; ModeIdx < ModeCount; ModeIdx++) {
+    if (SwitchMode) {
+      Status = EmmcModeSelection (Modes[ModeIdx]);
+      if (EFI_ERROR (Status)) {
+        ShellPrint (L"  %-8s | switch failed - %r\n", ModeNames[ModeIdx], Status);
+        continue;
+      }
+    }
+
+    for (Index = 0; Index < ARRAY_SIZE (mMmcPerfRequestSize); Index++) {
+      Status = MmcPerfRunPass (ModeNames[ModeIdx], Buffer, BlockInfo.BlockSize, TotalSize, mMmcPerfRequestSize[Index]);
+      if (EFI_ERROR (Status)) {
+        break;
+      }
+    }
+  }
+
+  if (SwitchMode) {
+    Status = EmmcModeSelection (OrgMode);
+    if (EFI_ERROR (Status)) {
+      ShellPrint (L"Restore bus mode failed - %r\n", Status);
+    }
+  }
+
+  FreePages (Buffer, EFI_SIZE_TO_PAGES (MMC_PERF_BUFFER_SIZE));
+  return EFI_SUCCESS;
+
+usage:
+  ShellPrint (L"Usage: %s [cur|hs200|hs400|all] [SizeInMB]\n", Argv[0]);
+  return EFI_ABORTED;
+}
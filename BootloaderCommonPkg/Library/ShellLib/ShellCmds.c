@@ -44,6 +44,7 @@ LoadShellCommands (
     ShellCommandRegister (Shell, &ShellCommandPerf);
     ShellCommandRegister (Shell, &ShellCommandBoot);
     ShellCommandRegister (Shell, &ShellCommandMmcDll);
+    ShellCommandRegister (Shell, &ShellCommandMmcPerf);
     ShellCommandRegister (Shell, &ShellCommandCdata);
     ShellCommandRegister (Shell, &ShellCommandDmesg);
     ShellCommandRegister (Shell, &ShellCommandReset);
@@ -18,6 +18,7 @@ extern CONST SHELL_COMMAND ShellCommandMmap;
 extern CONST SHELL_COMMAND ShellCommandPerf;
 extern CONST SHELL_COMMAND ShellCommandBoot;
 extern CONST SHELL_COMMAND ShellCommandMmcDll;
+extern CONST SHELL_COMMAND ShellCommandMmcPerf;
 extern CONST SHELL_COMMAND ShellCommandCdata;
 extern CONST SHELL_COMMAND ShellCommandDmesg;
 extern CONST SHELL_COMMAND ShellCommandCpuid;
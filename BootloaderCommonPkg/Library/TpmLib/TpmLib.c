@@ -618,6 +618,12 @@ IN  CONST  UINT8                     *Event
   TCG_PCR_EVENT2_HDR         PcrEventHdr;
   TPML_DIGEST_VALUES        *Digests;
   UINT32                     PcrBankActive;
+  UINT32                     BankMask;
+  UINT32                     Index;
+  UINT32                     Count;
+  HASH_ALG_TYPE              HashAlg[HASH_MULTI_MAX];
+  UINT8                      Digest[HASH_MULTI_MAX * HASH_DIGEST_MAX];
+  STATIC CONST UINT32        BankList[] = {HASH_ALG_SHA256, HASH_ALG_SHA384, HASH_ALG_SHA512, HASH_ALG_SM3_256};
 
   if (Data == NULL || Event == NULL) {
     return RETURN_INVALID_PARAMETER;
@@ -632,25 +638,24 @@ IN  CONST  UINT8                     *Event
 
   TpmLibGetActivePcrBanks(&PcrBankActive);
 
-  if ((PcrBankActive & HASH_ALG_SHA256) != 0) {
-      Digests->digests[Digests->count].hashAlg = (TPMI_ALG_HASH) GetTpmHashAlg(HASH_ALG_SHA256);
-      CalculateHash (Data, Length, GetCryptoHashAlg(HASH_ALG_SHA256) , (UINT8 *) (&(Digests->digests[Digests->count].digest)));
-      Digests->count++;
-  }
-  if ((PcrBankActive & HASH_ALG_SHA384) != 0) {
-      Digests->digests[Digests->count].hashAlg = (TPMI_ALG_HASH) GetTpmHashAlg(HASH_ALG_SHA384);
-      CalculateHash (Data, Length, GetCryptoHashAlg(HASH_ALG_SHA384) , (UINT8 *) (&(Digests->digests[Digests->count].digest)));
-      Digests->count++;
-  }
-  if ((PcrBankActive & HASH_ALG_SHA512) != 0) {
-      Digests->digests[Digests->count].hashAlg = (TPMI_ALG_HASH) GetTpmHashAlg(HASH_ALG_SHA512);
-      CalculateHash (Data, Length, GetCryptoHashAlg(HASH_ALG_SHA512) , (UINT8 *) (&(Digests->digests[Digests->count].digest)));
-      Digests->count++;
+  // Calculate the digests for all active banks in one pass over the data
+  Count = 0;
+  for (Index = 0; Index < ARRAY_SIZE (BankList); Index++) {
+    BankMask = BankList[Index];
+    if ((PcrBankActive & BankMask) != 0) {
+      Digests->digests[Count].hashAlg = (TPMI_ALG_HASH) GetTpmHashAlg(BankMask);
+      HashAlg[Count] = GetCryptoHashAlg(BankMask);
+      Count++;
+    }
   }
-  if ((PcrBankActive & HASH_ALG_SM3_256) != 0) {
-      Digests->digests[Digests->count].hashAlg = (TPMI_ALG_HASH) GetTpmHashAlg(HASH_ALG_SM3_256);
-      CalculateHash (Data, Length, GetCryptoHashAlg(HASH_ALG_SM3_256) , (UINT8 *) (&(Digests->digests[Digests->count].digest)));
-      Digests->count++;
+  Digests->count = Count;
+
+  if (Count > 0) {
+    ZeroMem (Digest, Count * HASH_DIGEST_MAX);
+    CalculateMultiHash (Data, Length, HashAlg, Count, Digest);
+    for (Index = 0; Index < Count; Index++) {
+      CopyMem (&Digests->digests[Index].digest, Digest + Index * HASH_DIGEST_MAX, sizeof (TPMU_HA));
+    }
   }
 
   Status = Tpm2PcrExtend (PcrHandle, Digests);
@@ -886,6 +886,52 @@ Done:
   return Status;
 }
 
+/**
+  Build a READ (10) or READ (16) SCSI Request Packet for a batched read.
+
+  @param[out] Packet               A pointer to the SCSI Request Packet to initialize.
+  @param[out] Cdb                  A pointer to a 16 byte buffer to receive the CDB.
+  @param[in]  UseRead16            Build a READ (16) command instead of READ (10).
+  @param[in]  StartLba             The start LBA.
+  @param[in]  SectorNum            The sector number to be read.
+  @param[in]  DataBuffer           A pointer to data buffer.
+  @param[in]  DataLength           The length of data to read in bytes.
+
+**/
+STATIC
+VOID
+UfsInitReadPacket (
+  OUT UFS_SCSI_REQUEST_PACKET      *Packet,
+  OUT UINT8                        *Cdb,
+  IN  BOOLEAN                      UseRead16,
+  IN  EFI_LBA                      StartLba,
+  IN  UINT32                       SectorNum,
+  IN  VOID                         *DataBuffer,
+  IN  UINT32                       DataLength
+  )
+{
+  ZeroMem (Packet, sizeof (UFS_SCSI_REQUEST_PACKET));
+  ZeroMem (Cdb, UFS_SCSI_OP_LENGTH_SIXTEEN);
+
+  if (UseRead16) {
+    Cdb[0] = EFI_SCSI_OP_READ16;
+    WriteUnaligned64 ((UINT64 *)&Cdb[2], SwapBytes64 (StartLba));
+    WriteUnaligned32 ((UINT32 *)&Cdb[10], SwapBytes32 (SectorNum));
+    Packet->CdbLength = UFS_SCSI_OP_LENGTH_SIXTEEN;
+  } else {
+    Cdb[0] = EFI_SCSI_OP_READ10;
+    WriteUnaligned32 ((UINT32 *)&Cdb[2], SwapBytes32 ((UINT32)StartLba));
+    WriteUnaligned16 ((UINT16 *)&Cdb[7], SwapBytes16 ((UINT16)SectorNum));
+    Packet->CdbLength = UFS_SCSI_OP_LENGTH_TEN;
+  }
+
+  Packet->Timeout          = UFS_TIMEOUT;
+  Packet->Cdb              = Cdb;
+  Packet->InDataBuffer     = DataBuffer;
+  Packet->InTransferLength = DataLength;
+  Packet->DataDirection    = UfsDataIn;
+}
+
 /**
   Reads the requested number of blocks from the specified block device.
 
@@ -927,11 +973,17 @@ UfsReadBlocksInternal (
 {
   EFI_STATUS                         Status;
   UINTN                              BlockSize;
-  UINTN                              NumberOfBlocks;
   UFS_PEIM_HC_PRIVATE_DATA           *Private;
   EFI_SCSI_SENSE_DATA                SenseData;
   UINT8                              SenseDataLength;
   BOOLEAN                            NeedRetry;
+  UFS_SCSI_REQUEST_PACKET            Packets[UFS_MAX_QUEUED_CMDS];
+  UINT8                              Cdbs[UFS_MAX_QUEUED_CMDS][UFS_SCSI_OP_LENGTH_SIXTEEN];
+  UINT32                             Length[UFS_MAX_QUEUED_CMDS];
+  UINTN                              QueueDepth;
+  UINTN                              Offset;
+  UINTN                              Count;
+  UINTN                              Index;
 
   Private = UfsGetPrivateData();
   if (Private == NULL) {
@@ -973,8 +1025,6 @@ UfsReadBlocksInternal (
     Status = EFI_INVALID_PARAMETER;
   }
 
-  NumberOfBlocks = BufferSize / BlockSize;
-
   do {
     Status = UfsTestUnitReady (
                Private,
@@ -997,30 +1047,41 @@ UfsReadBlocksInternal (
 
   } while (NeedRetry);
 
-  SenseDataLength = 0;
-  if (Private->Media[DeviceIndex].LastBlock < 0xfffffffful) {
-    Status = UfsRead10 (
-               Private,
-               DeviceIndex,
-               (UINT32)StartLBA,
-               (UINT32)NumberOfBlocks,
-               Buffer,
-               (UINT32 *)&BufferSize,
-               NULL,
-               &SenseDataLength
-               );
-  } else {
-    Status = UfsRead16 (
-               Private,
-               DeviceIndex,
-               (UINT32)StartLBA,
-               (UINT32)NumberOfBlocks,
-               Buffer,
-               (UINT32 *)&BufferSize,
-               NULL,
-               &SenseDataLength
-               );
+  //
+  // Split the read into READ commands and queue as many of them as the host
+  // controller has transfer request slots, so the link does not sit idle
+  // between commands.
+  //
+  QueueDepth = UfsGetQueueDepth (Private);
+  Offset     = 0;
+  while (Offset < BufferSize) {
+    for (Count = 0; (Count < QueueDepth) && (Offset < BufferSize); Count++) {
+      Length[Count] = (UINT32)MIN (BufferSize - Offset, UFS_MAX_READ_CMD_SIZE);
+      UfsInitReadPacket (
+        &Packets[Count],
+        Cdbs[Count],
+        Private->Media[DeviceIndex].LastBlock >= 0xfffffffful,
+        StartLBA,
+        Length[Count] / (UINT32)BlockSize,
+        (UINT8 *)Buffer + Offset,
+        Length[Count]
+        );
+      Offset   += Length[Count];
+      StartLBA += Length[Count] / BlockSize;
+    }
+
+    Status = UfsExecScsiCmdList (Private, (UINT8)DeviceIndex, Packets, Count);
+    if (EFI_ERROR (Status)) {
+      return Status;
+    }
+
+    for (Index = 0; Index < Count; Index++) {
+      if (Packets[Index].InTransferLength != Length[Index]) {
+        return EFI_DEVICE_ERROR;
+      }
+    }
   }
+
   return Status;
 }
 
@@ -1066,27 +1127,10 @@ UfsReadBlocks (
   )
 {
   EFI_STATUS                         Status;
-  UINT32                             ReadSize;
-  UINT32                             ReadBlockSize;
-  EFI_LBA                            LbaAddress;
-
-  Status     = EFI_SUCCESS;
-  ReadSize   = 0;
-  LbaAddress = StartLba;
-  while (ReadSize < BufferSize) {
-    if (ReadSize + SIZE_64KB > BufferSize) {
-      ReadBlockSize = (UINT32)BufferSize - ReadSize;
-    } else {
-      ReadBlockSize = SIZE_64KB;
-    }
 
-    Status = UfsReadBlocksInternal (DeviceIndex, LbaAddress, ReadBlockSize, (UINT8 *)Buffer + ReadSize);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_INFO, "    UfsReadBlocks_internal: Status = %r\n", Status));
-      break;
-    }
-    ReadSize   += ReadBlockSize;
-    LbaAddress += ReadBlockSize / SIZE_4KB;
+  Status = UfsReadBlocksInternal (DeviceIndex, StartLba, BufferSize, Buffer);
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "    UfsReadBlocks_internal: Status = %r\n", Status));
   }
 
   return Status;
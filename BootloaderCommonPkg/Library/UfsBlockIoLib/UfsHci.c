@@ -680,27 +680,45 @@ UfsFindAvailableSlotInTrl (
   ASSERT ((Private != NULL) && (Slot != NULL));
 
   //
-  // The simplest algo to always use slot 0.
-  // TODO: enhance it to support async transfer with multiple slot.
+  // Always start from slot 0. A batch of SCSI commands occupies the
+  // consecutive slots following it, see UfsExecScsiCmdList ().
   //
   *Slot = 0;
 
   return EFI_SUCCESS;
 }
 
+/**
+  Get the number of SCSI commands that can be queued in one batch.
+
+  @param[in]  Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+  @retval     The number of transfer request slots usable for one batch.
+
+**/
+UINTN
+UfsGetQueueDepth (
+  IN  UFS_PEIM_HC_PRIVATE_DATA     *Private
+  )
+{
+  return MIN (Private->Nutrs, UFS_MAX_QUEUED_CMDS);
+}
+
 
 
 /**
-  Start specified slot in transfer list of a UFS device.
+  Start the specified slots in transfer list of a UFS device with a single
+  doorbell write.
 
   @param[in]  Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
-  @param[in]  Slot          The slot to be started.
+  @param[in]  SlotMask      The bit mask of the slots to be started.
 
 **/
+STATIC
 VOID
-UfsStartExecCmd (
+UfsStartExecCmdList (
   IN  UFS_PEIM_HC_PRIVATE_DATA     *Private,
-  IN  UINT8                        Slot
+  IN  UINT32                       SlotMask
   )
 {
   UINTN         UfsHcBase;
@@ -716,20 +734,21 @@ UfsStartExecCmd (
   }
 
   Address = UfsHcBase + UFS_HC_UTRLDBR_OFFSET;
-  MmioWrite32 (Address, BIT0 << Slot);
+  MmioWrite32 (Address, SlotMask);
 }
 
 /**
-  Stop specified slot in transfer list of a UFS device.
+  Stop the specified slots in transfer list of a UFS device.
 
   @param[in]  Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
-  @param[in]  Slot          The slot to be stop.
+  @param[in]  SlotMask      The bit mask of the slots to be stopped.
 
 **/
+STATIC
 VOID
-UfsStopExecCmd (
+UfsStopExecCmdList (
   IN  UFS_PEIM_HC_PRIVATE_DATA     *Private,
-  IN  UINT8                        Slot
+  IN  UINT32                       SlotMask
   )
 {
   UINTN         UfsHcBase;
@@ -740,13 +759,45 @@ UfsStopExecCmd (
 
   Address = UfsHcBase + UFS_HC_UTRLDBR_OFFSET;
   Data    = MmioRead32 (Address);
-  if ((Data & (BIT0 << Slot)) != 0) {
+  if ((Data & SlotMask) != 0) {
     Address = UfsHcBase + UFS_HC_UTRLCLR_OFFSET;
     Data    = MmioRead32 (Address);
-    MmioWrite32 (Address, (Data & ~ (BIT0 << Slot)));
+    MmioWrite32 (Address, (Data & ~SlotMask));
   }
 }
 
+/**
+  Start specified slot in transfer list of a UFS device.
+
+  @param[in]  Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]  Slot          The slot to be started.
+
+**/
+VOID
+UfsStartExecCmd (
+  IN  UFS_PEIM_HC_PRIVATE_DATA     *Private,
+  IN  UINT8                        Slot
+  )
+{
+  UfsStartExecCmdList (Private, BIT0 << Slot);
+}
+
+/**
+  Stop specified slot in transfer list of a UFS device.
+
+  @param[in]  Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]  Slot          The slot to be stop.
+
+**/
+VOID
+UfsStopExecCmd (
+  IN  UFS_PEIM_HC_PRIVATE_DATA     *Private,
+  IN  UINT8                        Slot
+  )
+{
+  UfsStopExecCmdList (Private, BIT0 << Slot);
+}
+
 /**
   Read or write specified device descriptor of a UFS device.
 
@@ -1095,135 +1146,231 @@ Exit:
 }
 
 /**
-  Sends a UFS-supported SCSI Request Packet to a UFS device that is attached to the UFS host controller.
+  Check the response of a completed SCSI command and update the SCSI Request Packet.
+
+  @param[in]      Trd           The pointer to the UTP Transfer Request Descriptor.
+  @param[in]      CmdDescBase   The base address of the command descriptor.
+  @param[in, out] Packet        A pointer to the SCSI Request Packet.
+
+  @retval EFI_SUCCESS           The SCSI command completed successfully.
+  @retval EFI_DEVICE_ERROR      A device error occurred while executing the SCSI command.
+
+**/
+STATIC
+EFI_STATUS
+UfsCheckScsiCmdResult (
+  IN     UTP_TRD                       *Trd,
+  IN     UINT8                         *CmdDescBase,
+  IN OUT UFS_SCSI_REQUEST_PACKET       *Packet
+  )
+{
+  UTP_RESPONSE_UPIU                    *Response;
+  UINT16                               SenseDataLen;
+  UINT32                               ResTranCount;
+
+  //
+  // Get sense data if exists
+  //
+  Response     = (UTP_RESPONSE_UPIU *) (CmdDescBase + Trd->RuO * sizeof (UINT32));
+  SenseDataLen = Response->SenseDataLen;
+  SwapLittleEndianToBigEndian ((UINT8 *)&SenseDataLen, sizeof (UINT16));
+
+  if ((Packet->SenseDataLength != 0) && (Packet->SenseData != NULL)) {
+    //
+    // Make sure the hardware device does not return more data than expected.
+    //
+    if (SenseDataLen <= Packet->SenseDataLength) {
+      CopyMem (Packet->SenseData, Response->SenseData, SenseDataLen);
+      Packet->SenseDataLength = (UINT8)SenseDataLen;
+    } else {
+      Packet->SenseDataLength = 0;
+    }
+  }
+
+  //
+  // Check the transfer request result.
+  //
+  if (Response->Response != 0) {
+    DEBUG ((DEBUG_ERROR, "UfsExecScsiCmds() fails with Target Failure\n"));
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (Trd->Ocs != 0) {
+    return EFI_DEVICE_ERROR;
+  }
+
+  if (Packet->DataDirection == UfsDataIn) {
+    if ((Response->Flags & BIT5) == BIT5) {
+      ResTranCount = Response->ResTranCount;
+      SwapLittleEndianToBigEndian ((UINT8 *)&ResTranCount, sizeof (UINT32));
+      Packet->InTransferLength -= ResTranCount;
+    }
+  } else if (Packet->DataDirection == UfsDataOut) {
+    if ((Response->Flags & BIT5) == BIT5) {
+      ResTranCount = Response->ResTranCount;
+      SwapLittleEndianToBigEndian ((UINT8 *)&ResTranCount, sizeof (UINT32));
+      Packet->OutTransferLength -= ResTranCount;
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Sends a list of UFS-supported SCSI Request Packets to a UFS device that is attached
+  to the UFS host controller.
+
+  Each packet is placed into its own transfer request slot with its own command
+  descriptor and PRDT. All slots are started with a single doorbell write and the
+  doorbell register is then polled once for the whole batch.
 
   @param[in]      Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
-  @param[in]      Lun           The LUN of the UFS device to send the SCSI Request Packet.
-  @param[in, out] Packet        A pointer to the SCSI Request Packet to send to a specified Lun of the
+  @param[in]      Lun           The LUN of the UFS device to send the SCSI Request Packets.
+  @param[in, out] Packets       An array of SCSI Request Packets to send to a specified Lun of the
                                 UFS device.
+  @param[in]      Count         The number of packets in the array. It must not exceed the number
+                                of transfer request slots supported by the host controller.
 
-  @retval EFI_SUCCESS           The SCSI Request Packet was sent by the host. For bi-directional
-                                commands, InTransferLength bytes were transferred from
-                                InDataBuffer. For write and bi-directional commands,
-                                OutTransferLength bytes were transferred by
-                                OutDataBuffer.
-  @retval EFI_DEVICE_ERROR      A device error occurred while attempting to send the SCSI Request
-                                Packet.
+  @retval EFI_SUCCESS           All SCSI Request Packets were executed successfully.
+  @retval EFI_INVALID_PARAMETER Count is zero or exceeds the number of transfer request slots.
+  @retval EFI_DEVICE_ERROR      A device error occurred while attempting to send SCSI Request
+                                Packets.
   @retval EFI_OUT_OF_RESOURCES  The resource for transfer is not available.
-  @retval EFI_TIMEOUT           A timeout occurred while waiting for the SCSI Request Packet to execute.
+  @retval EFI_TIMEOUT           A timeout occurred while waiting for the SCSI Request Packets to execute.
 
 **/
 EFI_STATUS
 EFIAPI
-UfsExecScsiCmds (
+UfsExecScsiCmdList (
   IN     UFS_PEIM_HC_PRIVATE_DATA      *Private,
   IN     UINT8                         Lun,
-  IN OUT UFS_SCSI_REQUEST_PACKET       *Packet
+  IN OUT UFS_SCSI_REQUEST_PACKET       *Packets,
+  IN     UINTN                         Count
   )
 {
   EFI_STATUS                           Status;
+  EFI_STATUS                           CmdStatus;
   UINT8                                Slot;
   UTP_TRD                              *Trd;
   UINTN                                Address;
-  UINT8                                *CmdDescBase;
-  UINT32                               CmdDescSize;
-  UTP_RESPONSE_UPIU                    *Response;
-  UINT16                               SenseDataLen;
-  UINT32                               ResTranCount;
-  VOID                                 *PacketBufferMap;
+  UINTN                                Index;
+  UINTN                                Created;
+  UINT32                               SlotMask;
+  UINT64                               Timeout;
+  UINT8                                *CmdDescBase[UFS_MAX_QUEUED_CMDS];
+  UINT32                               CmdDescSize[UFS_MAX_QUEUED_CMDS];
+  VOID                                 *PacketBufferMap[UFS_MAX_QUEUED_CMDS];
+
+  if ((Count == 0) || (Count > UfsGetQueueDepth (Private))) {
+    return EFI_INVALID_PARAMETER;
+  }
 
   //
-  // Find out which slot of transfer request list is available.
+  // Find out the first available slot of transfer request list.
   //
   Status = UfsFindAvailableSlotInTrl (Private, &Slot);
   if (EFI_ERROR (Status)) {
     return Status;
   }
 
-  Trd = ((UTP_TRD *)Private->UtpTrlBase) + Slot;
-  PacketBufferMap = NULL;
-
   //
-  // Fill transfer request descriptor to this slot.
+  // Fill one transfer request descriptor per packet.
   //
-  Status = UfsCreateScsiCommandDesc (Private, Lun, Packet, Trd, &PacketBufferMap);
-  if (EFI_ERROR (Status)) {
-    return Status;
-  }
+  SlotMask = 0;
+  Timeout  = 0;
+  for (Created = 0; Created < Count; Created++) {
+    Trd = ((UTP_TRD *)Private->UtpTrlBase) + Slot + Created;
+    PacketBufferMap[Created] = NULL;
+    Status = UfsCreateScsiCommandDesc (Private, Lun, &Packets[Created], Trd, &PacketBufferMap[Created]);
+    if (EFI_ERROR (Status)) {
+      if (PacketBufferMap[Created] != NULL) {
+        IoMmuUnmap (PacketBufferMap[Created]);
+      }
+      goto Exit;
+    }
 
-  CmdDescBase = (UINT8 *) (UINTN) (LShiftU64 ((UINT64)Trd->UcdBaU, 32) | LShiftU64 ((UINT64)Trd->UcdBa, 7));
-  CmdDescSize = Trd->PrdtO * sizeof (UINT32) + Trd->PrdtL * sizeof (UTP_TR_PRD);
+    CmdDescBase[Created] = (UINT8 *) (UINTN) (LShiftU64 ((UINT64)Trd->UcdBaU, 32) | LShiftU64 ((UINT64)Trd->UcdBa, 7));
+    CmdDescSize[Created] = Trd->PrdtO * sizeof (UINT32) + Trd->PrdtL * sizeof (UTP_TR_PRD);
+    SlotMask |= BIT0 << (Slot + Created);
+
+    //
+    // Wait for the longest timeout of the batch. A zero timeout means waiting
+    // indefinitely, so it wins over any other value.
+    //
+    if (Created == 0) {
+      Timeout = Packets[Created].Timeout;
+    } else if ((Timeout != 0) && ((Packets[Created].Timeout == 0) || (Packets[Created].Timeout > Timeout))) {
+      Timeout = Packets[Created].Timeout;
+    }
+  }
 
   //
-  // Start to execute the transfer request.
+  // Start to execute all transfer requests at once.
   //
-  UfsStartExecCmd (Private, Slot);
+  UfsStartExecCmdList (Private, SlotMask);
 
   //
-  // Wait for the completion of the transfer request.
+  // Wait for the completion of all transfer requests.
   //
   Address = Private->UfsHcBase + UFS_HC_UTRLDBR_OFFSET;
-  Status = UfsWaitMemSet (Address, BIT0 << Slot, 0, Packet->Timeout);
+  Status = UfsWaitMemSet (Address, SlotMask, 0, Timeout);
   if (EFI_ERROR (Status)) {
     goto Exit;
   }
 
-  //
-  // Get sense data if exists
-  //
-  Response     = (UTP_RESPONSE_UPIU *) (CmdDescBase + Trd->RuO * sizeof (UINT32));
-  SenseDataLen = Response->SenseDataLen;
-  SwapLittleEndianToBigEndian ((UINT8 *)&SenseDataLen, sizeof (UINT16));
-
-  if ((Packet->SenseDataLength != 0) && (Packet->SenseData != NULL)) {
-    //
-    // Make sure the hardware device does not return more data than expected.
-    //
-    if (SenseDataLen <= Packet->SenseDataLength) {
-      CopyMem (Packet->SenseData, Response->SenseData, SenseDataLen);
-      Packet->SenseDataLength = (UINT8)SenseDataLen;
-    } else {
-      Packet->SenseDataLength = 0;
+  for (Index = 0; Index < Count; Index++) {
+    Trd = ((UTP_TRD *)Private->UtpTrlBase) + Slot + Index;
+    CmdStatus = UfsCheckScsiCmdResult (Trd, CmdDescBase[Index], &Packets[Index]);
+    if (EFI_ERROR (CmdStatus) && !EFI_ERROR (Status)) {
+      Status = CmdStatus;
     }
   }
 
-  //
-  // Check the transfer request result.
-  //
-  if (Response->Response != 0) {
-    DEBUG ((DEBUG_ERROR, "UfsExecScsiCmds() fails with Target Failure\n"));
-    Status = EFI_DEVICE_ERROR;
-    goto Exit;
+Exit:
+  if (SlotMask != 0) {
+    UfsStopExecCmdList (Private, SlotMask);
   }
 
-  if (Trd->Ocs == 0) {
-    if (Packet->DataDirection == UfsDataIn) {
-      if ((Response->Flags & BIT5) == BIT5) {
-        ResTranCount = Response->ResTranCount;
-        SwapLittleEndianToBigEndian ((UINT8 *)&ResTranCount, sizeof (UINT32));
-        Packet->InTransferLength -= ResTranCount;
-      }
-    } else if (Packet->DataDirection == UfsDataOut) {
-      if ((Response->Flags & BIT5) == BIT5) {
-        ResTranCount = Response->ResTranCount;
-        SwapLittleEndianToBigEndian ((UINT8 *)&ResTranCount, sizeof (UINT32));
-        Packet->OutTransferLength -= ResTranCount;
-      }
+  for (Index = 0; Index < Created; Index++) {
+    if (PacketBufferMap[Index] != NULL) {
+      IoMmuUnmap (PacketBufferMap[Index]);
     }
-  } else {
-    Status = EFI_DEVICE_ERROR;
-  }
-
-Exit:
-  if (PacketBufferMap != NULL) {
-    IoMmuUnmap (PacketBufferMap);
+    UfsFreeMem (Private->Pool, CmdDescBase[Index], CmdDescSize[Index]);
   }
-  UfsStopExecCmd (Private, Slot);
-  UfsFreeMem (Private->Pool, CmdDescBase, CmdDescSize);
 
   return Status;
 }
 
+/**
+  Sends a UFS-supported SCSI Request Packet to a UFS device that is attached to the UFS host controller.
+
+  @param[in]      Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]      Lun           The LUN of the UFS device to send the SCSI Request Packet.
+  @param[in, out] Packet        A pointer to the SCSI Request Packet to send to a specified Lun of the
+                                UFS device.
+
+  @retval EFI_SUCCESS           The SCSI Request Packet was sent by the host. For bi-directional
+                                commands, InTransferLength bytes were transferred from
+                                InDataBuffer. For write and bi-directional commands,
+                                OutTransferLength bytes were transferred by
+                                OutDataBuffer.
+  @retval EFI_DEVICE_ERROR      A device error occurred while attempting to send the SCSI Request
+                                Packet.
+  @retval EFI_OUT_OF_RESOURCES  The resource for transfer is not available.
+  @retval EFI_TIMEOUT           A timeout occurred while waiting for the SCSI Request Packet to execute.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsExecScsiCmds (
+  IN     UFS_PEIM_HC_PRIVATE_DATA      *Private,
+  IN     UINT8                         Lun,
+  IN OUT UFS_SCSI_REQUEST_PACKET       *Packet
+  )
+{
+  return UfsExecScsiCmdList (Private, Lun, Packet, 1);
+}
+
 
 /**
   Sent UIC DME_LINKSTARTUP command to start the link startup procedure.
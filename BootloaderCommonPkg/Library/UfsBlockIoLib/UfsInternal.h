@@ -148,6 +148,17 @@ typedef struct _UFS_PEIM_HC_PRIVATE_DATA {
 
 #define UFS_TIMEOUT                 MultU64x32((UINT64)(3), 1000000)
 
+//
+// Maximum number of SCSI commands queued in one batch, limited by the
+// 32 UTP transfer request slots defined by UFSHCI.
+//
+#define UFS_MAX_QUEUED_CMDS         32
+
+//
+// Maximum transfer size of a single READ command in a batch
+//
+#define UFS_MAX_READ_CMD_SIZE       SIZE_64KB
+
 #define ROUNDUP8(x) (((x) % 8 == 0) ? (x) : ((x) / 8 + 1) * 8)
 
 #define IS_ALIGNED(addr, size)      (((UINTN) (addr) & (size - 1)) == 0)
@@ -197,6 +208,51 @@ UfsExecScsiCmds (
   IN OUT UFS_SCSI_REQUEST_PACKET       *Packet
   );
 
+/**
+  Sends a list of UFS-supported SCSI Request Packets to a UFS device that is attached
+  to the UFS host controller.
+
+  Each packet is placed into its own transfer request slot with its own command
+  descriptor and PRDT. All slots are started with a single doorbell write and the
+  doorbell register is then polled once for the whole batch.
+
+  @param[in]      Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+  @param[in]      Lun           The LUN of the UFS device to send the SCSI Request Packets.
+  @param[in, out] Packets       An array of SCSI Request Packets to send to a specified Lun of the
+                                UFS device.
+  @param[in]      Count         The number of packets in the array. It must not exceed the number
+                                of transfer request slots supported by the host controller.
+
+  @retval EFI_SUCCESS           All SCSI Request Packets were executed successfully.
+  @retval EFI_INVALID_PARAMETER Count is zero or exceeds the number of transfer request slots.
+  @retval EFI_DEVICE_ERROR      A device error occurred while attempting to send SCSI Request
+                                Packets.
+  @retval EFI_OUT_OF_RESOURCES  The resource for transfer is not available.
+  @retval EFI_TIMEOUT           A timeout occurred while waiting for the SCSI Request Packets to execute.
+
+**/
+EFI_STATUS
+EFIAPI
+UfsExecScsiCmdList (
+  IN     UFS_PEIM_HC_PRIVATE_DATA      *Private,
+  IN     UINT8                         Lun,
+  IN OUT UFS_SCSI_REQUEST_PACKET       *Packets,
+  IN     UINTN                         Count
+  );
+
+/**
+  Get the number of SCSI commands that can be queued in one batch.
+
+  @param[in]  Private       The pointer to the UFS_PEIM_HC_PRIVATE_DATA data structure.
+
+  @retval     The number of transfer request slots usable for one batch.
+
+**/
+UINTN
+UfsGetQueueDepth (
+  IN  UFS_PEIM_HC_PRIVATE_DATA     *Private
+  );
+
 /**
   Initialize the UFS host controller.
 
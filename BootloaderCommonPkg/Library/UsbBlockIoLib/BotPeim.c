@@ -179,57 +179,33 @@ BotDataPhase (
   EFI_STATUS      Status;
   PEI_USB_IO_PPI  *UsbIoPpi;
   UINT8           EndpointAddr;
-  UINTN           Remain;
-  UINTN           Increment;
-  UINT32          MaxPacketLen;
-  UINT8           *BufferPtr;
   UINTN           TransferredSize;
 
   UsbIoPpi        = PeiBotDev->UsbIoPpi;
 
-  Remain          = *DataSize;
-  BufferPtr       = (UINT8 *) DataBuffer;
-  TransferredSize = 0;
-
-  //
-  // retrieve the the max packet length of the given endpoint
-  //
   if (Direction == EfiUsbDataIn) {
-    MaxPacketLen  = (PeiBotDev->BulkInEndpoint)->MaxPacketSize;
     EndpointAddr  = (PeiBotDev->BulkInEndpoint)->EndpointAddress;
   } else {
-    MaxPacketLen  = (PeiBotDev->BulkOutEndpoint)->MaxPacketSize;
     EndpointAddr  = (PeiBotDev->BulkOutEndpoint)->EndpointAddress;
   }
 
-  while (Remain > 0) {
-    //
-    // Using 15 packets to avoid Bitstuff error
-    //
-    if (Remain > 16 * MaxPacketLen) {
-      Increment = 16 * MaxPacketLen;
-    } else {
-      Increment = Remain;
-    }
-
-    Status = UsbIoPpi->UsbBulkTransfer (
-               PeiServices,
-               UsbIoPpi,
-               EndpointAddr,
-               BufferPtr,
-               &Increment,
-               Timeout
-               );
-
-    TransferredSize += Increment;
-
-    if (EFI_ERROR (Status)) {
-      PeiUsbClearEndpointHalt (PeiServices, UsbIoPpi, EndpointAddr);
-      return Status;
-    }
-
-    BufferPtr += Increment;
-    Remain -= Increment;
+  //
+  // Move the whole data stage with one bulk transfer. The XHCI host
+  // controller queues it as a chained TD, so there is no need to break
+  // it into a transfer per few packets.
+  //
+  TransferredSize = *DataSize;
+  Status = UsbIoPpi->UsbBulkTransfer (
+             PeiServices,
+             UsbIoPpi,
+             EndpointAddr,
+             DataBuffer,
+             &TransferredSize,
+             Timeout
+             );
+  if (EFI_ERROR (Status)) {
+    PeiUsbClearEndpointHalt (PeiServices, UsbIoPpi, EndpointAddr);
+    return Status;
   }
 
   *DataSize = (UINT32) TransferredSize;
@@ -58,6 +58,13 @@ typedef struct {
 #define CSWSIG  0x53425355
 #define CBWSIG  0x43425355
 
+//
+// Largest Read(10) request. Many USB 2.0 sticks fail requests above 240
+// sectors, SuperSpeed devices are fine with 1MB.
+//
+#define USB_BOT_MAX_READ_SIZE     (240 * 512)
+#define USB_BOT_MAX_READ_SIZE_SS  SIZE_1MB
+
 /**
   Sends out ATAPI Inquiry Packet Command to the specified device. This command will
   return INQUIRY data of the device.
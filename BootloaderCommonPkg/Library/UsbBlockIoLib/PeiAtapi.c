@@ -370,7 +370,7 @@ PeiUsbRead10 (
 {
   ATAPI_PACKET_COMMAND  Packet;
   ATAPI_READ10_CMD      *Read10Packet;
-  UINT16                MaxBlock;
+  UINT32                MaxBlock;
   UINT32                BlocksRemaining;
   UINT16                SectorCount;
   UINT32                Lba32;
@@ -390,7 +390,15 @@ PeiUsbRead10 (
 
   BlockSize       = (UINT32) PeiBotDevice->Media.BlockSize;
 
-  MaxBlock        = (UINT16) (65535 / BlockSize);
+  //
+  // A SuperSpeed bulk endpoint has a max packet size of 1024 bytes.
+  //
+  if (PeiBotDevice->BulkInEndpoint->MaxPacketSize >= 1024) {
+    MaxBlock      = USB_BOT_MAX_READ_SIZE_SS / BlockSize;
+  } else {
+    MaxBlock      = USB_BOT_MAX_READ_SIZE / BlockSize;
+  }
+  MaxBlock        = MAX (MIN (MaxBlock, MAX_UINT16), 1);
   BlocksRemaining = (UINT32) NumberOfBlocks;
 
   Status          = EFI_SUCCESS;
@@ -402,7 +410,7 @@ PeiUsbRead10 (
 
     } else {
 
-      SectorCount = MaxBlock;
+      SectorCount = (UINT16) MaxBlock;
     }
     //
     // fill the Packet data structure
@@ -427,7 +435,7 @@ PeiUsbRead10 (
 
     ByteCount               = SectorCount * BlockSize;
 
-    TimeOut                 = (UINT16) (SectorCount * 2000);
+    TimeOut                 = (UINT16) MIN ((UINT32) SectorCount * 2000, MAX_UINT16);
 
     //
     // send command packet
@@ -891,6 +891,9 @@ XhcPeiBulkTransfer (
   EFI_STATUS                    Status;
   EFI_STATUS                    RecoveryStatus;
   BOOLEAN                       IsInterruptTransfer;
+  UINTN                         Length;
+  UINTN                         Completed;
+  UINTN                         UrbCompleted;
 
   //
   // Validate the parameters
@@ -943,55 +946,88 @@ XhcPeiBulkTransfer (
   }
 
   //
-  // Create a new URB, insert it into the asynchronous
-  // schedule list, then poll the execution status.
+  // A bulk transfer reuses the URB of the XHCI device and is queued as one
+  // chained TD, or as a few of them when it is larger than a TD may be.
+  // An interrupt transfer gets a new URB.
   //
-  Urb = XhcPeiCreateUrb (
-          Xhc,
-          DeviceAddress,
-          EndPointAddress,
-          DeviceSpeed,
-          MaximumPacketLength,
-          IsInterruptTransfer ? XHC_INT_TRANSFER_SYNC : XHC_BULK_TRANSFER,
-          NULL,
-          Data[0],
-          *DataLength,
-          NULL,
-          NULL
-          );
+  Completed = 0;
+  do {
+    if (IsInterruptTransfer) {
+      Length = *DataLength;
+      Urb = XhcPeiCreateUrb (
+              Xhc,
+              DeviceAddress,
+              EndPointAddress,
+              DeviceSpeed,
+              MaximumPacketLength,
+              XHC_INT_TRANSFER_SYNC,
+              NULL,
+              Data[0],
+              Length,
+              NULL,
+              NULL
+              );
+    } else {
+      Length = MIN (*DataLength - Completed, XHC_MAX_BULK_TD_SIZE);
+      Urb = XhcPeiInitUrb (
+              Xhc,
+              &Xhc->BulkUrb,
+              DeviceAddress,
+              EndPointAddress,
+              DeviceSpeed,
+              MaximumPacketLength,
+              XHC_BULK_TRANSFER,
+              NULL,
+              (UINT8 *) Data[0] + Completed,
+              Length,
+              NULL,
+              NULL
+              );
+    }
 
-  if (Urb == NULL) {
-    DEBUG ((DEBUG_ERROR, "XhcPeiBulkTransfer: failed to create URB\n"));
-    Status = EFI_OUT_OF_RESOURCES;
-    goto ON_EXIT;
-  }
+    if (Urb == NULL) {
+      DEBUG ((DEBUG_ERROR, "XhcPeiBulkTransfer: failed to create URB\n"));
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
+    }
 
-  Status = XhcPeiExecTransfer (Xhc, FALSE, Urb, TimeOut);
+    Status = XhcPeiExecTransfer (Xhc, FALSE, Urb, TimeOut);
 
-  *TransferResult = Urb->Result;
-  *DataLength     = Urb->Completed;
+    *TransferResult = Urb->Result;
+    UrbCompleted    = Urb->Completed;
+    Completed      += UrbCompleted;
+
+    if (Status == EFI_TIMEOUT) {
+      //
+      // The transfer timed out. Abort the transfer by dequeueing of the TD.
+      //
+      RecoveryStatus = XhcPeiDequeueTrbFromEndpoint(Xhc, Urb);
+      if (EFI_ERROR(RecoveryStatus)) {
+        DEBUG((DEBUG_ERROR, "XhcPeiBulkTransfer: XhcPeiDequeueTrbFromEndpoint failed\n"));
+      }
+    } else {
+      if (*TransferResult == EFI_USB_NOERROR) {
+        Status = EFI_SUCCESS;
+      } else if ((*TransferResult == EFI_USB_ERR_STALL) || (*TransferResult == EFI_USB_ERR_BABBLE)) {
+        RecoveryStatus = XhcPeiRecoverHaltedEndpoint(Xhc, Urb);
+        if (EFI_ERROR (RecoveryStatus)) {
+          DEBUG ((DEBUG_ERROR, "XhcPeiBulkTransfer: XhcPeiRecoverHaltedEndpoint failed\n"));
+        }
+        Status = EFI_DEVICE_ERROR;
+      }
+    }
+
+    XhcPeiFreeUrb (Xhc, Urb);
 
-  if (Status == EFI_TIMEOUT) {
     //
-    // The transfer timed out. Abort the transfer by dequeueing of the TD.
+    // Stop on an error or on a short TD.
     //
-    RecoveryStatus = XhcPeiDequeueTrbFromEndpoint(Xhc, Urb);
-    if (EFI_ERROR(RecoveryStatus)) {
-      DEBUG((DEBUG_ERROR, "XhcPeiBulkTransfer: XhcPeiDequeueTrbFromEndpoint failed\n"));
-    }
-  } else {
-    if (*TransferResult == EFI_USB_NOERROR) {
-      Status = EFI_SUCCESS;
-    } else if ((*TransferResult == EFI_USB_ERR_STALL) || (*TransferResult == EFI_USB_ERR_BABBLE)) {
-      RecoveryStatus = XhcPeiRecoverHaltedEndpoint(Xhc, Urb);
-      if (EFI_ERROR (RecoveryStatus)) {
-        DEBUG ((DEBUG_ERROR, "XhcPeiBulkTransfer: XhcPeiRecoverHaltedEndpoint failed\n"));
-      }
-      Status = EFI_DEVICE_ERROR;
+    if (EFI_ERROR (Status) || (UrbCompleted != Length)) {
+      break;
     }
-  }
+  } while (Completed < *DataLength);
 
-  XhcPeiFreeUrb (Xhc, Urb);
+  *DataLength = Completed;
 
 ON_EXIT:
 
@@ -179,6 +179,10 @@ struct _PEI_XHC_DEV {
   // EventRing
   //
   EVENT_RING                        EventRing;
+  //
+  // URB reused by all the bulk transfers, as they are synchronous
+  //
+  URB                               BulkUrb;
 
   //
   // Store device contexts managed by XHCI device
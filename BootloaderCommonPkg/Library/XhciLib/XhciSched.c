@@ -123,12 +123,13 @@ ON_EXIT:
   @param  Callback  The function to call when data is transferred
   @param  Context   The context to the callback
 
-  @return Created URB or NULL
+  @return The initialized URB or NULL
 
 **/
 URB*
-XhcPeiCreateUrb (
+XhcPeiInitUrb (
   IN PEI_XHC_DEV                        *Xhc,
+  IN URB                                *Urb,
   IN UINT8                              BusAddr,
   IN UINT8                              EpAddr,
   IN UINT8                              DevSpeed,
@@ -143,13 +144,8 @@ XhcPeiCreateUrb (
 {
   USB_ENDPOINT      *Ep;
   EFI_STATUS        Status;
-  URB               *Urb;
-
-  Urb = AllocateZeroPool (sizeof (URB));
-  if (Urb == NULL) {
-    return NULL;
-  }
 
+  ZeroMem (Urb, sizeof (URB));
   Urb->Signature = XHC_URB_SIG;
 
   Ep            = &Urb->Ep;
@@ -168,7 +164,55 @@ XhcPeiCreateUrb (
 
   Status = XhcPeiCreateTransferTrb (Xhc, Urb);
   if (EFI_ERROR (Status)) {
-    DEBUG ((DEBUG_ERROR, "XhcPeiCreateUrb: XhcPeiCreateTransferTrb Failed, Status = %r\n", Status));
+    DEBUG ((DEBUG_ERROR, "XhcPeiInitUrb: XhcPeiCreateTransferTrb Failed, Status = %r\n", Status));
+    return NULL;
+  }
+
+  return Urb;
+}
+
+/**
+  Create a new URB for a new transaction.
+
+  @param  Xhc       The XHCI device
+  @param  BusAddr   The logical device address assigned by UsbBus driver
+  @param  EpAddr    Endpoint addrress
+  @param  DevSpeed  The device speed
+  @param  MaxPacket The max packet length of the endpoint
+  @param  Type      The transaction type
+  @param  Request   The standard USB request for control transfer
+  @param  Data      The user data to transfer
+  @param  DataLen   The length of data buffer
+  @param  Callback  The function to call when data is transferred
+  @param  Context   The context to the callback
+
+  @return Created URB or NULL
+
+**/
+URB*
+XhcPeiCreateUrb (
+  IN PEI_XHC_DEV                        *Xhc,
+  IN UINT8                              BusAddr,
+  IN UINT8                              EpAddr,
+  IN UINT8                              DevSpeed,
+  IN UINTN                              MaxPacket,
+  IN UINTN                              Type,
+  IN EFI_USB_DEVICE_REQUEST             *Request,
+  IN VOID                               *Data,
+  IN UINTN                              DataLen,
+  IN EFI_ASYNC_USB_TRANSFER_CALLBACK    Callback,
+  IN VOID                               *Context
+  )
+{
+  URB               *Urb;
+
+  Urb = AllocatePool (sizeof (URB));
+  if (Urb == NULL) {
+    return NULL;
+  }
+
+  if (XhcPeiInitUrb (Xhc, Urb, BusAddr, EpAddr, DevSpeed, MaxPacket, Type,
+                     Request, Data, DataLen, Callback, Context) == NULL) {
     FreePool (Urb);
     Urb = NULL;
   }
@@ -179,6 +223,8 @@ XhcPeiCreateUrb (
 /**
   Free an allocated URB.
 
+  The URB preallocated in the XHCI device is only unmapped.
+
   @param  Xhc       The XHCI device.
   @param  Urb       The URB to free.
 
@@ -194,8 +240,11 @@ XhcPeiFreeUrb (
   }
 
   IoMmuUnmap (Urb->DataMap);
+  Urb->DataMap = NULL;
 
-  FreePool (Urb);
+  if (Urb != &Xhc->BulkUrb) {
+    FreePool (Urb);
+  }
 }
 
 /**
@@ -219,8 +268,10 @@ XhcPeiCreateTransferTrb (
   UINT8                         SlotId;
   UINT8                         Dci;
   TRB                           *TrbStart;
+  LINK_TRB                      *LinkTrb;
   UINTN                         TotalLen;
   UINTN                         Len;
+  UINTN                         TdSize;
   UINTN                         TrbNum;
   EDKII_IOMMU_OPERATION         MapOp;
   EFI_PHYSICAL_ADDRESS          PhyAddr;
@@ -365,33 +416,50 @@ XhcPeiCreateTransferTrb (
 
     case ED_BULK_OUT:
     case ED_BULK_IN:
+      //
+      // Queue the whole buffer as one TD. A TRB buffer must not cross a 64KB
+      // boundary, so the buffer is split there. All the TRBs but the last one
+      // are chained, and only the last one generates an interrupt. A short
+      // packet still ends the TD early with an event since ISP is set.
+      //
       TotalLen = 0;
       Len      = 0;
       TrbNum   = 0;
       TrbStart = (TRB *) (UINTN) EPRing->RingEnqueue;
       while (TotalLen < Urb->DataLen) {
-        if ((TotalLen + 0x10000) >= Urb->DataLen) {
+        PhyAddr = (EFI_PHYSICAL_ADDRESS) (UINTN) Urb->DataPhy + TotalLen;
+        Len     = SIZE_64KB - (UINTN) (PhyAddr & (SIZE_64KB - 1));
+        if (Len > Urb->DataLen - TotalLen) {
           Len = Urb->DataLen - TotalLen;
-        } else {
-          Len = 0x10000;
         }
+        TotalLen += Len;
+        TdSize    = (Urb->DataLen - TotalLen + Urb->Ep.MaxPacket - 1) / Urb->Ep.MaxPacket;
+
         TrbStart = (TRB *)(UINTN)EPRing->RingEnqueue;
-        TrbStart->TrbNormal.TRBPtrLo  = XHC_LOW_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
-        TrbStart->TrbNormal.TRBPtrHi  = XHC_HIGH_32BIT((UINT8 *) Urb->DataPhy + TotalLen);
+        TrbStart->TrbNormal.TRBPtrLo  = XHC_LOW_32BIT (PhyAddr);
+        TrbStart->TrbNormal.TRBPtrHi  = XHC_HIGH_32BIT (PhyAddr);
         TrbStart->TrbNormal.Length    = (UINT32) Len;
-        TrbStart->TrbNormal.TDSize    = 0;
+        TrbStart->TrbNormal.TDSize    = (UINT32) MIN (TdSize, XHC_MAX_TD_SIZE);
         TrbStart->TrbNormal.IntTarget = 0;
         TrbStart->TrbNormal.ISP       = 1;
-        TrbStart->TrbNormal.IOC       = 1;
+        TrbStart->TrbNormal.IOC       = (TotalLen == Urb->DataLen) ? 1 : 0;
+        TrbStart->TrbNormal.CH        = (TotalLen == Urb->DataLen) ? 0 : 1;
         TrbStart->TrbNormal.Type      = TRB_TYPE_NORMAL;
         //
         // Update the cycle bit
         //
         TrbStart->TrbNormal.CycleBit = EPRing->RingPCS & BIT0;
 
+        //
+        // A Link TRB in the middle of the TD has to be chained too.
+        //
+        LinkTrb = (LINK_TRB *) ((TRB_TEMPLATE *) TrbStart + 1);
+        if ((UINT8) LinkTrb->Type == TRB_TYPE_LINK) {
+          LinkTrb->CH = TrbStart->TrbNormal.CH;
+        }
+
         XhcPeiSyncTrsRing (Xhc, EPRing);
         TrbNum++;
-        TotalLen += Len;
       }
 
       Urb->TrbNum = TrbNum;
@@ -705,9 +773,21 @@ XhcPeiCheckUrbResult (
         }
 
         TRBType = (UINT8) (TRBPtr->Type);
-        if ((TRBType == TRB_TYPE_DATA_STAGE) ||
-            (TRBType == TRB_TYPE_NORMAL) ||
-            (TRBType == TRB_TYPE_ISOCH)) {
+        if ((CheckedUrb->Ep.Type == XHC_BULK_TRANSFER) && (TRBType == TRB_TYPE_NORMAL)) {
+          //
+          // A bulk TD only reports its last TRB, or the TRB a short packet
+          // happened in. All the data in the TD before that TRB is done.
+          //
+          PhyAddr = (EFI_PHYSICAL_ADDRESS) (((TRANSFER_TRB_NORMAL*)TRBPtr)->TRBPtrLo |
+                    LShiftU64 ((UINT64) ((TRANSFER_TRB_NORMAL*)TRBPtr)->TRBPtrHi, 32));
+          CheckedUrb->Completed = (UINTN) (PhyAddr - (UINTN) CheckedUrb->DataPhy) +
+                                  (((TRANSFER_TRB_NORMAL*)TRBPtr)->Length - EvtTrb->Length);
+          if (EvtTrb->Completecode == TRB_COMPLETION_SHORT_PACKET) {
+            CheckedUrb->EndDone = TRUE;
+          }
+        } else if ((TRBType == TRB_TYPE_DATA_STAGE) ||
+                   (TRBType == TRB_TYPE_NORMAL) ||
+                   (TRBType == TRB_TYPE_ISOCH)) {
           CheckedUrb->Completed += (((TRANSFER_TRB_NORMAL*)TRBPtr)->Length - EvtTrb->Length);
         }
 
@@ -721,9 +801,10 @@ XhcPeiCheckUrbResult (
     }
 
     //
-    // Only check first and end Trb event address
+    // Only check first and end Trb event address. The first TRB of a bulk
+    // TD does not generate an event unless the TD has only one TRB.
     //
-    if (TRBPtr == CheckedUrb->TrbStart) {
+    if ((TRBPtr == CheckedUrb->TrbStart) || (CheckedUrb->Ep.Type == XHC_BULK_TRANSFER)) {
       CheckedUrb->StartDone = TRUE;
     }
 
@@ -17,6 +17,18 @@ SPDX-License-Identifier: BSD-2-Clause-Patent
 #define XHC_BULK_TRANSFER                       0x02
 #define XHC_INT_TRANSFER_SYNC                   0x04
 
+//
+// Largest bulk transfer that is queued as a single TD. The TRBs of a TD
+// never cross a 64KB boundary, so it takes at most 65 TRBs and always fits
+// into the transfer ring. Larger bulk transfers are split into several TDs.
+//
+#define XHC_MAX_BULK_TD_SIZE                    SIZE_4MB
+
+//
+// 4.11.2.4 TD Size is the number of packets left after the TRB, up to 31.
+//
+#define XHC_MAX_TD_SIZE                         31
+
 //
 // 6.4.6 TRB Types
 //
@@ -1173,9 +1185,46 @@ XhcPeiCreateUrb (
   IN VOID                               *Context
   );
 
+/**
+  Initialize a preallocated URB for a new transaction.
+
+  @param  Xhc       The XHCI device
+  @param  Urb       The URB to initialize
+  @param  DevAddr   The device address
+  @param  EpAddr    Endpoint addrress
+  @param  DevSpeed  The device speed
+  @param  MaxPacket The max packet length of the endpoint
+  @param  Type      The transaction type
+  @param  Request   The standard USB request for control transfer
+  @param  Data      The user data to transfer
+  @param  DataLen   The length of data buffer
+  @param  Callback  The function to call when data is transferred
+  @param  Context   The context to the callback
+
+  @return The initialized URB or NULL
+
+**/
+URB*
+XhcPeiInitUrb (
+  IN PEI_XHC_DEV                        *Xhc,
+  IN URB                                *Urb,
+  IN UINT8                              DevAddr,
+  IN UINT8                              EpAddr,
+  IN UINT8                              DevSpeed,
+  IN UINTN                              MaxPacket,
+  IN UINTN                              Type,
+  IN EFI_USB_DEVICE_REQUEST             *Request,
+  IN VOID                               *Data,
+  IN UINTN                              DataLen,
+  IN EFI_ASYNC_USB_TRANSFER_CALLBACK    Callback,
+  IN VOID                               *Context
+  );
+
 /**
   Free an allocated URB.
 
+  The URB preallocated in the XHCI device is only unmapped.
+
   @param  Xhc       The XHCI device.
   @param  Urb       The URB to free.
 
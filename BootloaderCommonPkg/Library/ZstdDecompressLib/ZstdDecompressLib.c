@@ -0,0 +1,1398 @@
+/** @file
+  Zstandard decompression.
+
+  A compact decoder for the Zstandard frame format described in RFC 8878.
+  It decodes one frame into a flat destination buffer, so matches are copied
+  from the output itself and no window buffer is required. Dictionaries are
+  not supported, and the optional content checksum is skipped since the
+  compressed images are authenticated before they are decompressed.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <Library/ZstdDecompressLib.h>
+
+#define ZSTD_MAGIC_NUMBER           0xFD2FB528
+#define ZSTD_BLOCK_SIZE_MAX         SIZE_128KB
+#define ZSTD_BLOCK_HEADER_SIZE      3
+
+#define ZSTD_BLOCK_RAW              0
+#define ZSTD_BLOCK_RLE              1
+#define ZSTD_BLOCK_COMPRESSED       2
+
+#define ZSTD_LIT_RAW                0
+#define ZSTD_LIT_RLE                1
+#define ZSTD_LIT_COMPRESSED         2
+#define ZSTD_LIT_TREELESS           3
+
+#define ZSTD_SEQ_PREDEFINED         0
+#define ZSTD_SEQ_RLE                1
+#define ZSTD_SEQ_COMPRESSED         2
+#define ZSTD_SEQ_REPEAT             3
+
+#define ZSTD_LL_MAX_LOG             9
+#define ZSTD_ML_MAX_LOG             9
+#define ZSTD_OF_MAX_LOG             8
+#define ZSTD_HUF_MAX_LOG            11
+#define ZSTD_HUF_WEIGHT_MAX_LOG     6
+
+#define ZSTD_LL_SYMBOLS             36
+#define ZSTD_ML_SYMBOLS             53
+#define ZSTD_OF_SYMBOLS             32
+#define ZSTD_HUF_WEIGHT_SYMBOLS     (ZSTD_HUF_MAX_LOG + 1)
+#define ZSTD_HUF_SYMBOLS            256
+#define ZSTD_FSE_SYMBOLS_MAX        ZSTD_ML_SYMBOLS
+
+//
+// Bit readers work on a UINTN container, so a single read is limited to
+// what is left after the byte alignment shift.
+//
+#define ZSTD_BITS_READ_MAX          ((UINT32)(sizeof (UINTN) * 8 - 7))
+
+typedef struct {
+  UINT16                    NewStateBase;
+  UINT8                     Symbol;
+  UINT8                     NumBits;
+} ZSTD_FSE_ENTRY;
+
+typedef struct {
+  UINT8                     Symbol;
+  UINT8                     NumBits;
+} ZSTD_HUF_ENTRY;
+
+typedef struct {
+  ZSTD_FSE_ENTRY           *Entry;
+  UINT32                    Log;
+  BOOLEAN                   Valid;
+} ZSTD_FSE_TABLE;
+
+typedef struct {
+  CONST UINT8              *Start;
+  UINTN                     Size;
+  INTN                      BitPos;
+} ZSTD_BIT_STREAM;
+
+//
+// Decoder context placed at the start of the scratch buffer. The literal
+// buffer of one block follows it.
+//
+typedef struct {
+  ZSTD_FSE_ENTRY            LlEntry[1 << ZSTD_LL_MAX_LOG];
+  ZSTD_FSE_ENTRY            OfEntry[1 << ZSTD_OF_MAX_LOG];
+  ZSTD_FSE_ENTRY            MlEntry[1 << ZSTD_ML_MAX_LOG];
+  ZSTD_FSE_ENTRY            WeightEntry[1 << ZSTD_HUF_WEIGHT_MAX_LOG];
+  ZSTD_HUF_ENTRY            HufEntry[1 << ZSTD_HUF_MAX_LOG];
+  ZSTD_FSE_TABLE            LlTable;
+  ZSTD_FSE_TABLE            OfTable;
+  ZSTD_FSE_TABLE            MlTable;
+  UINT32                    HufLog;
+  BOOLEAN                   HufValid;
+  UINT32                    RepOffset[3];
+  INT16                     NormFreq[ZSTD_FSE_SYMBOLS_MAX];
+  UINT16                    StateDesc[ZSTD_FSE_SYMBOLS_MAX];
+  UINT8                     Weight[ZSTD_HUF_SYMBOLS];
+  UINT8                    *LitBuffer;
+  UINT32                    LitBufferSize;
+  UINT8                    *DstStart;
+  UINT8                    *DstEnd;
+} ZSTD_DCTX;
+
+//
+// Predefined distributions, baselines and extra bits from RFC 8878
+//
+STATIC CONST INT16  mLlDefaultFreq[ZSTD_LL_SYMBOLS] = {
+  4, 3, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 2, 1, 1, 1,
+  2, 2, 2, 2, 2, 2, 2, 2, 2, 3, 2, 1, 1, 1, 1, 1,
+  -1, -1, -1, -1
+};
+
+STATIC CONST INT16  mMlDefaultFreq[ZSTD_ML_SYMBOLS] = {
+  1, 4, 3, 2, 2, 2, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, -1, -1,
+  -1, -1, -1, -1, -1
+};
+
+STATIC CONST INT16  mOfDefaultFreq[] = {
+  1, 1, 1, 1, 1, 1, 2, 2, 2, 1, 1, 1, 1, 1, 1, 1,
+  1, 1, 1, 1, 1, 1, 1, 1, -1, -1, -1, -1, -1
+};
+
+STATIC CONST UINT32 mLlBase[ZSTD_LL_SYMBOLS] = {
+  0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+  16, 18, 20, 22, 24, 28, 32, 40, 48, 64, 128, 256, 512, 1024, 2048, 4096,
+  8192, 16384, 32768, 65536
+};
+
+STATIC CONST UINT8  mLlBits[ZSTD_LL_SYMBOLS] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 1, 1, 1, 2, 2, 3, 3, 4, 6, 7, 8, 9, 10, 11, 12,
+  13, 14, 15, 16
+};
+
+STATIC CONST UINT32 mMlBase[ZSTD_ML_SYMBOLS] = {
+  3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17, 18,
+  19, 20, 21, 22, 23, 24, 25, 26, 27, 28, 29, 30, 31, 32, 33, 34,
+  35, 37, 39, 41, 43, 47, 51, 59, 67, 83, 99, 131, 259, 515, 1027, 2051,
+  4099, 8195, 16387, 32771, 65539
+};
+
+STATIC CONST UINT8  mMlBits[ZSTD_ML_SYMBOLS] = {
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0, 0,
+  1, 1, 1, 1, 2, 2, 3, 3, 4, 4, 5, 7, 8, 9, 10, 11,
+  12, 13, 14, 15, 16
+};
+
+/**
+  Load a little endian UINTN from a buffer.
+
+  Bytes outside of the buffer are read as zero.
+
+  @param[in] Buffer    The buffer to read from.
+  @param[in] Size      The size of the buffer.
+  @param[in] Offset    The byte offset to load from. It can be negative.
+
+  @retval    The loaded value.
+
+**/
+STATIC
+UINTN
+ZstdLoad (
+  IN CONST UINT8   *Buffer,
+  IN UINTN          Size,
+  IN INTN           Offset
+  )
+{
+  UINTN             Value;
+  UINTN             Index;
+  INTN              Pos;
+
+  if ((Offset >= 0) && ((UINTN)Offset + sizeof (UINTN) <= Size)) {
+    if (sizeof (UINTN) == sizeof (UINT64)) {
+      return (UINTN)ReadUnaligned64 ((CONST UINT64 *)(Buffer + Offset));
+    }
+    return (UINTN)ReadUnaligned32 ((CONST UINT32 *)(Buffer + Offset));
+  }
+
+  Value = 0;
+  for (Index = sizeof (UINTN); Index > 0; Index--) {
+    Pos   = Offset + (INTN)Index - 1;
+    Value = Value << 8;
+    if ((Pos >= 0) && ((UINTN)Pos < Size)) {
+      Value |= Buffer[Pos];
+    }
+  }
+  return Value;
+}
+
+/**
+  Get bits from a little endian bit stream.
+
+  Bits outside of the buffer are read as zero.
+
+  @param[in] Buffer    The buffer holding the bit stream.
+  @param[in] Size      The size of the buffer.
+  @param[in] BitPos    The position of the lowest bit to get. It can be negative.
+  @param[in] Count     The number of bits, up to ZSTD_BITS_READ_MAX.
+
+  @retval    The value of the bits.
+
+**/
+STATIC
+UINT32
+ZstdPeekBits (
+  IN CONST UINT8   *Buffer,
+  IN UINTN          Size,
+  IN INTN           BitPos,
+  IN UINT32         Count
+  )
+{
+  UINTN             Value;
+
+  if ((Count == 0) || (BitPos + (INTN)Count <= 0)) {
+    return 0;
+  }
+
+  if (BitPos >= 0) {
+    Value = ZstdLoad (Buffer, Size, BitPos >> 3) >> (BitPos & 7);
+  } else {
+    Value = ZstdLoad (Buffer, Size, 0) << (-BitPos);
+  }
+  return (UINT32)(Value & (((UINTN)1 << Count) - 1));
+}
+
+/**
+  Initialize a backward bit stream.
+
+  The stream is read from its end. The highest set bit of the last byte
+  marks the start of the data.
+
+  @param[out] Stream   The bit stream to initialize.
+  @param[in]  Buffer   The buffer holding the bit stream.
+  @param[in]  Size     The size of the buffer.
+
+  @retval RETURN_SUCCESS            The stream is initialized.
+  @retval RETURN_INVALID_PARAMETER  The stream is empty or has no end mark.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdInitBitStream (
+  OUT ZSTD_BIT_STREAM  *Stream,
+  IN  CONST UINT8      *Buffer,
+  IN  UINTN             Size
+  )
+{
+  if ((Size == 0) || (Buffer[Size - 1] == 0)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Stream->Start  = Buffer;
+  Stream->Size   = Size;
+  Stream->BitPos = (INTN)((Size - 1) * 8) + HighBitSet32 (Buffer[Size - 1]);
+  return RETURN_SUCCESS;
+}
+
+/**
+  Read bits from a backward bit stream.
+
+  Reading past the start of the stream returns zero bits and leaves the
+  position negative, which the caller checks at the end.
+
+  @param[in, out] Stream   The bit stream.
+  @param[in]      Count    The number of bits, up to 32.
+
+  @retval    The value of the bits.
+
+**/
+STATIC
+UINT32
+ZstdReadBits (
+  IN OUT ZSTD_BIT_STREAM  *Stream,
+  IN     UINT32            Count
+  )
+{
+  UINT32                   High;
+
+  if (Count > ZSTD_BITS_READ_MAX) {
+    High = ZstdReadBits (Stream, Count - 16);
+    return (High << 16) | ZstdReadBits (Stream, 16);
+  }
+
+  Stream->BitPos -= Count;
+  return ZstdPeekBits (Stream->Start, Stream->Size, Stream->BitPos, Count);
+}
+
+/**
+  Build a FSE decoding table from normalized frequencies.
+
+  @param[out] Entry       The decoding table entries.
+  @param[out] StateDesc   Work buffer of at least NumSymbols entries.
+  @param[in]  NormFreq    The normalized frequency of each symbol.
+  @param[in]  NumSymbols  The number of symbols.
+  @param[in]  Log         The accuracy log of the table.
+
+  @retval RETURN_SUCCESS            The table is built.
+  @retval RETURN_INVALID_PARAMETER  The frequencies do not fill the table.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdBuildFseTable (
+  OUT ZSTD_FSE_ENTRY   *Entry,
+  OUT UINT16           *StateDesc,
+  IN  CONST INT16      *NormFreq,
+  IN  UINT32            NumSymbols,
+  IN  UINT32            Log
+  )
+{
+  UINT32                TableSize;
+  UINT32                HighThreshold;
+  UINT32                Step;
+  UINT32                Mask;
+  UINT32                Pos;
+  UINT32                Symbol;
+  UINT32                Index;
+  UINT16                NextState;
+
+  TableSize     = 1 << Log;
+  HighThreshold = TableSize;
+  for (Symbol = 0; Symbol < NumSymbols; Symbol++) {
+    if (NormFreq[Symbol] == -1) {
+      if (HighThreshold == 0) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      Entry[--HighThreshold].Symbol = (UINT8)Symbol;
+      StateDesc[Symbol] = 1;
+    }
+  }
+
+  Step = (TableSize >> 1) + (TableSize >> 3) + 3;
+  Mask = TableSize - 1;
+  Pos  = 0;
+  for (Symbol = 0; Symbol < NumSymbols; Symbol++) {
+    if (NormFreq[Symbol] <= 0) {
+      continue;
+    }
+    StateDesc[Symbol] = (UINT16)NormFreq[Symbol];
+    for (Index = 0; Index < (UINT32)NormFreq[Symbol]; Index++) {
+      Entry[Pos].Symbol = (UINT8)Symbol;
+      do {
+        Pos = (Pos + Step) & Mask;
+      } while (Pos >= HighThreshold);
+    }
+  }
+  if (Pos != 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  for (Index = 0; Index < TableSize; Index++) {
+    NextState = StateDesc[Entry[Index].Symbol]++;
+    Entry[Index].NumBits      = (UINT8)(Log - HighBitSet32 (NextState));
+    Entry[Index].NewStateBase = (UINT16)((NextState << Entry[Index].NumBits) - TableSize);
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Read a FSE table description and build the decoding table.
+
+  @param[in]  Dctx        The decoder context.
+  @param[out] Table       The FSE table to build.
+  @param[in]  MaxLog      The maximum accuracy log allowed.
+  @param[in]  MaxSymbols  The size of the symbol alphabet.
+  @param[in]  Src         The table description.
+  @param[in]  Size        The size of the available source data.
+  @param[out] Consumed    The size of the table description.
+
+  @retval RETURN_SUCCESS            The table is built.
+  @retval RETURN_INVALID_PARAMETER  The table description is corrupted.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdReadFseTable (
+  IN  ZSTD_DCTX        *Dctx,
+  OUT ZSTD_FSE_TABLE   *Table,
+  IN  UINT32            MaxLog,
+  IN  UINT32            MaxSymbols,
+  IN  CONST UINT8      *Src,
+  IN  UINTN             Size,
+  OUT UINTN            *Consumed
+  )
+{
+  INTN                  BitPos;
+  UINT32                Log;
+  INT32                 Remaining;
+  UINT32                Symbol;
+  UINT32                Bits;
+  UINT32                Value;
+  UINT32                LowerMask;
+  UINT32                Threshold;
+  UINT32                Repeat;
+  UINT32                Index;
+  INT32                 Proba;
+
+  if (Size == 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Log    = ZstdPeekBits (Src, Size, 0, 4) + 5;
+  BitPos = 4;
+  if (Log > MaxLog) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Remaining = 1 << Log;
+  Symbol    = 0;
+  while ((Remaining > 0) && (Symbol < MaxSymbols)) {
+    Bits      = (UINT32)HighBitSet32 ((UINT32)Remaining + 1) + 1;
+    Value     = ZstdPeekBits (Src, Size, BitPos, Bits);
+    LowerMask = (1 << (Bits - 1)) - 1;
+    Threshold = (1 << Bits) - 1 - ((UINT32)Remaining + 1);
+    if ((Value & LowerMask) < Threshold) {
+      Value  &= LowerMask;
+      BitPos += Bits - 1;
+    } else {
+      if (Value > LowerMask) {
+        Value -= Threshold;
+      }
+      BitPos += Bits;
+    }
+
+    Proba      = (INT32)Value - 1;
+    Remaining -= (Proba < 0) ? -Proba : Proba;
+    Dctx->NormFreq[Symbol++] = (INT16)Proba;
+    if (Proba == 0) {
+      do {
+        Repeat  = ZstdPeekBits (Src, Size, BitPos, 2);
+        BitPos += 2;
+        for (Index = 0; (Index < Repeat) && (Symbol < MaxSymbols); Index++) {
+          Dctx->NormFreq[Symbol++] = 0;
+        }
+      } while ((Repeat == 3) && (Symbol < MaxSymbols));
+    }
+
+    if ((UINTN)(BitPos >> 3) > Size) {
+      return RETURN_INVALID_PARAMETER;
+    }
+  }
+
+  *Consumed = (UINTN)(BitPos + 7) >> 3;
+  if ((Remaining != 0) || (*Consumed > Size)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Table->Log   = Log;
+  Table->Valid = FALSE;
+  if (ZstdBuildFseTable (Table->Entry, Dctx->StateDesc, Dctx->NormFreq, Symbol, Log) != RETURN_SUCCESS) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  Table->Valid = TRUE;
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Read a Huffman tree description and build the literal decoding table.
+
+  @param[in]  Dctx        The decoder context.
+  @param[in]  Src         The tree description.
+  @param[in]  Size        The size of the available source data.
+  @param[out] Consumed    The size of the tree description.
+
+  @retval RETURN_SUCCESS            The table is built.
+  @retval RETURN_INVALID_PARAMETER  The tree description is corrupted.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdReadHuffmanTable (
+  IN  ZSTD_DCTX        *Dctx,
+  IN  CONST UINT8      *Src,
+  IN  UINTN             Size,
+  OUT UINTN            *Consumed
+  )
+{
+  ZSTD_FSE_TABLE        WeightTable;
+  ZSTD_BIT_STREAM       Stream;
+  UINTN                 HeaderSize;
+  UINT32                NumWeights;
+  UINT32                Index;
+  UINT32                State1;
+  UINT32                State2;
+  UINT32                Sum;
+  UINT32                MaxBits;
+  UINT32                Left;
+  UINT32                Bits;
+  UINT32                Length;
+  UINT32                RankCount[ZSTD_HUF_MAX_LOG + 1];
+  UINT32                RankIdx[ZSTD_HUF_MAX_LOG + 1];
+  ZSTD_FSE_ENTRY       *Entry;
+
+  Dctx->HufValid = FALSE;
+  if (Size == 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Src[0] >= 128) {
+    // Weights are stored directly as 4-bit values
+    NumWeights = Src[0] - 127;
+    *Consumed  = 1 + (NumWeights + 1) / 2;
+    if (*Consumed > Size) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    for (Index = 0; Index < NumWeights; Index++) {
+      Dctx->Weight[Index] = (Index & 1) ? (Src[1 + Index / 2] & 0xF) : (Src[1 + Index / 2] >> 4);
+    }
+  } else {
+    // Weights are FSE compressed, decoded with two interleaved states
+    *Consumed = 1 + (UINTN)Src[0];
+    if (*Consumed > Size) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    WeightTable.Entry = Dctx->WeightEntry;
+    if (ZstdReadFseTable (Dctx, &WeightTable, ZSTD_HUF_WEIGHT_MAX_LOG, ZSTD_HUF_WEIGHT_SYMBOLS,
+                          Src + 1, Src[0], &HeaderSize) != RETURN_SUCCESS) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    if (ZstdInitBitStream (&Stream, Src + 1 + HeaderSize, Src[0] - HeaderSize) != RETURN_SUCCESS) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    Entry      = WeightTable.Entry;
+    State1     = ZstdReadBits (&Stream, WeightTable.Log);
+    State2     = ZstdReadBits (&Stream, WeightTable.Log);
+    NumWeights = 0;
+    while (TRUE) {
+      if (NumWeights + 2 > ZSTD_HUF_SYMBOLS - 1) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      Dctx->Weight[NumWeights++] = Entry[State1].Symbol;
+      State1 = Entry[State1].NewStateBase + ZstdReadBits (&Stream, Entry[State1].NumBits);
+      if (Stream.BitPos < 0) {
+        Dctx->Weight[NumWeights++] = Entry[State2].Symbol;
+        break;
+      }
+      Dctx->Weight[NumWeights++] = Entry[State2].Symbol;
+      State2 = Entry[State2].NewStateBase + ZstdReadBits (&Stream, Entry[State2].NumBits);
+      if (Stream.BitPos < 0) {
+        if (NumWeights + 1 > ZSTD_HUF_SYMBOLS - 1) {
+          return RETURN_INVALID_PARAMETER;
+        }
+        Dctx->Weight[NumWeights++] = Entry[State1].Symbol;
+        break;
+      }
+    }
+  }
+
+  if (NumWeights > ZSTD_HUF_SYMBOLS - 1) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  // The weight of the last symbol is implied by the others
+  Sum = 0;
+  for (Index = 0; Index < NumWeights; Index++) {
+    if (Dctx->Weight[Index] > ZSTD_HUF_MAX_LOG) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    if (Dctx->Weight[Index] > 0) {
+      Sum += 1 << (Dctx->Weight[Index] - 1);
+    }
+  }
+  if (Sum == 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  MaxBits = (UINT32)HighBitSet32 (Sum) + 1;
+  Left    = (1 << MaxBits) - Sum;
+  if ((MaxBits > ZSTD_HUF_MAX_LOG) || ((Left & (Left - 1)) != 0)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  Dctx->Weight[NumWeights++] = (UINT8)(HighBitSet32 (Left) + 1);
+
+  // Convert weights to code lengths and assign codes by increasing weight
+  ZeroMem (RankCount, sizeof (RankCount));
+  for (Index = 0; Index < NumWeights; Index++) {
+    if (Dctx->Weight[Index] > 0) {
+      RankCount[MaxBits + 1 - Dctx->Weight[Index]]++;
+    }
+  }
+
+  RankIdx[MaxBits] = 0;
+  for (Bits = MaxBits; Bits >= 1; Bits--) {
+    RankIdx[Bits - 1] = RankIdx[Bits] + RankCount[Bits] * (1 << (MaxBits - Bits));
+    for (Index = RankIdx[Bits]; Index < RankIdx[Bits - 1]; Index++) {
+      Dctx->HufEntry[Index].NumBits = (UINT8)Bits;
+    }
+  }
+
+  for (Index = 0; Index < NumWeights; Index++) {
+    if (Dctx->Weight[Index] == 0) {
+      continue;
+    }
+    Bits   = MaxBits + 1 - Dctx->Weight[Index];
+    Length = 1 << (MaxBits - Bits);
+    while (Length-- > 0) {
+      Dctx->HufEntry[RankIdx[Bits]].Symbol  = (UINT8)Index;
+      Dctx->HufEntry[RankIdx[Bits]].NumBits = (UINT8)Bits;
+      RankIdx[Bits]++;
+    }
+  }
+
+  Dctx->HufLog   = MaxBits;
+  Dctx->HufValid = TRUE;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decode one Huffman coded literal stream.
+
+  @param[in]  Dctx        The decoder context.
+  @param[in]  Src         The literal stream.
+  @param[in]  Size        The size of the literal stream.
+  @param[out] Dst         The buffer to store the literals.
+  @param[in]  Count       The number of literals in the stream.
+
+  @retval RETURN_SUCCESS            The literals are decoded.
+  @retval RETURN_INVALID_PARAMETER  The stream is corrupted.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdDecodeHuffmanStream (
+  IN  ZSTD_DCTX        *Dctx,
+  IN  CONST UINT8      *Src,
+  IN  UINTN             Size,
+  OUT UINT8            *Dst,
+  IN  UINT32            Count
+  )
+{
+  ZSTD_BIT_STREAM       Stream;
+  ZSTD_HUF_ENTRY       *Entry;
+  UINT32                Log;
+  UINT32                Index;
+
+  if (ZstdInitBitStream (&Stream, Src, Size) != RETURN_SUCCESS) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Log = Dctx->HufLog;
+  for (Index = 0; Index < Count; Index++) {
+    Entry = &Dctx->HufEntry[ZstdPeekBits (Src, Size, Stream.BitPos - Log, Log)];
+    Dst[Index]     = Entry->Symbol;
+    Stream.BitPos -= Entry->NumBits;
+  }
+
+  return (Stream.BitPos == 0) ? RETURN_SUCCESS : RETURN_INVALID_PARAMETER;
+}
+
+/**
+  Decode the literals section of a compressed block.
+
+  Raw literals are used in place, all others are decoded into the literal buffer.
+
+  @param[in]  Dctx        The decoder context.
+  @param[in]  Src         The literals section.
+  @param[in]  Size        The size of the block.
+  @param[out] Literals    The decoded literals.
+  @param[out] LitSize     The number of decoded literals.
+  @param[out] Consumed    The size of the literals section.
+
+  @retval RETURN_SUCCESS            The literals are decoded.
+  @retval RETURN_INVALID_PARAMETER  The literals section is corrupted.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdDecodeLiterals (
+  IN  ZSTD_DCTX        *Dctx,
+  IN  CONST UINT8      *Src,
+  IN  UINTN             Size,
+  OUT CONST UINT8     **Literals,
+  OUT UINT32           *LitSize,
+  OUT UINTN            *Consumed
+  )
+{
+  UINT32                Type;
+  UINT32                SizeFormat;
+  UINT32                HeaderSize;
+  UINT32                RegenSize;
+  UINT32                CompSize;
+  UINT32                Value;
+  UINTN                 TreeSize;
+  UINTN                 StreamSize[4];
+  UINT32                SegmentSize;
+  UINT32                Index;
+  CONST UINT8          *Data;
+  UINTN                 DataSize;
+  UINT8                *Dst;
+
+  if (Size == 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Type       = Src[0] & 3;
+  SizeFormat = (Src[0] >> 2) & 3;
+
+  if ((Type == ZSTD_LIT_RAW) || (Type == ZSTD_LIT_RLE)) {
+    if ((SizeFormat & 1) == 0) {
+      HeaderSize = 1;
+      RegenSize  = Src[0] >> 3;
+    } else if (SizeFormat == 1) {
+      HeaderSize = 2;
+      RegenSize  = (Size < 2) ? 0 : ((Src[0] >> 4) + ((UINT32)Src[1] << 4));
+    } else {
+      HeaderSize = 3;
+      RegenSize  = (Size < 3) ? 0 : ((Src[0] >> 4) + ((UINT32)Src[1] << 4) + ((UINT32)Src[2] << 12));
+    }
+    if ((HeaderSize > Size) || (RegenSize > ZSTD_BLOCK_SIZE_MAX)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    if (Type == ZSTD_LIT_RAW) {
+      if (RegenSize > Size - HeaderSize) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      *Literals = Src + HeaderSize;
+      *Consumed = HeaderSize + RegenSize;
+    } else {
+      if ((HeaderSize + 1 > Size) || (RegenSize > Dctx->LitBufferSize)) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      SetMem (Dctx->LitBuffer, RegenSize, Src[HeaderSize]);
+      *Literals = Dctx->LitBuffer;
+      *Consumed = HeaderSize + 1;
+    }
+    *LitSize = RegenSize;
+    return RETURN_SUCCESS;
+  }
+
+  // Huffman coded literals
+  HeaderSize = (SizeFormat <= 1) ? 3 : (SizeFormat + 2);
+  if (HeaderSize > Size) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  Value = Src[0] | ((UINT32)Src[1] << 8) | ((UINT32)Src[2] << 16);
+  if (HeaderSize == 3) {
+    RegenSize = (Value >> 4) & 0x3FF;
+    CompSize  = (Value >> 14) & 0x3FF;
+  } else if (HeaderSize == 4) {
+    Value    |= (UINT32)Src[3] << 24;
+    RegenSize = (Value >> 4) & 0x3FFF;
+    CompSize  = Value >> 18;
+  } else {
+    Value    |= (UINT32)Src[3] << 24;
+    RegenSize = (Value >> 4) & 0x3FFFF;
+    CompSize  = (Value >> 22) + ((UINT32)Src[4] << 10);
+  }
+  if ((RegenSize > Dctx->LitBufferSize) || (CompSize > Size - HeaderSize)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Data     = Src + HeaderSize;
+  DataSize = CompSize;
+  if (Type == ZSTD_LIT_COMPRESSED) {
+    if (ZstdReadHuffmanTable (Dctx, Data, DataSize, &TreeSize) != RETURN_SUCCESS) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    Data     += TreeSize;
+    DataSize -= TreeSize;
+  } else if (!Dctx->HufValid) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Dst = Dctx->LitBuffer;
+  if (SizeFormat == 0) {
+    if (ZstdDecodeHuffmanStream (Dctx, Data, DataSize, Dst, RegenSize) != RETURN_SUCCESS) {
+      return RETURN_INVALID_PARAMETER;
+    }
+  } else {
+    // Four streams preceded by a jump table with the size of the first three
+    if (DataSize < 6) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    StreamSize[0] = ReadUnaligned16 ((CONST UINT16 *)Data);
+    StreamSize[1] = ReadUnaligned16 ((CONST UINT16 *)(Data + 2));
+    StreamSize[2] = ReadUnaligned16 ((CONST UINT16 *)(Data + 4));
+    Data     += 6;
+    DataSize -= 6;
+    if (StreamSize[0] + StreamSize[1] + StreamSize[2] > DataSize) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    StreamSize[3] = DataSize - StreamSize[0] - StreamSize[1] - StreamSize[2];
+
+    SegmentSize = (RegenSize + 3) / 4;
+    if (SegmentSize * 3 > RegenSize) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    for (Index = 0; Index < 4; Index++) {
+      if (ZstdDecodeHuffmanStream (Dctx, Data, StreamSize[Index], Dst,
+                                   (Index < 3) ? SegmentSize : (RegenSize - SegmentSize * 3)) != RETURN_SUCCESS) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      Data += StreamSize[Index];
+      Dst  += SegmentSize;
+    }
+  }
+
+  *Literals = Dctx->LitBuffer;
+  *LitSize  = RegenSize;
+  *Consumed = HeaderSize + CompSize;
+  return RETURN_SUCCESS;
+}
+
+/**
+  Set up the decoding table of a sequence symbol type.
+
+  @param[in]  Dctx        The decoder context.
+  @param[in]  Table       The FSE table to set up.
+  @param[in]  Mode        The compression mode of the table.
+  @param[in]  DefaultFreq The predefined distribution.
+  @param[in]  DefaultNum  The number of symbols in the predefined distribution.
+  @param[in]  DefaultLog  The accuracy log of the predefined distribution.
+  @param[in]  MaxLog      The maximum accuracy log allowed.
+  @param[in]  MaxSymbols  The size of the symbol alphabet.
+  @param[in]  Src         The table description.
+  @param[in]  Size        The size of the available source data.
+  @param[out] Consumed    The size of the table description.
+
+  @retval RETURN_SUCCESS            The table is ready.
+  @retval RETURN_INVALID_PARAMETER  The table description is corrupted.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdSetupSequenceTable (
+  IN  ZSTD_DCTX        *Dctx,
+  IN  ZSTD_FSE_TABLE   *Table,
+  IN  UINT32            Mode,
+  IN  CONST INT16      *DefaultFreq,
+  IN  UINT32            DefaultNum,
+  IN  UINT32            DefaultLog,
+  IN  UINT32            MaxLog,
+  IN  UINT32            MaxSymbols,
+  IN  CONST UINT8      *Src,
+  IN  UINTN             Size,
+  OUT UINTN            *Consumed
+  )
+{
+  *Consumed = 0;
+  switch (Mode) {
+  case ZSTD_SEQ_PREDEFINED:
+    Table->Log   = DefaultLog;
+    Table->Valid = (BOOLEAN)(ZstdBuildFseTable (Table->Entry, Dctx->StateDesc, DefaultFreq,
+                                                DefaultNum, DefaultLog) == RETURN_SUCCESS);
+    break;
+
+  case ZSTD_SEQ_RLE:
+    if ((Size == 0) || (Src[0] >= MaxSymbols)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    Table->Entry[0].Symbol       = Src[0];
+    Table->Entry[0].NumBits      = 0;
+    Table->Entry[0].NewStateBase = 0;
+    Table->Log   = 0;
+    Table->Valid = TRUE;
+    *Consumed    = 1;
+    break;
+
+  case ZSTD_SEQ_COMPRESSED:
+    return ZstdReadFseTable (Dctx, Table, MaxLog, MaxSymbols, Src, Size, Consumed);
+
+  default:
+    break;
+  }
+
+  return Table->Valid ? RETURN_SUCCESS : RETURN_INVALID_PARAMETER;
+}
+
+/**
+  Decode and execute the sequences of a compressed block.
+
+  @param[in]      Dctx        The decoder context.
+  @param[in]      Src         The sequence bit stream.
+  @param[in]      Size        The size of the sequence bit stream.
+  @param[in]      NumSeq      The number of sequences.
+  @param[in]      Literals    The literals of the block.
+  @param[in]      LitSize     The number of literals.
+  @param[in, out] Out         The current output position.
+
+  @retval RETURN_SUCCESS            The sequences are executed.
+  @retval RETURN_INVALID_PARAMETER  The sequences are corrupted.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdExecuteSequences (
+  IN     ZSTD_DCTX     *Dctx,
+  IN     CONST UINT8   *Src,
+  IN     UINTN          Size,
+  IN     UINT32         NumSeq,
+  IN     CONST UINT8   *Literals,
+  IN     UINT32         LitSize,
+  IN OUT UINT8        **Out
+  )
+{
+  ZSTD_BIT_STREAM       Stream;
+  ZSTD_FSE_ENTRY       *LlEntry;
+  ZSTD_FSE_ENTRY       *OfEntry;
+  ZSTD_FSE_ENTRY       *MlEntry;
+  UINT32                LlState;
+  UINT32                OfState;
+  UINT32                MlState;
+  UINT32                OfCode;
+  UINT32                LlCode;
+  UINT32                MlCode;
+  UINT32                Offset;
+  UINT32                MatchLength;
+  UINT32                LitLength;
+  UINT32                RepIdx;
+  UINT32                Index;
+  CONST UINT8          *LitEnd;
+  UINT8                *Dst;
+  UINT8                *Match;
+
+  if (ZstdInitBitStream (&Stream, Src, Size) != RETURN_SUCCESS) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  LlEntry = Dctx->LlTable.Entry;
+  OfEntry = Dctx->OfTable.Entry;
+  MlEntry = Dctx->MlTable.Entry;
+  LlState = ZstdReadBits (&Stream, Dctx->LlTable.Log);
+  OfState = ZstdReadBits (&Stream, Dctx->OfTable.Log);
+  MlState = ZstdReadBits (&Stream, Dctx->MlTable.Log);
+
+  Dst    = *Out;
+  LitEnd = Literals + LitSize;
+  for (Index = 0; Index < NumSeq; Index++) {
+    OfCode = OfEntry[OfState].Symbol;
+    LlCode = LlEntry[LlState].Symbol;
+    MlCode = MlEntry[MlState].Symbol;
+    if ((OfCode >= ZSTD_OF_SYMBOLS) || (LlCode >= ZSTD_LL_SYMBOLS) || (MlCode >= ZSTD_ML_SYMBOLS)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    Offset      = (1U << OfCode) + ZstdReadBits (&Stream, OfCode);
+    MatchLength = mMlBase[MlCode] + ZstdReadBits (&Stream, mMlBits[MlCode]);
+    LitLength   = mLlBase[LlCode] + ZstdReadBits (&Stream, mLlBits[LlCode]);
+
+    if (Index + 1 < NumSeq) {
+      LlState = LlEntry[LlState].NewStateBase + ZstdReadBits (&Stream, LlEntry[LlState].NumBits);
+      MlState = MlEntry[MlState].NewStateBase + ZstdReadBits (&Stream, MlEntry[MlState].NumBits);
+      OfState = OfEntry[OfState].NewStateBase + ZstdReadBits (&Stream, OfEntry[OfState].NumBits);
+    }
+
+    // Resolve repeat offsets
+    if (Offset > 3) {
+      Offset -= 3;
+      Dctx->RepOffset[2] = Dctx->RepOffset[1];
+      Dctx->RepOffset[1] = Dctx->RepOffset[0];
+      Dctx->RepOffset[0] = Offset;
+    } else {
+      RepIdx = Offset - 1;
+      if (LitLength == 0) {
+        RepIdx++;
+      }
+      if (RepIdx == 0) {
+        Offset = Dctx->RepOffset[0];
+      } else {
+        Offset = (RepIdx < 3) ? Dctx->RepOffset[RepIdx] : (Dctx->RepOffset[0] - 1);
+        if (RepIdx > 1) {
+          Dctx->RepOffset[2] = Dctx->RepOffset[1];
+        }
+        Dctx->RepOffset[1] = Dctx->RepOffset[0];
+        Dctx->RepOffset[0] = Offset;
+      }
+    }
+
+    // Copy the literals, then the match
+    if ((LitLength > (UINTN)(LitEnd - Literals)) || (LitLength > (UINTN)(Dctx->DstEnd - Dst))) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    CopyMem (Dst, Literals, LitLength);
+    Dst      += LitLength;
+    Literals += LitLength;
+
+    if ((Offset == 0) || (Offset > (UINTN)(Dst - Dctx->DstStart)) ||
+        (MatchLength > (UINTN)(Dctx->DstEnd - Dst))) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    Match = Dst - Offset;
+    if (Offset >= MatchLength) {
+      CopyMem (Dst, Match, MatchLength);
+      Dst += MatchLength;
+    } else {
+      while (MatchLength-- > 0) {
+        *Dst++ = *Match++;
+      }
+    }
+  }
+
+  if (Stream.BitPos != 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  // The remaining literals go after the last sequence
+  LitSize = (UINT32)(LitEnd - Literals);
+  if (LitSize > (UINTN)(Dctx->DstEnd - Dst)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  CopyMem (Dst, Literals, LitSize);
+  *Out = Dst + LitSize;
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decode a compressed block.
+
+  @param[in]      Dctx        The decoder context.
+  @param[in]      Src         The block content.
+  @param[in]      Size        The size of the block content.
+  @param[in, out] Out         The current output position.
+
+  @retval RETURN_SUCCESS            The block is decoded.
+  @retval RETURN_INVALID_PARAMETER  The block is corrupted.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdDecodeBlock (
+  IN     ZSTD_DCTX     *Dctx,
+  IN     CONST UINT8   *Src,
+  IN     UINTN          Size,
+  IN OUT UINT8        **Out
+  )
+{
+  CONST UINT8          *Literals;
+  UINT32                LitSize;
+  UINTN                 Pos;
+  UINTN                 Consumed;
+  UINT32                NumSeq;
+  UINT32                Modes;
+
+  if (ZstdDecodeLiterals (Dctx, Src, Size, &Literals, &LitSize, &Pos) != RETURN_SUCCESS) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  // Number of sequences
+  if (Pos >= Size) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  NumSeq = Src[Pos++];
+  if (NumSeq >= 128) {
+    if (NumSeq < 255) {
+      if (Pos + 1 > Size) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      NumSeq = ((NumSeq - 128) << 8) + Src[Pos];
+      Pos   += 1;
+    } else {
+      if (Pos + 2 > Size) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      NumSeq = Src[Pos] + ((UINT32)Src[Pos + 1] << 8) + 0x7F00;
+      Pos   += 2;
+    }
+  }
+
+  if (NumSeq == 0) {
+    if (LitSize > (UINTN)(Dctx->DstEnd - *Out)) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    CopyMem (*Out, Literals, LitSize);
+    *Out += LitSize;
+    return RETURN_SUCCESS;
+  }
+
+  // Symbol compression modes and the table descriptions
+  if (Pos >= Size) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  Modes = Src[Pos++];
+  if ((Modes & 3) != 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (ZstdSetupSequenceTable (Dctx, &Dctx->LlTable, (Modes >> 6) & 3, mLlDefaultFreq,
+                              ARRAY_SIZE (mLlDefaultFreq), 6, ZSTD_LL_MAX_LOG, ZSTD_LL_SYMBOLS,
+                              Src + Pos, Size - Pos, &Consumed) != RETURN_SUCCESS) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  Pos += Consumed;
+
+  if (ZstdSetupSequenceTable (Dctx, &Dctx->OfTable, (Modes >> 4) & 3, mOfDefaultFreq,
+                              ARRAY_SIZE (mOfDefaultFreq), 5, ZSTD_OF_MAX_LOG, ZSTD_OF_SYMBOLS,
+                              Src + Pos, Size - Pos, &Consumed) != RETURN_SUCCESS) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  Pos += Consumed;
+
+  if (ZstdSetupSequenceTable (Dctx, &Dctx->MlTable, (Modes >> 2) & 3, mMlDefaultFreq,
+                              ARRAY_SIZE (mMlDefaultFreq), 6, ZSTD_ML_MAX_LOG, ZSTD_ML_SYMBOLS,
+                              Src + Pos, Size - Pos, &Consumed) != RETURN_SUCCESS) {
+    return RETURN_INVALID_PARAMETER;
+  }
+  Pos += Consumed;
+
+  return ZstdExecuteSequences (Dctx, Src + Pos, Size - Pos, NumSeq, Literals, LitSize, Out);
+}
+
+/**
+  Parse the frame header.
+
+  @param[in]  Source        The compressed data.
+  @param[in]  SourceSize    The size of the compressed data.
+  @param[out] HeaderSize    The size of the frame header.
+  @param[out] ContentSize   The decompressed size recorded in the frame.
+  @param[out] HasChecksum   Whether the frame ends with a content checksum.
+
+  @retval RETURN_SUCCESS            The frame header is parsed.
+  @retval RETURN_UNSUPPORTED        The frame needs a dictionary or has no content size.
+  @retval RETURN_INVALID_PARAMETER  The frame header is not valid.
+
+**/
+STATIC
+RETURN_STATUS
+ZstdParseFrameHeader (
+  IN  CONST UINT8      *Source,
+  IN  UINTN             SourceSize,
+  OUT UINTN            *HeaderSize,
+  OUT UINT32           *ContentSize,
+  OUT BOOLEAN          *HasChecksum
+  )
+{
+  STATIC CONST UINT8    DictIdSize[4] = { 0, 1, 2, 4 };
+  STATIC CONST UINT8    FcsSize[4]    = { 0, 2, 4, 8 };
+  UINT8                 Descriptor;
+  UINTN                 Pos;
+  UINT32                DictSize;
+  UINT32                ContentFieldSize;
+  UINT32                Index;
+  UINT32                DictId;
+
+  if ((Source == NULL) || (SourceSize < 5) || (ReadUnaligned32 ((CONST UINT32 *)Source) != ZSTD_MAGIC_NUMBER)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Descriptor = Source[4];
+  if ((Descriptor & BIT3) != 0) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Pos = 5;
+  if ((Descriptor & BIT5) == 0) {
+    // Window descriptor, not needed when decoding into a flat buffer
+    Pos++;
+  }
+  DictSize         = DictIdSize[Descriptor & 3];
+  ContentFieldSize = FcsSize[Descriptor >> 6];
+  if ((ContentFieldSize == 0) && ((Descriptor & BIT5) != 0)) {
+    ContentFieldSize = 1;
+  }
+  if (Pos + DictSize + ContentFieldSize > SourceSize) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  DictId = 0;
+  for (Index = 0; Index < DictSize; Index++) {
+    DictId |= (UINT32)Source[Pos + Index] << (Index * 8);
+  }
+  Pos += DictSize;
+  if ((DictId != 0) || (ContentFieldSize == 0)) {
+    return RETURN_UNSUPPORTED;
+  }
+
+  switch (ContentFieldSize) {
+  case 1:
+    *ContentSize = Source[Pos];
+    break;
+  case 2:
+    *ContentSize = ReadUnaligned16 ((CONST UINT16 *)(Source + Pos)) + 256;
+    break;
+  case 4:
+    *ContentSize = ReadUnaligned32 ((CONST UINT32 *)(Source + Pos));
+    break;
+  default:
+    if (ReadUnaligned32 ((CONST UINT32 *)(Source + Pos + 4)) != 0) {
+      return RETURN_UNSUPPORTED;
+    }
+    *ContentSize = ReadUnaligned32 ((CONST UINT32 *)(Source + Pos));
+    break;
+  }
+
+  *HeaderSize  = Pos + ContentFieldSize;
+  *HasChecksum = (BOOLEAN)((Descriptor & BIT2) != 0);
+  return RETURN_SUCCESS;
+}
+
+/**
+  Get the size of the literal buffer for a frame.
+
+  @param[in] ContentSize   The decompressed size of the frame.
+
+  @retval    The literal buffer size.
+
+**/
+STATIC
+UINT32
+ZstdGetLitBufferSize (
+  IN UINT32   ContentSize
+  )
+{
+  return MIN (ContentSize, ZSTD_BLOCK_SIZE_MAX);
+}
+
+/**
+  Given a Zstandard compressed source buffer, this function retrieves the size of
+  the uncompressed buffer and the size of the scratch buffer required
+  to decompress the compressed source buffer.
+
+  The source must hold a single Zstandard frame that records its content size
+  and does not depend on a dictionary. The scratch buffer holds the decoding
+  tables and the literals of one block.
+
+  @param  Source          The source buffer containing the compressed data.
+  @param  SourceSize      The size, in bytes, of the source buffer.
+  @param  DestinationSize A pointer to the size, in bytes, of the uncompressed buffer
+                          that will be generated when the compressed buffer specified
+                          by Source and SourceSize is decompressed.
+  @param  ScratchSize     A pointer to the size, in bytes, of the scratch buffer that
+                          is required to decompress the compressed buffer specified
+                          by Source and SourceSize.
+
+  @retval  RETURN_SUCCESS The size of the uncompressed data was returned
+                          in DestinationSize and the size of the scratch
+                          buffer was returned in ScratchSize.
+  @retval  RETURN_UNSUPPORTED
+                          The frame needs a dictionary or does not record
+                          its content size.
+  @retval  RETURN_INVALID_PARAMETER
+                          The source buffer is not a valid Zstandard frame.
+
+**/
+RETURN_STATUS
+EFIAPI
+ZstdDecompressGetInfo (
+  IN  CONST VOID  *Source,
+  IN  UINT32       SourceSize,
+  OUT UINT32      *DestinationSize,
+  OUT UINT32      *ScratchSize
+  )
+{
+  RETURN_STATUS    Status;
+  UINTN            HeaderSize;
+  UINT32           ContentSize;
+  BOOLEAN          HasChecksum;
+
+  Status = ZstdParseFrameHeader (Source, SourceSize, &HeaderSize, &ContentSize, &HasChecksum);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+
+  if (DestinationSize != NULL) {
+    *DestinationSize = ContentSize;
+  }
+
+  if (ScratchSize != NULL) {
+    *ScratchSize = sizeof (ZSTD_DCTX) + ZstdGetLitBufferSize (ContentSize);
+  }
+
+  return RETURN_SUCCESS;
+}
+
+/**
+  Decompresses a Zstandard compressed source buffer.
+
+  Extracts decompressed data to its original form.
+  If the compressed source data specified by Source is successfully decompressed
+  into Destination, then RETURN_SUCCESS is returned.  If the compressed source data
+  specified by Source is not in a valid compressed data format,
+  then RETURN_INVALID_PARAMETER is returned.
+
+  @param  Source      The source buffer containing the compressed data.
+  @param  SourceSize  The size of source buffer.
+  @param  Destination The destination buffer to store the decompressed data
+  @param  Scratch     A temporary scratch buffer that is used to perform the decompression.
+                      Its size is given by ZstdDecompressGetInfo ().
+
+  @retval  RETURN_SUCCESS Decompression completed successfully, and
+                          the uncompressed buffer is returned in Destination.
+  @retval  RETURN_UNSUPPORTED
+                          The frame needs a dictionary or does not record
+                          its content size.
+  @retval  RETURN_INVALID_PARAMETER
+                          The source buffer specified by Source is corrupted
+                          (not in a valid compressed format).
+**/
+RETURN_STATUS
+EFIAPI
+ZstdDecompress (
+  IN CONST VOID  *Source,
+  IN UINTN       SourceSize,
+  IN OUT VOID    *Destination,
+  IN OUT VOID    *Scratch
+  )
+{
+  RETURN_STATUS    Status;
+  ZSTD_DCTX       *Dctx;
+  CONST UINT8     *Src;
+  UINTN            Pos;
+  UINT32           ContentSize;
+  BOOLEAN          HasChecksum;
+  BOOLEAN          LastBlock;
+  UINT32           BlockHeader;
+  UINT32           BlockType;
+  UINT32           BlockSize;
+  UINT8           *Out;
+
+  Status = ZstdParseFrameHeader (Source, SourceSize, &Pos, &ContentSize, &HasChecksum);
+  if (RETURN_ERROR (Status)) {
+    return Status;
+  }
+  if ((Scratch == NULL) || ((Destination == NULL) && (ContentSize > 0))) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  Dctx = (ZSTD_DCTX *)Scratch;
+  Dctx->LlTable.Entry = Dctx->LlEntry;
+  Dctx->LlTable.Valid = FALSE;
+  Dctx->OfTable.Entry = Dctx->OfEntry;
+  Dctx->OfTable.Valid = FALSE;
+  Dctx->MlTable.Entry = Dctx->MlEntry;
+  Dctx->MlTable.Valid = FALSE;
+  Dctx->HufValid      = FALSE;
+  Dctx->RepOffset[0]  = 1;
+  Dctx->RepOffset[1]  = 4;
+  Dctx->RepOffset[2]  = 8;
+  Dctx->LitBuffer     = (UINT8 *)(Dctx + 1);
+  Dctx->LitBufferSize = ZstdGetLitBufferSize (ContentSize);
+  Dctx->DstStart      = (UINT8 *)Destination;
+  Dctx->DstEnd        = Dctx->DstStart + ContentSize;
+
+  Src = (CONST UINT8 *)Source;
+  Out = Dctx->DstStart;
+  do {
+    if (ZSTD_BLOCK_HEADER_SIZE > SourceSize - Pos) {
+      return RETURN_INVALID_PARAMETER;
+    }
+    BlockHeader = Src[Pos] | ((UINT32)Src[Pos + 1] << 8) | ((UINT32)Src[Pos + 2] << 16);
+    Pos        += ZSTD_BLOCK_HEADER_SIZE;
+    LastBlock   = (BOOLEAN)((BlockHeader & 1) != 0);
+    BlockType   = (BlockHeader >> 1) & 3;
+    BlockSize   = BlockHeader >> 3;
+    if (BlockSize > ZSTD_BLOCK_SIZE_MAX) {
+      return RETURN_INVALID_PARAMETER;
+    }
+
+    switch (BlockType) {
+    case ZSTD_BLOCK_RAW:
+      if ((BlockSize > SourceSize - Pos) || (BlockSize > (UINTN)(Dctx->DstEnd - Out))) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      CopyMem (Out, Src + Pos, BlockSize);
+      Out += BlockSize;
+      Pos += BlockSize;
+      break;
+
+    case ZSTD_BLOCK_RLE:
+      if ((Pos >= SourceSize) || (BlockSize > (UINTN)(Dctx->DstEnd - Out))) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      SetMem (Out, BlockSize, Src[Pos]);
+      Out += BlockSize;
+      Pos += 1;
+      break;
+
+    case ZSTD_BLOCK_COMPRESSED:
+      if (BlockSize > SourceSize - Pos) {
+        return RETURN_INVALID_PARAMETER;
+      }
+      Status = ZstdDecodeBlock (Dctx, Src + Pos, BlockSize, &Out);
+      if (RETURN_ERROR (Status)) {
+        return Status;
+      }
+      Pos += BlockSize;
+      break;
+
+    default:
+      return RETURN_INVALID_PARAMETER;
+    }
+  } while (!LastBlock);
+
+  // The content checksum is not verified since the image has been authenticated
+  if (HasChecksum && (Pos + 4 > SourceSize)) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  if (Out != Dctx->DstEnd) {
+    return RETURN_INVALID_PARAMETER;
+  }
+
+  return RETURN_SUCCESS;
+}
@@ -76,6 +76,22 @@ AcpiInit (
   IN  UINT32    *AcpiMemTop
   );
 
+/**
+  Get FPDT boot performance table by searching ACPI table
+
+  The boot performance table created by AcpiInit() has room for
+  MAX_PERF_SPAN_NUM span records after the basic boot record.
+
+  @param[in]  AcpiTableBase    ACPI table base address
+
+  @retval Boot performance table address     Value 0 means not found.
+**/
+UINTN
+EFIAPI
+GetFpdtBootTable (
+  IN  UINT32    AcpiTableBase
+  );
+
 /**
   Update ACPI FPDT S3 performance record table.
 
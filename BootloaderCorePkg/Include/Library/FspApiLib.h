@@ -24,6 +24,8 @@
 
   @param[in] FspmBase                 The base address of FSPM.
   @param[out] HobListPtr              Pointer to receive the address of the HOB list.
+  @param[in] EventHandler             Optional handler for the events reported by FSP-M.
+                                      It is only installed if FSP-M supports it.
 
   @retval EFI_SUCCESS                 FSP execution environment was initialized successfully.
   @retval EFI_INVALID_PARAMETER       Input parameters are invalid.
@@ -36,7 +38,8 @@ EFI_STATUS
 EFIAPI
 CallFspMemoryInit (
   UINT32                     FspmBase,
-  VOID                       **HobList
+  VOID                       **HobList,
+  FSP_EVENT_HANDLER          EventHandler  OPTIONAL
   );
 
 /**
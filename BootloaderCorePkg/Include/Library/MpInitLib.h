@@ -100,6 +100,54 @@ MpRunTask (
   );
 
 
+/**
+  Get the number of CPUs that can run jobs, including the BSP.
+
+  @retval    CPU count. 1 means jobs will run on the BSP only.
+
+**/
+UINT32
+EFIAPI
+MpGetWorkerCount (
+  VOID
+  );
+
+/**
+  Submit a job to the AP worker pool.
+
+  The job is picked up by the first idle AP, or by the BSP while it waits in
+  MpWaitAllJobs. A job function runs on an AP with a small stack. It must not
+  allocate memory, print debug messages or access any hardware that is not
+  owned by the job itself. Jobs must not submit other jobs.
+
+  @param[in]  TaskFunc    Job function pointer.
+  @param[in]  Argument    Argument for the job function.
+
+  @retval EFI_INVALID_PARAMETER   TaskFunc is NULL.
+  @retval EFI_SUCCESS             The job has been queued.
+
+**/
+EFI_STATUS
+EFIAPI
+MpSubmitJob (
+  IN  CPU_TASK_FUNC  TaskFunc,
+  IN  UINT64         Argument
+  );
+
+/**
+  Wait for all submitted jobs to complete.
+
+  The BSP also runs queued jobs while waiting.
+
+  @retval EFI_SUCCESS             All submitted jobs have completed.
+
+**/
+EFI_STATUS
+EFIAPI
+MpWaitAllJobs (
+  VOID
+  );
+
 /**
   Dump MP task state
 
@@ -30,6 +30,7 @@ typedef  VOID   (EFIAPI *PAYLOAD_ENTRY) (VOID *HobList, VOID *Params);
 #define  STAGE_GDT_ENTRY_COUNT        7
 
 #define  PLATFORM_NAME_SIZE           8
+#define  MEM_POOL_CLASS_NUM           16
 
 typedef enum {
   EnumBufFlashMap,
@@ -94,6 +95,7 @@ typedef struct {
   UINT8         ConfigDataHash[HASH_DIGEST_MAX];
   UINT8         KeyHashManifestHashValid;
   UINT8         KeyHashManifestHash[HASH_DIGEST_MAX];
+  UINT32        Stage2Staging;
 } STAGE1B_PARAM;
 
 typedef struct {
@@ -195,6 +197,9 @@ typedef struct {
   UINT32            CarBase;
   UINT32            CarSize;
   UINT32            MemPoolMaxUsed;
+  UINT32            MemPoolFreePages;
+  UINT32            MemPoolFreeList[MEM_POOL_CLASS_NUM];
+  VOID             *ImageCachePtr;
 } LOADER_GLOBAL_DATA;
 
 /**
@@ -12,6 +12,7 @@
 #include <Library/BootloaderCoreLib.h>
 #include <Library/AcpiInitLib.h>
 #include <Library/TimeStampLib.h>
+#include <Library/LoaderPerformanceLib.h>
 
 BOOT_PERFORMANCE_TABLE mBootPerformanceTableTemplate = {
   {
@@ -86,14 +87,15 @@ UpdateFpdtBootTable (
 
 
 /**
-  Get FPDT S3 performance table by searching ACPI table
+  Find FPDT table by searching ACPI table
 
   @param[in]  AcpiTableBase    ACPI table base address
 
-  @retval S3 performance table address     Value 0 means not found.
+  @retval FPDT table pointer     NULL means not found.
 **/
-UINTN
-GetFpdtS3Table (
+STATIC
+FIRMWARE_PERFORMANCE_TABLE *
+FindFpdt (
   IN  UINT32                                   AcpiTableBase
   )
 {
@@ -102,9 +104,7 @@ GetFpdtS3Table (
   EFI_ACPI_COMMON_HEADER                       *Hdr;
   UINT32                                       *RsdtEntry;
   UINT32                                       NumEntries;
-  FIRMWARE_PERFORMANCE_TABLE                   *Fpdt;
   UINT8                                        Index;
-  BOOT_PERFORMANCE_TABLE                       *BootTable;
 
   Rsdp = (EFI_ACPI_5_0_ROOT_SYSTEM_DESCRIPTION_POINTER *)(UINTN)AcpiTableBase;
   Rsdt = (EFI_ACPI_DESCRIPTION_HEADER *)(UINTN)Rsdp->RsdtAddress;
@@ -114,22 +114,72 @@ GetFpdtS3Table (
   for (Index = 0; Index < NumEntries; Index++) {
     Hdr = (EFI_ACPI_COMMON_HEADER *) (UINTN) RsdtEntry[Index];
     if (Hdr->Signature == EFI_ACPI_5_0_FIRMWARE_PERFORMANCE_DATA_TABLE_SIGNATURE) {
-      Fpdt = (FIRMWARE_PERFORMANCE_TABLE *) Hdr;
-      BootTable = (BOOT_PERFORMANCE_TABLE *)(UINTN)Fpdt->BootPointerRecord.BootPerformanceTablePointer;
-      DEBUG ((DEBUG_VERBOSE, "FPDT: ResetEnd                = %ld\n", BootTable->BasicBoot.ResetEnd));
-      DEBUG ((DEBUG_VERBOSE, "FPDT: OsLoaderLoadImageStart  = %ld\n", BootTable->BasicBoot.OsLoaderLoadImageStart));
-      DEBUG ((DEBUG_VERBOSE, "FPDT: OsLoaderStartImageStart = %ld\n", BootTable->BasicBoot.OsLoaderStartImageStart));
-      DEBUG ((DEBUG_VERBOSE, "FPDT: ExitBootServicesEntry   = %ld\n", BootTable->BasicBoot.ExitBootServicesEntry));
-      DEBUG ((DEBUG_VERBOSE, "FPDT: ExitBootServicesExit    = %ld\n", BootTable->BasicBoot.ExitBootServicesExit));
-
-      return (UINTN)Fpdt->S3PointerRecord.S3PerformanceTablePointer;
+      return (FIRMWARE_PERFORMANCE_TABLE *) Hdr;
     }
   }
 
+  return NULL;
+}
+
+
+/**
+  Get FPDT S3 performance table by searching ACPI table
+
+  @param[in]  AcpiTableBase    ACPI table base address
+
+  @retval S3 performance table address     Value 0 means not found.
+**/
+UINTN
+GetFpdtS3Table (
+  IN  UINT32                                   AcpiTableBase
+  )
+{
+  FIRMWARE_PERFORMANCE_TABLE                   *Fpdt;
+  BOOT_PERFORMANCE_TABLE                       *BootTable;
+
+  Fpdt = FindFpdt (AcpiTableBase);
+  if (Fpdt != NULL) {
+    BootTable = (BOOT_PERFORMANCE_TABLE *)(UINTN)Fpdt->BootPointerRecord.BootPerformanceTablePointer;
+    DEBUG ((DEBUG_VERBOSE, "FPDT: ResetEnd                = %ld\n", BootTable->BasicBoot.ResetEnd));
+    DEBUG ((DEBUG_VERBOSE, "FPDT: OsLoaderLoadImageStart  = %ld\n", BootTable->BasicBoot.OsLoaderLoadImageStart));
+    DEBUG ((DEBUG_VERBOSE, "FPDT: OsLoaderStartImageStart = %ld\n", BootTable->BasicBoot.OsLoaderStartImageStart));
+    DEBUG ((DEBUG_VERBOSE, "FPDT: ExitBootServicesEntry   = %ld\n", BootTable->BasicBoot.ExitBootServicesEntry));
+    DEBUG ((DEBUG_VERBOSE, "FPDT: ExitBootServicesExit    = %ld\n", BootTable->BasicBoot.ExitBootServicesExit));
+
+    return (UINTN)Fpdt->S3PointerRecord.S3PerformanceTablePointer;
+  }
+
   return 0;
 }
 
 
+/**
+  Get FPDT boot performance table by searching ACPI table
+
+  The boot performance table created by AcpiInit() has room for
+  MAX_PERF_SPAN_NUM span records after the basic boot record.
+
+  @param[in]  AcpiTableBase    ACPI table base address
+
+  @retval Boot performance table address     Value 0 means not found.
+**/
+UINTN
+EFIAPI
+GetFpdtBootTable (
+  IN  UINT32                                   AcpiTableBase
+  )
+{
+  FIRMWARE_PERFORMANCE_TABLE                   *Fpdt;
+
+  Fpdt = FindFpdt (AcpiTableBase);
+  if (Fpdt == NULL) {
+    return 0;
+  }
+
+  return (UINTN)Fpdt->BootPointerRecord.BootPerformanceTablePointer;
+}
+
+
 /**
   Update ACPI FPDT S3 performance record table.
 
@@ -208,13 +258,15 @@ UpdateFpdt (
   if (BootMode != BOOT_ON_S3_RESUME) {
     Fpdt          = (FIRMWARE_PERFORMANCE_TABLE *)Table;
     BootPerfTable = (BOOT_PERFORMANCE_TABLE *) (Fpdt + 1);
-    S3PerfTable   = (S3_PERFORMANCE_TABLE *) (BootPerfTable + 1);
+    S3PerfTable   = (S3_PERFORMANCE_TABLE *) ((UINT8 *) (BootPerfTable + 1) +
+                                             MAX_PERF_SPAN_NUM * sizeof (FPDT_LOADER_SPAN_RECORD));
 
     Fpdt->BootPointerRecord.BootPerformanceTablePointer = (UINT64) (UINTN) BootPerfTable;
     Fpdt->S3PointerRecord.S3PerformanceTablePointer     = (UINT64) (UINTN) S3PerfTable;
     CopyMem (BootPerfTable, &mBootPerformanceTableTemplate, sizeof (mBootPerformanceTableTemplate));
     CopyMem (S3PerfTable, &mS3PerformanceTableTemplate, sizeof (mS3PerformanceTableTemplate));
     UpdateFpdtBootTable (BootPerfTable);
+    UpdateFpdtSpanRecords (&BootPerfTable->Header, GetPerfDataPtr ());
 
     if (ExtraSize != NULL) {
       *ExtraSize = (UINT32)((UINT8 *) (S3PerfTable + 1) - Table - Fpdt->Header.Length);
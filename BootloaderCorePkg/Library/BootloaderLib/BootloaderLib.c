@@ -235,6 +235,21 @@ GetHashStorePtr (
   return GetLoaderGlobalDataPointer()->HashStorePtr;
 }
 
+/**
+  This function retrieves the image cache pointer.
+
+  @retval    The image cache pointer, or NULL if there is no image cache.
+
+**/
+VOID *
+EFIAPI
+GetImageCachePtr (
+  VOID
+  )
+{
+  return GetLoaderGlobalDataPointer()->ImageCachePtr;
+}
+
 /**
   This function retrieves features configuration.
 
@@ -23,6 +23,8 @@
 
   @param[in] FspmBase                 The base address of FSPM.
   @param[out] HobListPtr              Pointer to receive the address of the HOB list.
+  @param[in] EventHandler             Optional handler for the events reported by FSP-M.
+                                      It is only installed if FSP-M supports it.
 
   @retval EFI_SUCCESS                 FSP execution environment was initialized successfully.
   @retval EFI_INVALID_PARAMETER       Input parameters are invalid.
@@ -35,7 +37,8 @@ EFI_STATUS
 EFIAPI
 CallFspMemoryInit (
   UINT32                     FspmBase,
-  VOID                       **HobList
+  VOID                       **HobList,
+  FSP_EVENT_HANDLER          EventHandler  OPTIONAL
   )
 {
   UINT8                       FspmUpd[FixedPcdGet32 (PcdFSPMUpdSize)];
@@ -60,6 +63,10 @@ CallFspMemoryInit (
   FspmUpdCommon->FspmArchUpd.BootLoaderTolumSize = 0;
   FspmUpdCommon->FspmArchUpd.BootMode            = (UINT32)GetBootMode();
   FspmUpdCommon->FspmArchUpd.NvsBufferPtr        = (UINT32)(UINTN)FindNvsData();
+  // The event handler field only exists from FSP 2.2 on
+  if ((EventHandler != NULL) && (FspmUpdCommon->FspmArchUpd.Revision >= 2)) {
+    FspmUpdCommon->FspmArchUpd.FspEventHandler   = (UINT32)(UINTN)EventHandler;
+  }
 
   UpdateFspConfig (FspmUpd);
 
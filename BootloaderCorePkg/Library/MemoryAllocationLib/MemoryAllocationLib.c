@@ -9,12 +9,35 @@
 
 
 #include <PiPei.h>
+#include <Library/BaseLib.h>
 #include <Library/MemoryAllocationLib.h>
 #include <Library/BaseMemoryLib.h>
 #include <Library/DebugLib.h>
 #include <BootloaderCoreGlobal.h>
 
 #define   POOL_MIN_ALIGNMENT    0x10
+#define   POOL_HEAD_SIGNATURE   SIGNATURE_32 ('p', 'h', 'd', '0')
+#define   POOL_CLASS_SHIFT      5
+#define   POOL_CLASS_SEARCH     3
+
+//
+// Every pool block is prefixed by this header so that it can be freed.
+// Freed blocks are linked into the size class lists through Next.
+//
+typedef struct {
+  UINT32    Signature;
+  UINT32    Size;
+  UINT32    Next;
+  UINT32    Reserved;
+} POOL_HEAD;
+
+//
+// Freed page runs are linked through the first bytes of the run.
+//
+typedef struct {
+  UINT32    Next;
+  UINT32    Pages;
+} FREE_PAGE_RUN;
 
 /**
   Update the Memory pool top address.
@@ -62,13 +85,171 @@ InternalUpdateMemPoolBottom (
   LdrGlobal->MemPoolCurrBottom = Bottom;
 }
 
+/**
+  Check if a buffer is inside the permanent memory pool in use.
+
+  Buffers allocated from a previous memory pool, such as the one in CAR
+  before memory migration, are not in the range and cannot be freed.
+
+  @param[in] Buffer   Buffer address.
+  @param[in] Size     Buffer size.
+
+  @retval TRUE        The buffer is inside the used permanent memory pool.
+  @retval FALSE       The buffer is not inside the used permanent memory pool.
+**/
+STATIC
+BOOLEAN
+InternalIsInMemPool (
+  IN UINT32  Buffer,
+  IN UINT32  Size
+  )
+{
+  LOADER_GLOBAL_DATA  *LdrGlobal;
+
+  LdrGlobal = GetLoaderGlobalDataPointer();
+  return (Buffer >= LdrGlobal->MemPoolCurrTop) && (Size <= LdrGlobal->MemPoolEnd - Buffer);
+}
+
+/**
+  Get the size class index for a pool block.
+
+  Size class N holds the freed blocks whose size is at least 2^(N + 5) bytes.
+  The last class holds all the remaining larger blocks.
+
+  @param[in] Size     Pool block size including the header.
+
+  @retval  Size class index.
+**/
+STATIC
+UINT32
+InternalGetPoolClass (
+  IN UINT32  Size
+  )
+{
+  UINT32  Class;
+
+  Class = (UINT32)HighBitSet32 (Size);
+  Class = (Class > POOL_CLASS_SHIFT) ? (Class - POOL_CLASS_SHIFT) : 0;
+  return MIN (Class, MEM_POOL_CLASS_NUM - 1);
+}
+
+/**
+  Give back the free memory that is adjacent to the permanent pool top.
+
+  Freed page runs that start at the current pool top are merged back
+  into the pool so that the pool top can move up again.
+**/
+STATIC
+VOID
+InternalReclaimMemPoolTop (
+  VOID
+  )
+{
+  LOADER_GLOBAL_DATA  *LdrGlobal;
+  FREE_PAGE_RUN       *Run;
+  UINT32              *Link;
+  BOOLEAN              Merged;
+
+  LdrGlobal = GetLoaderGlobalDataPointer();
+  do {
+    Merged = FALSE;
+    Link   = &LdrGlobal->MemPoolFreePages;
+    while (*Link != 0) {
+      Run = (FREE_PAGE_RUN *)(UINTN)*Link;
+      if ((UINT32)(UINTN)Run == LdrGlobal->MemPoolCurrTop) {
+        *Link = Run->Next;
+        InternalUpdateMemPoolTop (LdrGlobal->MemPoolCurrTop + Run->Pages * EFI_PAGE_SIZE);
+        Merged = TRUE;
+        break;
+      }
+      Link = &Run->Next;
+    }
+  } while (Merged);
+}
+
+/**
+  Allocate a pool block from the size class free lists.
+
+  @param[in] Size     Pool block size including the header.
+
+  @retval  A pointer to the pool block or NULL if no freed block fits.
+**/
+STATIC
+POOL_HEAD *
+InternalAllocateFreePool (
+  IN UINT32  Size
+  )
+{
+  LOADER_GLOBAL_DATA  *LdrGlobal;
+  POOL_HEAD           *Head;
+  UINT32              *Link;
+  UINT32               Class;
+  UINT32               Last;
+
+  LdrGlobal = GetLoaderGlobalDataPointer();
+  Class     = InternalGetPoolClass (Size);
+  Last      = MIN (Class + POOL_CLASS_SEARCH, MEM_POOL_CLASS_NUM - 1);
+
+  // Blocks in the same class might be smaller, so search for the first fit.
+  // Blocks in the higher classes always fit, but avoid wasting too much.
+  for (; Class <= Last; Class++) {
+    Link = &LdrGlobal->MemPoolFreeList[Class];
+    while (*Link != 0) {
+      Head = (POOL_HEAD *)(UINTN)*Link;
+      if (Head->Size >= Size) {
+        *Link      = Head->Next;
+        Head->Next = 0;
+        return Head;
+      }
+      Link = &Head->Next;
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Allocate pages from the freed page runs.
+
+  @param[in] Pages    The number of 4 KB pages to allocate.
+
+  @retval  A pointer to the allocated pages or NULL if no freed run fits.
+**/
+STATIC
+VOID *
+InternalAllocateFreePages (
+  IN UINTN  Pages
+  )
+{
+  LOADER_GLOBAL_DATA  *LdrGlobal;
+  FREE_PAGE_RUN       *Run;
+  UINT32              *Link;
+
+  LdrGlobal = GetLoaderGlobalDataPointer();
+  Link      = &LdrGlobal->MemPoolFreePages;
+  while (*Link != 0) {
+    Run = (FREE_PAGE_RUN *)(UINTN)*Link;
+    if (Run->Pages == Pages) {
+      *Link = Run->Next;
+      return Run;
+    } else if (Run->Pages > Pages) {
+      // Split the run and hand out its upper part
+      Run->Pages -= (UINT32)Pages;
+      return (UINT8 *)Run + Run->Pages * EFI_PAGE_SIZE;
+    }
+    Link = &Run->Next;
+  }
+
+  return NULL;
+}
+
 /**
   Allocates a buffer of type EfiBootServicesData.
 
   Allocates the number bytes specified by AllocationSize of type EfiBootServicesData and returns a
-  pointer to the allocated buffer.  If AllocationSize is 0, LdrGlobal->MemPoolCurrTop is returned.
-  If there is not enough memory remaining to satisfy the request, InternalUpdateMemPoolTop ASSERTS
-  and the function does not return.
+  pointer to the allocated buffer.  A previously freed buffer is reused if one fits, otherwise the
+  buffer is carved from LdrGlobal->MemPoolCurrTop. If there is not enough memory remaining to
+  satisfy the request, InternalUpdateMemPoolTop ASSERTS and the function does not return.
 
   @param  AllocationSize        The number of bytes to allocate.
 
@@ -82,23 +263,32 @@ AllocatePool (
   )
 {
   LOADER_GLOBAL_DATA  *LdrGlobal;
+  POOL_HEAD           *Head;
+  UINT32               Size;
   UINT32               Top;
 
-  LdrGlobal = GetLoaderGlobalDataPointer();
-  Top  = LdrGlobal->MemPoolCurrTop;
-  Top -= (UINT32)AllocationSize;
-  Top  = ALIGN_DOWN (Top, POOL_MIN_ALIGNMENT);
-  InternalUpdateMemPoolTop (Top);
-  return (VOID *)(UINTN)Top;
+  Size = (UINT32)ALIGN_UP (AllocationSize + sizeof (POOL_HEAD), POOL_MIN_ALIGNMENT);
+  Head = InternalAllocateFreePool (Size);
+  if (Head == NULL) {
+    LdrGlobal = GetLoaderGlobalDataPointer();
+    Top  = LdrGlobal->MemPoolCurrTop;
+    Top -= Size;
+    Top  = ALIGN_DOWN (Top, POOL_MIN_ALIGNMENT);
+    InternalUpdateMemPoolTop (Top);
+    Head = (POOL_HEAD *)(UINTN)Top;
+    Head->Size = Size;
+    Head->Next = 0;
+  }
+  Head->Signature = POOL_HEAD_SIGNATURE;
+  return (VOID *)(Head + 1);
 }
 
 /**
   Allocates and zeros a buffer of type EfiBootServicesData.
 
   Allocates the number bytes specified by AllocationSize of type EfiBootServicesData, clears the
-  buffer with zeros, and returns a pointer to the allocated buffer.  If AllocationSize is 0,
-  LdrGlobal->MemPoolCurrTop is returned. If there is not enough memory remaining to satisfy the
-  request, InternalUpdateMemPoolTop ASSERTS and the function does not return.
+  buffer with zeros, and returns a pointer to the allocated buffer. If there is not enough memory
+  remaining to satisfy the request, InternalUpdateMemPoolTop ASSERTS and the function does not return.
 
   @param  AllocationSize        The number of bytes to allocate and zero.
 
@@ -140,12 +330,18 @@ AllocatePages (
   )
 {
   LOADER_GLOBAL_DATA  *LdrGlobal;
+  VOID                *Buffer;
   UINT32               Top;
 
   if (Pages == 0) {
     return NULL;
   }
 
+  Buffer = InternalAllocateFreePages (Pages);
+  if (Buffer != NULL) {
+    return Buffer;
+  }
+
   LdrGlobal = GetLoaderGlobalDataPointer();
   Top  = LdrGlobal->MemPoolCurrTop;
   Top  = ALIGN_DOWN (Top, EFI_PAGE_SIZE);
@@ -261,6 +457,9 @@ FreeTemporaryMemory (
   Allocation Library.  If it is not possible to free allocated pages, then this function will
   perform no actions.
 
+  The pages are given back to the pool directly if they are at the pool top. Otherwise they
+  are kept in the freed page run list and reused by later page allocations.
+
   If Buffer was not allocated with a page allocation function in the Memory Allocation Library,
   then ASSERT().
   If Pages is zero, then ASSERT().
@@ -276,6 +475,27 @@ FreePages (
   IN UINTN  Pages
   )
 {
+  LOADER_GLOBAL_DATA  *LdrGlobal;
+  FREE_PAGE_RUN       *Run;
+  UINT32               Base;
+
+  ASSERT (Pages != 0);
+
+  Base = (UINT32)(UINTN)Buffer;
+  if ((Pages == 0) || ((Base & EFI_PAGE_MASK) != 0) || !InternalIsInMemPool (Base, (UINT32)Pages * EFI_PAGE_SIZE)) {
+    return;
+  }
+
+  LdrGlobal = GetLoaderGlobalDataPointer();
+  if (Base == LdrGlobal->MemPoolCurrTop) {
+    InternalUpdateMemPoolTop (Base + (UINT32)Pages * EFI_PAGE_SIZE);
+    InternalReclaimMemPoolTop ();
+  } else {
+    Run        = (FREE_PAGE_RUN *)Buffer;
+    Run->Pages = (UINT32)Pages;
+    Run->Next  = LdrGlobal->MemPoolFreePages;
+    LdrGlobal->MemPoolFreePages = Base;
+  }
 }
 
 /**
@@ -286,6 +506,9 @@ FreePages (
   pool allocation services of the Memory Allocation Library.  If it is not possible to free pool
   resources, then this function will perform no actions.
 
+  The buffer is given back to the pool directly if it is at the pool top. Otherwise it is kept
+  in a size class free list and reused by later pool allocations.
+
   If Buffer was not allocated with a pool allocation function in the Memory Allocation Library,
   then ASSERT().
 
@@ -298,6 +521,30 @@ FreePool (
   IN VOID   *Buffer
   )
 {
+  LOADER_GLOBAL_DATA  *LdrGlobal;
+  POOL_HEAD           *Head;
+  UINT32               Class;
+
+  if (Buffer == NULL) {
+    return;
+  }
+
+  Head = (POOL_HEAD *)Buffer - 1;
+  if (!InternalIsInMemPool ((UINT32)(UINTN)Head, sizeof (POOL_HEAD)) || (Head->Signature != POOL_HEAD_SIGNATURE)
+      || !InternalIsInMemPool ((UINT32)(UINTN)Head, Head->Size)) {
+    return;
+  }
+
+  Head->Signature = 0;
+  LdrGlobal = GetLoaderGlobalDataPointer();
+  if ((UINT32)(UINTN)Head == LdrGlobal->MemPoolCurrTop) {
+    InternalUpdateMemPoolTop ((UINT32)(UINTN)Head + Head->Size);
+    InternalReclaimMemPoolTop ();
+  } else {
+    Class      = InternalGetPoolClass (Head->Size);
+    Head->Next = LdrGlobal->MemPoolFreeList[Class];
+    LdrGlobal->MemPoolFreeList[Class] = (UINT32)(UINTN)Head;
+  }
 }
 
 /**
@@ -15,6 +15,16 @@ STATIC UINT8                             *mBackupBuffer;
 STATIC UINT32                             mMpInitPhase = EnumMpInitNull;
 STATIC SMMBASE_INFO                      *mSmmBaseInfo;
 STATIC MTRR_SETTINGS                      mMtrrTable;
+STATIC volatile MP_JOB_QUEUE              mJobQueue;
+STATIC MP_SERVICE                         mMpService = {
+  {
+    MP_SERVICE_SIGNATURE,
+    MP_SERVICE_VERSION,
+  },
+  MpSubmitJob,
+  MpWaitAllJobs,
+  MpGetWorkerCount
+};
 extern UINT8                             *mDefaultSmiHandlerStart;
 extern UINT8                             *mDefaultSmiHandlerRet;
 extern UINT8                             *mDefaultSmiHandlerEnd;
@@ -526,6 +536,11 @@ MpInit (
       // Restore AP buffer (needed for S3)
       CopyMem (ApBuffer, mBackupBuffer, AP_BUFFER_SIZE);
       mMpInitPhase = EnumMpInitRun;
+
+      // APs are parked in the task loop now, offer them as job workers
+      if (CpuCount > 1) {
+        RegisterService ((VOID *)&mMpService);
+      }
     }
   }
 
@@ -537,6 +552,9 @@ MpInit (
     } else {
       DEBUG ((DEBUG_INFO, "MP Init (Done)\n"));
 
+      // Drain the job queue before APs are put back into wait-for-SIPI
+      MpWaitAllJobs ();
+
       // All APs should be in EnumCpuReady now
       Status = GetCpuMtrrs (&mMtrrTable);
       if (!EFI_ERROR(Status)) {
@@ -661,3 +679,171 @@ MpDumpTask (
   }
   DEBUG ((DEBUG_INFO, "\n"));
 }
+
+
+/**
+  Claim and run the next pending job from the job queue.
+
+  @retval TRUE     A job was run.
+  @retval FALSE    No pending job is left.
+
+**/
+STATIC
+BOOLEAN
+RunNextJob (
+  VOID
+  )
+{
+  UINT32         Index;
+  CPU_TASK_FUNC  TaskFunc;
+
+  do {
+    Index = mJobQueue.Taken;
+    if (Index >= mJobQueue.Count) {
+      return FALSE;
+    }
+  } while (InterlockedCompareExchange32 ((UINT32 *)&mJobQueue.Taken, Index, Index + 1) != Index);
+
+  TaskFunc = (CPU_TASK_FUNC)(UINTN)mJobQueue.Job[Index].TaskFunc;
+  TaskFunc (mJobQueue.Job[Index].Argument);
+  InterlockedIncrement ((UINT32 *)&mJobQueue.Done);
+
+  return TRUE;
+}
+
+/**
+  The CPU task function to run queued jobs on an AP until the queue is empty.
+
+  @param[in] Arg  Task parameter, unused.
+
+  @retval  0      Always.
+**/
+STATIC
+UINT64
+EFIAPI
+MpJobWorkerTask (
+  IN  UINT64   Arg
+  )
+{
+  while (RunNextJob ()) {
+  }
+
+  return 0;
+}
+
+/**
+  Get the number of CPUs that can run jobs, including the BSP.
+
+  @retval    CPU count. 1 means jobs will run on the BSP only.
+
+**/
+UINT32
+EFIAPI
+MpGetWorkerCount (
+  VOID
+  )
+{
+  if (mMpInitPhase != EnumMpInitRun) {
+    return 1;
+  }
+
+  return mSysCpuTask.CpuCount;
+}
+
+/**
+  Submit a job to the AP worker pool.
+
+  The job is picked up by the first idle AP, or by the BSP while it waits in
+  MpWaitAllJobs. A job function runs on an AP with a small stack. It must not
+  allocate memory, print debug messages or access any hardware that is not
+  owned by the job itself. Jobs must not submit other jobs.
+
+  @param[in]  TaskFunc    Job function pointer.
+  @param[in]  Argument    Argument for the job function.
+
+  @retval EFI_INVALID_PARAMETER   TaskFunc is NULL.
+  @retval EFI_SUCCESS             The job has been queued.
+
+**/
+EFI_STATUS
+EFIAPI
+MpSubmitJob (
+  IN  CPU_TASK_FUNC  TaskFunc,
+  IN  UINT64         Argument
+  )
+{
+  UINT32   Index;
+  UINT32   Pending;
+
+  if (TaskFunc == NULL) {
+    return EFI_INVALID_PARAMETER;
+  }
+
+  if (mJobQueue.Count >= MP_JOB_QUEUE_SIZE) {
+    // Queue is full, finish the current batch first
+    MpWaitAllJobs ();
+  }
+
+  Index = mJobQueue.Count;
+  mJobQueue.Job[Index].TaskFunc = (UINT64)(UINTN)TaskFunc;
+  mJobQueue.Job[Index].Argument = Argument;
+  MemoryFence ();
+  mJobQueue.Count = Index + 1;
+
+  if (mMpInitPhase != EnumMpInitRun) {
+    return EFI_SUCCESS;
+  }
+
+  // Wake up idle APs, no more than the number of pending jobs
+  Pending = mJobQueue.Count - mJobQueue.Taken;
+  for (Index = 1; (Index < mSysCpuTask.CpuCount) && (Pending > 0); Index++) {
+    if (mSysCpuTask.CpuTask[Index].State == EnumCpuReady) {
+      if (!EFI_ERROR (MpRunTask (Index, MpJobWorkerTask, 0))) {
+        Pending--;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Wait for all submitted jobs to complete.
+
+  The BSP also runs queued jobs while waiting.
+
+  @retval EFI_SUCCESS             All submitted jobs have completed.
+
+**/
+EFI_STATUS
+EFIAPI
+MpWaitAllJobs (
+  VOID
+  )
+{
+  UINT32   Index;
+
+  while (RunNextJob ()) {
+  }
+
+  while (mJobQueue.Done != mJobQueue.Count) {
+    if (DebugLogBufferPoll () == 0) {
+      CpuPause ();
+    }
+  }
+
+  // Make sure no AP is still looking at the queue before it is reset
+  if (mMpInitPhase == EnumMpInitRun) {
+    for (Index = 1; Index < mSysCpuTask.CpuCount; Index++) {
+      while (mSysCpuTask.CpuTask[Index].State != EnumCpuReady) {
+        CpuPause ();
+      }
+    }
+  }
+
+  mJobQueue.Count = 0;
+  mJobQueue.Taken = 0;
+  mJobQueue.Done  = 0;
+
+  return EFI_SUCCESS;
+}
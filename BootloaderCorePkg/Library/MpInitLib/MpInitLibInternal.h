@@ -24,17 +24,24 @@
 #include <Library/ExtraBaseLib.h>
 #include <Library/BootloaderCoreLib.h>
 #include <Library/S3SaveRestoreLib.h>
+#include <Library/DebugLogBufferLib.h>
 #include <Register/Intel/ArchitecturalMsr.h>
 #include <Guid/SmmS3CommunicationInfoGuid.h>
+#include <Service/MpService.h>
 
 #define   AP_BUFFER_ADDRESS        0x38000
 #define   AP_BUFFER_SIZE           0x8000
 
-#define   AP_STACK_SIZE_SHIFT_BITS 12
+//
+// An AP stack holds MP_JOB_STACK_SIZE for a job on top of the AP job loop
+//
+#define   AP_STACK_SIZE_SHIFT_BITS 13
 #define   AP_STACK_SIZE            (1<<AP_STACK_SIZE_SHIFT_BITS)
 #define   AP_TASK_TIMEOUT_UNIT     15
 #define   AP_TASK_TIMEOUT_CNT      1000
 
+#define   MP_JOB_QUEUE_SIZE        32
+
 #define   RSM_SIG                  0x9090AA0F  /// Opcode for 'rsm'
 
 #define SMM_BASE_GAP               0x1000
@@ -85,6 +92,21 @@ typedef struct {
   CPU_TASK         CpuTask[FixedPcdGet32 (PcdCpuMaxLogicalProcessorNumber)];
 } ALL_CPU_TASK;
 
+typedef struct {
+  UINT64           TaskFunc;
+  UINT64           Argument;
+} MP_JOB;
+
+typedef struct {
+  // Number of jobs submitted
+  UINT32           Count;
+  // Number of jobs claimed by a CPU
+  UINT32           Taken;
+  // Number of jobs completed
+  UINT32           Done;
+  MP_JOB           Job[MP_JOB_QUEUE_SIZE];
+} MP_JOB_QUEUE;
+
 /**
   Assembly function to get the BSP.
 
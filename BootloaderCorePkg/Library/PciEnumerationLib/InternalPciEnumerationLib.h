@@ -172,6 +172,19 @@ struct _PCI_IO_DEVICE {
 
 };
 
+/**
+  Allocate the memory of specified size from the memory pool.
+
+  @param AllocationSize size to be allocated.
+
+  @return Pointer to the allocated buffer.
+
+**/
+VOID *
+PciAllocatePool (
+  IN UINTN            AllocationSize
+  );
+
 /**
   Check whether the bar is existed or not.
 
@@ -17,6 +17,7 @@
 #include <Library/BootloaderCommonLib.h>
 #include "PciAri.h"
 #include "PciIov.h"
+#include "PciTopologyCache.h"
 
 #define  DEBUG_PCI_ENUM    0
 
@@ -1868,16 +1869,31 @@ PciEnumeration (
   EnumPolicy = (PCI_ENUM_POLICY_INFO *)PcdGetPtr (PcdPciEnumPolicyInfo);
   RootBridgeCount = 0;
 
+  GetPciResourceAllocTable (&ResAllocTable);
+
+  //
+  // On fast boot, program the devices from the saved topology if it still matches
+  //
+  if (FixedPcdGetBool (PcdFastBootEnabled)) {
+    Status = PciRestoreTopologyCache (EnumPolicy, ResAllocTable);
+    if (!EFI_ERROR (Status)) {
+      SetAllocationPool (MemPool);
+      return EFI_SUCCESS;
+    }
+  }
+
   Status = PciScanRootBridges (EnumPolicy, &RootBridges, &RootBridgeCount);
   ASSERT_EFI_ERROR (Status);
   ASSERT (RootBridgeCount > 0);
 
-  GetPciResourceAllocTable (&ResAllocTable);
   PciProgramResources (EnumPolicy, ResAllocTable, RootBridges);
 
   PciEnableDevices (RootBridges);
 
-  BuildPciRootBridgeInfoHob (RootBridges, RootBridgeCount);
+  Status = BuildPciRootBridgeInfoHob (RootBridges, RootBridgeCount);
+  if (FixedPcdGetBool (PcdFastBootEnabled) && !EFI_ERROR (Status)) {
+    PciSaveTopologyCache (EnumPolicy, ResAllocTable, RootBridges);
+  }
 
 #if DEBUG_PCI_ENUM
   DumpPciResAllocTable ();
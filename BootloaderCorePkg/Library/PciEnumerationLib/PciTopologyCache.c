@@ -0,0 +1,1029 @@
+/** @file
+  Save the PCI topology and resource assignment after a full enumeration,
+  and program the devices directly from it on later boots.
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#include <PiPei.h>
+#include <Library/PcdLib.h>
+#include <Library/BaseLib.h>
+#include <Library/DebugLib.h>
+#include <Library/BaseMemoryLib.h>
+#include <Library/PciExpressLib.h>
+#include <Library/HobLib.h>
+#include <Library/VariableLib.h>
+#include <Library/BootloaderCommonLib.h>
+#include <Library/PciEnumerationLib.h>
+#include "InternalPciEnumerationLib.h"
+#include "PciTopologyCache.h"
+
+#define PCI_TOPOLOGY_NEXT_DEV(Dev)  \
+          ((PCI_TOPOLOGY_DEV *)((PCI_TOPOLOGY_REG *)((Dev) + 1) + (Dev)->RegCount))
+
+typedef struct {
+  UINT8                    *Buffer;
+  UINT32                    Length;
+  UINT32                    MaxLength;
+  UINT16                    DeviceCount;
+  BOOLEAN                   Overflow;
+  PCI_TOPOLOGY_DEV         *Dev;
+} PCI_TOPOLOGY_BUILDER;
+
+typedef struct {
+  PCI_TOPOLOGY_DEV         *Dev;
+  UINT16                    Remaining;
+} PCI_TOPOLOGY_WALK;
+
+//
+// Bound on the capability list walks in case a device reports a loop
+//
+#define PCI_TOPOLOGY_MAX_CAP_NUM    48
+#define PCI_TOPOLOGY_MAX_EXT_CAP_NUM  ((SIZE_4KB - EFI_PCIE_CAPABILITY_BASE_OFFSET) / 4)
+
+/**
+  Calculate the CRC of the configuration that determines the resource assignment.
+
+  @param [in] EnumPolicy      PciEnum Policy with root bridge mask to be scanned
+  @param [in] ResAllocTable   PCI Resource Allocation Table
+
+  @retval     CRC32 of the enumeration policy and the resource allocation table.
+
+**/
+STATIC
+UINT32
+PciTopologyConfigCrc (
+  IN CONST  PCI_ENUM_POLICY_INFO  *EnumPolicy,
+  IN CONST  PCI_RES_ALLOC_TABLE   *ResAllocTable
+  )
+{
+  UINT8     *Buffer;
+  UINT32     PolicyLen;
+  UINT32     TableLen;
+
+  PolicyLen = sizeof (PCI_ENUM_POLICY_INFO) + EnumPolicy->NumOfBus;
+  TableLen  = sizeof (PCI_RES_ALLOC_TABLE) + sizeof (PCI_RES_ALLOC_RANGE) * ResAllocTable->NumOfEntries;
+  Buffer    = PciAllocatePool (PolicyLen + TableLen);
+  CopyMem (Buffer, EnumPolicy, PolicyLen);
+  CopyMem (Buffer + PolicyLen, ResAllocTable, TableLen);
+
+  return CalculateCrc32 (Buffer, PolicyLen + TableLen);
+}
+
+/**
+  Append a register value to the current device record.
+
+  @param [in, out] Builder    Topology cache builder.
+  @param [in]      Offset     Register offset in the config space.
+  @param [in]      Width      Register width in bytes, 1, 2 or 4.
+  @param [in]      Value      Register value to program.
+
+  @retval     The register entry, or NULL if the cache is full.
+
+**/
+STATIC
+PCI_TOPOLOGY_REG *
+PciTopologyAddReg (
+  IN OUT  PCI_TOPOLOGY_BUILDER  *Builder,
+  IN      UINTN                  Offset,
+  IN      UINT8                  Width,
+  IN      UINT32                 Value
+  )
+{
+  PCI_TOPOLOGY_REG     *Reg;
+
+  if (Builder->Length + sizeof (PCI_TOPOLOGY_REG) > Builder->MaxLength) {
+    Builder->Overflow = TRUE;
+    return NULL;
+  }
+
+  Reg = (PCI_TOPOLOGY_REG *)(Builder->Buffer + Builder->Length);
+  Reg->Offset    = (UINT16)Offset;
+  Reg->Width     = Width;
+  Reg->SizeShift = 0;
+  Reg->Value     = Value;
+  Builder->Length += sizeof (PCI_TOPOLOGY_REG);
+  Builder->Dev->RegCount++;
+
+  return Reg;
+}
+
+/**
+  Append the programmed value of a BAR to the current device record.
+
+  @param [in, out] Builder    Topology cache builder.
+  @param [in]      Address    PCI address of the function.
+  @param [in]      PciBar     BAR to save.
+  @param [in]      Instances  Number of functions sharing the BAR, InitialVFs for a VF BAR.
+
+**/
+STATIC
+VOID
+PciTopologyAddBar (
+  IN OUT  PCI_TOPOLOGY_BUILDER  *Builder,
+  IN      UINT32                 Address,
+  IN      PCI_BAR               *PciBar,
+  IN      UINT32                 Instances
+  )
+{
+  PCI_TOPOLOGY_REG     *Reg;
+
+  Reg = PciTopologyAddReg (Builder, PciBar->Offset, 4, PciExpressRead32 (Address + PciBar->Offset));
+  if (Reg != NULL) {
+    Reg->SizeShift = (UINT8)HighBitSet64 (DivU64x32 (PciBar->Length, Instances));
+  }
+  if ((PciBar->OrgBarType == PciBarTypeMem64) || (PciBar->OrgBarType == PciBarTypePMem64)) {
+    PciTopologyAddReg (Builder, PciBar->Offset + 4, 4, PciExpressRead32 (Address + PciBar->Offset + 4));
+  }
+}
+
+/**
+  Append a device record with the final register values of a PCI function.
+
+  @param [in, out] Builder      Topology cache builder.
+  @param [in]      PciIoDevice  Pointer to the PCI IO device.
+
+**/
+STATIC
+VOID
+PciTopologyAddDevice (
+  IN OUT  PCI_TOPOLOGY_BUILDER  *Builder,
+  IN      PCI_IO_DEVICE         *PciIoDevice
+  )
+{
+  PCI_TOPOLOGY_DEV     *Dev;
+  UINT32                Address;
+  UINT32                Value;
+  UINTN                 Offset;
+  UINT32                Idx;
+
+  if (Builder->Length + sizeof (PCI_TOPOLOGY_DEV) > Builder->MaxLength) {
+    Builder->Overflow = TRUE;
+    return;
+  }
+
+  Address = PciIoDevice->Address;
+  Dev = (PCI_TOPOLOGY_DEV *)(Builder->Buffer + Builder->Length);
+  ZeroMem (Dev, sizeof (PCI_TOPOLOGY_DEV));
+  Dev->Address   = Address;
+  Dev->Id        = PciExpressRead32 (Address);
+  Dev->ClassCode = (PciExpressRead32 (Address + PCI_REVISION_ID_OFFSET) & 0xFFFFFF00) |
+                   PciExpressRead8 (Address + PCI_HEADER_TYPE_OFFSET);
+  Dev->Command   = PciExpressRead16 (Address + PCI_COMMAND_OFFSET) & EFI_PCI_COMMAND_BITS_OWNED;
+  Builder->Dev     = Dev;
+  Builder->Length += sizeof (PCI_TOPOLOGY_DEV);
+  Builder->DeviceCount++;
+
+  if (IS_PCI_BRIDGE (&PciIoDevice->Pci)) {
+    Dev->Flags          = PCI_TOPOLOGY_DEV_FLAG_BRIDGE;
+    Dev->SecondaryBus   = PciExpressRead8 (Address + PCI_BRIDGE_SECONDARY_BUS_REGISTER_OFFSET);
+    Dev->SubordinateBus = PciExpressRead8 (Address + PCI_BRIDGE_SUBORDINATE_BUS_REGISTER_OFFSET);
+
+    for (Idx = 0; Idx < PPB_MAX_BAR; Idx++) {
+      if (PciIoDevice->PpbBar[Idx].Length > 0) {
+        PciTopologyAddBar (Builder, Address, &PciIoDevice->PpbBar[Idx], 1);
+      }
+    }
+
+    //
+    // IO, memory and prefetchable memory apertures
+    //
+    PciTopologyAddReg (Builder, 0x1C, 2, PciExpressRead16 (Address + 0x1C));
+    for (Offset = 0x20; Offset <= 0x30; Offset += 4) {
+      PciTopologyAddReg (Builder, Offset, 4, PciExpressRead32 (Address + Offset));
+    }
+
+    if (FeaturePcdGet (PcdAriSupport) && (PciIoDevice->PciExpressCapabilityOffset != 0)) {
+      Offset = PciIoDevice->PciExpressCapabilityOffset + EFI_PCIE_CAPABILITY_DEVICE_CONTROL_2_OFFSET;
+      Value  = PciExpressRead32 (Address + Offset);
+      if ((Value & EFI_PCIE_CAPABILITY_DEVICE_CONTROL_2_ARI_FORWARDING) != 0) {
+        PciTopologyAddReg (Builder, Offset, 4, Value);
+      }
+    }
+  } else {
+    for (Idx = 0; Idx < PCI_MAX_BAR; Idx++) {
+      if (PciIoDevice->PciBar[Idx].Length > 0) {
+        PciTopologyAddBar (Builder, Address, &PciIoDevice->PciBar[Idx], 1);
+      }
+    }
+
+    if (FeaturePcdGet (PcdSrIovSupport) && (PciIoDevice->SrIovCapabilityOffset != 0)) {
+      Offset = PciIoDevice->SrIovCapabilityOffset + EFI_PCIE_CAPABILITY_ID_SRIOV_CONTROL;
+      PciTopologyAddReg (Builder, Offset, 2, PciExpressRead16 (Address + Offset));
+      Offset = PciIoDevice->SrIovCapabilityOffset + EFI_PCIE_CAPABILITY_ID_SRIOV_SUPPORTED_PAGE_SIZE;
+      PciTopologyAddReg (Builder, Offset, 4, PciIoDevice->SystemPageSize >> 12);
+      for (Idx = 0; Idx < PCI_MAX_BAR; Idx++) {
+        if (PciIoDevice->VfPciBar[Idx].Length > 0) {
+          PciTopologyAddBar (Builder, Address, &PciIoDevice->VfPciBar[Idx], PciIoDevice->InitialVFs);
+        }
+      }
+    }
+  }
+}
+
+/**
+  Recursively append the device records under a parent in scan order.
+
+  @param [in, out] Builder    Topology cache builder.
+  @param [in]      Parent     Pointer to the parent PCI IO device.
+
+**/
+STATIC
+VOID
+PciTopologyAddDevices (
+  IN OUT  PCI_TOPOLOGY_BUILDER  *Builder,
+  IN      PCI_IO_DEVICE         *Parent
+  )
+{
+  LIST_ENTRY                *CurrentLink;
+  PCI_IO_DEVICE             *PciIoDevice;
+
+  CurrentLink = Parent->ChildList.ForwardLink;
+  while ((CurrentLink != NULL) && (CurrentLink != &Parent->ChildList) && !Builder->Overflow) {
+    PciIoDevice = PCI_IO_DEVICE_FROM_LINK (CurrentLink);
+    PciTopologyAddDevice (Builder, PciIoDevice);
+    PciTopologyAddDevices (Builder, PciIoDevice);
+    CurrentLink = CurrentLink->ForwardLink;
+  }
+}
+
+/**
+  Find a capability in the PCI capability list of a function.
+
+  @param [in] Address         PCI address of the function.
+  @param [in] CapId           Capability ID.
+
+  @retval     Offset of the capability, 0 if it is not found.
+
+**/
+STATIC
+UINT32
+PciTopologyFindCap (
+  IN  UINT32                 Address,
+  IN  UINT8                  CapId
+  )
+{
+  UINT16      CapEntry;
+  UINT8       CapPtr;
+  UINT32      Count;
+
+  if ((PciExpressRead16 (Address + PCI_PRIMARY_STATUS_OFFSET) & EFI_PCI_STATUS_CAPABILITY) == 0) {
+    return 0;
+  }
+
+  CapPtr = PciExpressRead8 (Address + PCI_CAPBILITY_POINTER_OFFSET);
+  for (Count = 0; (Count < PCI_TOPOLOGY_MAX_CAP_NUM) && (CapPtr >= 0x40) && ((CapPtr & 0x03) == 0); Count++) {
+    CapEntry = PciExpressRead16 (Address + CapPtr);
+    if ((UINT8)CapEntry == CapId) {
+      return CapPtr;
+    }
+    CapPtr = (UINT8)(CapEntry >> 8);
+  }
+
+  return 0;
+}
+
+/**
+  Find a capability in the PCI Express extended capability list of a function.
+
+  @param [in] Address         PCI address of the function.
+  @param [in] CapId           Extended capability ID.
+
+  @retval     Offset of the capability, 0 if it is not found.
+
+**/
+STATIC
+UINT32
+PciTopologyFindExtCap (
+  IN  UINT32                 Address,
+  IN  UINT16                 CapId
+  )
+{
+  UINT32      CapEntry;
+  UINT32      CapPtr;
+  UINT32      Count;
+
+  CapPtr = EFI_PCIE_CAPABILITY_BASE_OFFSET;
+  for (Count = 0; (Count < PCI_TOPOLOGY_MAX_EXT_CAP_NUM) && (CapPtr >= EFI_PCIE_CAPABILITY_BASE_OFFSET); Count++) {
+    CapEntry = PciExpressRead32 (Address + CapPtr);
+    if ((CapEntry == 0) || (CapEntry == MAX_UINT32)) {
+      break;
+    }
+    if ((UINT16)CapEntry == CapId) {
+      return CapPtr;
+    }
+    CapPtr = (CapEntry >> 20) & 0xFFC;
+  }
+
+  return 0;
+}
+
+/**
+  Check that the saved registers of a function are among the registers the
+  enumerator programs for it.
+
+  These are the BARs, the bridge apertures, the PCI Express Device Control 2
+  register of a bridge and the SR-IOV control, page size and VF BAR registers.
+  The capability offsets are taken from the function itself, not from the cache.
+
+  @param [in] Dev             Saved device record.
+
+  @retval TRUE                All saved registers are allowed.
+  @retval FALSE               The record holds a register that is not allowed.
+
+**/
+STATIC
+BOOLEAN
+PciTopologyCheckRegs (
+  IN CONST  PCI_TOPOLOGY_DEV    *Dev
+  )
+{
+  CONST PCI_TOPOLOGY_REG  *Reg;
+  UINT32                   PcieCap;
+  UINT32                   SrIovCap;
+  UINT32                   Offset;
+  UINT32                   Idx;
+  BOOLEAN                  IsBridge;
+  BOOLEAN                  Allowed;
+
+  IsBridge = (BOOLEAN)((Dev->Flags & PCI_TOPOLOGY_DEV_FLAG_BRIDGE) != 0);
+  PcieCap  = 0;
+  SrIovCap = 0;
+  if (Dev->RegCount > 0) {
+    PcieCap = PciTopologyFindCap (Dev->Address, EFI_PCI_CAPABILITY_ID_PCIEXP);
+    if ((PcieCap != 0) && !IsBridge) {
+      SrIovCap = PciTopologyFindExtCap (Dev->Address, EFI_PCIE_CAPABILITY_ID_SRIOV);
+    }
+  }
+
+  Reg = (CONST PCI_TOPOLOGY_REG *)(Dev + 1);
+  for (Idx = 0; Idx < Dev->RegCount; Idx++) {
+    Offset = Reg[Idx].Offset;
+    if (IsBridge) {
+      Allowed = (BOOLEAN)(((Reg[Idx].Width == 4) && (Offset >= PCI_BASE_ADDRESSREG_OFFSET) && (Offset <= 0x14)) ||
+                          ((Reg[Idx].Width == 2) && (Offset == 0x1C)) ||
+                          ((Reg[Idx].Width == 4) && (Offset >= 0x20) && (Offset <= 0x30)) ||
+                          ((Reg[Idx].Width == 4) && (PcieCap != 0) &&
+                           (Offset == PcieCap + EFI_PCIE_CAPABILITY_DEVICE_CONTROL_2_OFFSET)));
+    } else {
+      Allowed = (BOOLEAN)(((Reg[Idx].Width == 4) && (Offset >= PCI_BASE_ADDRESSREG_OFFSET) && (Offset <= 0x24)) ||
+                          ((Reg[Idx].Width == 2) && (SrIovCap != 0) &&
+                           (Offset == SrIovCap + EFI_PCIE_CAPABILITY_ID_SRIOV_CONTROL)) ||
+                          ((Reg[Idx].Width == 4) && (SrIovCap != 0) &&
+                           (Offset == SrIovCap + EFI_PCIE_CAPABILITY_ID_SRIOV_SUPPORTED_PAGE_SIZE)) ||
+                          ((Reg[Idx].Width == 4) && (SrIovCap != 0) &&
+                           (Offset >= SrIovCap + EFI_PCIE_CAPABILITY_ID_SRIOV_BAR0) &&
+                           (Offset <= SrIovCap + EFI_PCIE_CAPABILITY_ID_SRIOV_BAR5)));
+    }
+    if (!Allowed) {
+      return FALSE;
+    }
+  }
+
+  return TRUE;
+}
+
+/**
+  Get the resource allocation range of a root bridge bus range.
+
+  @param [in] ResAllocTable   PCI Resource Allocation Table
+  @param [in] BusBase         First bus number of the root bridge.
+  @param [in] BusLimit        Last bus number of the root bridge.
+
+  @retval     The resource allocation range, NULL if no range covers the buses.
+
+**/
+STATIC
+CONST PCI_RES_ALLOC_RANGE *
+PciTopologyGetResRange (
+  IN CONST  PCI_RES_ALLOC_TABLE   *ResAllocTable,
+  IN        UINT8                  BusBase,
+  IN        UINT8                  BusLimit
+  )
+{
+  UINT8     Index;
+
+  for (Index = 0; Index < ResAllocTable->NumOfEntries; Index++) {
+    if ((ResAllocTable->ResourceRange[Index].BusBase <= BusBase) &&
+        (ResAllocTable->ResourceRange[Index].BusLimit >= BusLimit) && (BusBase <= BusLimit)) {
+      return &ResAllocTable->ResourceRange[Index];
+    }
+  }
+
+  return NULL;
+}
+
+/**
+  Check that a resource is within a root bridge resource allocation range.
+
+  A memory resource may be in the 32-bit or the 64-bit range, since 64-bit
+  BARs can be downgraded by the enumeration policy.
+
+  @param [in] ResRange        Resource allocation range of the root bridge.
+  @param [in] IsIo            TRUE for an IO resource, FALSE for a memory resource.
+  @param [in] Base            Resource base.
+  @param [in] Length          Resource length.
+
+  @retval TRUE                The resource is empty or within the range.
+  @retval FALSE               The resource is outside the range.
+
+**/
+STATIC
+BOOLEAN
+PciTopologyInResRange (
+  IN CONST  PCI_RES_ALLOC_RANGE   *ResRange,
+  IN        BOOLEAN                IsIo,
+  IN        UINT64                 Base,
+  IN        UINT64                 Length
+  )
+{
+  UINT64    Limit;
+
+  if (Length == 0) {
+    return TRUE;
+  }
+
+  Limit = Base + Length - 1;
+  if (Limit < Base) {
+    return FALSE;
+  }
+
+  if (IsIo) {
+    return (BOOLEAN)((Base >= ResRange->IoBase) && (Limit <= ResRange->IoLimit));
+  }
+
+  if ((Base >= ResRange->Mmio32Base) && (Limit <= ResRange->Mmio32Limit)) {
+    return TRUE;
+  }
+  return (BOOLEAN)((Base >= ResRange->Mmio64Base) && (Limit <= ResRange->Mmio64Limit));
+}
+
+/**
+  Read which bits of a BAR register can be written.
+
+  The original register value is restored. The function must not decode the
+  BAR while it is probed.
+
+  @param [in] Address         PCI address of the BAR register.
+
+  @retval     The register value read back after writing all ones.
+
+**/
+STATIC
+UINT32
+PciTopologyProbeBar (
+  IN  UINT32                 Address
+  )
+{
+  UINT32      OriginalValue;
+  UINT32      Value;
+
+  OriginalValue = PciExpressRead32 (Address);
+  PciExpressWrite32 (Address, MAX_UINT32);
+  Value = PciExpressRead32 (Address);
+  PciExpressWrite32 (Address, OriginalValue);
+
+  return Value;
+}
+
+/**
+  Check the saved BARs and bridge apertures of a function before they are
+  programmed.
+
+  Each BAR is probed the same way the enumerator sizes it. It must still
+  decode the saved size and type, and the saved base must be aligned to the
+  size. All BARs and apertures must be within the resource allocation range
+  of the root bridge.
+
+  @param [in] Dev             Saved device record, already checked by PciTopologyCheckRegs.
+  @param [in] ResRange        Resource allocation range of the root bridge.
+
+  @retval TRUE                The saved resources can be programmed.
+  @retval FALSE               The BARs changed or a resource is out of range.
+
+**/
+STATIC
+BOOLEAN
+PciTopologyCheckResources (
+  IN CONST  PCI_TOPOLOGY_DEV      *Dev,
+  IN CONST  PCI_RES_ALLOC_RANGE   *ResRange
+  )
+{
+  CONST PCI_TOPOLOGY_REG  *Reg;
+  UINT32                   Aperture[6];
+  UINT32                   ApertureMask;
+  UINT32                   SrIovCap;
+  UINT32                   Offset;
+  UINT32                   Probe;
+  UINT32                   ProbeHigh;
+  UINT32                   Instances;
+  UINT32                   Idx;
+  UINT64                   Base;
+  UINT64                   Limit;
+  UINT64                   Length;
+  BOOLEAN                  IsBridge;
+  UINT8                    SizeShift;
+  BOOLEAN                  IsBar;
+  BOOLEAN                  IsIo;
+
+  IsBridge     = (BOOLEAN)((Dev->Flags & PCI_TOPOLOGY_DEV_FLAG_BRIDGE) != 0);
+  SrIovCap     = 0;
+  ApertureMask = 0;
+  ZeroMem (Aperture, sizeof (Aperture));
+
+  Reg = (CONST PCI_TOPOLOGY_REG *)(Dev + 1);
+  for (Idx = 0; Idx < Dev->RegCount; Idx++) {
+    Offset = Reg[Idx].Offset;
+    if (IsBridge && (Offset >= 0x1C) && (Offset <= 0x30)) {
+      Aperture[(Offset - 0x1C) / 4] = Reg[Idx].Value;
+      ApertureMask |= 1 << ((Offset - 0x1C) / 4);
+      continue;
+    }
+
+    Instances = 1;
+    if (IsBridge) {
+      IsBar = (BOOLEAN)((Offset >= PCI_BASE_ADDRESSREG_OFFSET) && (Offset <= 0x14));
+    } else if (Offset < EFI_PCIE_CAPABILITY_BASE_OFFSET) {
+      IsBar = (BOOLEAN)((Offset >= PCI_BASE_ADDRESSREG_OFFSET) && (Offset <= 0x24));
+    } else {
+      if (SrIovCap == 0) {
+        SrIovCap = PciTopologyFindExtCap (Dev->Address, EFI_PCIE_CAPABILITY_ID_SRIOV);
+      }
+      IsBar = (BOOLEAN)((SrIovCap != 0) &&
+                        (Offset >= SrIovCap + EFI_PCIE_CAPABILITY_ID_SRIOV_BAR0) &&
+                        (Offset <= SrIovCap + EFI_PCIE_CAPABILITY_ID_SRIOV_BAR5));
+      if (IsBar) {
+        Instances = PciExpressRead16 (Dev->Address + SrIovCap + EFI_PCIE_CAPABILITY_ID_SRIOV_INITIALVFS);
+      }
+    }
+    if (!IsBar) {
+      continue;
+    }
+
+    //
+    // Every BAR register is the lower half of a BAR, or the upper half of a
+    // 64-bit BAR that is consumed below
+    //
+    SizeShift = Reg[Idx].SizeShift;
+    if ((SizeShift == 0) || (SizeShift > 63)) {
+      return FALSE;
+    }
+
+    Probe = PciTopologyProbeBar (Dev->Address + Offset);
+    IsIo  = (BOOLEAN)((Probe & BIT0) != 0);
+    if (IsIo) {
+      if (((Reg[Idx].Value ^ Probe) & BIT0) != 0) {
+        return FALSE;
+      }
+      Base   = Reg[Idx].Value & 0xFFFFFFFC;
+      Length = (UINT32)(~(Probe & 0xFFFFFFFC) + 1);
+      if ((Probe & 0xFFFF0000) == 0) {
+        Length &= 0x0000FFFF;
+      }
+    } else if ((Probe & 0x07) == 0x04) {
+      if (((Reg[Idx].Value ^ Probe) & 0x0F) != 0) {
+        return FALSE;
+      }
+      if ((Idx + 1 >= Dev->RegCount) || (Reg[Idx + 1].Offset != Offset + 4) || (Reg[Idx + 1].SizeShift != 0)) {
+        return FALSE;
+      }
+      ProbeHigh = PciTopologyProbeBar (Dev->Address + Offset + 4);
+      if (ProbeHigh == 0) {
+        ProbeHigh = MAX_UINT32;
+      } else {
+        ProbeHigh |= MAX_UINT32 << HighBitSet32 (ProbeHigh);
+      }
+      Base   = (Reg[Idx].Value & 0xFFFFFFF0) | LShiftU64 (Reg[Idx + 1].Value, 32);
+      Length = ~((Probe & 0xFFFFFFF0) | LShiftU64 (ProbeHigh, 32)) + 1;
+      Idx++;
+    } else {
+      if (((Reg[Idx].Value ^ Probe) & 0x0F) != 0) {
+        return FALSE;
+      }
+      Base   = Reg[Idx].Value & 0xFFFFFFF0;
+      Length = (UINT32)(~(Probe & 0xFFFFFFF0) + 1);
+    }
+
+    if ((Length != LShiftU64 (1, SizeShift)) || ((Base & (Length - 1)) != 0) ||
+        !PciTopologyInResRange (ResRange, IsIo, Base, MultU64x32 (Length, Instances))) {
+      return FALSE;
+    }
+  }
+
+  if (!IsBridge) {
+    return TRUE;
+  }
+
+  //
+  // IO, memory and prefetchable memory apertures. A window with the base
+  // above the limit is closed.
+  //
+  if (ApertureMask != 0x3F) {
+    return FALSE;
+  }
+
+  Base  = ((Aperture[0] & 0xF0) << 8)   | ((Aperture[5] & 0xFFFF) << 16);
+  Limit = (Aperture[0] & 0xF000) | 0xFFF | (Aperture[5] & 0xFFFF0000);
+  if ((Base <= Limit) && !PciTopologyInResRange (ResRange, TRUE, Base, Limit - Base + 1)) {
+    return FALSE;
+  }
+
+  Base  = (Aperture[1] & 0xFFF0) << 16;
+  Limit = (Aperture[1] & 0xFFF00000) | 0xFFFFF;
+  if ((Base <= Limit) && !PciTopologyInResRange (ResRange, FALSE, Base, Limit - Base + 1)) {
+    return FALSE;
+  }
+
+  Base  = ((Aperture[2] & 0xFFF0) << 16) | LShiftU64 (Aperture[3], 32);
+  Limit = (Aperture[2] & 0xFFF00000) | 0xFFFFF | LShiftU64 (Aperture[4], 32);
+  if ((Base <= Limit) && !PciTopologyInResRange (ResRange, FALSE, Base, Limit - Base + 1)) {
+    return FALSE;
+  }
+
+  return TRUE;
+}
+
+/**
+  Walk a PCI bus the same way PciScanBus does and compare each function
+  with the saved device records. Bridge bus numbers are programmed from
+  the records so that the buses behind them become visible.
+
+  @param [in]      Bus        PCI bus number to walk.
+  @param [in]      ResRange   Resource allocation range of the root bridge.
+  @param [in, out] Walk       Current position in the device records.
+
+  @retval EFI_SUCCESS         All functions on the bus match the records.
+  @retval EFI_NOT_READY       The topology changed, or a saved bus number or
+                              resource does not fit the device or the root bridge.
+  @retval EFI_NOT_FOUND       A record holds a register that must not be programmed.
+
+**/
+STATIC
+EFI_STATUS
+PciTopologyScanBus (
+  IN      UINT8                  Bus,
+  IN CONST PCI_RES_ALLOC_RANGE   *ResRange,
+  IN OUT  PCI_TOPOLOGY_WALK     *Walk
+  )
+{
+  EFI_STATUS                   Status;
+  PCI_TOPOLOGY_DEV            *Dev;
+  UINT32                       Address;
+  UINT32                       Id;
+  UINT8                        HeaderType;
+  UINT8                        Device;
+  UINT8                        Func;
+  BOOLEAN                      IsBridge;
+  PLATFORM_PCI_ENUM_HOOK_PROC  PlatformPciEnumHookProc;
+
+  for (Device = 0; Device <= PCI_MAX_DEVICE; Device++) {
+    for (Func = 0; Func <= PCI_MAX_FUNC; Func++) {
+      Address = PCI_EXPRESS_LIB_ADDRESS (Bus, Device, Func, 0);
+      Id      = PciExpressRead32 (Address);
+      if ((Id & 0xFFFF) == 0xFFFF) {
+        if (Func == 0) {
+          break;
+        }
+        continue;
+      }
+
+      Dev = Walk->Dev;
+      if ((Walk->Remaining == 0) || (Dev->Address != Address) || (Dev->Id != Id)) {
+        return EFI_NOT_READY;
+      }
+      HeaderType = PciExpressRead8 (Address + PCI_HEADER_TYPE_OFFSET);
+      if (Dev->ClassCode != ((PciExpressRead32 (Address + PCI_REVISION_ID_OFFSET) & 0xFFFFFF00) | HeaderType)) {
+        return EFI_NOT_READY;
+      }
+      IsBridge = (BOOLEAN)((HeaderType & HEADER_LAYOUT_CODE) == HEADER_TYPE_PCI_TO_PCI_BRIDGE);
+      if ((IsBridge != ((Dev->Flags & PCI_TOPOLOGY_DEV_FLAG_BRIDGE) != 0)) || !PciTopologyCheckRegs (Dev)) {
+        return EFI_NOT_FOUND;
+      }
+      if (IsBridge && ((Dev->SecondaryBus <= Bus) || (Dev->SubordinateBus < Dev->SecondaryBus) ||
+                       (Dev->SubordinateBus > ResRange->BusLimit))) {
+        return EFI_NOT_READY;
+      }
+      Walk->Dev = PCI_TOPOLOGY_NEXT_DEV (Dev);
+      Walk->Remaining--;
+
+      //
+      // Disconnect the device before its resources are probed and programmed
+      //
+      PciExpressAnd16 (Address + PCI_COMMAND_OFFSET, (UINT16)~EFI_PCI_COMMAND_BITS_OWNED);
+      if (!PciTopologyCheckResources (Dev, ResRange)) {
+        DEBUG ((DEBUG_INFO, "PCI topology cache resources of %02X:%02X.%X changed\n", Bus, Device, Func));
+        return EFI_NOT_READY;
+      }
+
+      if ((Dev->Flags & PCI_TOPOLOGY_DEV_FLAG_BRIDGE) != 0) {
+        PciExpressAnd16 (Address + PCI_BRIDGE_CONTROL_REGISTER_OFFSET, (UINT16)~EFI_PCI_BRIDGE_CONTROL_BITS_OWNED);
+        PciExpressWrite8 (Address + PCI_BRIDGE_PRIMARY_BUS_REGISTER_OFFSET, Bus);
+        PciExpressWrite8 (Address + PCI_BRIDGE_SECONDARY_BUS_REGISTER_OFFSET, Dev->SecondaryBus);
+        PciExpressWrite8 (Address + PCI_BRIDGE_SUBORDINATE_BUS_REGISTER_OFFSET, Dev->SubordinateBus);
+
+        PlatformPciEnumHookProc = (PLATFORM_PCI_ENUM_HOOK_PROC)(UINTN)PcdGet32 (PcdPciEnumHookProc);
+        if (PlatformPciEnumHookProc != NULL) {
+          PlatformPciEnumHookProc (Bus, Device, Func, EfiPciBeforeChildBusEnumeration);
+        }
+
+        Status = PciTopologyScanBus (Dev->SecondaryBus, ResRange, Walk);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+      }
+
+      if ((Func == 0) && ((HeaderType & HEADER_TYPE_MULTI_FUNCTION) == 0)) {
+        Func = PCI_MAX_FUNC;
+      }
+    }
+  }
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Check the integrity of a topology cache read from the variable.
+
+  The variable is only protected by a CRC, so the whole cache is rejected
+  if any saved register is not a valid config space access. Whether the
+  register may be programmed is checked against each function while the
+  buses are walked.
+
+  @param [in] Cache           Pointer to the topology cache.
+  @param [in] Length          Length of the variable data.
+  @param [in] ConfigCrc       CRC of the current enumeration configuration.
+
+  @retval EFI_SUCCESS         The cache is valid for the current configuration.
+  @retval EFI_NOT_FOUND       The cache is invalid or stale.
+
+**/
+STATIC
+EFI_STATUS
+PciTopologyValidate (
+  IN CONST  PCI_TOPOLOGY_CACHE_HDR  *Cache,
+  IN        UINTN                    Length,
+  IN        UINT32                   ConfigCrc
+  )
+{
+  PCI_TOPOLOGY_DEV     *Dev;
+  PCI_TOPOLOGY_REG     *Reg;
+  UINT8                *End;
+  UINT32                Index;
+  UINT32                RegIdx;
+
+  if ((Length < sizeof (PCI_TOPOLOGY_CACHE_HDR)) ||
+      (Cache->Signature != PCI_TOPOLOGY_CACHE_SIGNATURE) ||
+      (Cache->Version != PCI_TOPOLOGY_CACHE_VERSION) ||
+      (Cache->Length != Length) || (Cache->RootBridgeCount == 0) ||
+      (Cache->ConfigCrc != ConfigCrc)) {
+    return EFI_NOT_FOUND;
+  }
+
+  if (CalculateCrc32 ((VOID *)(Cache + 1), Length - sizeof (PCI_TOPOLOGY_CACHE_HDR)) != Cache->DataCrc) {
+    return EFI_NOT_FOUND;
+  }
+
+  End = (UINT8 *)Cache + Length;
+  Dev = (PCI_TOPOLOGY_DEV *)((PCI_ROOT_BRIDGE_ENTRY *)(Cache + 1) + Cache->RootBridgeCount);
+  for (Index = 0; Index < Cache->DeviceCount; Index++) {
+    if (((UINT8 *)(Dev + 1) > End) || ((UINT8 *)PCI_TOPOLOGY_NEXT_DEV (Dev) > End)) {
+      return EFI_NOT_FOUND;
+    }
+
+    //
+    // Every register must be a naturally aligned access within the config space
+    //
+    Reg = (PCI_TOPOLOGY_REG *)(Dev + 1);
+    for (RegIdx = 0; RegIdx < Dev->RegCount; RegIdx++) {
+      if (((Reg[RegIdx].Width != 1) && (Reg[RegIdx].Width != 2) && (Reg[RegIdx].Width != 4)) ||
+          ((Reg[RegIdx].Offset & (Reg[RegIdx].Width - 1)) != 0) ||
+          ((UINT32)Reg[RegIdx].Offset + Reg[RegIdx].Width > SIZE_4KB)) {
+        return EFI_NOT_FOUND;
+      }
+    }
+    Dev = PCI_TOPOLOGY_NEXT_DEV (Dev);
+  }
+
+  return ((UINT8 *)Dev == End) ? EFI_SUCCESS : EFI_NOT_FOUND;
+}
+
+/**
+  Program the PCI devices from the saved topology cache.
+
+  The saved topology is only used when the enumeration policy and the
+  resource allocation table are unchanged, and every function found while
+  walking the buses matches the saved VID/DID, class code and header type.
+  The saved BARs must still decode the saved sizes, and all bus numbers and
+  resources must be within the root bridge ranges of the resource allocation
+  table.
+
+  @param [in] EnumPolicy      PciEnum Policy with root bridge mask to be scanned
+  @param [in] ResAllocTable   PCI Resource Allocation Table
+
+  @retval EFI_SUCCESS         All devices are programmed from the cache.
+  @retval EFI_NOT_FOUND       No valid cache is available, or it holds registers
+                              that must not be programmed.
+  @retval EFI_NOT_READY       The topology changed, a full enumeration is required.
+
+**/
+EFI_STATUS
+PciRestoreTopologyCache (
+  IN CONST  PCI_ENUM_POLICY_INFO  *EnumPolicy,
+  IN CONST  PCI_RES_ALLOC_TABLE   *ResAllocTable
+  )
+{
+  EFI_STATUS                 Status;
+  PCI_TOPOLOGY_CACHE_HDR    *Cache;
+  PCI_ROOT_BRIDGE_ENTRY     *RootEntry;
+  PCI_ROOT_BRIDGE_INFO_HOB  *RootBridgeInfoHob;
+  CONST PCI_RES_ALLOC_RANGE *ResRange;
+  PCI_TOPOLOGY_WALK          Walk;
+  PCI_TOPOLOGY_DEV          *Dev;
+  PCI_TOPOLOGY_REG          *Reg;
+  UINTN                      Length;
+  UINT32                     Address;
+  UINT32                     Index;
+  UINT32                     RegIdx;
+  UINT32                     ResIdx;
+
+  Cache  = (PCI_TOPOLOGY_CACHE_HDR *)PciAllocatePool (PCI_TOPOLOGY_CACHE_MAX_SIZE);
+  Length = PCI_TOPOLOGY_CACHE_MAX_SIZE;
+  Status = GetVariable (PCI_TOPOLOGY_CACHE_NAME, NULL, &Length, Cache);
+  if (EFI_ERROR (Status)) {
+    return EFI_NOT_FOUND;
+  }
+
+  Status = PciTopologyValidate (Cache, Length, PciTopologyConfigCrc (EnumPolicy, ResAllocTable));
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "PCI topology cache is stale\n"));
+    return Status;
+  }
+
+  //
+  // Compare the topology and program the bus numbers
+  //
+  RootEntry      = (PCI_ROOT_BRIDGE_ENTRY *)(Cache + 1);
+  Walk.Dev       = (PCI_TOPOLOGY_DEV *)(RootEntry + Cache->RootBridgeCount);
+  Walk.Remaining = Cache->DeviceCount;
+  for (Index = 0; Index < Cache->RootBridgeCount; Index++) {
+    if (PciExpressRead16 (PCI_EXPRESS_LIB_ADDRESS (RootEntry[Index].BusBase, 0, 0, 0)) == 0xFFFF) {
+      Status = EFI_NOT_READY;
+      break;
+    }
+
+    ResRange = PciTopologyGetResRange (ResAllocTable, RootEntry[Index].BusBase, RootEntry[Index].BusLimit);
+    if (ResRange == NULL) {
+      Status = EFI_NOT_READY;
+      break;
+    }
+    for (ResIdx = 0; ResIdx < PCI_MAX_BAR; ResIdx++) {
+      if (!PciTopologyInResRange (ResRange, (BOOLEAN)(ResIdx + 1 <= PciBarTypeIo32),
+                                  RootEntry[Index].Resource[ResIdx].ResBase,
+                                  RootEntry[Index].Resource[ResIdx].ResLength)) {
+        Status = EFI_NOT_READY;
+        break;
+      }
+    }
+    if (ResIdx < PCI_MAX_BAR) {
+      break;
+    }
+
+    Status = PciTopologyScanBus (RootEntry[Index].BusBase, ResRange, &Walk);
+    if (EFI_ERROR (Status)) {
+      break;
+    }
+  }
+  if (!EFI_ERROR (Status) && (Walk.Remaining != 0)) {
+    Status = EFI_NOT_READY;
+  }
+  if (Status == EFI_NOT_FOUND) {
+    DEBUG ((DEBUG_INFO, "PCI topology cache holds invalid registers\n"));
+    return Status;
+  }
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "PCI topology changed, full enumeration is required\n"));
+    return Status;
+  }
+
+  //
+  // Program the BARs and apertures, then enable the devices
+  //
+  Dev = (PCI_TOPOLOGY_DEV *)(RootEntry + Cache->RootBridgeCount);
+  for (Index = 0; Index < Cache->DeviceCount; Index++) {
+    Reg = (PCI_TOPOLOGY_REG *)(Dev + 1);
+    for (RegIdx = 0; RegIdx < Dev->RegCount; RegIdx++) {
+      Address = Dev->Address + Reg[RegIdx].Offset;
+      if (Reg[RegIdx].Width == 1) {
+        PciExpressWrite8 (Address, (UINT8)Reg[RegIdx].Value);
+      } else if (Reg[RegIdx].Width == 2) {
+        PciExpressWrite16 (Address, (UINT16)Reg[RegIdx].Value);
+      } else if (Reg[RegIdx].Width == 4) {
+        PciExpressWrite32 (Address, Reg[RegIdx].Value);
+      }
+    }
+    Dev = PCI_TOPOLOGY_NEXT_DEV (Dev);
+  }
+
+  Dev = (PCI_TOPOLOGY_DEV *)(RootEntry + Cache->RootBridgeCount);
+  for (Index = 0; Index < Cache->DeviceCount; Index++) {
+    if (Dev->Command != 0) {
+      PciExpressOr16 (Dev->Address + PCI_COMMAND_OFFSET, Dev->Command);
+    }
+    Dev = PCI_TOPOLOGY_NEXT_DEV (Dev);
+  }
+
+  Length = sizeof (PCI_ROOT_BRIDGE_INFO_HOB) + sizeof (PCI_ROOT_BRIDGE_ENTRY) * Cache->RootBridgeCount;
+  RootBridgeInfoHob = BuildGuidHob (&gLoaderPciRootBridgeInfoGuid, Length);
+  if (RootBridgeInfoHob != NULL) {
+    ZeroMem (RootBridgeInfoHob, Length);
+    RootBridgeInfoHob->Revision = 1;
+    RootBridgeInfoHob->Count    = Cache->RootBridgeCount;
+    CopyMem (RootBridgeInfoHob->Entry, RootEntry, sizeof (PCI_ROOT_BRIDGE_ENTRY) * Cache->RootBridgeCount);
+  }
+
+  DEBUG ((DEBUG_INFO, "PCI programmed from topology cache (%d devices)\n", Cache->DeviceCount));
+  return EFI_SUCCESS;
+}
+
+/**
+  Save the enumerated PCI topology and resource assignment into the cache.
+
+  The variable is only written when its content changes.
+
+  @param [in] EnumPolicy      PciEnum Policy with root bridge mask to be scanned
+  @param [in] ResAllocTable   PCI Resource Allocation Table
+  @param [in] RootBridges     A pointer which has Root Bridges in ChildList
+
+  @retval EFI_SUCCESS         The cache is up to date.
+  @retval EFI_BUFFER_TOO_SMALL The topology does not fit into the cache.
+  @retval Others              The cache could not be saved.
+
+**/
+EFI_STATUS
+PciSaveTopologyCache (
+  IN CONST  PCI_ENUM_POLICY_INFO  *EnumPolicy,
+  IN CONST  PCI_RES_ALLOC_TABLE   *ResAllocTable,
+  IN CONST  PCI_IO_DEVICE         *RootBridges
+  )
+{
+  EFI_STATUS                 Status;
+  PCI_TOPOLOGY_BUILDER       Builder;
+  PCI_TOPOLOGY_CACHE_HDR    *Cache;
+  PCI_ROOT_BRIDGE_INFO_HOB  *RootBridgeInfoHob;
+  LIST_ENTRY                *CurrentLink;
+  VOID                      *OldCache;
+  UINTN                      OldLength;
+
+  RootBridgeInfoHob = (PCI_ROOT_BRIDGE_INFO_HOB *)GetGuidHobData (NULL, NULL, &gLoaderPciRootBridgeInfoGuid);
+  if ((RootBridgeInfoHob == NULL) || (RootBridgeInfoHob->Count == 0)) {
+    return EFI_NOT_FOUND;
+  }
+
+  ZeroMem (&Builder, sizeof (Builder));
+  Builder.Buffer    = PciAllocatePool (PCI_TOPOLOGY_CACHE_MAX_SIZE);
+  Builder.MaxLength = PCI_TOPOLOGY_CACHE_MAX_SIZE;
+  Builder.Length    = sizeof (PCI_TOPOLOGY_CACHE_HDR) + sizeof (PCI_ROOT_BRIDGE_ENTRY) * RootBridgeInfoHob->Count;
+  if (Builder.Length > Builder.MaxLength) {
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Cache = (PCI_TOPOLOGY_CACHE_HDR *)Builder.Buffer;
+  CopyMem (Cache + 1, RootBridgeInfoHob->Entry, sizeof (PCI_ROOT_BRIDGE_ENTRY) * RootBridgeInfoHob->Count);
+
+  CurrentLink = RootBridges->ChildList.ForwardLink;
+  while ((CurrentLink != NULL) && (CurrentLink != &RootBridges->ChildList)) {
+    PciTopologyAddDevices (&Builder, PCI_IO_DEVICE_FROM_LINK (CurrentLink));
+    CurrentLink = CurrentLink->ForwardLink;
+  }
+
+  if (Builder.Overflow) {
+    DEBUG ((DEBUG_INFO, "PCI topology is too large to be cached\n"));
+    return EFI_BUFFER_TOO_SMALL;
+  }
+
+  Cache->Signature       = PCI_TOPOLOGY_CACHE_SIGNATURE;
+  Cache->Version         = PCI_TOPOLOGY_CACHE_VERSION;
+  Cache->RootBridgeCount = RootBridgeInfoHob->Count;
+  Cache->DeviceCount     = Builder.DeviceCount;
+  Cache->Length          = Builder.Length;
+  Cache->ConfigCrc       = PciTopologyConfigCrc (EnumPolicy, ResAllocTable);
+  Cache->DataCrc         = CalculateCrc32 ((VOID *)(Cache + 1), Builder.Length - sizeof (PCI_TOPOLOGY_CACHE_HDR));
+
+  //
+  // Avoid a flash write if the saved copy is identical
+  //
+  OldCache  = PciAllocatePool (PCI_TOPOLOGY_CACHE_MAX_SIZE);
+  OldLength = PCI_TOPOLOGY_CACHE_MAX_SIZE;
+  Status = GetVariable (PCI_TOPOLOGY_CACHE_NAME, NULL, &OldLength, OldCache);
+  if (!EFI_ERROR (Status) && (OldLength == Builder.Length) &&
+      (CompareMem (OldCache, Cache, Builder.Length) == 0)) {
+    return EFI_SUCCESS;
+  }
+
+  Status = SetVariable (PCI_TOPOLOGY_CACHE_NAME, 0, Builder.Length, Cache);
+  DEBUG ((DEBUG_INFO, "Save PCI topology cache (%d devices): %r\n", Builder.DeviceCount, Status));
+
+  return Status;
+}
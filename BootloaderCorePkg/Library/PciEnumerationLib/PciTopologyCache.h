@@ -0,0 +1,101 @@
+/** @file
+
+  Copyright (c) 2021, Intel Corporation. All rights reserved.<BR>
+  SPDX-License-Identifier: BSD-2-Clause-Patent
+
+**/
+
+#ifndef __PCI_TOPOLOGY_CACHE_H__
+#define __PCI_TOPOLOGY_CACHE_H__
+
+#define PCI_TOPOLOGY_CACHE_NAME         "PCITOPO"
+#define PCI_TOPOLOGY_CACHE_SIGNATURE    SIGNATURE_32 ('P', 'C', 'I', 'T')
+#define PCI_TOPOLOGY_CACHE_VERSION      2
+#define PCI_TOPOLOGY_CACHE_MAX_SIZE     0xC00
+
+#define PCI_TOPOLOGY_DEV_FLAG_BRIDGE    BIT0
+
+//
+// The cache holds the root bridge entries followed by one PCI_TOPOLOGY_DEV
+// per function in scan order. Each PCI_TOPOLOGY_DEV is followed by RegCount
+// PCI_TOPOLOGY_REG entries with the final register values to program.
+// SizeShift is log2 of the size decoded by a BAR (by one VF for a VF BAR)
+// in the entry of its lower register, and 0 in all other entries.
+//
+typedef struct {
+  UINT32                    Signature;
+  UINT8                     Version;
+  UINT8                     RootBridgeCount;
+  UINT16                    DeviceCount;
+  UINT32                    Length;
+  UINT32                    ConfigCrc;
+  UINT32                    DataCrc;
+} PCI_TOPOLOGY_CACHE_HDR;
+
+typedef struct {
+  UINT32                    Address;
+  UINT32                    Id;
+  UINT32                    ClassCode;
+  UINT16                    Command;
+  UINT8                     SecondaryBus;
+  UINT8                     SubordinateBus;
+  UINT8                     Flags;
+  UINT8                     RegCount;
+  UINT16                    Reserved;
+} PCI_TOPOLOGY_DEV;
+
+typedef struct {
+  UINT16                    Offset;
+  UINT8                     Width;
+  UINT8                     SizeShift;
+  UINT32                    Value;
+} PCI_TOPOLOGY_REG;
+
+/**
+  Program the PCI devices from the saved topology cache.
+
+  The saved topology is only used when the enumeration policy and the
+  resource allocation table are unchanged, and every function found while
+  walking the buses matches the saved VID/DID, class code and header type.
+  The saved BARs must still decode the saved sizes, and all bus numbers and
+  resources must be within the root bridge ranges of the resource allocation
+  table.
+
+  @param [in] EnumPolicy      PciEnum Policy with root bridge mask to be scanned
+  @param [in] ResAllocTable   PCI Resource Allocation Table
+
+  @retval EFI_SUCCESS         All devices are programmed from the cache.
+  @retval EFI_NOT_FOUND       No valid cache is available, or it holds registers
+                              that must not be programmed.
+  @retval EFI_NOT_READY       The topology or the resources changed, a full
+                              enumeration is required.
+
+**/
+EFI_STATUS
+PciRestoreTopologyCache (
+  IN CONST  PCI_ENUM_POLICY_INFO  *EnumPolicy,
+  IN CONST  PCI_RES_ALLOC_TABLE   *ResAllocTable
+  );
+
+/**
+  Save the enumerated PCI topology and resource assignment into the cache.
+
+  The variable is only written when its content changes.
+
+  @param [in] EnumPolicy      PciEnum Policy with root bridge mask to be scanned
+  @param [in] ResAllocTable   PCI Resource Allocation Table
+  @param [in] RootBridges     A pointer which has Root Bridges in ChildList
+
+  @retval EFI_SUCCESS         The cache is up to date.
+  @retval EFI_BUFFER_TOO_SMALL The topology does not fit into the cache.
+  @retval Others              The cache could not be saved.
+
+**/
+EFI_STATUS
+PciSaveTopologyCache (
+  IN CONST  PCI_ENUM_POLICY_INFO  *EnumPolicy,
+  IN CONST  PCI_RES_ALLOC_TABLE   *ResAllocTable,
+  IN CONST  PCI_IO_DEVICE         *RootBridges
+  );
+
+#endif // __PCI_TOPOLOGY_CACHE_H__
@@ -22,9 +22,11 @@ CONST DEBUG_LOG_BUFFER_HEADER mLogBufHdrTmpl = {
   DEBUG_LOG_BUFFER_SIGNATURE,
   sizeof (DEBUG_LOG_BUFFER_HEADER),
   0,
-  {0, 0},
+  0,
+  sizeof (DEBUG_LOG_BUFFER_HEADER),
+  FixedPcdGet32 (PcdEarlyLogBufferSize),
   sizeof (DEBUG_LOG_BUFFER_HEADER),
-  FixedPcdGet32 (PcdEarlyLogBufferSize)
+  0
 };
 
 //
@@ -7,6 +7,12 @@
 
 #include "Stage1B.h"
 
+//
+// Stage2 staging state used by the FSP-M event handler. It is only set when
+// Stage1B runs from CAR, where this variable is writable.
+//
+STATIC STAGE2_STAGING   *mStage2Staging;
+
 /**
   Callback function to add performance measure point during component loading.
 
@@ -43,6 +49,213 @@ LoadComponentCallback (
   }
 }
 
+/**
+  FSP-M event handler to stage Stage2 while memory is being initialized.
+
+  Each event reported by FSP-M copies and hashes one more chunk of Stage2
+  into CAR. It runs on the FSP-M stack with the FSP IDT loaded, so it must
+  not use the loader global data, including debug and performance output.
+
+  @param[in] Type        Indicates the type of event being reported.
+  @param[in] Value       Describes the current status of a hardware or software entity.
+  @param[in] Instance    The enumeration of a hardware or software entity.
+  @param[in] CallerId    Identifies the sub-module within the FSP generating the event.
+  @param[in] Data        Additional event specific data.
+
+  @retval EFI_SUCCESS    The event was handled successfully.
+
+**/
+STATIC
+EFI_STATUS
+EFIAPI
+Stage2StagingEventHandler (
+  IN          EFI_STATUS_CODE_TYPE   Type,
+  IN          EFI_STATUS_CODE_VALUE  Value,
+  IN          UINT32                 Instance,
+  IN OPTIONAL EFI_GUID               *CallerId,
+  IN OPTIONAL EFI_STATUS_CODE_DATA   *Data
+  )
+{
+  STAGE2_STAGING           *Staging;
+
+  Staging = mStage2Staging;
+  if ((Staging == NULL) || Staging->StageCtx.Complete) {
+    return EFI_SUCCESS;
+  }
+
+  if (Staging->EventCount == 0) {
+    Staging->StartTime = ReadTimeStamp ();
+  }
+  StageComponentStep (&Staging->StageCtx, STAGE2_STAGING_STEP_SIZE);
+  Staging->EndTime = ReadTimeStamp ();
+  Staging->EventCount++;
+
+  return EFI_SUCCESS;
+}
+
+/**
+  Start staging Stage2 into CAR during FSP memory initialization.
+
+  The FSP-M event handler is called in 32-bit mode, and it needs a writable
+  data section to find the staging state. So the staging is only done for
+  IA32 builds with a Stage1B that is not XIP.
+
+  @param[in]  Stage1bParam    Param pointer for Stage1B
+
+  @retval     The FSP-M event handler to install, or NULL if Stage2 is not staged.
+
+**/
+STATIC
+FSP_EVENT_HANDLER
+StartStage2Staging (
+  IN STAGE1B_PARAM   *Stage1bParam
+  )
+{
+  STAGE2_STAGING           *Staging;
+  EFI_STATUS                Status;
+  UINT32                    BufferSize;
+
+  BufferSize = FixedPcdGet32 (PcdStage2StagingSize);
+  if ((BufferSize == 0) || FeaturePcdGet (PcdStage1BXip) || IS_X64) {
+    return NULL;
+  }
+
+  Staging = (STAGE2_STAGING *)AllocatePool (sizeof (STAGE2_STAGING) + BufferSize);
+  if (Staging == NULL) {
+    DEBUG ((DEBUG_INFO, "No CAR space to stage Stage2\n"));
+    return NULL;
+  }
+
+  ZeroMem (Staging, sizeof (STAGE2_STAGING));
+  Status = StageComponentInit (&Staging->StageCtx, COMP_TYPE_STAGE_2, FLASH_MAP_SIG_STAGE2,
+                               Staging + 1, BufferSize);
+  if (!EFI_ERROR (Status) && (Staging->StageCtx.Length > BufferSize)) {
+    // The hash context cannot leave CAR before it is final, so it must all fit
+    Status = EFI_BUFFER_TOO_SMALL;
+  }
+  if (EFI_ERROR (Status)) {
+    DEBUG ((DEBUG_INFO, "Stage2 staging disabled - %r\n", Status));
+    FreePool (Staging);
+    return NULL;
+  }
+
+  mStage2Staging = Staging;
+  Stage1bParam->Stage2Staging = (UINT32)(UINTN)Staging;
+
+  return Stage2StagingEventHandler;
+}
+
+/**
+  Stop staging Stage2 from the FSP-M event handler.
+
+  The time spent on staging inside FSP memory initialization is recorded as a
+  span under the FSP MemoryInit span.
+
+**/
+STATIC
+VOID
+StopStage2Staging (
+  VOID
+  )
+{
+  STAGE2_STAGING           *Staging;
+
+  Staging = mStage2Staging;
+  if (Staging == NULL) {
+    return;
+  }
+  mStage2Staging = NULL;
+
+  if (Staging->EventCount > 0) {
+    AddMeasureSpan (0x2028, FLASH_MAP_SIG_STAGE2, PERF_SPAN_NO_DEVICE,
+                    Staging->StartTime, Staging->EndTime, Staging->StageCtx.Offset);
+  }
+  DEBUG ((DEBUG_INFO, "Staged 0x%X of 0x%X Stage2 bytes in %d FSP-M events\n",
+          Staging->StageCtx.Offset, Staging->StageCtx.Length, Staging->EventCount));
+}
+
+/**
+  Complete Stage2 staging and move it out of CAR.
+
+  It must be called before TempRamExit, since the hash context started in CAR
+  is only valid until its digests are final.
+
+  @param[in]  Stage1bParam    Param pointer for Stage1B
+
+  @retval     The Stage2 stage context in memory, or NULL if Stage2 is not staged.
+
+**/
+STATIC
+COMPONENT_STAGE_CTX *
+CompleteStage2Staging (
+  IN STAGE1B_PARAM   *Stage1bParam
+  )
+{
+  STAGE2_STAGING           *Staging;
+  COMPONENT_STAGE_CTX      *StageCtx;
+  VOID                     *Buffer;
+  UINT32                    Pages;
+
+  Staging = (STAGE2_STAGING *)(UINTN)Stage1bParam->Stage2Staging;
+  Stage1bParam->Stage2Staging = 0;
+  if (Staging == NULL) {
+    return NULL;
+  }
+
+  // Stage whatever FSP-M did not leave time for
+  StageComponentStep (&Staging->StageCtx, Staging->StageCtx.Length);
+
+  Pages    = EFI_SIZE_TO_PAGES (Staging->StageCtx.Length);
+  StageCtx = (COMPONENT_STAGE_CTX *)AllocatePool (sizeof (COMPONENT_STAGE_CTX));
+  Buffer   = AllocatePages (Pages);
+  if ((StageCtx == NULL) || (Buffer == NULL)) {
+    if (StageCtx != NULL) {
+      FreePool (StageCtx);
+    }
+    if (Buffer != NULL) {
+      FreePages (Buffer, Pages);
+    }
+    return NULL;
+  }
+
+  CopyMem (StageCtx, &Staging->StageCtx, sizeof (COMPONENT_STAGE_CTX));
+  RelocateStagedComponent (StageCtx, Buffer, EFI_PAGES_TO_SIZE (Pages));
+
+  return StageCtx;
+}
+
+/**
+  Initialize the image cache kept in loader reserved memory.
+
+  The components cached by the last boot are only kept across a warm reset.
+  They are dropped on power-on, global and watchdog resets, and when booting
+  for firmware update.
+
+  @param[in]  LdrGlobal       Loader global data in memory.
+
+**/
+STATIC
+VOID
+PrepareImageCache (
+  IN LOADER_GLOBAL_DATA    *LdrGlobal
+  )
+{
+  EFI_STATUS                Status;
+  BOOLEAN                   Reset;
+
+  if (LdrGlobal->ImageCachePtr == NULL) {
+    return;
+  }
+
+  Reset  = (BOOLEAN)((GetBootMode () == BOOT_ON_FLASH_UPDATE) ||
+                     ((GetResetReason () & (ResetPowerOn | ResetGlobal | ResetTcoWdt)) != 0));
+  Status = InitImageCache (LdrGlobal->ImageCachePtr, PcdGet32 (PcdLoaderImageCacheSize), Reset);
+  if (Status == EFI_INVALID_PARAMETER) {
+    LdrGlobal->ImageCachePtr = NULL;
+  }
+  DEBUG ((DEBUG_INFO, "Image cache @ 0x%08X: %r\n", LdrGlobal->ImageCachePtr, Status));
+}
+
 /**
   Prepare and load Stage2 into proper location for execution.
   - Load stage2 and check if compressed, if not CPU halted.
@@ -52,6 +265,7 @@ LoadComponentCallback (
   - uncompress stage2 and rebase if required.
 
   @param[in]  Stage1bParam    Param pointer for Stage1B
+  @param[in]  StageCtx        Stage2 copy staged ahead of time, or NULL.
 
   @retval     The base address of the stage.
               0 if loading fails
@@ -59,7 +273,8 @@ LoadComponentCallback (
 **/
 UINT32
 PrepareStage2 (
-  IN STAGE1B_PARAM   *Stage1bParam
+  IN STAGE1B_PARAM         *Stage1bParam,
+  IN COMPONENT_STAGE_CTX   *StageCtx  OPTIONAL
   )
 {
   UINT32                    Dst;
@@ -68,6 +283,7 @@ PrepareStage2 (
   EFI_STATUS                Status;
   UINT32                    Delta;
   STAGE_HDR                *StageHdr;
+  UINT32                    Span;
 
 
   if (FixedPcdGetBool (PcdStage2LoadHigh)) {
@@ -77,8 +293,16 @@ PrepareStage2 (
   }
 
   AddMeasurePoint (0x2080);
-  Status = LoadComponentWithCallback (COMP_TYPE_STAGE_2, FLASH_MAP_SIG_STAGE2,
-                                     &DstAdr, &DstLen, LoadComponentCallback);
+  Span   = BeginMeasureSpan (0x2080, FLASH_MAP_SIG_STAGE2, PERF_SPAN_NO_DEVICE);
+  if (StageCtx != NULL) {
+    Status = LoadStagedComponentWithCallback (StageCtx, &DstAdr, &DstLen, LoadComponentCallback);
+    FreePages (StageCtx->Buffer, EFI_SIZE_TO_PAGES (StageCtx->BufferSize));
+    FreePool (StageCtx);
+  } else {
+    Status = LoadComponentWithCallback (COMP_TYPE_STAGE_2, FLASH_MAP_SIG_STAGE2,
+                                       &DstAdr, &DstLen, LoadComponentCallback);
+  }
+  EndMeasureSpan (Span, EFI_ERROR (Status) ? 0 : DstLen);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Loading Stage2 error - %r !", Status));
     return 0;
@@ -336,6 +560,7 @@ SecStartup2 (
   UINT32                    MemPoolEnd;
   UINT32                    MemPoolCurrTop;
   UINT32                    DmaBuffer;
+  VOID                     *ImageCache;
   UINT32                    AllocateLen;
   UINT32                    Offset;
   UINT32                    Delta;
@@ -356,6 +581,8 @@ SecStartup2 (
   VOID                    **FieldPtr;
   UINT32                    Tolum;
   UINT64                    Touum;
+  UINT32                    Span;
+  FSP_EVENT_HANDLER         FspEventHandler;
 
   LdrGlobal = (LOADER_GLOBAL_DATA *)GetLoaderGlobalDataPointer ();
   ASSERT (LdrGlobal != NULL);
@@ -388,6 +615,11 @@ SecStartup2 (
   DEBUG ((DEBUG_INFO,  "Append public key hash into store: %r\n", Status));
 
   CreateConfigDatabase (LdrGlobal, &Stage1bParam);
+  if (PcdGet32 (PcdCfgDataSize) > 0) {
+    // Index the database so that the following lookups do not walk the blob
+    Status = BuildConfigDataIndex ();
+    DEBUG ((DEBUG_INFO, "Build CFG Data index ... %r\n", Status));
+  }
 
   // Overwrite platform ID if CFGDATA contains it
   PidCfgData = (PLATFORMID_CFG_DATA *)FindConfigDataByTag (CDATA_PLATFORMID_TAG);
@@ -413,7 +645,13 @@ SecStartup2 (
   HobList = NULL;
   DEBUG ((DEBUG_INIT, "Memory Init\n"));
   AddMeasurePoint (0x2020);
-  Status = CallFspMemoryInit (PCD_GET32_WITH_ADJUST (PcdFSPMBase), &HobList);
+  // The span table stays out of the Stage1A global data on the CAR stack
+  LdrGlobal->PerfData.Span = AllocateZeroPool (sizeof (PERFORMANCE_SPAN) * MAX_PERF_SPAN_NUM);
+  FspEventHandler = StartStage2Staging (&Stage1bParam);
+  Span   = BeginMeasureSpan (0x2030, 0, PERF_SPAN_NO_DEVICE);
+  Status = CallFspMemoryInit (PCD_GET32_WITH_ADJUST (PcdFSPMBase), &HobList, FspEventHandler);
+  StopStage2Staging ();
+  EndMeasureSpan (Span, 0);
   AddMeasurePoint (0x2030);
   FspResetHandler (Status);
   ASSERT_EFI_ERROR (Status);
@@ -435,6 +673,12 @@ SecStartup2 (
   IdtTablePtr    = (STAGE_IDT_TABLE *)(UINTN)MemPoolCurrTop;
   MemPoolCurrTop = ALIGN_DOWN (MemPoolCurrTop - sizeof (STAGE_GDT_TABLE), 0x10);
   GdtTablePtr    = (STAGE_GDT_TABLE *)(UINTN)MemPoolCurrTop;
+  // Keep the image cache at a fixed address so that it can survive a warm reset
+  ImageCache     = NULL;
+  if (PcdGet32 (PcdLoaderImageCacheSize) > 0) {
+    MemPoolCurrTop = ALIGN_DOWN (MemPoolCurrTop - PcdGet32 (PcdLoaderImageCacheSize), EFI_PAGE_SIZE);
+    ImageCache     = (VOID *)(UINTN)MemPoolCurrTop;
+  }
 
   if (FixedPcdGetBool (PcdS3DebugEnabled)) {
     SavedLdrHobList = LdrGlobal->LdrHobList;
@@ -449,6 +693,9 @@ SecStartup2 (
   LdrGlobal->MemPoolCurrTop    = MemPoolCurrTop;
   LdrGlobal->MemPoolCurrBottom = MemPoolStart;
   LdrGlobal->MemPoolMaxUsed    = 0;
+  LdrGlobal->MemPoolFreePages  = 0;
+  ZeroMem (LdrGlobal->MemPoolFreeList, sizeof (LdrGlobal->MemPoolFreeList));
+  LdrGlobal->ImageCachePtr     = ImageCache;
 
   if (FeaturePcdGet (PcdDmaProtectionEnabled)) {
     DmaBuffer = MemPoolStart - (PcdGet32 (PcdLoaderAcpiNvsSize) + PcdGet32 (PcdLoaderAcpiReclaimSize)
@@ -521,6 +768,18 @@ SecStartup2 (
     }
   }
 
+  // Move the span table allocated in CAR
+  if (LdrGlobal->PerfData.Span != NULL) {
+    BufPtr = AllocatePool (sizeof (PERFORMANCE_SPAN) * MAX_PERF_SPAN_NUM);
+    if (BufPtr != NULL) {
+      CopyMem (BufPtr, LdrGlobal->PerfData.Span, sizeof (PERFORMANCE_SPAN) * MAX_PERF_SPAN_NUM);
+    } else {
+      LdrGlobal->PerfData.SpanCount = 0;
+      LdrGlobal->PerfData.SpanOpen  = 0;
+    }
+    LdrGlobal->PerfData.Span = (PERFORMANCE_SPAN *)BufPtr;
+  }
+
   // Re-allocate Lib Data
   LibDataPtr  = (LIBRARY_DATA *) LdrGlobal->LibDataPtr;
   if (LibDataPtr != NULL) {
@@ -544,17 +803,13 @@ SecStartup2 (
   if (LdrGlobal->LogBufPtr != NULL) {
     if (PcdGet32 (PcdEarlyLogBufferSize) < PcdGet32 (PcdLogBufferSize)) {
       // If log buffer needs to be bigger post memory, increase it.
+      // Any deferred serial output stays pending in the new buffer.
       OldLogBuf = (DEBUG_LOG_BUFFER_HEADER *)LdrGlobal->LogBufPtr;
       NewLogBuf = (DEBUG_LOG_BUFFER_HEADER *)AllocatePool (PcdGet32 (PcdLogBufferSize));
       if (NewLogBuf != NULL) {
-        CopyMem ((VOID *)NewLogBuf, (VOID *)OldLogBuf, OldLogBuf->UsedLength);
-        NewLogBuf->TotalLength = PcdGet32 (PcdLogBufferSize);
-        LdrGlobal->LogBufPtr = NewLogBuf;
-        //
-        // No ring buffer manipulation here even if early log buffer was full.
-        // Simply clear FULL attribute and continue to overwrite logs.
-        //
-        NewLogBuf->Attribute &= (UINT8)~(DEBUG_LOG_BUFFER_ATTRIBUTE_FULL);
+        if (!RETURN_ERROR (DebugLogBufferCopy (NewLogBuf, PcdGet32 (PcdLogBufferSize), OldLogBuf))) {
+          LdrGlobal->LogBufPtr = NewLogBuf;
+        }
       }
     }
   }
@@ -645,6 +900,7 @@ ContinueFunc (
   LOADER_GLOBAL_DATA       *LdrGlobal;
   LOADER_GLOBAL_DATA       *OldLdrGlobal;
   TPMI_ALG_HASH             MbTmpAlgHash;
+  COMPONENT_STAGE_CTX      *Stage2StageCtx;
 
   Stage1bParam   = (STAGE1B_PARAM *)Context1;
   OldLdrGlobal = (LOADER_GLOBAL_DATA *)Context2;
@@ -671,6 +927,8 @@ ContinueFunc (
            ));
   DEBUG_CODE_END ();
 
+  Stage2StageCtx = CompleteStage2Staging (Stage1bParam);
+
   AddMeasurePoint (0x2050);
   Status = CallFspTempRamExit (PCD_GET32_WITH_ADJUST (PcdFSPMBase), NULL);
   AddMeasurePoint (0x2060);
@@ -714,7 +972,9 @@ ContinueFunc (
   DEBUG ((DEBUG_INFO, "Memory FSP @ 0x%08X\n", LdrGlobal->StackTop));
   DEBUG ((DEBUG_INFO, "Memory TOP @ 0x%08X\n", LdrGlobal->MemPoolStart));
 
-  Dst = PrepareStage2 (Stage1bParam);
+  PrepareImageCache (LdrGlobal);
+
+  Dst = PrepareStage2 (Stage1bParam, Stage2StageCtx);
   if (Dst == 0) {
     CpuHalt ("Failed to load Stage2!");
   }
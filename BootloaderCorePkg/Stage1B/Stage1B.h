@@ -39,8 +39,24 @@
 #include <Library/ContainerLib.h>
 #include <Guid/PcdDataBaseSignatureGuid.h>
 #include <Guid/LoaderPlatformDataGuid.h>
+#include <Guid/OsBootOptionGuid.h>
 #include <VerInfo.h>
 
+//
+// Bytes of Stage2 staged for each event reported by FSP-M
+//
+#define  STAGE2_STAGING_STEP_SIZE   SIZE_16KB
+
+//
+// Stage2 staging state shared with the FSP-M event handler
+//
+typedef struct {
+  COMPONENT_STAGE_CTX   StageCtx;
+  UINT32                EventCount;
+  UINT64                StartTime;
+  UINT64                EndTime;
+} STAGE2_STAGING;
+
 /**
   Continue Stage1B execution.
 
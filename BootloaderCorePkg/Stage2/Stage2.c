@@ -72,6 +72,7 @@ PreparePayload (
   UINT32                         ComponentName;
   UINT8                          BootMode;
   UINT64                         SignatureBuf;
+  UINT32                         Span;
 
   BootMode = GetBootMode();
   //
@@ -108,8 +109,10 @@ PreparePayload (
   AddMeasurePoint (0x3100);
   DstLen = 0;
   DstAdr = (VOID *)(UINTN)Dst;
+  Span   = BeginMeasureSpan (0x3100, ComponentName, PERF_SPAN_NO_DEVICE);
   Status = LoadComponentWithCallback (ContainerSig, ComponentName,
                                       &DstAdr, &DstLen, LoadComponentCallback);
+  EndMeasureSpan (Span, EFI_ERROR (Status) ? 0 : DstLen);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Loading payload error - %r !", Status));
     return 0;
@@ -152,6 +155,7 @@ NormalBootPath (
   UINT16                          PldMachine;
   LOADED_PAYLOAD_INFO             PayloadInfo;
   UNIVERSAL_PAYLOAD_EXTRA_DATA   *PldImgInfo;
+  LOAD_COMPONENT_REQUEST          LoadReq[2];
 
   LdrGlobal = (LOADER_GLOBAL_DATA *)GetLoaderGlobalDataPointer();
 
@@ -214,9 +218,19 @@ NormalBootPath (
         InitRdLen  = 0;
         CmdLine    = NULL;
         CmdLineLen = 0;
-        Status = LoadComponent (FLASH_MAP_SIG_EPAYLOAD, SIGNATURE_32 ('C', 'M', 'D', 'L'),
-                                (VOID **)&CmdLine, &CmdLineLen);
-        if (!EFI_ERROR (Status)) {
+
+        // Load command line and InitRd together so that they can be
+        // authenticated and decompressed in parallel
+        ZeroMem (LoadReq, sizeof (LoadReq));
+        LoadReq[0].ContainerSig  = FLASH_MAP_SIG_EPAYLOAD;
+        LoadReq[0].ComponentName = SIGNATURE_32 ('C', 'M', 'D', 'L');
+        LoadReq[1].ContainerSig  = FLASH_MAP_SIG_EPAYLOAD;
+        LoadReq[1].ComponentName = SIGNATURE_32 ('I', 'N', 'R', 'D');
+        LoadComponentListWithCallback (LoadReq, ARRAY_SIZE (LoadReq), NULL);
+
+        if (!EFI_ERROR (LoadReq[0].Status)) {
+          CmdLine    = (UINT8 *)LoadReq[0].Buffer;
+          CmdLineLen = LoadReq[0].Length;
           // Limit max command line length
           if (CmdLineLen > CMDLINE_LENGTH_MAX - 1) {
             CmdLineLen = CMDLINE_LENGTH_MAX - 1;
@@ -225,10 +239,10 @@ NormalBootPath (
           DEBUG ((DEBUG_INFO, "Kernel command line: \n%a\n", CmdLine));
         }
 
-        // Try to load InitRd if it exists. If loading fails, continue booting
-        Status = LoadComponent (FLASH_MAP_SIG_EPAYLOAD, SIGNATURE_32 ('I', 'N', 'R', 'D'),
-                                (VOID **)&InitRd, &InitRdLen);
-        if (!EFI_ERROR (Status)) {
+        // Use InitRd if it exists. If loading fails, continue booting
+        if (!EFI_ERROR (LoadReq[1].Status)) {
+          InitRd    = LoadReq[1].Buffer;
+          InitRdLen = LoadReq[1].Length;
           DEBUG ((DEBUG_INFO, "InitRD is loaded at 0x%x:0x%x\n", InitRd, InitRdLen));
         }
         PldEntry = (PAYLOAD_ENTRY)(UINTN)LinuxBoot;
@@ -301,6 +315,8 @@ NormalBootPath (
       }
     }
     DEBUG ((DEBUG_INIT, "Jump to payload\n\n"));
+    // Deferred serial output not sent yet is handed over to the payload
+    // along with the log buffer, so it is not flushed here.
     if (PldMachine == IMAGE_FILE_MACHINE_X64) {
       // Need to call in x64 long mode
       Execute64BitCode ((UINT64)(UINTN)PldEntry, (UINT64)(UINTN)PldHobList,
@@ -380,6 +396,7 @@ SecStartup (
   VOID                           *NvsData;
   UINT32                          MrcDataLen;
   VOID                           *MemPool;
+  UINT32                          Span;
   UINT32                          Delta;
   UINT32                          AcpiGnvs;
   UINT32                          AcpiBase;
@@ -446,7 +463,9 @@ SecStartup (
 
   DEBUG ((DEBUG_INIT, "Silicon Init\n"));
   AddMeasurePoint (0x3020);
+  Span   = BeginMeasureSpan (0x3030, 0, PERF_SPAN_NO_DEVICE);
   Status = CallFspSiliconInit ();
+  EndMeasureSpan (Span, 0);
   AddMeasurePoint (0x3030);
   FspResetHandler (Status);
   ASSERT_EFI_ERROR (Status);
@@ -517,7 +536,9 @@ SecStartup (
   if (FixedPcdGetBool (PcdPciEnumEnabled)) {
     MemPool = AllocateTemporaryMemory (0);
     DEBUG ((DEBUG_INIT, "PCI Enum\n"));
+    Span   = BeginMeasureSpan (0x30A0, 0, PERF_SPAN_NO_DEVICE);
     Status = PciEnumeration (MemPool);
+    EndMeasureSpan (Span, 0);
     AddMeasurePoint (0x30A0);
     UpdateGraphicsHob ();
     BoardInit (PostPciEnumeration);
@@ -531,6 +552,12 @@ SecStartup (
     }
     ASSERT_EFI_ERROR (Status);
 
+    // Let the boot device power up while the rest of Stage2 runs
+    if (FeaturePcdGet (PcdEarlyBootDeviceInitEnabled) && !EFI_ERROR (Status) &&
+        (BootMode != BOOT_ON_S3_RESUME) && (GetPayloadId () == 0)) {
+      EarlyBootDeviceInit ();
+    }
+
     if (FixedPcdGetBool (PcdSplashEnabled)) {
       if (SplashPostPci) {
         DisplaySplash ();
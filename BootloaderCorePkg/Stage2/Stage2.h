@@ -41,6 +41,7 @@
 #include <Library/ThunkLib.h>
 #include <Library/LocalApicLib.h>
 #include <Library/ContainerLib.h>
+#include <Library/MmcAccessLib.h>
 #include <Guid/BootLoaderServiceGuid.h>
 #include <Guid/BootLoaderVersionGuid.h>
 #include <Guid/LoaderPlatformInfoGuid.h>
@@ -179,4 +180,17 @@ UpdateGraphicsHob (
   VOID
   );
 
+/**
+  Start the initialization of the boot device early.
+
+  The controller state is handed over to the payload through the library
+  data HOB.
+
+**/
+VOID
+EFIAPI
+EarlyBootDeviceInit (
+  VOID
+  );
+
 #endif
@@ -812,6 +812,8 @@ BuildExtraInfoHob (
   SYSTEM_TABLE_INFO                *SystemTableInfo;
   SYS_CPU_INFO                     *SysCpuInfo;
   PERFORMANCE_INFO                 *PerformanceInfo;
+  PERFORMANCE_TIMELINE_INFO        *PerformanceTimeline;
+  UINTN                            FpdtBootTable;
   OS_BOOT_OPTION_LIST              *OsBootOptionInfo;
   LOADER_PLATFORM_INFO             *LoaderPlatformInfo;
   LOADER_PLATFORM_DATA             *LoaderPlatformData;
@@ -935,6 +937,26 @@ BuildExtraInfoHob (
     CopyMem (PerformanceInfo->TimeStamp, LdrGlobal->PerfData.TimeStamp, sizeof (UINT64) * Count);
   }
 
+  // Build Performance timeline Hob, and export the spans into FPDT
+  FpdtBootTable = 0;
+  if (S3Data->AcpiBase != 0) {
+    FpdtBootTable = GetFpdtBootTable (S3Data->AcpiBase);
+    if (FpdtBootTable != 0) {
+      UpdateFpdtSpanRecords ((EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *)FpdtBootTable, &LdrGlobal->PerfData);
+    }
+  }
+  Count  = (LdrGlobal->PerfData.Span == NULL) ? 0 : MIN (LdrGlobal->PerfData.SpanCount, MAX_PERF_SPAN_NUM);
+  Length = sizeof (PERFORMANCE_TIMELINE_INFO) + sizeof (PERFORMANCE_SPAN) * Count;
+  PerformanceTimeline = BuildGuidHob (&gLoaderPerformanceTimelineGuid, Length);
+  if (PerformanceTimeline != NULL) {
+    ZeroMem (PerformanceTimeline, sizeof (PERFORMANCE_TIMELINE_INFO));
+    PerformanceTimeline->Revision      = 1;
+    PerformanceTimeline->Count         = (UINT16)Count;
+    PerformanceTimeline->Frequency     = LdrGlobal->PerfData.FreqKhz;
+    PerformanceTimeline->FpdtBootTable = FpdtBootTable;
+    CopyMem (PerformanceTimeline->Span, LdrGlobal->PerfData.Span, sizeof (PERFORMANCE_SPAN) * Count);
+  }
+
   // Build Loader Platform info Hob
   Length       = sizeof (LOADER_PLATFORM_INFO);
   LoaderPlatformInfo = BuildGuidHob (&gLoaderPlatformInfoGuid, Length);
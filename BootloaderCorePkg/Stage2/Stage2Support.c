@@ -173,3 +173,59 @@ InitializeService (
   RegisterService ((VOID *)&mPlatformService);
 
 }
+
+/**
+  Start the initialization of the boot device early.
+
+  The controller of the first OS boot option is reset and the card is asked
+  to power up right after PCI enumeration. The card then becomes ready while
+  Stage2 continues with ACPI and payload loading. The controller state is
+  kept in the library data, which the payload receives through the library
+  data HOB, so the payload only completes the initialization.
+
+  Only eMMC and SD are supported, since no other block device library keeps
+  its state in the library data.
+
+**/
+VOID
+EFIAPI
+EarlyBootDeviceInit (
+  VOID
+  )
+{
+  OS_BOOT_OPTION_LIST            *OsBootOptionList;
+  OS_BOOT_OPTION                 *OsBootOption;
+  EFI_STATUS                      Status;
+  UINTN                           DevPciBase;
+  UINT32                          Length;
+  UINT32                          Span;
+
+  Length = sizeof (OS_BOOT_OPTION_LIST) + sizeof (OS_BOOT_OPTION) * PcdGet32 (PcdOsBootOptionNumber);
+  OsBootOptionList = AllocateTemporaryMemory (Length);
+  if (OsBootOptionList == NULL) {
+    return;
+  }
+
+  ZeroMem (OsBootOptionList, Length);
+  OsBootOptionList->Revision = 1;
+  PlatformUpdateHobInfo (&gOsBootOptionGuid, OsBootOptionList);
+
+  OsBootOption = &OsBootOptionList->OsBootOption[0];
+  if ((OsBootOptionList->OsBootOptionCount > 0) &&
+      ((OsBootOption->DevType == OsBootDeviceEmmc) || (OsBootOption->DevType == OsBootDeviceSd))) {
+    DevPciBase = GetDeviceAddr (OsBootOption->DevType, OsBootOption->DevInstance);
+    if (DevPciBase != 0) {
+      DevPciBase = TO_MM_PCI_ADDRESS (DevPciBase);
+      Span = BeginMeasureSpan (0x30B8, 0, OsBootOption->DevType);
+      if (OsBootOption->DevType == OsBootDeviceEmmc) {
+        Status = MmcInitialize (DevPciBase, DevInitOnlyPhase1);
+      } else {
+        Status = SdInitialize (DevPciBase, DevInitOnlyPhase1);
+      }
+      EndMeasureSpan (Span, 0);
+      DEBUG ((DEBUG_INFO, "Early boot device %d init - %r\n", OsBootOption->DevType, Status));
+    }
+  }
+
+  FreeTemporaryMemory (OsBootOptionList);
+}
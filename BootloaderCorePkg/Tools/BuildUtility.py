@@ -85,6 +85,7 @@ IPP_CRYPTO_OPTIMIZATION_MASK = {
     "SHA256_NI"       : 0x0002,
     "SHA384_W7"       : 0x0004,
     "SHA384_G9"       : 0x0008,
+    "SHA384_L9"       : 0x0010,
     }
 
 IPP_CRYPTO_ALG_MASK = {
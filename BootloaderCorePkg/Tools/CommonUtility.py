@@ -111,6 +111,7 @@ class LZ_HEADER(Structure):
         b'LZDM' : 'Dummy',
         b'LZ4 ' : 'Lz4',
         b'LZMA' : 'Lzma',
+        b'ZSTD' : 'Zstd',
     }
 
 def print_bytes (data, indent=0, offset=0, show_ascii = False):
@@ -346,6 +347,8 @@ def decompress (in_file, out_file, tool_dir = ''):
         alg = "Lzma"
     elif lz_hdr.signature == b"LZ4 ":
         alg = "Lz4"
+    elif lz_hdr.signature == b"ZSTD":
+        alg = "Zstd"
     else:
         raise Exception ("Unsupported compression '%s' !" % lz_hdr.signature)
 
@@ -374,6 +377,24 @@ def decompress (in_file, out_file, tool_dir = ''):
             decompress_data = lz4.block.decompress(get_file_data(temp))
             with open(out_file, "wb") as lz4bin:
                 lz4bin.write(decompress_data)
+    elif alg == "Zstd":
+        try:
+            cmdline = [
+                os.path.join (tool_dir, compress_tool),
+                "-d",
+                "-o", out_file,
+                temp]
+            run_process (cmdline, False, True)
+        except:
+            print("Could not find/use ZstdCompress tool, trying with python zstandard...")
+            try:
+                import zstandard
+            except ImportError:
+                print("Could not import zstandard, use 'python -m pip install zstandard' to install it.")
+                exit(1)
+            decompress_data = zstandard.ZstdDecompressor().decompress(get_file_data(temp))
+            with open(out_file, "wb") as zstdbin:
+                zstdbin.write(decompress_data)
     else:
         cmdline = [
             os.path.join (tool_dir, compress_tool),
@@ -402,6 +423,8 @@ def compress (in_file, alg, svn=0, out_path = '', tool_dir = ''):
         sig = "LZUF"
     elif alg == "Lz4":
         sig = "LZ4 "
+    elif alg == "Zstd":
+        sig = "ZSTD"
     elif alg == "Dummy":
         sig = "LZDM"
     else:
@@ -432,6 +455,25 @@ def compress (in_file, alg, svn=0, out_path = '', tool_dir = ''):
                     print("Could not import lz4, use 'python -m pip install lz4==3.1.1' to install it.")
                     exit(1)
                 compress_data = lz4.block.compress(get_file_data(in_file), mode='high_compression')
+        elif sig == "ZSTD":
+            try:
+                cmdline = [
+                    os.path.join (tool_dir, compress_tool),
+                    "-e",
+                    "-o", out_file,
+                    in_file]
+                run_process (cmdline, False, True)
+                compress_data = get_file_data(out_file)
+            except:
+                print("Could not find/use ZstdCompress tool, trying with python zstandard...")
+                try:
+                    import zstandard
+                except ImportError:
+                    print("Could not import zstandard, use 'python -m pip install zstandard' to install it.")
+                    exit(1)
+                # Match ZstdCompress: one frame with content size and no checksum
+                cctx = zstandard.ZstdCompressor(level=19, write_content_size=True, write_checksum=False, write_dict_id=False)
+                compress_data = cctx.compress(get_file_data(in_file))
         elif sig == "LZMA":
             cmdline = [
                 os.path.join (tool_dir, compress_tool),
@@ -42,6 +42,8 @@ def decompress_comp (fsp, fspc, in_file, out_file, compress_tool_dir):
         fsp[fspc]['lz'] = 'Lz4'
     elif data[0:4] == b'LZMA':
         fsp[fspc]['lz'] = 'Lzma'
+    elif data[0:4] == b'ZSTD':
+        fsp[fspc]['lz'] = 'Zstd'
     else:
         fsp[fspc]['lz'] = ''
         shutil.copyfile (in_file, out_file)
@@ -27,7 +27,7 @@ from   BuildUtility import *
 import glob
 
 def rebuild_basetools ():
-    exe_list = 'GenFfs  GenFv  GenFw  GenSec  Lz4Compress  LzmaCompress'.split()
+    exe_list = 'GenFfs  GenFv  GenFw  GenSec  Lz4Compress  LzmaCompress  ZstdCompress'.split()
     ret = 0
     sblsource = os.environ['SBL_SOURCE']
 
@@ -160,7 +160,7 @@ class BaseBoard(object):
         self.ENABLE_SPLASH         = 0
         self.ENABLE_FRAMEBUFFER_INIT = 0
         self.ENABLE_PRE_OS_CHECKER = 0
-        self.ENABLE_CRYPTO_SHA_OPT  = IPP_CRYPTO_OPTIMIZATION_MASK['SHA256_V8']
+        self.ENABLE_CRYPTO_SHA_OPT  = IPP_CRYPTO_OPTIMIZATION_MASK['SHA256_V8'] | IPP_CRYPTO_OPTIMIZATION_MASK['SHA256_NI']
         self.ENABLE_FWU            = 0
         self.ENABLE_SOURCE_DEBUG   = 0
         self.ENABLE_GRUB_CONFIG    = 0
@@ -175,6 +175,7 @@ class BaseBoard(object):
         self.ENABLE_PAYLOD_MODULE  = 0
         self.ENABLE_FAST_BOOT      = 0
         self.ENABLE_LEGACY_EF_SEG  = 1
+        self.ENABLE_EARLY_BOOT_DEVICE_INIT = 0
         # 0: Disable  1: Enable  2: Auto (disable for UEFI payload, enable for others)
         self.ENABLE_SMM_REBASE     = 0
 
@@ -208,6 +209,9 @@ class BaseBoard(object):
         self.STAGE1_STACK_BASE_OFFSET = 0
         self.STAGE2_XIP            = 0
         self.STAGE2_LOAD_HIGH      = 1
+        # CAR buffer to copy and hash STAGE2 while FSP-M initializes memory.
+        # It is allocated from STAGE1_DATA_SIZE. 0 disables the staging.
+        self.STAGE2_STAGING_SIZE   = 0
         self.PAYLOAD_LOAD_HIGH     = 1
         self.PAYLOAD_EXE_BASE      = 0x00800000
 
@@ -229,6 +233,9 @@ class BaseBoard(object):
         self.LOADER_RSVD_MEM_SIZE         = 0x0038C000
         self.LOADER_ACPI_NVS_MEM_SIZE     = 0x00008000
         self.LOADER_ACPI_RECLAIM_MEM_SIZE = 0x00068000
+        # Part of LOADER_RSVD_MEM_SIZE to keep the signed STAGE2 and payload
+        # across warm resets. It needs verified boot. 0 disables the cache.
+        self.LOADER_IMAGE_CACHE_SIZE      = 0
 
         self.CFGDATA_REGION_TYPE   = FLASH_REGION_TYPE.BIOS
 
@@ -22,6 +22,12 @@
 #include "FirmwareUpdateHelper.h"
 #include <Service/SpiFlashService.h>
 
+//
+// Number of changed 4KB sectors in a 64KB sector to erase the full sector
+//
+#define FWU_SECTOR_ERASE_THRESHOLD   4
+#define FWU_PROGRAM_PAGE_SIZE        256
+
 SPI_FLASH_SERVICE   *mFwuSpiService = NULL;
 
 /**
@@ -256,12 +262,93 @@ GetVersionfromFv (
   return EFI_SUCCESS;
 }
 
+/**
+  Check if a buffer only contains erased flash bytes.
+
+  @param[in] Buffer           The buffer to check.
+  @param[in] Length           The buffer length in bytes.
+
+  @retval  TRUE               All the bytes are 0xFF.
+  @retval  FALSE              Some bytes are not 0xFF.
+**/
+STATIC
+BOOLEAN
+IsErasedBuffer (
+  IN  UINT8     *Buffer,
+  IN  UINT32    Length
+  )
+{
+  UINT32        Index;
+
+  for (Index = 0; Index < Length; Index++) {
+    if (Buffer[Index] != 0xFF) {
+      return FALSE;
+    }
+  }
+  return TRUE;
+}
+
+/**
+  Write data into an erased boot media range.
+
+  The pages that only contain 0xFF are skipped since they are already
+  in that state after erasing.
+
+  @param[in] Address          The boot media address to write.
+  @param[in] Buffer           The source buffer to write to the boot media.
+  @param[in] Length           The length of data to write to boot media.
+
+  @retval  EFI_SUCCESS        Write successfully.
+  @retval  others             Error happening when writing.
+**/
+STATIC
+EFI_STATUS
+WriteErasedRange (
+  IN  UINT64    Address,
+  IN  UINT8     *Buffer,
+  IN  UINT32    Length
+  )
+{
+  EFI_STATUS    Status;
+  UINT32        Offset;
+  UINT32        Start;
+  UINT32        PageLen;
+
+  Status = EFI_SUCCESS;
+  Start  = 0;
+  for (Offset = 0; Offset < Length; Offset += PageLen) {
+    PageLen = MIN (FWU_PROGRAM_PAGE_SIZE, Length - Offset);
+    if (IsErasedBuffer (Buffer + Offset, PageLen)) {
+      // Flush the pending pages before the blank one
+      if (Offset > Start) {
+        Status = BootMediaWrite (Address + Start, Offset - Start, Buffer + Start);
+        if (EFI_ERROR (Status)) {
+          return Status;
+        }
+      }
+      Start = Offset + PageLen;
+    }
+  }
+
+  if (Length > Start) {
+    Status = BootMediaWrite (Address + Start, Length - Start, Buffer + Start);
+  }
+
+  return Status;
+}
+
 /**
   Update a region block.
 
   This is the acture function to update boot meia. It will erase boot device,
   write new data to boot device, and verify the written data.
 
+  The block is processed in windows of up to one 64KB erase sector. Each window
+  is read and compared with the new data in a single pass to find the changed
+  4KB sectors. A window with many changed sectors is erased with a single 64KB
+  erase when it is 64KB aligned, otherwise each run of changed sectors is erased
+  and written in one request. Only the changed sectors are read back to verify.
+
   @param[in] Address          The boot media address to be update.
   @param[in] Buffer           The source buffer to write to the boot media.
   @param[in] Length           The length of data to write to boot media.
@@ -279,81 +366,113 @@ UpdateRegionBlock (
 {
   EFI_STATUS    Status;
   UINT8         *ReadBuffer;
-  UINT32        Count;
-  UINT32        BlockLen;
   UINT8         *Src;
-
-  ReadBuffer = NULL;
+  UINT32        Count;
+  UINT32        WinLen;
+  UINT32        Sector;
+  UINT32        SectorNum;
+  UINT32        SectorLen;
+  UINT32        DirtyMask;
+  UINT32        DirtyNum;
+  UINT32        RunStart;
+  UINT32        RunEnd;
+  UINT32        RunLen;
 
   if (Length == 0) {
     return EFI_SUCCESS;
   }
 
-  ReadBuffer = AllocatePages (EFI_SIZE_TO_PAGES (SIZE_4KB));
+  ReadBuffer = AllocatePages (EFI_SIZE_TO_PAGES (SIZE_64KB));
   if (ReadBuffer == NULL) {
     return EFI_OUT_OF_RESOURCES;
   }
 
-  BlockLen   = SIZE_4KB;
-  Src = (UINT8 *)Buffer;
+  Status = EFI_SUCCESS;
+  for (Count = 0; Count < Length; Count += WinLen) {
+    //
+    // Stop each window at the next 64KB boundary
+    //
+    WinLen = SIZE_64KB - (UINT32)((Address + Count) & (SIZE_64KB - 1));
+    WinLen = MIN (WinLen, Length - Count);
+    Src    = (UINT8 *)Buffer + Count;
 
-  //
-  // Read, compare, erase, write, read, compare
-  //
-  for (Count = 0; Count < Length; Count += BlockLen) {
     //
-    // If updating region less than 4K bytes,
-    // adjust the block length to size remaining, i.e less than 4k
+    // Read the whole window once and find the changed 4KB sectors
     //
-    if (Count + BlockLen > Length) {
-      BlockLen = Length - Count;
-    }
-    Status = BootMediaRead(Address + Count, BlockLen, ReadBuffer);
+    Status = BootMediaRead (Address + Count, WinLen, ReadBuffer);
     if (EFI_ERROR (Status)) {
       DEBUG ((DEBUG_ERROR, "BootMediaRead.  readaddr: 0x%llx, Status = 0x%x\n", Address + Count, Status));
       goto End;
     }
 
-    if (CompareMem (Src + Count, ReadBuffer, BlockLen) == 0) {
+    SectorNum = (WinLen + SIZE_4KB - 1) / SIZE_4KB;
+    DirtyMask = 0;
+    DirtyNum  = 0;
+    for (Sector = 0; Sector < SectorNum; Sector++) {
+      SectorLen = MIN (SIZE_4KB, WinLen - Sector * SIZE_4KB);
+      if (CompareMem (Src + Sector * SIZE_4KB, ReadBuffer + Sector * SIZE_4KB, SectorLen) != 0) {
+        DirtyMask |= (1 << Sector);
+        DirtyNum++;
+      }
+    }
+
+    if (DirtyNum == 0) {
       DEBUG ((DEBUG_INIT, "."));
       continue;
     }
 
-    //
-    // Erase the boot media
-    // Block length for erase is always 4K bytes
-    //
-    DEBUG ((DEBUG_INIT, "x"));
-    Status = BootMediaErase ((UINT32) (Address + Count),  SIZE_4KB);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "ERROR: in BootMediaErase. Status = 0x%x\n", Status));
-      goto End;
+    if ((WinLen == SIZE_64KB) && (DirtyNum >= FWU_SECTOR_ERASE_THRESHOLD)) {
+      //
+      // Erase the full 64KB sector at once and write back the whole window.
+      // The SPI driver uses the 64KB erase opcode if the flash part supports it.
+      //
+      DEBUG ((DEBUG_INIT, "X"));
+      DirtyMask = (1 << SectorNum) - 1;
+    } else {
+      DEBUG ((DEBUG_INIT, "x"));
     }
 
     //
-    // Write to the boot media
+    // Erase and write each run of changed sectors
     //
-    Status = BootMediaWrite ((UINT32) (Address + Count),  BlockLen, Src + Count);
-    if (EFI_ERROR (Status)) {
-      DEBUG ((DEBUG_ERROR, "ERROR: in BootDeviceWrite. Status = 0x%x\n", Status));
-      goto End;
-    }
+    for (RunStart = 0; RunStart < SectorNum; RunStart = RunEnd) {
+      if ((DirtyMask & (1 << RunStart)) == 0) {
+        RunEnd = RunStart + 1;
+        continue;
+      }
+      for (RunEnd = RunStart + 1; (RunEnd < SectorNum) && ((DirtyMask & (1 << RunEnd)) != 0); RunEnd++) {
+      }
+      RunLen = MIN (RunEnd * SIZE_4KB, WinLen) - RunStart * SIZE_4KB;
+
+      //
+      // Block length for erase is always 4K bytes aligned
+      //
+      Status = BootMediaErase ((UINT32) (Address + Count + RunStart * SIZE_4KB), (RunEnd - RunStart) * SIZE_4KB);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "ERROR: in BootMediaErase. Status = 0x%x\n", Status));
+        goto End;
+      }
 
-    //
-    // Verify the written data
-    //
-    Status = BootMediaRead (Address + Count, BlockLen, ReadBuffer);
-    if (CompareMem (Src + Count, ReadBuffer, BlockLen) != 0) {
-      DEBUG ((DEBUG_ERROR, "Verify Error !\n"));
-      Status = EFI_DEVICE_ERROR;
-      goto End;
+      Status = WriteErasedRange (Address + Count + RunStart * SIZE_4KB, Src + RunStart * SIZE_4KB, RunLen);
+      if (EFI_ERROR (Status)) {
+        DEBUG ((DEBUG_ERROR, "ERROR: in BootDeviceWrite. Status = 0x%x\n", Status));
+        goto End;
+      }
+
+      //
+      // Verify the written data
+      //
+      Status = BootMediaRead (Address + Count + RunStart * SIZE_4KB, RunLen, ReadBuffer);
+      if (EFI_ERROR (Status) || (CompareMem (Src + RunStart * SIZE_4KB, ReadBuffer, RunLen) != 0)) {
+        DEBUG ((DEBUG_ERROR, "Verify Error !\n"));
+        Status = EFI_DEVICE_ERROR;
+        goto End;
+      }
     }
   }
 
 End:
-  if (ReadBuffer != NULL) {
-    FreePages (ReadBuffer, EFI_SIZE_TO_PAGES (SIZE_4KB));
-  }
+  FreePages (ReadBuffer, EFI_SIZE_TO_PAGES (SIZE_64KB));
 
   return Status;
 }
@@ -394,10 +513,12 @@ UpdateBootRegion (
     if (UpdateRegion->UpdateSize < SIZE_4KB) {
       UpdateBlockSize = UpdateRegion->UpdateSize;
     } else {
-      if (UpdatedSize + SIZE_64KB > UpdateRegion->UpdateSize) {
+      //
+      // Keep the blocks 64KB aligned so that full sector erase can be used
+      //
+      UpdateBlockSize = SIZE_64KB - (UINT32)(UpdateAddress & (SIZE_64KB - 1));
+      if (UpdatedSize + UpdateBlockSize > UpdateRegion->UpdateSize) {
         UpdateBlockSize = UpdateRegion->UpdateSize - UpdatedSize;
-      } else {
-        UpdateBlockSize = SIZE_64KB;
       }
     }
     DEBUG ((DEBUG_INIT, "Updating 0x%08llx, Size:0x%05x\n", UpdateAddress, UpdateBlockSize));
@@ -133,9 +133,12 @@ PayloadInit (
 
     DebugLogBufferHdr  = LoaderPlatformData->DebugLogBuffer;
     if (DebugLogBufferHdr->Signature == DEBUG_LOG_BUFFER_SIGNATURE) {
+      // Continue sending out the deferred serial output from the new buffer
       BufPtr = AllocatePool (DebugLogBufferHdr->TotalLength);
-      CopyMem (BufPtr, DebugLogBufferHdr, DebugLogBufferHdr->UsedLength);
-      GlobalDataPtr->LogBufPtr = BufPtr;
+      if ((BufPtr != NULL) && !RETURN_ERROR (DebugLogBufferCopy ((DEBUG_LOG_BUFFER_HEADER *)BufPtr,
+                                              DebugLogBufferHdr->TotalLength, DebugLogBufferHdr))) {
+        GlobalDataPtr->LogBufPtr = BufPtr;
+      }
     }
 
     ContainerList = LoaderPlatformData->ContainerList;
@@ -267,6 +270,7 @@ SecStartup (
   //
   // GetLoaderPerformanceInfo() function
   //
+  GlobalDataPtr->PerfData.Span = AllocateZeroPool (sizeof (PERFORMANCE_SPAN) * MAX_PERF_SPAN_NUM);
   GetLoaderPerformanceInfo (&GlobalDataPtr->PerfData);
   AddMeasurePointTimestamp (0x4000, TimeStamp);
 
@@ -331,3 +331,20 @@ GetHashStorePtr (
 
   return PayloadGlobalDataPtr->HashStorePtr;
 }
+
+/**
+  This function retrieves the image cache pointer.
+
+  The image cache is owned by the bootloader, so it is not used by payloads.
+
+  @retval    NULL.
+
+**/
+VOID *
+EFIAPI
+GetImageCachePtr (
+  VOID
+  )
+{
+  return NULL;
+}
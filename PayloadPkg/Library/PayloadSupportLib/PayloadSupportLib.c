@@ -265,7 +265,8 @@ GetPayloadReservedRamRegion (
 /**
   Returns the timestamps data.
 
-  Finds timestamps data from loader performance info hob
+  Finds timestamps data from loader performance info hob, and the
+  performance spans from loader performance timeline hob if present.
 
   @param[out] PerfData  Pointer to loader performance data.
 
@@ -280,6 +281,7 @@ GetLoaderPerformanceInfo (
 {
   EFI_HOB_GUID_TYPE             *GuidHob;
   PERFORMANCE_INFO              *PerfInfo;
+  PERFORMANCE_TIMELINE_INFO     *PerfTimeline;
 
   GuidHob = GetNextGuidHob (&gLoaderPerformanceInfoGuid, (VOID *)(UINTN)PcdGet32 (PcdPayloadHobList));
   if (GuidHob == NULL) {
@@ -293,6 +295,14 @@ GetLoaderPerformanceInfo (
     CopyMem ((VOID *)PerfData->TimeStamp, (VOID *)PerfInfo->TimeStamp, sizeof (UINT64) * PerfInfo->Count);
   }
 
+  GuidHob = GetNextGuidHob (&gLoaderPerformanceTimelineGuid, (VOID *)(UINTN)PcdGet32 (PcdPayloadHobList));
+  if ((GuidHob != NULL) && (PerfData != NULL) && (PerfData->Span != NULL)) {
+    PerfTimeline        = (PERFORMANCE_TIMELINE_INFO *)GET_GUID_HOB_DATA (GuidHob);
+    PerfData->SpanCount = MIN (PerfTimeline->Count, MAX_PERF_SPAN_NUM);
+    PerfData->SpanOpen  = 0;
+    CopyMem ((VOID *)PerfData->Span, (VOID *)PerfTimeline->Span, sizeof (PERFORMANCE_SPAN) * PerfData->SpanCount);
+  }
+
   return EFI_SUCCESS;
 }
 
@@ -653,6 +653,96 @@ FreeImageData (
   ZeroMem (ImageData, sizeof (IMAGE_DATA));
 }
 
+/**
+  Free the digests calculated ahead of time for a loaded image
+
+  @param[in]  LoadedImage     A load image pointer which has a boot image info
+
+**/
+VOID
+FreeImageDigests (
+  IN  LOADED_IMAGE  *LoadedImage
+  )
+{
+  if (LoadedImage->DigestReq != NULL) {
+    FreePool (LoadedImage->DigestReq);
+    LoadedImage->DigestReq      = NULL;
+    LoadedImage->DigestReqCount = 0;
+  }
+}
+
+/**
+  The job function to calculate the digest for one hash request.
+
+  It can run on an AP, so it must not print any debug messages.
+
+  @param[in] Arg  Pointer to the HASH_REQUEST.
+
+  @retval  0      Always.
+**/
+STATIC
+UINT64
+EFIAPI
+CalculateImageDigestTask (
+  IN  UINT64   Arg
+  )
+{
+  HASH_REQUEST     *Request;
+
+  Request = (HASH_REQUEST *)(UINTN)Arg;
+  Request->Status = CalculateHash (Request->Data, Request->Length, Request->HashAlg, Request->Digest);
+  return 0;
+}
+
+/**
+  Start calculating the digests needed to authenticate a loaded image.
+
+  The digests of the signed regions are calculated by the AP jobs while the
+  BSP reads the next image. They are used when the image is parsed.
+
+  @param[in]      MpService     MP service to run the jobs.
+  @param[in, out] LoadedImage   Loaded Image information.
+
+**/
+STATIC
+VOID
+SubmitImageDigests (
+  IN     MP_SERVICE          *MpService,
+  IN OUT LOADED_IMAGE        *LoadedImage
+  )
+{
+  EFI_STATUS                 Status;
+  UINT32                     Count;
+  UINT32                     Index;
+
+  if ((LoadedImage->Flags & (LOADED_IMAGE_CONTAINER | LOADED_IMAGE_IAS)) == 0) {
+    return;
+  }
+
+  LoadedImage->DigestReq = (HASH_REQUEST *)AllocatePool (sizeof (HASH_REQUEST) * MAX_IAS_SUB_IMAGE);
+  if (LoadedImage->DigestReq == NULL) {
+    return;
+  }
+
+  Count = MAX_IAS_SUB_IMAGE;
+  if ((LoadedImage->Flags & LOADED_IMAGE_CONTAINER) != 0) {
+    Status = PrepareContainerDigests ((CONTAINER_HDR *)LoadedImage->ImageData.Addr,
+                                      LoadedImage->ImageData.Size, LoadedImage->DigestReq, &Count);
+  } else {
+    Count  = 1;
+    Status = IasPrepareDigest (LoadedImage->ImageData.Addr, LoadedImage->ImageData.Size, LoadedImage->DigestReq);
+  }
+  if (EFI_ERROR (Status) || (Count == 0)) {
+    FreeImageDigests (LoadedImage);
+    return;
+  }
+
+  LoadedImage->DigestReqCount = Count;
+  for (Index = 0; Index < Count; Index++) {
+    MpService->SubmitJob (CalculateImageDigestTask, (UINT64)(UINTN)&LoadedImage->DigestReq[Index]);
+  }
+}
+
 /**
   Free all allocated memory in a loaded image
 
@@ -679,6 +769,8 @@ UnloadLoadedImage (
     return;
   }
 
+  FreeImageDigests (LoadedImage);
+
   //
   // Free Boot Image Data loaded from FS or RAW partition
   //
@@ -804,6 +896,7 @@ LoadBootImages (
   EFI_STATUS                 Status;
   UINT8                      Index;
   CONTAINER_IMAGE           *ContainerImage;
+  MP_SERVICE                *MpService;
 
   ASSERT (OsBootOption != NULL);
 
@@ -816,6 +909,19 @@ LoadBootImages (
   }
   LoadedImagesInfo->Signature = LOADED_IMAGES_INFO_SIGNATURE;
 
+  //
+  // Authenticating an image is mostly hashing it. With idle APs, the digests of
+  // an image are calculated while the next image is read from the boot media.
+  //
+  MpService = NULL;
+  if (FeaturePcdGet (PcdVerifiedBootEnabled)) {
+    MpService = (MP_SERVICE *) GetServiceBySignature (MP_SERVICE_SIGNATURE);
+    if ((MpService != NULL) && (MpService->GetWorkerCount () <= 1)) {
+      MpService = NULL;
+    }
+  }
+
+  Status = EFI_SUCCESS;
   for (Index = 0; Index < LoadImageTypeMax; Index++) {
     if ((Index == LoadImageTypePreOs) && ((BootFlags & BOOT_FLAGS_PREOS) == 0)) {
       continue;
@@ -832,7 +938,9 @@ LoadBootImages (
 
     LoadedImage = (LOADED_IMAGE *)AllocateZeroPool (sizeof (LOADED_IMAGE));
     if (LoadedImage == NULL) {
-      return EFI_OUT_OF_RESOURCES;
+      // Digest jobs of the images loaded so far might still be running
+      Status = EFI_OUT_OF_RESOURCES;
+      break;
     }
     LoadedImage->HwPartHandle   = HwPartHandle;
     LoadedImage->LoadImageType  = Index;
@@ -852,6 +960,10 @@ LoadBootImages (
     DEBUG ((DEBUG_INFO, "LoadBootImage ImageType-%d %r\n", Index, Status));
     LoadedImagesInfo->LoadedImageList[Index] = LoadedImage;
 
+    if (!EFI_ERROR (Status) && (MpService != NULL)) {
+      SubmitImageDigests (MpService, LoadedImage);
+    }
+
     if (EFI_ERROR (Status)) {
       if (Index >= LoadImageTypeExtra0) {
         // Continue boot if load extra image failed.
@@ -864,6 +976,13 @@ LoadBootImages (
     }
   }
 
+  //
+  // The images must not be parsed or freed while a digest job is running
+  //
+  if (MpService != NULL) {
+    MpService->WaitAllJobs ();
+  }
+
   //
   // Launch Traditional Linux for debugging purpose only
   //
@@ -201,7 +201,11 @@ ParseContainerImage (
   UINT64                      ComponentName;
   LOADER_COMPRESSED_HEADER   *LzHdr;
   IMAGE_DATA                  File[MAX_IAS_SUB_IMAGE];
+  LOAD_COMPONENT_REQUEST      LoadReq[MAX_IAS_SUB_IMAGE];
+  IMAGE_DATA                  Extra;
   UINT8                       Index;
+  UINT8                       Index2;
+  UINT8                       Count;
 
   ContainerHdr = (CONTAINER_HDR  *)LoadedImage->ImageData.Addr;
   if (ContainerHdr->Signature != CONTAINER_BOOT_SIGNATURE) {
@@ -215,6 +219,7 @@ ParseContainerImage (
   }
 
   ZeroMem (File, sizeof (File));
+  ZeroMem (LoadReq, sizeof (LoadReq));
 
   DEBUG ((DEBUG_INFO, "CONTAINER size = 0x%x, image type = 0x%x, # of components = %d\n", LoadedImage->ImageData.Size, ContainerHdr->ImageType, ContainerHdr->Count));
 
@@ -243,18 +248,45 @@ ParseContainerImage (
       File[Index].Size = LzHdr->Size;
       File[Index].AllocType = ImageAllocateTypePointer;
     } else {
-      //
-      // Use Load to decompress to a new aligned page
-      //
-      Status = LoadComponent (ContainerHdr->Signature, (UINT32) ComponentName, (VOID **)&File[Index].Addr, &File[Index].Size);
-      if (!EFI_ERROR (Status)) {
-        File[Index].AllocType = ImageAllocateTypePage;
-      }
+      // Collect the component so that all of them are loaded in one batch
+      LoadReq[Index].ContainerSig  = ContainerHdr->Signature;
+      LoadReq[Index].ComponentName = (UINT32) ComponentName;
     }
 
     Index++;
   } while ((Status == EFI_SUCCESS) && (Index < ARRAY_SIZE (File)));
 
+  if (((ContainerHdr->Flags & CONTAINER_HDR_FLAG_MONO_SIGNING) == 0) && (Index > 0)) {
+    //
+    // Use Load to decompress to new aligned pages
+    // Components are authenticated and decompressed in parallel if possible
+    //
+    Count = Index;
+    LoadComponentListWithDigest (LoadReq, Count, LoadedImage->DigestReq, LoadedImage->DigestReqCount, NULL);
+    for (Index = 0; Index < Count; Index++) {
+      if (EFI_ERROR (LoadReq[Index].Status)) {
+        break;
+      }
+      File[Index].Addr      = LoadReq[Index].Buffer;
+      File[Index].Size      = LoadReq[Index].Length;
+      File[Index].AllocType = ImageAllocateTypePage;
+    }
+
+    if (Index < Count) {
+      // Keep the failed entry and release the components loaded after it
+      DEBUG ((DEBUG_INFO, "Load COMP:%a %r\n", &LoadReq[Index].ComponentName, LoadReq[Index].Status));
+      for (Index2 = Index + 1; Index2 < Count; Index2++) {
+        if (!EFI_ERROR (LoadReq[Index2].Status)) {
+          Extra.Addr      = LoadReq[Index2].Buffer;
+          Extra.Size      = LoadReq[Index2].Length;
+          Extra.AllocType = ImageAllocateTypePage;
+          FreeImageData (&Extra);
+        }
+      }
+      Index++;
+    }
+  }
+
   Status = UnregisterContainer (ContainerHdr->Signature);
   DEBUG ((DEBUG_INFO, "Unregister done - %r!\n", Status));
 
@@ -325,8 +357,15 @@ ParseIasImage (
   IAS_IMAGE_INFO             IasImageInfo;
   COMPONENT_CALLBACK_INFO    CompInfo;
   EFI_STATUS                 Status;
+  UINT8                     *Digest;
 
-  IasImage = IsIasImageValid (LoadedImage->ImageData.Addr, LoadedImage->ImageData.Size, &IasImageInfo);
+  // Use the digest calculated while the next image was read
+  Digest = NULL;
+  if ((LoadedImage->DigestReqCount > 0) && !RETURN_ERROR (LoadedImage->DigestReq[0].Status)) {
+    Digest = LoadedImage->DigestReq[0].Digest;
+  }
+
+  IasImage = IsIasImageValidWithDigest (LoadedImage->ImageData.Addr, LoadedImage->ImageData.Size, Digest, &IasImageInfo);
   if (IasImage == NULL) {
     DEBUG ((DEBUG_INFO, "Image given is not a valid IAS image\n"));
     return EFI_LOAD_ERROR;
@@ -612,6 +651,9 @@ BeforeOSJump (
   }
   AddMeasurePoint (0x4100);
 
+  // Export the payload performance spans into ACPI FPDT
+  UpdateFpdtPerfTimeline ();
+
   // De-init boot devices before OS boot.
   DeinitBootDevices ();
 
@@ -620,6 +662,9 @@ BeforeOSJump (
 
   DEBUG ((DEBUG_INIT, "\n%a\n\n", Message));
 
+  // Send out the deferred serial output
+  DebugLogBufferFlush (MAX_UINTN);
+
   // Print debug log buffer if serial port is not an active debug output device
   if ((PcdGet32 (PcdDebugOutputDeviceMask) & DEBUG_OUTPUT_DEVICE_SERIAL_PORT) == 0) {
     LogBufHdr = (DEBUG_LOG_BUFFER_HEADER *) GetDebugLogBufferPtr ();
@@ -748,6 +793,7 @@ InitBootDevice (
   UINTN                     BootMediumPciBase;
   UINT8                     DeviceType;
   UINT8                     DeviceInstance;
+  UINT32                    Span;
 
   AddMeasurePoint (0x4040);
 
@@ -773,7 +819,9 @@ InitBootDevice (
   }
 
   DEBUG ((DEBUG_INFO, "Getting boot image from %a\n", GetBootDeviceNameString(DeviceType)));
+  Span   = BeginMeasureSpan (0x4050, 0, DeviceType);
   Status = MediaInitialize (BootMediumPciBase, DevInitAll);
+  EndMeasureSpan (Span, 0);
   if (EFI_ERROR (Status)) {
     DEBUG ((DEBUG_ERROR, "Failed to init media - %r\n", Status));
     return Status;
@@ -934,6 +982,7 @@ ParseBootImages (
       DEBUG ((DEBUG_INFO, "ParseLoadedImage: Status = %r\n", Status));
       break;
     }
+    FreeImageDigests (LoadedImage);
   }
 
   return Status;
@@ -1096,6 +1145,7 @@ BootOsImage (
   UINT8                StartPart;
   UINT8                EndPart;
   OS_BOOT_MEDIUM_TYPE  MediaType;
+  UINT32               Span;
 
   HwPartHandle      = NULL;
   FsHandle          = NULL;
@@ -1119,6 +1169,7 @@ BootOsImage (
   //
   MediaType = MediaGetInterfaceType ();
   OldHwPart = OsBootOption->HwPart;
+  Span      = BeginMeasureSpan (0x4070, 0, (UINT8)MediaType);
   if ((MediaType == OsBootDeviceUsb) && (OldHwPart == 0xFF)) {
     StartPart = 0;
     EndPart   = 0x10;
@@ -1161,8 +1212,10 @@ BootOsImage (
 
     //
     // Load Boot Image
+    // Give the console shadow buffer back to the heap before the images are loaded
     //
     if (!EFI_ERROR (Status)) {
+      FrameBufferConsoleReleaseShadow ();
       Status = LoadBootImages (OsBootOption, HwPartHandle, FsHandle, &LoadedImageHandle);
       if (EFI_ERROR (Status)) {
         DEBUG ((DEBUG_INFO, "Failed to Load Boot Image\n"));
@@ -1194,6 +1247,7 @@ BootOsImage (
   }
 
   AddMeasurePoint (0x4070);
+  EndMeasureSpan (Span, 0);
   OsBootOption->HwPart = OldHwPart;
 
   if (EFI_ERROR (Status)) {
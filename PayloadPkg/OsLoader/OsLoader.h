@@ -56,8 +56,10 @@
 #include <Guid/GraphicsInfoHob.h>
 #include <Guid/LoaderPlatformInfoGuid.h>
 #include <Guid/BootLoaderVersionGuid.h>
+#include <Guid/PerformanceInfoGuid.h>
 #include <Guid/LoaderPlatformInfoGuid.h>
 #include <Service/PlatformService.h>
+#include <Service/MpService.h>
 #include <IndustryStandard/Mbr.h>
 #include <Uefi/UefiGpt.h>
 #include <PayloadModule.h>
@@ -146,6 +148,8 @@ typedef struct {
   LOADED_IMAGE_TYPE       Image;
   UINT8                   ImageHash[HASH_DIGEST_MAX];
   RESERVED_CMDLINE_DATA   ReservedCmdlineData;
+  HASH_REQUEST           *DigestReq;
+  UINT32                  DigestReqCount;
 } LOADED_IMAGE;
 
 /**
@@ -255,6 +259,17 @@ UnloadLoadedImage (
   IN  LOADED_IMAGE  *LoadedImage
   );
 
+/**
+  Free the digests calculated ahead of time for a loaded image
+
+  @param[in]  LoadedImage     A load image pointer which has a boot image info
+
+**/
+VOID
+FreeImageDigests (
+  IN  LOADED_IMAGE  *LoadedImage
+  );
+
 /**
   Free the allocated memory in an image data
 
@@ -300,6 +315,14 @@ PrintLinuxMeasurePoint (
   VOID
   );
 
+/**
+  Update the performance span records in ACPI FPDT.
+**/
+VOID
+UpdateFpdtPerfTimeline (
+  VOID
+  );
+
 /**
   Get command line arguments from the config file.
 
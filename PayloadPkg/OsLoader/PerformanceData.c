@@ -70,3 +70,25 @@ PrintLinuxMeasurePoint (
   PrintMeasurePoint (PerfData, LinuxPerfIdToStr);
 }
 
+/**
+  Update the performance span records in ACPI FPDT.
+
+  The FPDT boot performance table location is provided by the loader
+  performance timeline hob. The span records in it are rewritten with
+  the spans collected so far, including the ones added in payload.
+
+**/
+VOID
+UpdateFpdtPerfTimeline (
+  VOID
+  )
+{
+  PERFORMANCE_TIMELINE_INFO  *PerfTimeline;
+
+  PerfTimeline = (PERFORMANCE_TIMELINE_INFO *)GetGuidHobData (NULL, NULL, &gLoaderPerformanceTimelineGuid);
+  if ((PerfTimeline == NULL) || (PerfTimeline->FpdtBootTable == 0)) {
+    return;
+  }
+
+  UpdateFpdtSpanRecords ((EFI_ACPI_5_0_FPDT_PERFORMANCE_TABLE_HEADER *)(UINTN)PerfTimeline->FpdtBootTable, GetPerfDataPtr ());
+}
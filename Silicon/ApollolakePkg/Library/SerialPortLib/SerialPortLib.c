@@ -9,6 +9,7 @@
 #include <Library/BaseLib.h>
 #include <Library/IoLib.h>
 #include <Library/PlatformHookLib.h>
+#include <Library/SerialPortLib.h>
 
 //---------------------------------------------
 // UART Register Offsets
@@ -279,3 +280,33 @@ SerialPortPoll (
   return FALSE;
 }
 
+/**
+  Retrieve the status of the control bits on a serial device.
+
+  Only the input and output buffer states are reported. The output buffer is
+  empty when a write of up to the transmit FIFO depth does not wait.
+
+  @param Control                A pointer to return the current control signals from the serial device.
+
+  @retval RETURN_SUCCESS        The control bits were read from the serial device.
+
+**/
+RETURN_STATUS
+EFIAPI
+SerialPortGetControl (
+  OUT UINT32 *Control
+  )
+{
+  UINT8    Lsr;
+
+  *Control = 0;
+  Lsr      = SerialPortReadRegister (LSR_OFFSET);
+  if ((Lsr & LSR_TXRDY) != 0) {
+    *Control |= EFI_SERIAL_OUTPUT_BUFFER_EMPTY;
+  }
+  if ((Lsr & LSR_RXDA) == 0) {
+    *Control |= EFI_SERIAL_INPUT_BUFFER_EMPTY;
+  }
+
+  return RETURN_SUCCESS;
+}